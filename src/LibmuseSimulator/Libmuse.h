@@ -0,0 +1,126 @@
+// Libmuse.h : Ix* C API of libmuse, as bound by Services/BCI/Muse/Interop/Native.cs.
+//
+// The simulator builds as Libmuse.dll / libLibmuse.so and exports the same symbols, so the app
+// and TestMuseLibraries can run against virtual headbands. Conventions follow libmuse: 0 on
+// success, -1 on failure with a message in errorOut; string outputs return the required buffer
+// size (a positive value) when jsonLen/nameLen is too small. Booleans are 4-byte Win32 BOOLs,
+// matching the default P/Invoke marshalling.
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(LIBMUSE_STATIC)
+#define LIBMUSE_API
+#elif defined(_WIN32)
+#ifdef LIBMUSE_EXPORTS
+#define LIBMUSE_API __declspec(dllexport)
+#else
+#define LIBMUSE_API __declspec(dllimport)
+#endif
+#else
+#define LIBMUSE_API __attribute__((visibility("default")))
+#endif
+
+// DllImport and managed delegates default to the platform calling convention (stdcall on x86)
+#if defined(_WIN32)
+#define LIBMUSE_CALL __stdcall
+#else
+#define LIBMUSE_CALL
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    typedef void (LIBMUSE_CALL* IxApiCallback)(const char* jsonArgs);
+    typedef void (LIBMUSE_CALL* IxDataCallback)(int packetType, const double* values, int numValues, int64_t timestamp, const char* macAddress);
+
+    LIBMUSE_API int LIBMUSE_CALL IxApiVersion(char* version, int versionLen, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxLibmuseVersion(char* version, int versionLen, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxInitialize(char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxWriteLog(int severity, int raw, const char* tag, const char* message, char* errorOut, int errorLen);
+
+    // muse manager
+    LIBMUSE_API int LIBMUSE_CALL IxSetRecorderInfo(const char* recorderName, const char* recorderVersion, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxStartListening(char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxStopListening(char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxSetMuseListener(IxApiCallback listener, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxSetLogListener(IxApiCallback listener, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetAdvertisingStats(const char* macAddress, char* jsonOut, int jsonLen, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxResetAdvertisingStats(char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxRemoveFromListAfter(int64_t time, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetMuses(char* jsonOut, int jsonLen, char* errorOut, int errorLen);
+
+    // muse
+    LIBMUSE_API int LIBMUSE_CALL IxRegisterConnectionListener(const char* macAddress, IxApiCallback listener, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxUnregisterConnectionListener(const char* macAddress, IxApiCallback listener, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxRegisterDataListener(const char* macAddress, IxDataCallback listener, int packetType, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxUnregisterDataListener(const char* macAddress, IxDataCallback listener, int packetType, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxRegisterErrorListener(const char* macAddress, IxApiCallback listener, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxUnregisterErrorListener(const char* macAddress, IxApiCallback listener, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxUnregisterAllListeners(const char* macAddress, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxSetPreset(const char* macAddress, int preset, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxEnableDataTransmission(const char* macAddress, int enable, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxSetNotchFrequency(const char* macAddress, int frequency, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxEnableException(const char* macAddress, int enable, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxEnableLedIndicator(const char* macAddress, int enable, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxConnect(const char* macAddress, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxDisconnect(const char* macAddress, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxExecute(const char* macAddress, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxRunAsynchronously(const char* macAddress, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxSetNumConnectTries(const char* macAddress, int numTries, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetMuseConfiguration(const char* macAddress, char* jsonOut, int jsonLen, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetMuseVersion(const char* macAddress, char* jsonOut, int jsonLen, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetConnectionState(const char* macAddress, int* connectionState, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetRssi(const char* macAddress, double* rssi, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetLastDiscoveredTime(const char* macAddress, double* time, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetName(const char* macAddress, char* nameOut, int nameLen, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetModel(const char* macAddress, char* jsonOut, int jsonLen, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxIsPaired(const char* macAddress, int* isPaired, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxIsLowEnergy(const char* macAddress, int* isLowEnergy, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxIsConnectable(const char* macAddress, int* isConnectable, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxSetLicenseData(const char* macAddress, const uint8_t* dataBlob, int blobLen, char* errorOut, int errorLen);
+
+    // file reader (not simulated; every call fails)
+    LIBMUSE_API int LIBMUSE_CALL IxOpenFileReader(const char* filePath, int* handle, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxCloseFileReader(int handle, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetReaderNextMessage(int handle, char* jsonOut, int jsonLen, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetReaderMessageType(int handle, char* jsonOut, int jsonLen, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetReaderMessageId(int handle, int* messageId, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetReaderMessageTime(int handle, int64_t* timestamp, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetReaderAnnotation(int handle, char* jsonOut, int jsonLen, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetReaderMuseConfiguration(int handle, char* jsonOut, int jsonLen, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetReaderVersion(int handle, char* jsonOut, int jsonLen, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetReaderDeviceConfiguration(int handle, char* jsonOut, int jsonLen, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetReaderDspData(int handle, char* jsonOut, int jsonLen, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetReaderDataPacket(int handle, char* jsonOut, int jsonLen, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetReaderArtifactPacket(int handle, char* jsonOut, int jsonLen, char* errorOut, int errorLen);
+
+    // file writer (not simulated; every call fails)
+    LIBMUSE_API int LIBMUSE_CALL IxOpenFileWriter(const char* filePath, int* handle, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxCloseFileWriter(int handle, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxWriterDiscardBuffer(int handle, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxWriterFlush(int handle, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetWriterBufferedMessagesCount(int handle, int* count, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetWriterBufferedMessagesSize(int handle, int* size, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxGetWriterBytesWritten(int handle, int64_t* byteCount, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxWriterAddArtifactPacket(int handle, int id, int headbandOn, int blink, int jawClench, int64_t timestamp, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxWriterAddDataPacket(int handle, int id, int packetType, int64_t timestamp, const double* values, int64_t valuesSize, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxWriterAddAnnotationString(int handle, int id, const char* annotation, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxWriterAddAnnotation(int handle, int id, const char* annotationData, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxWriterAddMuseConfiguration(int handle, int id, const char* configuration, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxWriterAddVersion(int handle, int id, const char* version, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxWriterAddDeviceConfiguration(int handle, int id, const char* configuration, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxWriterAddDspData(int handle, int id, const char* dspData, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxSetWriterTimestampMode(int handle, int mode, char* errorOut, int errorLen);
+    LIBMUSE_API int LIBMUSE_CALL IxSetWriterTimestamp(int handle, int64_t timestamp, char* errorOut, int errorLen);
+
+    LIBMUSE_API int LIBMUSE_CALL IxGetComputingDeviceConfiguration(char* jsonOut, int jsonLen, char* errorOut, int errorLen);
+
+    // simulator control (not part of libmuse)
+    LIBMUSE_API int LIBMUSE_CALL IxSimConfigure(const char* options, char* errorOut, int errorLen);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,421 @@
+// LibmuseApi.cpp : Exported Ix* entry points backed by the simulator.
+#include "pch.h"
+#include "Libmuse.h"
+#include "Simulator.h"
+
+#include <cstdio>
+
+using namespace LibmuseSimulator;
+
+namespace
+{
+    constexpr int IxFailure = -1;
+
+    void WriteError(char* errorOut, int errorLen, const char* message)
+    {
+        if (errorOut != nullptr && errorLen > 0)
+        {
+            std::snprintf(errorOut, static_cast<size_t>(errorLen), "%s", message);
+        }
+    }
+
+    template <typename Fn>
+    int Invoke(char* errorOut, int errorLen, Fn&& body)
+    {
+        try
+        {
+            WriteError(errorOut, errorLen, "");
+            return body();
+        }
+        catch (const std::exception& e)
+        {
+            WriteError(errorOut, errorLen, e.what());
+            return IxFailure;
+        }
+        catch (...)
+        {
+            WriteError(errorOut, errorLen, "Unknown simulator exception");
+            return IxFailure;
+        }
+    }
+
+    // libmuse convention: 0 when the string fits, otherwise the buffer size required
+    int CopyString(const std::string& text, char* out, int length)
+    {
+        int required = static_cast<int>(text.size()) + 1;
+        if (out == nullptr || length < required)
+        {
+            return required;
+        }
+        std::memcpy(out, text.c_str(), static_cast<size_t>(required));
+        return 0;
+    }
+
+    MuseDataPacketType PacketType(int type)
+    {
+        if (type < 0 || type >= PacketTypeCount)
+        {
+            throw std::invalid_argument("Unknown packet type " + std::to_string(type));
+        }
+        return static_cast<MuseDataPacketType>(type);
+    }
+
+    template <typename T>
+    void RequireOut(T* out)
+    {
+        if (out == nullptr)
+        {
+            throw std::invalid_argument("Output pointer is null");
+        }
+    }
+
+    int NotSimulated(char* errorOut, int errorLen)
+    {
+        WriteError(errorOut, errorLen, "Muse file reading and writing is not available in the libmuse simulator");
+        return IxFailure;
+    }
+}
+
+int LIBMUSE_CALL IxApiVersion(char* version, int versionLen, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { return CopyString("1.1", version, versionLen); });
+}
+
+int LIBMUSE_CALL IxLibmuseVersion(char* version, int versionLen, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { return CopyString("LibmuseSimulator 1.0", version, versionLen); });
+}
+
+int LIBMUSE_CALL IxInitialize(char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance(); return 0; });
+}
+
+int LIBMUSE_CALL IxWriteLog(int severity, int raw, const char* tag, const char* message, char* errorOut, int errorLen)
+{
+    (void)raw;
+    return Invoke(errorOut, errorLen, [&]
+    {
+        Simulator::Instance().Log(severity, tag != nullptr ? tag : "", message != nullptr ? message : "");
+        return 0;
+    });
+}
+
+int LIBMUSE_CALL IxSetRecorderInfo(const char* recorderName, const char* recorderVersion, char* errorOut, int errorLen)
+{
+    (void)recorderName;
+    (void)recorderVersion;
+    return Invoke(errorOut, errorLen, [&] { return 0; });
+}
+
+int LIBMUSE_CALL IxStartListening(char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().StartListening(); return 0; });
+}
+
+int LIBMUSE_CALL IxStopListening(char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().StopListening(); return 0; });
+}
+
+int LIBMUSE_CALL IxSetMuseListener(IxApiCallback listener, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().SetMuseListener(listener); return 0; });
+}
+
+int LIBMUSE_CALL IxSetLogListener(IxApiCallback listener, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().SetLogListener(listener); return 0; });
+}
+
+int LIBMUSE_CALL IxGetAdvertisingStats(const char* macAddress, char* jsonOut, int jsonLen, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&]
+    {
+        Simulator::Instance().Device(macAddress);
+        return CopyString("{\"numAdvertisingPackets\":0,\"isConnectable\":true}", jsonOut, jsonLen);
+    });
+}
+
+int LIBMUSE_CALL IxResetAdvertisingStats(char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { return 0; });
+}
+
+int LIBMUSE_CALL IxRemoveFromListAfter(int64_t time, char* errorOut, int errorLen)
+{
+    (void)time;
+    return Invoke(errorOut, errorLen, [&] { return 0; });
+}
+
+int LIBMUSE_CALL IxGetMuses(char* jsonOut, int jsonLen, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { return CopyString(Simulator::Instance().MusesJson(), jsonOut, jsonLen); });
+}
+
+int LIBMUSE_CALL IxRegisterConnectionListener(const char* macAddress, IxApiCallback listener, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().Device(macAddress).AddConnectionListener(listener); return 0; });
+}
+
+int LIBMUSE_CALL IxUnregisterConnectionListener(const char* macAddress, IxApiCallback listener, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().Device(macAddress).RemoveConnectionListener(listener); return 0; });
+}
+
+int LIBMUSE_CALL IxRegisterDataListener(const char* macAddress, IxDataCallback listener, int packetType, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().Device(macAddress).AddDataListener(PacketType(packetType), listener); return 0; });
+}
+
+int LIBMUSE_CALL IxUnregisterDataListener(const char* macAddress, IxDataCallback listener, int packetType, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().Device(macAddress).RemoveDataListener(PacketType(packetType), listener); return 0; });
+}
+
+int LIBMUSE_CALL IxRegisterErrorListener(const char* macAddress, IxApiCallback listener, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().Device(macAddress).AddErrorListener(listener); return 0; });
+}
+
+int LIBMUSE_CALL IxUnregisterErrorListener(const char* macAddress, IxApiCallback listener, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().Device(macAddress).RemoveErrorListener(listener); return 0; });
+}
+
+int LIBMUSE_CALL IxUnregisterAllListeners(const char* macAddress, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().Device(macAddress).RemoveAllListeners(); return 0; });
+}
+
+int LIBMUSE_CALL IxSetPreset(const char* macAddress, int preset, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().Device(macAddress).preset = preset; return 0; });
+}
+
+int LIBMUSE_CALL IxEnableDataTransmission(const char* macAddress, int enable, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().Device(macAddress).EnableDataTransmission(enable != 0); return 0; });
+}
+
+int LIBMUSE_CALL IxSetNotchFrequency(const char* macAddress, int frequency, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().Device(macAddress).notchFrequency = frequency; return 0; });
+}
+
+int LIBMUSE_CALL IxEnableException(const char* macAddress, int enable, char* errorOut, int errorLen)
+{
+    (void)enable;
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().Device(macAddress); return 0; });
+}
+
+int LIBMUSE_CALL IxEnableLedIndicator(const char* macAddress, int enable, char* errorOut, int errorLen)
+{
+    (void)enable;
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().Device(macAddress); return 0; });
+}
+
+int LIBMUSE_CALL IxConnect(const char* macAddress, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&]
+    {
+        Simulator& simulator = Simulator::Instance();
+        simulator.Device(macAddress).RequestConnect();
+        simulator.Wake();
+        return 0;
+    });
+}
+
+int LIBMUSE_CALL IxDisconnect(const char* macAddress, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&]
+    {
+        Simulator& simulator = Simulator::Instance();
+        simulator.Device(macAddress).RequestDisconnect();
+        simulator.Wake();
+        return 0;
+    });
+}
+
+int LIBMUSE_CALL IxExecute(const char* macAddress, char* errorOut, int errorLen)
+{
+    // The engine thread already drives every device; nothing to pump on the caller's thread
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().Device(macAddress); return 0; });
+}
+
+int LIBMUSE_CALL IxRunAsynchronously(const char* macAddress, char* errorOut, int errorLen)
+{
+    return IxConnect(macAddress, errorOut, errorLen);
+}
+
+int LIBMUSE_CALL IxSetNumConnectTries(const char* macAddress, int numTries, char* errorOut, int errorLen)
+{
+    (void)numTries;
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().Device(macAddress); return 0; });
+}
+
+int LIBMUSE_CALL IxGetMuseConfiguration(const char* macAddress, char* jsonOut, int jsonLen, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&]
+    {
+        Simulator& simulator = Simulator::Instance();
+        VirtualDevice& device = simulator.Device(macAddress);
+        const SimulatorOptions& options = simulator.Options();
+        char json[768];
+        std::snprintf(json, sizeof(json),
+            "{\"preset\":%d,\"headbandName\":%s,\"microcontrollerId\":\"SIM\",\"eegChannelCount\":%d,\"afeGain\":2000,"
+            "\"downsampleRate\":1,\"seroutMode\":1,\"outputFrequency\":%d,\"adcFrequency\":%d,\"notchFilterEnabled\":%s,"
+            "\"notchFilter\":%d,\"accelerometerSampleFrequency\":%d,\"batteryDataEnabled\":true,\"drlRefEnabled\":false,"
+            "\"drlRefFrequency\":0,\"batteryPercentRemaining\":%.1f,\"bluetoothMac\":%s,\"serialNumber\":\"SIM-%s\","
+            "\"headsetSerialNumber\":\"SIM-%s\",\"model\":3,\"nonce\":\"\"}",
+            device.preset.load(), JsonString(device.Name()).c_str(), options.eegChannels,
+            static_cast<int>(options.eegRate), static_cast<int>(options.eegRate), device.notchFrequency.load() != 0 ? "true" : "false",
+            device.notchFrequency.load(), static_cast<int>(options.motionRate), device.BatteryPercent(),
+            JsonString(device.Mac()).c_str(), device.Mac().c_str() + 12, device.Mac().c_str() + 12);
+        return CopyString(json, jsonOut, jsonLen);
+    });
+}
+
+int LIBMUSE_CALL IxGetMuseVersion(const char* macAddress, char* jsonOut, int jsonLen, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&]
+    {
+        Simulator::Instance().Device(macAddress);
+        return CopyString("{\"runningState\":\"headset\",\"hardwareVersion\":\"SIM\",\"bspVersion\":\"SIM\",\"firmwareVersion\":\"1.0.0\","
+            "\"bootloaderVersion\":\"1.0.0\",\"firmwareBuildNumber\":\"0\",\"firmwareType\":\"consumer\",\"protocolVersion\":2}", jsonOut, jsonLen);
+    });
+}
+
+int LIBMUSE_CALL IxGetConnectionState(const char* macAddress, int* connectionState, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&]
+    {
+        RequireOut(connectionState);
+        *connectionState = static_cast<int>(Simulator::Instance().Device(macAddress).State());
+        return 0;
+    });
+}
+
+int LIBMUSE_CALL IxGetRssi(const char* macAddress, double* rssi, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&]
+    {
+        RequireOut(rssi);
+        *rssi = Simulator::Instance().Device(macAddress).Rssi();
+        return 0;
+    });
+}
+
+int LIBMUSE_CALL IxGetLastDiscoveredTime(const char* macAddress, double* time, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&]
+    {
+        RequireOut(time);
+        Simulator& simulator = Simulator::Instance();
+        *time = simulator.DiscoveredTime(simulator.Device(macAddress));
+        return 0;
+    });
+}
+
+int LIBMUSE_CALL IxGetName(const char* macAddress, char* nameOut, int nameLen, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&] { return CopyString(Simulator::Instance().Device(macAddress).Name(), nameOut, nameLen); });
+}
+
+int LIBMUSE_CALL IxGetModel(const char* macAddress, char* jsonOut, int jsonLen, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&]
+    {
+        Simulator::Instance().Device(macAddress);
+        return CopyString("MU_04", jsonOut, jsonLen);
+    });
+}
+
+int LIBMUSE_CALL IxIsPaired(const char* macAddress, int* isPaired, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&]
+    {
+        RequireOut(isPaired);
+        Simulator::Instance().Device(macAddress);
+        *isPaired = 1;
+        return 0;
+    });
+}
+
+int LIBMUSE_CALL IxIsLowEnergy(const char* macAddress, int* isLowEnergy, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&]
+    {
+        RequireOut(isLowEnergy);
+        Simulator::Instance().Device(macAddress);
+        *isLowEnergy = 1;
+        return 0;
+    });
+}
+
+int LIBMUSE_CALL IxIsConnectable(const char* macAddress, int* isConnectable, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&]
+    {
+        RequireOut(isConnectable);
+        Simulator::Instance().Device(macAddress);
+        *isConnectable = 1;
+        return 0;
+    });
+}
+
+int LIBMUSE_CALL IxSetLicenseData(const char* macAddress, const uint8_t* dataBlob, int blobLen, char* errorOut, int errorLen)
+{
+    (void)dataBlob;
+    (void)blobLen;
+    return Invoke(errorOut, errorLen, [&] { Simulator::Instance().Device(macAddress); return 0; });
+}
+
+int LIBMUSE_CALL IxOpenFileReader(const char*, int*, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxCloseFileReader(int, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxGetReaderNextMessage(int, char*, int, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxGetReaderMessageType(int, char*, int, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxGetReaderMessageId(int, int*, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxGetReaderMessageTime(int, int64_t*, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxGetReaderAnnotation(int, char*, int, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxGetReaderMuseConfiguration(int, char*, int, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxGetReaderVersion(int, char*, int, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxGetReaderDeviceConfiguration(int, char*, int, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxGetReaderDspData(int, char*, int, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxGetReaderDataPacket(int, char*, int, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxGetReaderArtifactPacket(int, char*, int, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+
+int LIBMUSE_CALL IxOpenFileWriter(const char*, int*, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxCloseFileWriter(int, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxWriterDiscardBuffer(int, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxWriterFlush(int, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxGetWriterBufferedMessagesCount(int, int*, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxGetWriterBufferedMessagesSize(int, int*, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxGetWriterBytesWritten(int, int64_t*, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxWriterAddArtifactPacket(int, int, int, int, int, int64_t, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxWriterAddDataPacket(int, int, int, int64_t, const double*, int64_t, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxWriterAddAnnotationString(int, int, const char*, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxWriterAddAnnotation(int, int, const char*, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxWriterAddMuseConfiguration(int, int, const char*, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxWriterAddVersion(int, int, const char*, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxWriterAddDeviceConfiguration(int, int, const char*, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxWriterAddDspData(int, int, const char*, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxSetWriterTimestampMode(int, int, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+int LIBMUSE_CALL IxSetWriterTimestamp(int, int64_t, char* errorOut, int errorLen) { return NotSimulated(errorOut, errorLen); }
+
+int LIBMUSE_CALL IxGetComputingDeviceConfiguration(char* jsonOut, int jsonLen, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&]
+    {
+        return CopyString("{\"osType\":\"simulator\",\"osVersion\":\"1.0\",\"model\":\"LibmuseSimulator\",\"bluetoothVersion\":\"5.0\"}", jsonOut, jsonLen);
+    });
+}
+
+int LIBMUSE_CALL IxSimConfigure(const char* options, char* errorOut, int errorLen)
+{
+    return Invoke(errorOut, errorLen, [&]
+    {
+        Simulator::Instance().Configure(options != nullptr ? options : "");
+        return 0;
+    });
+}
@@ -0,0 +1,183 @@
+// SignalGenerator.cpp : Synthetic EEG, band powers and artifacts for virtual headbands.
+#include "pch.h"
+#include "SignalGenerator.h"
+
+namespace LibmuseSimulator
+{
+    namespace
+    {
+        constexpr double Pi = 3.14159265358979323846;
+
+        // Centre frequencies and edges in libmuse order: alpha, beta, delta, theta, gamma
+        constexpr double BandFrequency[SignalGenerator::BandCount] = { 10.0, 20.0, 2.0, 6.0, 40.0 };
+        constexpr double BandLow[SignalGenerator::BandCount] = { 7.5, 13.0, 1.0, 4.0, 30.0 };
+        constexpr double BandHigh[SignalGenerator::BandCount] = { 13.0, 30.0, 4.0, 8.0, 44.0 };
+        constexpr int Alpha = 0;
+        constexpr int Beta = 1;
+        constexpr int Delta = 2;
+        constexpr int Theta = 3;
+        constexpr int Gamma = 4;
+
+        constexpr double EegOffset = 841.0;         // libmuse raw EEG sits mid-range of 0-1682 uV
+        constexpr double BlinkSeconds = 0.3;
+        constexpr double BlinkMicrovolts = 150.0;
+        constexpr double ClenchSeconds = 0.6;
+        constexpr double ClenchMicrovolts = 40.0;
+
+        // Frontal electrodes (AF7, AF8) carry most of the blink; the temporal ones most of the clench
+        bool IsFrontal(int channel)
+        {
+            return channel == 1 || channel == 2;
+        }
+
+        bool Within(const std::deque<double>& starts, double t, double duration)
+        {
+            for (double start : starts)
+            {
+                if (t >= start && t < start + duration)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    SignalGenerator::SignalGenerator(const SimulatorOptions& options, uint32_t seed)
+        : channels(std::min(options.eegChannels, MaxChannels)),
+          noise(options.noise),
+          blinksPerMinute(options.blinksPerMinute),
+          jawClenchesPerMinute(options.jawClenchesPerMinute),
+          random(seed)
+    {
+        std::uniform_real_distribution<double> phase(0.0, 2.0 * Pi);
+        for (auto& channel : phases)
+        {
+            for (double& p : channel)
+            {
+                p = phase(random);
+            }
+        }
+        focus = std::uniform_real_distribution<double>(0.3, 0.7)(random);
+        nextBlink = Exponential(blinksPerMinute);
+        nextClench = Exponential(jawClenchesPerMinute);
+        Advance(0.0);
+    }
+
+    double SignalGenerator::Exponential(double perMinute)
+    {
+        if (perMinute <= 0.0)
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+        return std::exponential_distribution<double>(perMinute / 60.0)(random);
+    }
+
+    void SignalGenerator::Advance(double t)
+    {
+        // Focus is an Ornstein-Uhlenbeck walk around 0.5 with a ~20 s time constant
+        double dt = std::max(t - stateTime, 0.0);
+        stateTime = t;
+        focus += (0.5 - focus) * dt / 20.0 + Gaussian() * 0.08 * std::sqrt(dt);
+        focus = std::clamp(focus, 0.0, 1.0);
+
+        amplitudes[Alpha] = 12.0 * (1.2 - focus);
+        amplitudes[Beta] = 4.0 + 6.0 * focus;
+        amplitudes[Delta] = 9.0;
+        amplitudes[Theta] = 7.0 * (1.1 - 0.5 * focus);
+        amplitudes[Gamma] = 1.5 + 1.5 * focus;
+
+        while (nextBlink <= t)
+        {
+            blinks.push_back(nextBlink);
+            nextBlink += std::max(Exponential(blinksPerMinute), BlinkSeconds);
+        }
+        while (nextClench <= t)
+        {
+            clenches.push_back(nextClench);
+            nextClench += std::max(Exponential(jawClenchesPerMinute), ClenchSeconds);
+        }
+
+        // Keep a second of history for packets timestamped slightly behind the engine clock
+        while (!blinks.empty() && blinks.front() + BlinkSeconds < t - 1.0)
+        {
+            blinks.pop_front();
+        }
+        while (!clenches.empty() && clenches.front() + ClenchSeconds < t - 1.0)
+        {
+            clenches.pop_front();
+        }
+    }
+
+    bool SignalGenerator::Blinking(double t) const
+    {
+        return Within(blinks, t, BlinkSeconds);
+    }
+
+    bool SignalGenerator::JawClenched(double t) const
+    {
+        return Within(clenches, t, ClenchSeconds);
+    }
+
+    double SignalGenerator::PinkNoise(int channel)
+    {
+        // Paul Kellet's economy pink filter: -3 dB/octave within 0.5 dB across the EEG range
+        double white = Gaussian();
+        std::array<double, 3>& b = pink[static_cast<size_t>(channel)];
+        b[0] = 0.99765 * b[0] + white * 0.0990460;
+        b[1] = 0.96300 * b[1] + white * 0.2965164;
+        b[2] = 0.57000 * b[2] + white * 1.0526913;
+        return (b[0] + b[1] + b[2] + white * 0.1848) * 0.25;
+    }
+
+    void SignalGenerator::Eeg(double t, double* values)
+    {
+        double blink = 0.0;
+        for (double start : blinks)
+        {
+            double centre = start + BlinkSeconds / 2.0;
+            double z = (t - centre) / (BlinkSeconds / 6.0);
+            blink += std::exp(-0.5 * z * z);
+        }
+        bool clench = JawClenched(t);
+
+        for (int channel = 0; channel < channels; channel++)
+        {
+            double value = EegOffset + noise * PinkNoise(channel);
+            for (int band = 0; band < BandCount; band++)
+            {
+                value += amplitudes[band] * std::sin(2.0 * Pi * BandFrequency[band] * t + phases[static_cast<size_t>(channel)][band]);
+            }
+            value += blink * BlinkMicrovolts * (IsFrontal(channel) ? 1.0 : 0.2);
+            if (clench)
+            {
+                value += Gaussian() * ClenchMicrovolts * (IsFrontal(channel) ? 0.5 : 1.0);
+            }
+            values[channel] = std::clamp(value, 0.0, 2.0 * EegOffset);
+        }
+    }
+
+    void SignalGenerator::BandPowers(double t, double powers[BandCount][MaxChannels])
+    {
+        bool blink = Blinking(t);
+        bool clench = JawClenched(t);
+        for (int band = 0; band < BandCount; band++)
+        {
+            // 1/f noise power is proportional to log(high / low) of the band
+            double background = noise * noise * std::log(BandHigh[band] / BandLow[band]);
+            for (int channel = 0; channel < channels; channel++)
+            {
+                double power = amplitudes[band] * amplitudes[band] / 2.0 + background;
+                if (blink && (band == Delta || band == Theta))
+                {
+                    power += BlinkMicrovolts * BlinkMicrovolts * (IsFrontal(channel) ? 0.25 : 0.01);
+                }
+                if (clench && (band == Beta || band == Gamma))
+                {
+                    power += ClenchMicrovolts * ClenchMicrovolts * (IsFrontal(channel) ? 0.1 : 0.4);
+                }
+                powers[band][channel] = std::log10(power) + Gaussian() * 0.03;
+            }
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "SimulatorOptions.h"
+
+#include <deque>
+
+namespace LibmuseSimulator
+{
+    /// <summary>
+    /// Synthetic EEG for one virtual headband: per-band sinusoids whose amplitudes follow a slowly
+    /// wandering focus level, 1/f background noise, blinks (frontal) and jaw clenches (broadband).
+    /// Band powers are derived analytically from the same model, so band packets agree with the raw
+    /// signal without running an FFT per device. Times are simulated seconds since the connection.
+    /// </summary>
+    class SignalGenerator
+    {
+    public:
+        /// <summary>
+        /// Bands in libmuse packet order (AlphaAbsolute, BetaAbsolute, DeltaAbsolute, ThetaAbsolute, GammaAbsolute)
+        /// </summary>
+        static constexpr int BandCount = 5;
+        static constexpr int MaxChannels = 8;
+
+        SignalGenerator(const SimulatorOptions& options, uint32_t seed);
+
+        /// <summary>
+        /// Moves the mental state and artifact schedule forward to time t; call once per engine tick
+        /// </summary>
+        void Advance(double t);
+
+        void Eeg(double t, double* values);
+
+        /// <summary>
+        /// Band power per band and channel in Bels (log10 of power in uV^2), as in *_ABSOLUTE packets
+        /// </summary>
+        void BandPowers(double t, double powers[BandCount][MaxChannels]);
+
+        bool Blinking(double t) const;
+        bool JawClenched(double t) const;
+        double Focus() const { return focus; }
+
+    private:
+        double Gaussian() { return normal(random); }
+        double Exponential(double perMinute);
+        double PinkNoise(int channel);
+
+        int channels;
+        double noise;
+        double blinksPerMinute;
+        double jawClenchesPerMinute;
+        std::mt19937 random;
+        std::normal_distribution<double> normal{ 0.0, 1.0 };
+
+        double focus = 0.5;
+        double stateTime = 0.0;
+        std::array<double, BandCount> amplitudes = {};
+        std::array<std::array<double, BandCount>, MaxChannels> phases = {};
+        std::array<std::array<double, 3>, MaxChannels> pink = {};
+
+        double nextBlink = 0.0;
+        double nextClench = 0.0;
+        std::deque<double> blinks;
+        std::deque<double> clenches;
+    };
+}
@@ -0,0 +1,271 @@
+// Simulator.cpp : Device registry, discovery and the engine thread of the libmuse simulator.
+#include "pch.h"
+#include "Simulator.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace LibmuseSimulator
+{
+    namespace
+    {
+        int64_t SteadyNanoseconds()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        int64_t WallMicroseconds()
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+    }
+
+    std::string JsonString(const std::string& text)
+    {
+        std::string json = "\"";
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                json += '\\';
+                json += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                json += escaped;
+            }
+            else
+            {
+                json += c;
+            }
+        }
+        return json + "\"";
+    }
+
+    Simulator& Simulator::Instance()
+    {
+        // Intentionally leaked: the engine thread must never be joined from DllMain or static destructors
+        static Simulator* instance = new Simulator();
+        return *instance;
+    }
+
+    Simulator::Simulator()
+        : originUs(WallMicroseconds()), originSteadyNs(SteadyNanoseconds())
+    {
+        if (const char* environment = std::getenv("LIBMUSE_SIM_OPTIONS"))
+        {
+            options.Parse(environment);
+        }
+        CreateDevices();
+    }
+
+    void Simulator::CreateDevices()
+    {
+        devices.clear();
+        for (int i = 0; i < options.devices; i++)
+        {
+            devices.push_back(std::make_unique<VirtualDevice>(i, options));
+        }
+        discoveredUs.assign(devices.size(), INT64_MAX);
+    }
+
+    void Simulator::Configure(const std::string& text)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (running)
+        {
+            throw std::logic_error("Configure the simulator before listening or connecting");
+        }
+        SimulatorOptions next = options;
+        next.Parse(text);
+
+        // Keep simulated time continuous across a speed change
+        originUs = NowUs();
+        originSteadyNs = SteadyNanoseconds();
+        options = next;
+        CreateDevices();
+    }
+
+    int64_t Simulator::NowUs() const
+    {
+        double elapsedUs = static_cast<double>(SteadyNanoseconds() - originSteadyNs) / 1000.0;
+        return originUs + static_cast<int64_t>(elapsedUs * options.speed);
+    }
+
+    void Simulator::StartListening()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (!listening)
+            {
+                listening = true;
+                listenStartUs = NowUs();
+            }
+        }
+        Wake();
+    }
+
+    void Simulator::StopListening()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        listening = false;
+    }
+
+    void Simulator::SetMuseListener(IxApiCallback listener)
+    {
+        museListener = listener;
+    }
+
+    void Simulator::SetLogListener(IxApiCallback listener)
+    {
+        logListener = listener;
+    }
+
+    std::string Simulator::MusesJson()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        std::string json = "[";
+        for (size_t i = 0; i < devices.size(); i++)
+        {
+            if (discoveredUs[i] == INT64_MAX)
+            {
+                continue;
+            }
+            char rssi[32];
+            std::snprintf(rssi, sizeof(rssi), "%.1f", devices[i]->Rssi());
+            json += json.size() > 1 ? "," : "";
+            json += "{\"name\":" + JsonString(devices[i]->Name()) + ",\"bluetoothMac\":" + JsonString(devices[i]->Mac()) + ",\"rssi\":" + rssi + "}";
+        }
+        return json + "]";
+    }
+
+    VirtualDevice& Simulator::Device(const char* macAddress)
+    {
+        if (macAddress != nullptr)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (auto& device : devices)
+            {
+                if (device->Mac() == macAddress)
+                {
+                    return *device;
+                }
+            }
+        }
+        throw std::invalid_argument(std::string("Unknown Muse ") + (macAddress != nullptr ? macAddress : "(null)"));
+    }
+
+    double Simulator::DiscoveredTime(const VirtualDevice& device)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (size_t i = 0; i < devices.size(); i++)
+        {
+            if (devices[i].get() == &device && discoveredUs[i] != INT64_MAX)
+            {
+                return static_cast<double>(discoveredUs[i]) / 1e6;
+            }
+        }
+        return 0.0;
+    }
+
+    void Simulator::Log(int severity, const char* tag, const std::string& message)
+    {
+        IxApiCallback listener = logListener.load();
+        if (listener == nullptr)
+        {
+            return;
+        }
+        char head[96];
+        std::snprintf(head, sizeof(head), "{\"severity\":%d,\"raw\":false,\"timestamp\":%.6f,\"tag\":", severity, static_cast<double>(NowUs()) / 1e6);
+        std::string json = head + JsonString(tag) + ",\"message\":" + JsonString(message) + "}";
+        listener(json.c_str());
+    }
+
+    void Simulator::Wake()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (running)
+        {
+            return;
+        }
+        if (worker.joinable())
+        {
+            // The previous engine has already decided to exit; it only needs reaping
+            worker.join();
+        }
+        running = true;
+        worker = std::thread(&Simulator::Run, this);
+    }
+
+    bool Simulator::Idle() const
+    {
+        if (listening)
+        {
+            return false;
+        }
+        for (const auto& device : devices)
+        {
+            if (device->Active())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void Simulator::Run()
+    {
+        auto period = std::chrono::milliseconds(options.tickMs);
+        auto next = std::chrono::steady_clock::now();
+        while (true)
+        {
+            int64_t now = NowUs();
+            bool discovered = false;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                for (size_t i = 0; listening && i < devices.size(); i++)
+                {
+                    int64_t dueUs = listenStartUs + static_cast<int64_t>(options.discoverySeconds * 1e6 * static_cast<double>(i + 1));
+                    if (discoveredUs[i] == INT64_MAX && now >= dueUs)
+                    {
+                        discoveredUs[i] = now;
+                        discovered = true;
+                    }
+                }
+            }
+            IxApiCallback listener = museListener.load();
+            if (discovered && listener != nullptr)
+            {
+                listener("{}");
+            }
+
+            for (auto& device : devices)
+            {
+                if (device->Active())
+                {
+                    device->Tick(now, *this);
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (Idle())
+                {
+                    running = false;
+                    return;
+                }
+            }
+
+            next += period;
+            auto current = std::chrono::steady_clock::now();
+            if (next < current)
+            {
+                // Fell behind (overloaded host or heavy listeners): catch up in one larger tick
+                next = current;
+            }
+            std::this_thread::sleep_until(next);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "VirtualDevice.h"
+
+namespace LibmuseSimulator
+{
+    /// <summary>
+    /// Process-wide stand-in for the libmuse MuseManager. Owns the virtual devices and an engine thread
+    /// that ticks them on a simulated clock running at options.speed times real time. The engine runs
+    /// only while listening or while any device is active, so an idle process has no extra thread.
+    /// </summary>
+    class Simulator
+    {
+    public:
+        static Simulator& Instance();
+
+        /// <summary>
+        /// Replaces the options and recreates the devices; fails while any device is connecting or connected
+        /// </summary>
+        void Configure(const std::string& text);
+
+        void StartListening();
+        void StopListening();
+        void SetMuseListener(IxApiCallback listener);
+        void SetLogListener(IxApiCallback listener);
+
+        /// <summary>
+        /// JSON array of discovered devices, in the shape MuseManager.GetMuses deserialises
+        /// </summary>
+        std::string MusesJson();
+
+        /// <summary>
+        /// Looks up a device by MAC address; throws std::invalid_argument for unknown addresses
+        /// </summary>
+        VirtualDevice& Device(const char* macAddress);
+
+        /// <summary>
+        /// Starts the engine thread if it is not running; call after queueing a device request
+        /// </summary>
+        void Wake();
+
+        int64_t NowUs() const;
+        double DiscoveredTime(const VirtualDevice& device);
+        void Log(int severity, const char* tag, const std::string& message);
+        const SimulatorOptions& Options() const { return options; }
+
+    private:
+        Simulator();
+
+        void CreateDevices();
+        bool Idle() const;
+        void Run();
+
+        SimulatorOptions options;
+        std::vector<std::unique_ptr<VirtualDevice>> devices;
+        std::vector<int64_t> discoveredUs;
+
+        mutable std::mutex lock;
+        std::thread worker;
+        bool running = false;
+        bool listening = false;
+        int64_t listenStartUs = 0;
+        std::atomic<IxApiCallback> museListener{ nullptr };
+        std::atomic<IxApiCallback> logListener{ nullptr };
+
+        int64_t originUs;
+        int64_t originSteadyNs;
+    };
+
+    /// <summary>
+    /// Escapes a string for embedding in the JSON passed to listeners
+    /// </summary>
+    std::string JsonString(const std::string& text);
+}
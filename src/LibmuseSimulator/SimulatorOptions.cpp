@@ -0,0 +1,87 @@
+// SimulatorOptions.cpp : Parses simulator settings.
+#include "pch.h"
+#include "SimulatorOptions.h"
+
+#include <cstdlib>
+
+namespace LibmuseSimulator
+{
+    namespace
+    {
+        std::string Trim(const std::string& text)
+        {
+            size_t first = text.find_first_not_of(" \t");
+            size_t last = text.find_last_not_of(" \t");
+            return first == std::string::npos ? std::string() : text.substr(first, last - first + 1);
+        }
+
+        double ToNumber(const std::string& key, const std::string& value)
+        {
+            char* end = nullptr;
+            double number = std::strtod(value.c_str(), &end);
+            if (value.empty() || *end != '\0' || !std::isfinite(number) || number < 0.0)
+            {
+                throw std::invalid_argument("Invalid value '" + value + "' for simulator option " + key);
+            }
+            return number;
+        }
+
+        struct Setting
+        {
+            const char* key;
+            void (*apply)(SimulatorOptions& options, double value);
+        };
+
+        const Setting settings[] =
+        {
+            { "devices", [](SimulatorOptions& o, double v) { o.devices = std::clamp(static_cast<int>(v), 1, 1024); } },
+            { "speed", [](SimulatorOptions& o, double v) { o.speed = std::max(v, 0.01); } },
+            { "seed", [](SimulatorOptions& o, double v) { o.seed = static_cast<uint32_t>(v); } },
+            { "eegChannels", [](SimulatorOptions& o, double v) { o.eegChannels = std::clamp(static_cast<int>(v), 1, 8); } },
+            { "eegRate", [](SimulatorOptions& o, double v) { o.eegRate = std::max(v, 1.0); } },
+            { "bandRate", [](SimulatorOptions& o, double v) { o.bandRate = std::max(v, 0.1); } },
+            { "motionRate", [](SimulatorOptions& o, double v) { o.motionRate = v; } },
+            { "batteryRate", [](SimulatorOptions& o, double v) { o.batteryRate = v; } },
+            { "noise", [](SimulatorOptions& o, double v) { o.noise = v; } },
+            { "blinksPerMinute", [](SimulatorOptions& o, double v) { o.blinksPerMinute = v; } },
+            { "jawClenchesPerMinute", [](SimulatorOptions& o, double v) { o.jawClenchesPerMinute = v; } },
+            { "packetLoss", [](SimulatorOptions& o, double v) { o.packetLoss = std::min(v, 1.0); } },
+            { "disconnectsPerHour", [](SimulatorOptions& o, double v) { o.disconnectsPerHour = v; } },
+            { "connectFailure", [](SimulatorOptions& o, double v) { o.connectFailure = std::min(v, 1.0); } },
+            { "connectSeconds", [](SimulatorOptions& o, double v) { o.connectSeconds = v; } },
+            { "discoverySeconds", [](SimulatorOptions& o, double v) { o.discoverySeconds = v; } },
+            { "tickMs", [](SimulatorOptions& o, double v) { o.tickMs = std::clamp(static_cast<int>(v), 1, 1000); } },
+        };
+    }
+
+    void SimulatorOptions::Parse(const std::string& text)
+    {
+        size_t start = 0;
+        while (start <= text.size())
+        {
+            size_t end = text.find_first_of(";,", start);
+            std::string pair = Trim(text.substr(start, end == std::string::npos ? std::string::npos : end - start));
+            start = end == std::string::npos ? text.size() + 1 : end + 1;
+            if (pair.empty())
+            {
+                continue;
+            }
+
+            size_t equals = pair.find('=');
+            if (equals == std::string::npos)
+            {
+                throw std::invalid_argument("Simulator option '" + pair + "' is not key=value");
+            }
+            std::string key = Trim(pair.substr(0, equals));
+            double value = ToNumber(key, Trim(pair.substr(equals + 1)));
+
+            auto setting = std::find_if(std::begin(settings), std::end(settings),
+                [&](const Setting& candidate) { return key == candidate.key; });
+            if (setting == std::end(settings))
+            {
+                throw std::invalid_argument("Unknown simulator option " + key);
+            }
+            setting->apply(*this, value);
+        }
+    }
+}
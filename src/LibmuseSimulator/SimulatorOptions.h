@@ -0,0 +1,34 @@
+#pragma once
+
+namespace LibmuseSimulator
+{
+    /// <summary>
+    /// Simulation parameters, set from a "key=value;key=value" string passed to IxSimConfigure or
+    /// read from the LIBMUSE_SIM_OPTIONS environment variable on first use
+    /// </summary>
+    struct SimulatorOptions
+    {
+        int devices = 1;                    // virtual headbands advertised
+        double speed = 1.0;                 // simulated seconds per wall-clock second
+        uint32_t seed = 1;
+        int eegChannels = 4;                // TP9, AF7, AF8, TP10
+        double eegRate = 256.0;             // Hz
+        double bandRate = 10.0;             // band powers, scores, IsGood, HSI and artifacts
+        double motionRate = 52.0;           // accelerometer and gyro
+        double batteryRate = 0.1;
+        double noise = 6.0;                 // 1/f background amplitude, microvolts
+        double blinksPerMinute = 15.0;
+        double jawClenchesPerMinute = 2.0;
+        double packetLoss = 0.0;            // probability that an EEG sample is replaced by a DroppedEeg packet
+        double disconnectsPerHour = 0.0;    // spontaneous link drops while connected
+        double connectFailure = 0.0;        // probability that a connection attempt times out
+        double connectSeconds = 1.5;        // simulated time spent in Connecting
+        double discoverySeconds = 0.2;      // stagger between devices appearing after IxStartListening
+        int tickMs = 4;                     // engine period; packets due within a tick are delivered together
+
+        /// <summary>
+        /// Applies "key=value" pairs separated by ';' or ','; throws std::invalid_argument on unknown keys or bad values
+        /// </summary>
+        void Parse(const std::string& text);
+    };
+}
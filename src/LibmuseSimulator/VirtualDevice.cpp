@@ -0,0 +1,369 @@
+// VirtualDevice.cpp : Connection state machine and packet generation for one simulated headband.
+#include "pch.h"
+#include "Simulator.h"
+#include "VirtualDevice.h"
+
+#include <cstdio>
+
+namespace LibmuseSimulator
+{
+    namespace
+    {
+        constexpr int ErrorTypeTimeout = 1;
+
+        template <typename T>
+        void AddUnique(std::vector<T>& items, T item)
+        {
+            if (item != nullptr && std::find(items.begin(), items.end(), item) == items.end())
+            {
+                items.push_back(item);
+            }
+        }
+
+        template <typename T>
+        void Remove(std::vector<T>& items, T item)
+        {
+            items.erase(std::remove(items.begin(), items.end(), item), items.end());
+        }
+
+        MuseDataPacketType Offset(MuseDataPacketType first, int band)
+        {
+            return static_cast<MuseDataPacketType>(static_cast<int>(first) + band);
+        }
+    }
+
+    VirtualDevice::VirtualDevice(int index, const SimulatorOptions& options)
+        : options(options),
+          random(options.seed * 7919u + static_cast<uint32_t>(index)),
+          batteryPercent(95.0 - (index % 10) * 3.0)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "00:55:DA:B0:%02X:%02X", (index >> 8) & 0xFF, index & 0xFF);
+        mac = buffer;
+        std::snprintf(buffer, sizeof(buffer), "MuseS-SIM%d", index + 1);
+        name = buffer;
+        rssi = -45.0 - static_cast<double>(random() % 40);
+    }
+
+    bool VirtualDevice::Active() const
+    {
+        ConnectionState current = state.load();
+        if (current == ConnectionState::Connecting || current == ConnectionState::Connected)
+        {
+            return true;
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        return connectRequested;
+    }
+
+    void VirtualDevice::AddConnectionListener(IxApiCallback listener)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        AddUnique(listeners.connection, listener);
+        listenersVersion++;
+    }
+
+    void VirtualDevice::RemoveConnectionListener(IxApiCallback listener)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        Remove(listeners.connection, listener);
+        listenersVersion++;
+    }
+
+    void VirtualDevice::AddErrorListener(IxApiCallback listener)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        AddUnique(listeners.error, listener);
+        listenersVersion++;
+    }
+
+    void VirtualDevice::RemoveErrorListener(IxApiCallback listener)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        Remove(listeners.error, listener);
+        listenersVersion++;
+    }
+
+    void VirtualDevice::AddDataListener(MuseDataPacketType type, IxDataCallback listener)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        AddUnique(listeners.data[static_cast<size_t>(type)], listener);
+        listenersVersion++;
+    }
+
+    void VirtualDevice::RemoveDataListener(MuseDataPacketType type, IxDataCallback listener)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        Remove(listeners.data[static_cast<size_t>(type)], listener);
+        listenersVersion++;
+    }
+
+    void VirtualDevice::RemoveAllListeners()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        listeners = Listeners();
+        listenersVersion++;
+    }
+
+    void VirtualDevice::RequestConnect()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        connectRequested = true;
+        disconnectRequested = false;
+    }
+
+    void VirtualDevice::RequestDisconnect()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        disconnectRequested = true;
+        connectRequested = false;
+    }
+
+    void VirtualDevice::EnableDataTransmission(bool enable)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        transmitting = enable;
+    }
+
+    void VirtualDevice::SetState(ConnectionState next, Simulator& simulator)
+    {
+        ConnectionState previous = state.exchange(next);
+        if (previous == next)
+        {
+            return;
+        }
+        char json[160];
+        std::snprintf(json, sizeof(json), "{\"previousConnectionState\":%d,\"currentConnectionState\":%d,\"bluetoothMac\":\"%s\"}",
+            static_cast<int>(previous), static_cast<int>(next), mac.c_str());
+        for (IxApiCallback listener : snapshot.connection)
+        {
+            listener(json);
+        }
+        static const char* const names[] = { "unknown", "connected", "connecting", "disconnected", "needs update", "needs license" };
+        simulator.Log(1, "sim", name + " " + names[static_cast<int>(next)]);
+    }
+
+    void VirtualDevice::Emit(MuseDataPacketType type, const double* values, int count, int64_t timestampUs)
+    {
+        for (IxDataCallback listener : snapshot.data[static_cast<size_t>(type)])
+        {
+            listener(static_cast<int>(type), values, count, timestampUs, mac.c_str());
+        }
+    }
+
+    void VirtualDevice::EmitBands(int64_t timestampUs)
+    {
+        using Type = MuseDataPacketType;
+        constexpr int Bands = SignalGenerator::BandCount;
+        int channels = std::min(options.eegChannels, SignalGenerator::MaxChannels);
+        double t = Seconds(timestampUs);
+
+        double absolute[Bands][SignalGenerator::MaxChannels];
+        generator->BandPowers(t, absolute);
+        for (int band = 0; band < Bands; band++)
+        {
+            Emit(Offset(Type::AlphaAbsolute, band), absolute[band], channels, timestampUs);
+        }
+
+        double relative[Bands][SignalGenerator::MaxChannels];
+        for (int channel = 0; channel < channels; channel++)
+        {
+            double total = 0.0;
+            for (int band = 0; band < Bands; band++)
+            {
+                relative[band][channel] = std::pow(10.0, absolute[band][channel]);
+                total += relative[band][channel];
+            }
+            for (int band = 0; band < Bands; band++)
+            {
+                relative[band][channel] /= total;
+            }
+        }
+        for (int band = 0; band < Bands; band++)
+        {
+            Emit(Offset(Type::AlphaRelative, band), relative[band], channels, timestampUs);
+        }
+
+        // Scores compare the relative power with its recent average, as libmuse does with session history
+        double scores[Bands][SignalGenerator::MaxChannels];
+        for (int band = 0; band < Bands; band++)
+        {
+            double mean = 0.0;
+            for (int channel = 0; channel < channels; channel++)
+            {
+                mean += relative[band][channel] / channels;
+            }
+            double& baseline = scoreBaseline[static_cast<size_t>(band)];
+            baseline = baseline == 0.0 ? mean : baseline + (mean - baseline) * 0.01;
+            for (int channel = 0; channel < channels; channel++)
+            {
+                scores[band][channel] = 0.5 + 0.5 * std::tanh((relative[band][channel] - baseline) / 0.05);
+            }
+        }
+        for (int band = 0; band < Bands; band++)
+        {
+            Emit(Offset(Type::AlphaScore, band), scores[band], channels, timestampUs);
+        }
+
+        bool blink = generator->Blinking(t);
+        bool clench = generator->JawClenched(t);
+        double good[SignalGenerator::MaxChannels];
+        double horseshoe[SignalGenerator::MaxChannels];
+        for (int channel = 0; channel < channels; channel++)
+        {
+            bool disturbed = clench || (blink && (channel == 1 || channel == 2));
+            good[channel] = disturbed ? 0.0 : 1.0;
+            horseshoe[channel] = disturbed ? 2.0 : 1.0;
+        }
+        Emit(Type::IsGood, good, channels, timestampUs);
+        Emit(Type::Hsi, horseshoe, channels, timestampUs);
+        Emit(Type::HsiPrecision, horseshoe, channels, timestampUs);
+
+        double artifacts[3] = { 1.0, blink ? 1.0 : 0.0, clench ? 1.0 : 0.0 };
+        Emit(Type::Artifacts, artifacts, 3, timestampUs);
+    }
+
+    void VirtualDevice::Tick(int64_t nowUs, Simulator& simulator)
+    {
+        bool connect;
+        bool disconnect;
+        bool transmit;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (snapshotVersion != listenersVersion)
+            {
+                snapshot = listeners;
+                snapshotVersion = listenersVersion;
+            }
+            connect = connectRequested;
+            disconnect = disconnectRequested;
+            connectRequested = false;
+            disconnectRequested = false;
+            transmit = transmitting;
+        }
+
+        ConnectionState current = state.load();
+        bool linked = current == ConnectionState::Connecting || current == ConnectionState::Connected;
+        if (disconnect && linked)
+        {
+            SetState(ConnectionState::Disconnected, simulator);
+        }
+        if (connect && !linked)
+        {
+            connectDueUs = nowUs + static_cast<int64_t>(options.connectSeconds * 1e6);
+            SetState(ConnectionState::Connecting, simulator);
+        }
+
+        if (state.load() == ConnectionState::Connecting && nowUs >= connectDueUs)
+        {
+            if (std::uniform_real_distribution<double>(0.0, 1.0)(random) < options.connectFailure)
+            {
+                char json[192];
+                std::snprintf(json, sizeof(json), "{\"type\":%d,\"code\":0,\"info\":\"Connection attempt timed out\",\"bluetoothMac\":\"%s\"}",
+                    ErrorTypeTimeout, mac.c_str());
+                for (IxApiCallback listener : snapshot.error)
+                {
+                    listener(json);
+                }
+                SetState(ConnectionState::Disconnected, simulator);
+                return;
+            }
+
+            connectedUs = connectDueUs;
+            generator = std::make_unique<SignalGenerator>(options, static_cast<uint32_t>(random()));
+            eeg.Start(options.eegRate, connectedUs);
+            bands.Start(options.bandRate, connectedUs);
+            motion.Start(options.motionRate, connectedUs);
+            battery.Start(options.batteryRate, connectedUs);
+            droppedEeg = 0;
+            scoreBaseline = {};
+            disconnectDueUs = options.disconnectsPerHour > 0.0
+                ? connectedUs + static_cast<int64_t>(std::exponential_distribution<double>(options.disconnectsPerHour / 3600.0)(random) * 1e6)
+                : INT64_MAX;
+            SetState(ConnectionState::Connected, simulator);
+        }
+
+        if (state.load() != ConnectionState::Connected)
+        {
+            return;
+        }
+        if (nowUs >= disconnectDueUs)
+        {
+            simulator.Log(2, "sim", name + " lost the Bluetooth link");
+            SetState(ConnectionState::Disconnected, simulator);
+            return;
+        }
+
+        generator->Advance(Seconds(nowUs));
+        const auto& data = snapshot.data;
+        auto wants = [&](MuseDataPacketType type) { return transmit && !data[static_cast<size_t>(type)].empty(); };
+        int channels = std::min(options.eegChannels, SignalGenerator::MaxChannels);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        double values[SignalGenerator::MaxChannels];
+
+        bool eegWanted = wants(MuseDataPacketType::Eeg) || wants(MuseDataPacketType::DroppedEeg);
+        for (; eeg.Due(nowUs); eeg.count++)
+        {
+            if (!eegWanted)
+            {
+                continue;
+            }
+            int64_t timestampUs = eeg.NextUs();
+            if (options.packetLoss > 0.0 && unit(random) < options.packetLoss)
+            {
+                droppedEeg++;
+                continue;
+            }
+            if (droppedEeg > 0)
+            {
+                double dropped = static_cast<double>(droppedEeg);
+                Emit(MuseDataPacketType::DroppedEeg, &dropped, 1, timestampUs);
+                droppedEeg = 0;
+            }
+            generator->Eeg(Seconds(timestampUs), values);
+            Emit(MuseDataPacketType::Eeg, values, channels, timestampUs);
+        }
+
+        bool bandsWanted = false;
+        for (int type = static_cast<int>(MuseDataPacketType::AlphaAbsolute); type <= static_cast<int>(MuseDataPacketType::Artifacts); type++)
+        {
+            bandsWanted = bandsWanted || wants(static_cast<MuseDataPacketType>(type));
+        }
+        for (; bands.Due(nowUs); bands.count++)
+        {
+            if (bandsWanted)
+            {
+                EmitBands(bands.NextUs());
+            }
+        }
+
+        bool motionWanted = wants(MuseDataPacketType::Accelerometer) || wants(MuseDataPacketType::Gyro);
+        for (; motion.Due(nowUs); motion.count++)
+        {
+            if (!motionWanted)
+            {
+                continue;
+            }
+            int64_t timestampUs = motion.NextUs();
+            double t = Seconds(timestampUs);
+            double sway = std::sin(t * 0.7) * 0.03;
+            double accelerometer[3] = { sway + 0.004 * (unit(random) - 0.5), 0.05, 0.99 + 0.004 * (unit(random) - 0.5) };
+            double gyro[3] = { std::cos(t * 0.7) * 1.2 + unit(random) - 0.5, unit(random) - 0.5, unit(random) - 0.5 };
+            Emit(MuseDataPacketType::Accelerometer, accelerometer, 3, timestampUs);
+            Emit(MuseDataPacketType::Gyro, gyro, 3, timestampUs);
+        }
+
+        for (; battery.Due(nowUs); battery.count++)
+        {
+            // Drains about 6% per simulated hour
+            double percent = std::max(0.0, batteryPercent.load(std::memory_order_relaxed) - 6.0 / 3600.0 / options.batteryRate);
+            batteryPercent.store(percent, std::memory_order_relaxed);
+            double millivolts = 3300.0 + 9.0 * percent;
+            double status[4] = { percent, millivolts, millivolts, 31.5 };
+            if (wants(MuseDataPacketType::Battery))
+            {
+                Emit(MuseDataPacketType::Battery, status, 4, battery.NextUs());
+            }
+        }
+    }
+}
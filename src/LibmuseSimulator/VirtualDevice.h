@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Libmuse.h"
+#include "MuseTypes.h"
+#include "SignalGenerator.h"
+
+namespace LibmuseSimulator
+{
+    using MuseWrapper::ConnectionState;
+    using MuseWrapper::MuseDataPacketType;
+    using MuseWrapper::PacketTypeCount;
+
+    class Simulator;
+
+    /// <summary>
+    /// One simulated headband. API calls only record requests and listener changes under the device
+    /// lock; the engine thread applies connection transitions and generates packets in Tick, invoking
+    /// listeners without holding the lock, as libmuse does from its own threads.
+    /// </summary>
+    class VirtualDevice
+    {
+    public:
+        VirtualDevice(int index, const SimulatorOptions& options);
+
+        const std::string& Mac() const { return mac; }
+        const std::string& Name() const { return name; }
+        double Rssi() const { return rssi; }
+        ConnectionState State() const { return state.load(); }
+        double BatteryPercent() const { return batteryPercent.load(std::memory_order_relaxed); }
+
+        std::atomic<int> preset{ 0 };
+        std::atomic<int> notchFrequency{ 1 };
+
+        /// <summary>
+        /// Whether the device needs engine ticks (connecting, connected or a request is pending)
+        /// </summary>
+        bool Active() const;
+
+        void AddConnectionListener(IxApiCallback listener);
+        void RemoveConnectionListener(IxApiCallback listener);
+        void AddErrorListener(IxApiCallback listener);
+        void RemoveErrorListener(IxApiCallback listener);
+        void AddDataListener(MuseDataPacketType type, IxDataCallback listener);
+        void RemoveDataListener(MuseDataPacketType type, IxDataCallback listener);
+        void RemoveAllListeners();
+
+        void RequestConnect();
+        void RequestDisconnect();
+        void EnableDataTransmission(bool enable);
+
+        /// <summary>
+        /// Engine thread only: applies pending requests and emits every packet due up to nowUs
+        /// </summary>
+        void Tick(int64_t nowUs, Simulator& simulator);
+
+    private:
+        struct Listeners
+        {
+            std::vector<IxApiCallback> connection;
+            std::vector<IxApiCallback> error;
+            std::array<std::vector<IxDataCallback>, PacketTypeCount> data;
+        };
+
+        // Timestamps of a fixed-rate stream derived from a sample counter so they never drift
+        struct Stream
+        {
+            double rate = 0.0;
+            int64_t originUs = 0;
+            int64_t count = 0;
+
+            void Start(double hz, int64_t nowUs) { rate = hz; originUs = nowUs; count = 0; }
+            bool Due(int64_t nowUs) const { return rate > 0.0 && NextUs() <= nowUs; }
+            int64_t NextUs() const { return originUs + static_cast<int64_t>(static_cast<double>(count) * 1e6 / rate); }
+        };
+
+        void SetState(ConnectionState next, Simulator& simulator);
+        void Emit(MuseDataPacketType type, const double* values, int count, int64_t timestampUs);
+        void EmitBands(int64_t timestampUs);
+        double Seconds(int64_t timestampUs) const { return static_cast<double>(timestampUs - connectedUs) / 1e6; }
+
+        const SimulatorOptions& options;
+        std::string mac;
+        std::string name;
+        double rssi;
+        std::atomic<ConnectionState> state{ ConnectionState::Disconnected };
+
+        mutable std::mutex lock;
+        Listeners listeners;
+        uint64_t listenersVersion = 0;
+        bool connectRequested = false;
+        bool disconnectRequested = false;
+        bool transmitting = true;
+
+        // Engine-thread state
+        Listeners snapshot;
+        uint64_t snapshotVersion = UINT64_MAX;
+        std::mt19937 random;
+        std::unique_ptr<SignalGenerator> generator;
+        int64_t connectDueUs = 0;
+        int64_t disconnectDueUs = INT64_MAX;
+        int64_t connectedUs = 0;
+        Stream eeg;
+        Stream bands;
+        Stream motion;
+        Stream battery;
+        int64_t droppedEeg = 0;
+        std::atomic<double> batteryPercent;
+        std::array<double, SignalGenerator::BandCount> scoreBaseline = {};
+    };
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
+#define NOMINMAX                        // Keep std::min/std::max usable
+// Windows Header Files
+#include <windows.h>
+#endif
@@ -0,0 +1,91 @@
+// AllocationApi.cpp : Exported entry points for the allocation-tracking build mode.
+#include "pch.h"
+#include "AllocationTracking.h"
+#include "ApiSupport.h"
+
+#include <cstdio>
+
+using namespace MuseWrapper;
+
+namespace
+{
+    void RequireTracking()
+    {
+        Require(AllocationTracking::CompiledIn,
+            "This MuseWrapper build does not track allocations; rebuild with MUSEWRAPPER_ALLOCATION_TRACKING defined");
+    }
+}
+
+int MwAllocationReset(int captureCallSites, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        RequireTracking();
+        AllocationTracking::Reset(captureCallSites != 0);
+        return MW_OK;
+    });
+}
+
+int MwAllocationGetStats(MwAllocationStats* statsOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        RequireTracking();
+        Require(statsOut != nullptr, "statsOut is required");
+        AllocationTracking::Totals totals = AllocationTracking::GetTotals();
+        statsOut->allocations = static_cast<int64_t>(totals.allocations);
+        statsOut->frees = static_cast<int64_t>(totals.frees);
+        statsOut->bytesAllocated = static_cast<int64_t>(totals.bytesAllocated);
+        statsOut->liveBytes = static_cast<int64_t>(totals.liveBytes);
+        statsOut->peakBytes = static_cast<int64_t>(totals.peakBytes);
+        statsOut->poolAllocations = static_cast<int64_t>(totals.poolAllocations);
+        statsOut->poolBytesAllocated = static_cast<int64_t>(totals.poolBytesAllocated);
+        statsOut->poolLiveBytes = static_cast<int64_t>(totals.poolLiveBytes);
+        statsOut->elapsedNs = static_cast<int64_t>(totals.elapsedNs);
+        return MW_OK;
+    });
+}
+
+int MwAllocationGetStage(int index, char* nameOut, int nameLen, MwAllocationStageStats* statsOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        RequireTracking();
+        Require(index >= 0, "index must not be negative");
+        Require(statsOut != nullptr, "statsOut is required");
+        std::vector<AllocationTracking::StageTotals> stages = AllocationTracking::Stages();
+        if (static_cast<size_t>(index) >= stages.size())
+        {
+            return MW_NO_DATA;
+        }
+        const AllocationTracking::StageTotals& stage = stages[static_cast<size_t>(index)];
+        WriteError(nameOut, nameLen, stage.name);    // same truncating copy the name needs
+        statsOut->allocations = static_cast<int64_t>(stage.allocations);
+        statsOut->bytes = static_cast<int64_t>(stage.bytes);
+        statsOut->poolAllocations = static_cast<int64_t>(stage.poolAllocations);
+        statsOut->poolBytes = static_cast<int64_t>(stage.poolBytes);
+        return MW_OK;
+    });
+}
+
+int MwAllocationWriteReport(const char* path, int callSites, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        RequireTracking();
+        Require(path != nullptr, "path is required");
+        Require(callSites >= 0, "callSites must not be negative");
+        std::string report = AllocationTracking::Report(static_cast<size_t>(callSites));
+        std::FILE* file = std::fopen(path, "wb");
+        if (file == nullptr)
+        {
+            throw std::runtime_error(std::string("Cannot create allocation report ") + path);
+        }
+        bool written = std::fwrite(report.data(), 1, report.size(), file) == report.size();
+        if (std::fclose(file) != 0 || !written)
+        {
+            throw std::runtime_error(std::string("Failed to write allocation report ") + path);
+        }
+        return MW_OK;
+    });
+}
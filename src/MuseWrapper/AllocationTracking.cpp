@@ -0,0 +1,458 @@
+#include "pch.h"
+#include "AllocationTracking.h"
+#include "Clock.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <malloc.h>
+#endif
+
+namespace MuseWrapper
+{
+    namespace AllocationTracking
+    {
+        namespace
+        {
+            constexpr size_t CallSiteSlots = 4096;     // power of two
+            constexpr size_t CallSiteProbes = 32;
+            constexpr int SkippedFrames = 3;            // CaptureCallSite, RecordAllocation, operator new
+
+            struct StageCounters
+            {
+                std::atomic<const char*> name{ nullptr };
+                std::atomic<uint64_t> allocations{ 0 };
+                std::atomic<uint64_t> bytes{ 0 };
+                std::atomic<uint64_t> poolAllocations{ 0 };
+                std::atomic<uint64_t> poolBytes{ 0 };
+            };
+
+            struct CallSiteSlot
+            {
+                std::atomic<uint64_t> key{ 0 };
+                std::atomic<bool> ready{ false };       // frames written
+                std::array<void*, CallSiteFrames> frames = {};
+                std::atomic<int> stage{ 0 };
+                std::atomic<uint64_t> allocations{ 0 };
+                std::atomic<uint64_t> bytes{ 0 };
+            };
+
+            std::array<StageCounters, MaxStages> stages;
+            std::atomic<int> stageCount{ 1 };
+            std::mutex registerLock;
+
+            std::array<CallSiteSlot, CallSiteSlots> callSites;
+            std::atomic<bool> captureCallSites{ false };
+            std::atomic<uint64_t> unrecordedCallSites{ 0 };
+
+            std::atomic<uint64_t> allocations{ 0 };
+            std::atomic<uint64_t> frees{ 0 };
+            std::atomic<uint64_t> bytesAllocated{ 0 };
+            std::atomic<int64_t> liveBytes{ 0 };
+            std::atomic<int64_t> peakBytes{ 0 };
+            std::atomic<uint64_t> poolAllocations{ 0 };
+            std::atomic<uint64_t> poolBytesAllocated{ 0 };
+            std::atomic<int64_t> poolLiveBytes{ 0 };
+            std::atomic<uint64_t> resetNs{ MonotonicNanoseconds() };
+
+            thread_local int currentStage = 0;
+            thread_local bool capturing = false;        // stack capture may itself allocate
+
+            int CaptureFrames(void** frames, int count)
+            {
+#ifdef _WIN32
+                return CaptureStackBackTrace(SkippedFrames, static_cast<DWORD>(count), frames, nullptr);
+#else
+                void* raw[CallSiteFrames + SkippedFrames];
+                int captured = backtrace(raw, count + SkippedFrames);
+                int kept = std::max(0, captured - SkippedFrames);
+                std::copy_n(raw + SkippedFrames, kept, frames);
+                return kept;
+#endif
+            }
+
+            void CaptureCallSite(size_t bytes, int stage)
+            {
+                capturing = true;
+                std::array<void*, CallSiteFrames> frames = {};
+                CaptureFrames(frames.data(), CallSiteFrames);
+                capturing = false;
+
+                // FNV-1a over the return addresses; 0 marks an empty slot
+                uint64_t key = 14695981039346656037ull;
+                for (void* frame : frames)
+                {
+                    key = (key ^ reinterpret_cast<uintptr_t>(frame)) * 1099511628211ull;
+                }
+                key |= 1;
+
+                for (size_t probe = 0; probe < CallSiteProbes; probe++)
+                {
+                    CallSiteSlot& slot = callSites[(key + probe) & (CallSiteSlots - 1)];
+                    uint64_t existing = slot.key.load(std::memory_order_acquire);
+                    if (existing == 0)
+                    {
+                        if (slot.key.compare_exchange_strong(existing, key, std::memory_order_acq_rel))
+                        {
+                            slot.frames = frames;
+                            slot.stage.store(stage, std::memory_order_relaxed);
+                            slot.ready.store(true, std::memory_order_release);
+                            existing = key;
+                        }
+                    }
+                    if (existing == key)
+                    {
+                        slot.allocations.fetch_add(1, std::memory_order_relaxed);
+                        slot.bytes.fetch_add(bytes, std::memory_order_relaxed);
+                        return;
+                    }
+                }
+                unrecordedCallSites.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void RaisePeak(int64_t live)
+            {
+                int64_t peak = peakBytes.load(std::memory_order_relaxed);
+                while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+                {
+                }
+            }
+
+            std::string DescribeFrame(void* frame)
+            {
+                char text[512];
+#ifdef _WIN32
+                HMODULE module = nullptr;
+                char path[MAX_PATH] = "?";
+                if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                    static_cast<LPCSTR>(frame), &module))
+                {
+                    GetModuleFileNameA(module, path, MAX_PATH);
+                }
+                const char* name = std::strrchr(path, '\\') ? std::strrchr(path, '\\') + 1 : path;
+                std::snprintf(text, sizeof(text), "%s+0x%llx", name,
+                    static_cast<unsigned long long>(static_cast<const char*>(frame) - reinterpret_cast<const char*>(module)));
+#else
+                Dl_info info = {};
+                if (dladdr(frame, &info) == 0 || info.dli_fname == nullptr)
+                {
+                    std::snprintf(text, sizeof(text), "%p", frame);
+                    return text;
+                }
+                const char* name = std::strrchr(info.dli_fname, '/') ? std::strrchr(info.dli_fname, '/') + 1 : info.dli_fname;
+                std::snprintf(text, sizeof(text), "%s+0x%llx%s%s", name,
+                    static_cast<unsigned long long>(static_cast<const char*>(frame) - static_cast<const char*>(info.dli_fbase)),
+                    info.dli_sname ? " " : "", info.dli_sname ? info.dli_sname : "");
+#endif
+                return text;
+            }
+        }
+
+        int RegisterStage(const char* name)
+        {
+            std::lock_guard<std::mutex> guard(registerLock);
+            int count = stageCount.load(std::memory_order_relaxed);
+            for (int i = 1; i < count; i++)
+            {
+                if (std::strcmp(stages[static_cast<size_t>(i)].name.load(std::memory_order_relaxed), name) == 0)
+                {
+                    return i;
+                }
+            }
+            if (count == MaxStages)
+            {
+                return 0;
+            }
+            stages[static_cast<size_t>(count)].name.store(name, std::memory_order_relaxed);
+            stageCount.store(count + 1, std::memory_order_release);
+            return count;
+        }
+
+        void RecordAllocation(size_t bytes)
+        {
+            allocations.fetch_add(1, std::memory_order_relaxed);
+            bytesAllocated.fetch_add(bytes, std::memory_order_relaxed);
+            RaisePeak(liveBytes.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed) + static_cast<int64_t>(bytes));
+            StageCounters& stage = stages[static_cast<size_t>(currentStage)];
+            stage.allocations.fetch_add(1, std::memory_order_relaxed);
+            stage.bytes.fetch_add(bytes, std::memory_order_relaxed);
+            if (captureCallSites.load(std::memory_order_relaxed) && !capturing)
+            {
+                CaptureCallSite(bytes, currentStage);
+            }
+        }
+
+        void RecordFree(size_t bytes)
+        {
+            frees.fetch_add(1, std::memory_order_relaxed);
+            liveBytes.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+        }
+
+        void RecordPoolAllocation(size_t bytes)
+        {
+            poolAllocations.fetch_add(1, std::memory_order_relaxed);
+            poolBytesAllocated.fetch_add(bytes, std::memory_order_relaxed);
+            poolLiveBytes.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+            StageCounters& stage = stages[static_cast<size_t>(currentStage)];
+            stage.poolAllocations.fetch_add(1, std::memory_order_relaxed);
+            stage.poolBytes.fetch_add(bytes, std::memory_order_relaxed);
+        }
+
+        void RecordPoolFree(size_t bytes)
+        {
+            poolLiveBytes.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+        }
+
+        void Reset(bool captureSites)
+        {
+            // Other threads keep allocating throughout, so a reset is only as exact as the moment it lands
+            captureCallSites.store(false, std::memory_order_relaxed);
+            allocations.store(0, std::memory_order_relaxed);
+            frees.store(0, std::memory_order_relaxed);
+            bytesAllocated.store(0, std::memory_order_relaxed);
+            peakBytes.store(liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            poolAllocations.store(0, std::memory_order_relaxed);
+            poolBytesAllocated.store(0, std::memory_order_relaxed);
+            for (StageCounters& stage : stages)
+            {
+                stage.allocations.store(0, std::memory_order_relaxed);
+                stage.bytes.store(0, std::memory_order_relaxed);
+                stage.poolAllocations.store(0, std::memory_order_relaxed);
+                stage.poolBytes.store(0, std::memory_order_relaxed);
+            }
+            for (CallSiteSlot& slot : callSites)
+            {
+                slot.allocations.store(0, std::memory_order_relaxed);
+                slot.bytes.store(0, std::memory_order_relaxed);
+            }
+            unrecordedCallSites.store(0, std::memory_order_relaxed);
+            resetNs.store(MonotonicNanoseconds(), std::memory_order_relaxed);
+            captureCallSites.store(captureSites, std::memory_order_relaxed);
+        }
+
+        Totals GetTotals()
+        {
+            Totals totals;
+            totals.allocations = allocations.load(std::memory_order_relaxed);
+            totals.frees = frees.load(std::memory_order_relaxed);
+            totals.bytesAllocated = bytesAllocated.load(std::memory_order_relaxed);
+            totals.liveBytes = static_cast<uint64_t>(std::max<int64_t>(0, liveBytes.load(std::memory_order_relaxed)));
+            totals.peakBytes = static_cast<uint64_t>(std::max<int64_t>(0, peakBytes.load(std::memory_order_relaxed)));
+            totals.poolAllocations = poolAllocations.load(std::memory_order_relaxed);
+            totals.poolBytesAllocated = poolBytesAllocated.load(std::memory_order_relaxed);
+            totals.poolLiveBytes = static_cast<uint64_t>(std::max<int64_t>(0, poolLiveBytes.load(std::memory_order_relaxed)));
+            totals.elapsedNs = MonotonicNanoseconds() - resetNs.load(std::memory_order_relaxed);
+            return totals;
+        }
+
+        std::vector<StageTotals> Stages()
+        {
+            std::vector<StageTotals> result;
+            int count = stageCount.load(std::memory_order_acquire);
+            for (int i = 0; i < count; i++)
+            {
+                const StageCounters& stage = stages[static_cast<size_t>(i)];
+                result.push_back({ i == 0 ? "(unstaged)" : stage.name.load(std::memory_order_relaxed),
+                    stage.allocations.load(std::memory_order_relaxed), stage.bytes.load(std::memory_order_relaxed),
+                    stage.poolAllocations.load(std::memory_order_relaxed), stage.poolBytes.load(std::memory_order_relaxed) });
+            }
+            return result;
+        }
+
+        std::vector<CallSite> TopCallSites(size_t count)
+        {
+            std::vector<CallSite> result;
+            for (const CallSiteSlot& slot : callSites)
+            {
+                uint64_t siteAllocations = slot.allocations.load(std::memory_order_relaxed);
+                if (siteAllocations != 0 && slot.ready.load(std::memory_order_acquire))
+                {
+                    int stage = slot.stage.load(std::memory_order_relaxed);
+                    result.push_back({ slot.frames, stage == 0 ? "(unstaged)" : stages[static_cast<size_t>(stage)].name.load(),
+                        siteAllocations, slot.bytes.load(std::memory_order_relaxed) });
+                }
+            }
+            std::sort(result.begin(), result.end(), [](const CallSite& a, const CallSite& b) { return a.allocations > b.allocations; });
+            result.resize(std::min(result.size(), count));
+            return result;
+        }
+
+        std::string Report(size_t callSiteCount)
+        {
+            Totals totals = GetTotals();
+            double seconds = std::max(1e-9, totals.elapsedNs / 1e9);
+            std::string report;
+            char line[512];
+            std::snprintf(line, sizeof(line),
+                "Heap: %llu allocations (%.1f/s), %llu frees, %llu bytes allocated, %llu live, %llu peak over %.1f s\n"
+                "Pools: %llu allocations (%.1f/s), %llu bytes allocated, %llu live\n\n",
+                static_cast<unsigned long long>(totals.allocations), totals.allocations / seconds,
+                static_cast<unsigned long long>(totals.frees), static_cast<unsigned long long>(totals.bytesAllocated),
+                static_cast<unsigned long long>(totals.liveBytes), static_cast<unsigned long long>(totals.peakBytes), seconds,
+                static_cast<unsigned long long>(totals.poolAllocations), totals.poolAllocations / seconds,
+                static_cast<unsigned long long>(totals.poolBytesAllocated), static_cast<unsigned long long>(totals.poolLiveBytes));
+            report += line;
+
+            std::snprintf(line, sizeof(line), "%-24s %12s %10s %14s %12s %10s\n", "stage", "allocations", "per sec", "bytes",
+                "pool allocs", "per sec");
+            report += line;
+            for (const StageTotals& stage : Stages())
+            {
+                if (stage.allocations == 0 && stage.poolAllocations == 0)
+                {
+                    continue;
+                }
+                std::snprintf(line, sizeof(line), "%-24s %12llu %10.1f %14llu %12llu %10.1f\n", stage.name,
+                    static_cast<unsigned long long>(stage.allocations), stage.allocations / seconds,
+                    static_cast<unsigned long long>(stage.bytes), static_cast<unsigned long long>(stage.poolAllocations),
+                    stage.poolAllocations / seconds);
+                report += line;
+            }
+
+            if (callSiteCount > 0)
+            {
+                if (!captureCallSites.load(std::memory_order_relaxed))
+                {
+                    report += "\nCall sites were not captured; reset with capture enabled to record them\n";
+                    return report;
+                }
+                report += "\nTop call sites (innermost frame first):\n";
+                for (const CallSite& site : TopCallSites(callSiteCount))
+                {
+                    std::snprintf(line, sizeof(line), "%12llu allocations %12llu bytes  [%s]\n",
+                        static_cast<unsigned long long>(site.allocations), static_cast<unsigned long long>(site.bytes), site.stage);
+                    report += line;
+                    for (void* frame : site.frames)
+                    {
+                        if (frame != nullptr)
+                        {
+                            report += "        " + DescribeFrame(frame) + "\n";
+                        }
+                    }
+                }
+                uint64_t unrecorded = unrecordedCallSites.load(std::memory_order_relaxed);
+                if (unrecorded != 0)
+                {
+                    std::snprintf(line, sizeof(line), "%llu allocations came from call sites the table had no room for\n",
+                        static_cast<unsigned long long>(unrecorded));
+                    report += line;
+                }
+            }
+            return report;
+        }
+
+        StageScope::StageScope(int stage) : previous(currentStage)
+        {
+            currentStage = stage;
+        }
+
+        StageScope::~StageScope()
+        {
+            currentStage = previous;
+        }
+    }
+}
+
+#ifdef MUSEWRAPPER_ALLOCATION_TRACKING
+
+// Replacing the global allocation functions here covers everything linked into this module: all of
+// MuseWrapper in the DLL, or the whole harness when MuseWrapper is linked statically
+namespace
+{
+    using MuseWrapper::AllocationTracking::RecordAllocation;
+    using MuseWrapper::AllocationTracking::RecordFree;
+
+    size_t UsableSize(void* p)
+    {
+#ifdef _WIN32
+        return _msize(p);
+#else
+        return malloc_usable_size(p);
+#endif
+    }
+
+    size_t UsableSizeAligned(void* p, size_t align)
+    {
+#ifdef _WIN32
+        return _aligned_msize(p, align, 0);
+#else
+        (void)align;
+        return malloc_usable_size(p);
+#endif
+    }
+
+    void* Allocate(size_t size)
+    {
+        void* p = std::malloc(size != 0 ? size : 1);
+        if (p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        RecordAllocation(UsableSize(p));
+        return p;
+    }
+
+    void* AllocateAligned(size_t size, std::align_val_t alignment)
+    {
+        size_t align = static_cast<size_t>(alignment);
+#ifdef _WIN32
+        void* p = _aligned_malloc(size != 0 ? size : 1, align);
+#else
+        void* p = nullptr;
+        if (posix_memalign(&p, std::max(align, sizeof(void*)), size != 0 ? size : 1) != 0)
+        {
+            p = nullptr;
+        }
+#endif
+        if (p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        RecordAllocation(UsableSizeAligned(p, align));
+        return p;
+    }
+
+    void Free(void* p)
+    {
+        if (p != nullptr)
+        {
+            RecordFree(UsableSize(p));
+            std::free(p);
+        }
+    }
+
+    void FreeAligned(void* p, std::align_val_t alignment)
+    {
+        if (p != nullptr)
+        {
+            RecordFree(UsableSizeAligned(p, static_cast<size_t>(alignment)));
+#ifdef _WIN32
+            _aligned_free(p);
+#else
+            std::free(p);
+#endif
+        }
+    }
+}
+
+void* operator new(size_t size) { return Allocate(size); }
+void* operator new[](size_t size) { return Allocate(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+
+void operator delete(void* p) noexcept { Free(p); }
+void operator delete[](void* p) noexcept { Free(p); }
+void operator delete(void* p, size_t) noexcept { Free(p); }
+void operator delete[](void* p, size_t) noexcept { Free(p); }
+void operator delete(void* p, std::align_val_t alignment) noexcept { FreeAligned(p, alignment); }
+void operator delete[](void* p, std::align_val_t alignment) noexcept { FreeAligned(p, alignment); }
+void operator delete(void* p, size_t, std::align_val_t alignment) noexcept { FreeAligned(p, alignment); }
+void operator delete[](void* p, size_t, std::align_val_t alignment) noexcept { FreeAligned(p, alignment); }
+
+#endif
@@ -0,0 +1,129 @@
+#pragma once
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Allocation accounting for the native pipeline. With MUSEWRAPPER_ALLOCATION_TRACKING defined the
+    /// module replaces the global operator new and delete, so every heap allocation is counted against
+    /// the stage the calling thread is in (MW_ALLOCATION_STAGE), along with live and peak bytes and,
+    /// optionally, the allocating call site. Arena and pool allocators report through RecordPoolAllocation
+    /// and RecordPoolFree so memory they hand out is visible too, counted separately from the heap.
+    ///
+    /// The steady-state goal is zero heap allocations per packet; stage counts divided by packets
+    /// ingested show where that is not yet met.
+    /// </summary>
+    namespace AllocationTracking
+    {
+        /// <summary>
+        /// True when MUSEWRAPPER_ALLOCATION_TRACKING was defined for this build
+        /// </summary>
+        constexpr bool CompiledIn =
+#ifdef MUSEWRAPPER_ALLOCATION_TRACKING
+            true;
+#else
+            false;
+#endif
+
+        constexpr int MaxStages = 64;
+        constexpr int CallSiteFrames = 4;
+
+        struct Totals
+        {
+            uint64_t allocations;
+            uint64_t frees;
+            uint64_t bytesAllocated;
+            uint64_t liveBytes;
+            uint64_t peakBytes;             // highest liveBytes since the last Reset
+            uint64_t poolAllocations;
+            uint64_t poolBytesAllocated;
+            uint64_t poolLiveBytes;
+            uint64_t elapsedNs;             // since the last Reset
+        };
+
+        struct StageTotals
+        {
+            const char* name;
+            uint64_t allocations;
+            uint64_t bytes;
+            uint64_t poolAllocations;
+            uint64_t poolBytes;
+        };
+
+        struct CallSite
+        {
+            std::array<void*, CallSiteFrames> frames;   // innermost first, starting at operator new's caller
+            const char* stage;                          // stage of the first allocation seen from this site
+            uint64_t allocations;
+            uint64_t bytes;
+        };
+
+        /// <summary>
+        /// Returns the index of a stage name, registering it on first use. Names must be string literals.
+        /// Index 0 is the unnamed stage threads start in.
+        /// </summary>
+        int RegisterStage(const char* name);
+
+        /// <summary>
+        /// Accounts a heap allocation or free of the given usable size to the calling thread's stage
+        /// </summary>
+        void RecordAllocation(size_t bytes);
+        void RecordFree(size_t bytes);
+
+        /// <summary>
+        /// Hooks for arena and pool allocators, called when they hand out or take back a block
+        /// </summary>
+        void RecordPoolAllocation(size_t bytes);
+        void RecordPoolFree(size_t bytes);
+
+        /// <summary>
+        /// Zeroes the counters (live bytes excepted) and restarts the per-second clock. Call-site capture
+        /// walks the stack on every allocation, so it is off unless asked for here.
+        /// </summary>
+        void Reset(bool captureCallSites);
+
+        Totals GetTotals();
+        std::vector<StageTotals> Stages();
+
+        /// <summary>
+        /// Call sites ordered by allocation count, most first
+        /// </summary>
+        std::vector<CallSite> TopCallSites(size_t count);
+
+        /// <summary>
+        /// Human-readable report: totals, per-stage counts and rates, and the top call sites with
+        /// module-relative addresses for symbolising offline
+        /// </summary>
+        std::string Report(size_t callSites);
+
+        /// <summary>
+        /// Attributes allocations on this thread to a stage until destroyed, then restores the previous one
+        /// </summary>
+        class StageScope
+        {
+        public:
+            explicit StageScope(int stage);
+            ~StageScope();
+
+            StageScope(const StageScope&) = delete;
+            StageScope& operator=(const StageScope&) = delete;
+
+        private:
+            int previous;
+        };
+    }
+}
+
+#define MW_ALLOCATION_CONCAT_INNER(a, b) a##b
+#define MW_ALLOCATION_CONCAT(a, b) MW_ALLOCATION_CONCAT_INNER(a, b)
+
+#ifdef MUSEWRAPPER_ALLOCATION_TRACKING
+#define MW_ALLOCATION_STAGE(name) \
+    static const int MW_ALLOCATION_CONCAT(allocationStageIndex, __LINE__) = ::MuseWrapper::AllocationTracking::RegisterStage(name); \
+    ::MuseWrapper::AllocationTracking::StageScope MW_ALLOCATION_CONCAT(allocationStage, __LINE__)(MW_ALLOCATION_CONCAT(allocationStageIndex, __LINE__))
+#define MW_ALLOCATION_POOL_ALLOCATE(bytes) ::MuseWrapper::AllocationTracking::RecordPoolAllocation(bytes)
+#define MW_ALLOCATION_POOL_FREE(bytes) ::MuseWrapper::AllocationTracking::RecordPoolFree(bytes)
+#else
+#define MW_ALLOCATION_STAGE(name) ((void)0)
+#define MW_ALLOCATION_POOL_ALLOCATE(bytes) ((void)0)
+#define MW_ALLOCATION_POOL_FREE(bytes) ((void)0)
+#endif
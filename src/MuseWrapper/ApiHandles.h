@@ -0,0 +1,34 @@
+#pragma once
+
+#include "ApiSupport.h"
+
+namespace MuseWrapper
+{
+    class BroadcastHub;
+    class DspPool;
+    class IngestPipeline;
+    class OverlaySource;
+    class PacketTimingMonitor;
+    class RecordingWriter;
+    class ReplayServer;
+    class TimerWheel;
+
+    // Handle tables of objects that other entry points attach to; each is defined next to its own API
+
+    HandleTable<BroadcastHub>& HubHandles();
+    HandleTable<IngestPipeline>& IngestHandles();
+    HandleTable<OverlaySource>& OverlayHandles();
+    HandleTable<DspPool>& PoolHandles();
+    HandleTable<PacketTimingMonitor>& TimingHandles();
+    HandleTable<RecordingWriter>& RecordingHandles();
+
+    /// <summary>
+    /// The process-wide replay server behind the MwReplay* entry points
+    /// </summary>
+    ReplayServer& SharedReplayServer();
+
+    /// <summary>
+    /// The process-wide timer wheel behind the MwTimer* entry points, shared by native periodic work
+    /// </summary>
+    TimerWheel& SharedTimerWheel();
+}
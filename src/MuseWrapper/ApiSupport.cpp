@@ -0,0 +1,72 @@
+#include "pch.h"
+#include "ApiSupport.h"
+#include "Backpressure.h"
+#include "LatencyHistogram.h"
+
+namespace MuseWrapper
+{
+    void WriteError(char* errorOut, int errorLen, const char* message)
+    {
+        if (errorOut == nullptr || errorLen <= 0)
+        {
+            return;
+        }
+
+        size_t length = std::min(std::strlen(message), static_cast<size_t>(errorLen - 1));
+        std::memcpy(errorOut, message, length);
+        errorOut[length] = '\0';
+    }
+
+    namespace
+    {
+        struct ThreadError
+        {
+            int code = MW_OK;
+            char message[256] = {};
+        };
+
+        thread_local ThreadError lastError;
+    }
+
+    void RecordThreadError(int code, const char* message)
+    {
+        lastError.code = code;
+        WriteError(lastError.message, sizeof(lastError.message), message);
+    }
+
+    int LastThreadError(char* messageOut, int messageLen)
+    {
+        WriteError(messageOut, messageLen, lastError.message);
+        return lastError.code;
+    }
+
+    void CopyLatency(const LatencySummary& summary, MwLatencyStats* statsOut)
+    {
+        statsOut->count = static_cast<int64_t>(summary.count);
+        statsOut->minNs = static_cast<int64_t>(summary.count != 0 ? summary.minNs : 0);
+        statsOut->maxNs = static_cast<int64_t>(summary.maxNs);
+        statsOut->meanNs = summary.meanNs;
+        statsOut->p50Ns = static_cast<int64_t>(summary.p50Ns);
+        statsOut->p90Ns = static_cast<int64_t>(summary.p90Ns);
+        statsOut->p99Ns = static_cast<int64_t>(summary.p99Ns);
+        statsOut->p999Ns = static_cast<int64_t>(summary.p999Ns);
+    }
+
+    void CopyQueueStats(const QueueStats& stats, MwQueueStats* statsOut)
+    {
+        statsOut->accepted = static_cast<int64_t>(stats.accepted);
+        statsOut->droppedNewest = static_cast<int64_t>(stats.droppedNewest);
+        statsOut->droppedOldest = static_cast<int64_t>(stats.droppedOldest);
+        statsOut->coalesced = static_cast<int64_t>(stats.coalesced);
+        statsOut->blockedNs = static_cast<int64_t>(stats.blockedNs);
+        statsOut->depth = static_cast<int32_t>(stats.depth);
+        statsOut->capacity = static_cast<int32_t>(stats.capacity);
+        statsOut->policy = static_cast<int32_t>(stats.policy);
+    }
+
+    OverflowPolicy ToOverflowPolicy(int policy)
+    {
+        Require(policy >= MW_OVERFLOW_BLOCK && policy <= MW_OVERFLOW_LATEST_ONLY, "Unknown overflow policy");
+        return static_cast<OverflowPolicy>(policy);
+    }
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "MuseWrapper.h"
+
+namespace MuseWrapper
+{
+    struct LatencySummary;
+    struct QueueStats;
+    enum class OverflowPolicy : int;
+
+    /// <summary>
+    /// Exception carrying an MW_* status code back to the exported entry point
+    /// </summary>
+    class ApiError : public std::runtime_error
+    {
+    public:
+        ApiError(int code, const std::string& message) : std::runtime_error(message), code(code) {}
+
+        int Code() const { return code; }
+
+    private:
+        int code;
+    };
+
+    /// <summary>
+    /// Copies a message into a caller-supplied error buffer, truncating if necessary
+    /// </summary>
+    void WriteError(char* errorOut, int errorLen, const char* message);
+
+    /// <summary>
+    /// Keeps the status and message of the calling thread's latest failed call for MwGetLastError,
+    /// so callers may pass no error buffer at all and share nothing between threads
+    /// </summary>
+    void RecordThreadError(int code, const char* message);
+
+    /// <summary>
+    /// Copies the calling thread's last recorded message and returns its status, MW_OK if none
+    /// </summary>
+    int LastThreadError(char* messageOut, int messageLen);
+
+    /// <summary>
+    /// Converts a histogram summary to the exported MwLatencyStats layout
+    /// </summary>
+    void CopyLatency(const LatencySummary& summary, MwLatencyStats* statsOut);
+
+    /// <summary>
+    /// Converts a queue's counters to the exported MwQueueStats layout
+    /// </summary>
+    void CopyQueueStats(const QueueStats& stats, MwQueueStats* statsOut);
+
+    /// <summary>
+    /// Checks an MW_OVERFLOW_* value and converts it
+    /// </summary>
+    OverflowPolicy ToOverflowPolicy(int policy);
+
+    /// <summary>
+    /// Runs the body of an exported function, translating exceptions into MW_* status codes
+    /// </summary>
+    template <typename Fn>
+    int InvokeApi(char* errorOut, int errorLen, Fn&& body)
+    {
+        try
+        {
+            return body();
+        }
+        catch (const ApiError& e)
+        {
+            WriteError(errorOut, errorLen, e.what());
+            RecordThreadError(e.Code(), e.what());
+            return e.Code();
+        }
+        catch (const std::exception& e)
+        {
+            WriteError(errorOut, errorLen, e.what());
+            RecordThreadError(MW_FAILURE, e.what());
+            return MW_FAILURE;
+        }
+        catch (...)
+        {
+            WriteError(errorOut, errorLen, "Unknown native exception");
+            RecordThreadError(MW_FAILURE, "Unknown native exception");
+            return MW_FAILURE;
+        }
+    }
+
+    /// <summary>
+    /// Throws MW_INVALID_ARGUMENT with the given message when the condition does not hold
+    /// </summary>
+    inline void Require(bool condition, const char* message)
+    {
+        if (!condition)
+        {
+            throw ApiError(MW_INVALID_ARGUMENT, message);
+        }
+    }
+
+    /// <summary>
+    /// Maps integer handles handed to managed code onto native objects
+    /// </summary>
+    template <typename T>
+    class HandleTable
+    {
+    public:
+        int Add(std::shared_ptr<T> item)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            int handle = nextHandle++;
+            items.emplace(handle, std::move(item));
+            return handle;
+        }
+
+        std::shared_ptr<T> Get(int handle) const
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            auto it = items.find(handle);
+            if (it == items.end())
+            {
+                throw ApiError(MW_INVALID_HANDLE, "Invalid handle " + std::to_string(handle));
+            }
+            return it->second;
+        }
+
+        std::shared_ptr<T> Remove(int handle)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            auto it = items.find(handle);
+            if (it == items.end())
+            {
+                throw ApiError(MW_INVALID_HANDLE, "Invalid handle " + std::to_string(handle));
+            }
+            auto item = std::move(it->second);
+            items.erase(it);
+            return item;
+        }
+
+        /// <summary>
+        /// Every live object, for aggregate reporting
+        /// </summary>
+        std::vector<std::shared_ptr<T>> Snapshot() const
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            std::vector<std::shared_ptr<T>> snapshot;
+            snapshot.reserve(items.size());
+            for (const auto& entry : items)
+            {
+                snapshot.push_back(entry.second);
+            }
+            return snapshot;
+        }
+
+    private:
+        mutable std::mutex lock;
+        std::unordered_map<int, std::shared_ptr<T>> items;
+        int nextHandle = 1;
+    };
+}
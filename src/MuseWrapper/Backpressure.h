@@ -0,0 +1,64 @@
+#pragma once
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// What a bounded queue does with an item that arrives while it is full; values match the
+    /// MW_OVERFLOW_* constants
+    /// </summary>
+    enum class OverflowPolicy : int
+    {
+        Block,          // the producer waits for room, pushing the overload back to its own source
+        DropOldest,     // the oldest queued item makes room, so consumers see the freshest data
+        DropNewest,     // the arriving item is refused and the queue keeps what it has
+        LatestOnly,     // one item per key is kept, each arrival replacing the one still waiting
+    };
+
+    constexpr int OverflowPolicyCount = 4;
+
+    /// <summary>
+    /// What one bounded queue has done with its items; every item a producer offered was either
+    /// accepted or dropped, and an accepted item may still be dropped later as the oldest or coalesced
+    /// </summary>
+    struct QueueStats
+    {
+        OverflowPolicy policy;
+        size_t depth;               // items waiting now
+        size_t capacity;
+        uint64_t accepted;
+        uint64_t droppedNewest;     // refused on arrival
+        uint64_t droppedOldest;     // evicted to make room for a newer item
+        uint64_t coalesced;         // replaced by a newer item before the consumer took it
+        uint64_t blockedNs;         // producers' total wait for room
+
+        uint64_t Dropped() const { return droppedNewest + droppedOldest + coalesced; }
+    };
+
+    /// <summary>
+    /// Counters behind QueueStats, updated by producers and consumers without a lock
+    /// </summary>
+    struct QueueCounters
+    {
+        std::atomic<uint64_t> accepted{ 0 };
+        std::atomic<uint64_t> droppedNewest{ 0 };
+        std::atomic<uint64_t> droppedOldest{ 0 };
+        std::atomic<uint64_t> coalesced{ 0 };
+        std::atomic<uint64_t> blockedNs{ 0 };
+
+        static void Add(std::atomic<uint64_t>& counter, uint64_t count = 1) { counter.fetch_add(count, std::memory_order_relaxed); }
+
+        QueueStats Read(OverflowPolicy policy, size_t depth, size_t capacity) const
+        {
+            return QueueStats{
+                policy,
+                depth,
+                capacity,
+                accepted.load(std::memory_order_relaxed),
+                droppedNewest.load(std::memory_order_relaxed),
+                droppedOldest.load(std::memory_order_relaxed),
+                coalesced.load(std::memory_order_relaxed),
+                blockedNs.load(std::memory_order_relaxed),
+            };
+        }
+    };
+}
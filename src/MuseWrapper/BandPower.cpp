@@ -0,0 +1,114 @@
+#include "pch.h"
+#include "BandPower.h"
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        constexpr double Pi = 3.14159265358979323846;
+
+        // Band edges in Hz used by libmuse, in BandPowerEstimator::Band order
+        constexpr double BandEdges[BandPowerEstimator<>::BandCount][2] =
+        {
+            { 7.5, 13.0 },
+            { 13.0, 30.0 },
+            { 1.0, 4.0 },
+            { 4.0, 8.0 },
+            { 30.0, 44.0 },
+        };
+    }
+
+    template <typename T>
+    BandPowerEstimator<T>::BandPowerEstimator(int channels, double sampleRate, std::pmr::memory_resource* memory,
+        size_t windowSize, double outputRate)
+        : channels(channels),
+          windowSize(windowSize),
+          hop(std::max<size_t>(1, static_cast<size_t>(std::lround(sampleRate / outputRate)))),
+          fft(windowSize, memory),
+          window(windowSize, memory),
+          history(channels, windowSize, memory),
+          frame(windowSize, memory),
+          spectrum(windowSize / 2 + 1, memory),
+          powers(static_cast<size_t>(channels) * BandCount, memory)
+    {
+        if (channels <= 0)
+        {
+            throw std::invalid_argument("Band power needs at least one channel");
+        }
+
+        double sumSquares = 0.0;
+        for (size_t i = 0; i < windowSize; i++)
+        {
+            double w = 0.5 - 0.5 * std::cos(2.0 * Pi * static_cast<double>(i) / static_cast<double>(windowSize));
+            window[i] = static_cast<T>(w);
+            sumSquares += w * w;
+        }
+        // One-sided PSD integrated over bins of width fs/N: 2|X|^2 / (N * sum(w^2))
+        scale = 2.0 / (static_cast<double>(windowSize) * sumSquares);
+
+        double binHz = sampleRate / static_cast<double>(windowSize);
+        for (int band = 0; band < BandCount; band++)
+        {
+            size_t first = static_cast<size_t>(std::ceil(BandEdges[band][0] / binHz));
+            size_t last = std::min(spectrum.size() - 1, static_cast<size_t>(std::floor(BandEdges[band][1] / binHz)));
+            bins[band] = { first, std::max(first, last) };
+        }
+    }
+
+    template <typename T>
+    bool BandPowerEstimator<T>::AddSample(const T* values)
+    {
+        history.Push(values);
+        if (++sinceUpdate < hop || history.Filled() < windowSize)
+        {
+            return false;
+        }
+        sinceUpdate = 0;
+        Update();
+        return true;
+    }
+
+    template <typename T>
+    void BandPowerEstimator<T>::Reset()
+    {
+        history.Reset();
+        sinceUpdate = 0;
+        std::fill(powers.begin(), powers.end(), 0.0);
+    }
+
+    template <typename T>
+    void BandPowerEstimator<T>::Update()
+    {
+        for (int c = 0; c < channels; c++)
+        {
+            // The ring keeps the window contiguous and oldest-first, so it lines up with time as is
+            const T* samples = history.Latest(c, windowSize);
+            T mean = T();
+            for (size_t i = 0; i < windowSize; i++)
+            {
+                mean += samples[i];
+            }
+            mean /= static_cast<T>(windowSize);
+            for (size_t i = 0; i < windowSize; i++)
+            {
+                frame[i] = (samples[i] - mean) * window[i];
+            }
+
+            fft.PowerSpectrum(frame.data(), spectrum.data());
+
+            double* out = powers.data() + static_cast<size_t>(c) * BandCount;
+            for (int band = 0; band < BandCount; band++)
+            {
+                double sum = 0.0;
+                for (size_t k = bins[band].first; k <= bins[band].second; k++)
+                {
+                    sum += spectrum[k];
+                }
+                out[band] = std::log10(std::max(sum * scale, 1e-12));
+            }
+        }
+    }
+
+    template class BandPowerEstimator<float>;
+    template class BandPowerEstimator<double>;
+}
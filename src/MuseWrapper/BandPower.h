@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ChannelRing.h"
+#include "Dsp.h"
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Sliding-window absolute band power per EEG channel, recomputed at a fixed output rate like
+    /// libmuse's 10 Hz *_ABSOLUTE packets. Each update removes the window mean, applies a Hann
+    /// window and integrates the one-sided PSD over each band; values are log10 (Bels) as in libmuse.
+    /// Samples, window and FFT are in T; the band powers are reported in double either way.
+    /// </summary>
+    template <typename T = double>
+    class BandPowerEstimator
+    {
+    public:
+        // Band order of the libmuse *_ABSOLUTE packet types
+        enum Band { Alpha, Beta, Delta, Theta, Gamma, BandCount };
+
+        BandPowerEstimator(int channels, double sampleRate, std::pmr::memory_resource* memory = std::pmr::get_default_resource(),
+            size_t windowSize = 256, double outputRate = 10.0);
+
+        int Channels() const { return channels; }
+
+        /// <summary>
+        /// Adds one sample for every channel; returns true when a new set of band powers is available
+        /// </summary>
+        bool AddSample(const T* values);
+
+        /// <summary>
+        /// Latest band powers indexed [channel * BandCount + band]
+        /// </summary>
+        const double* Powers() const { return powers.data(); }
+
+        void Reset();
+
+    private:
+        void Update();
+
+        int channels;
+        size_t windowSize;
+        size_t hop;
+        size_t sinceUpdate = 0;
+        double scale;
+
+        RealFft<T> fft;
+        std::pmr::vector<T> window;
+        ChannelRing<T> history;             // the last windowSize samples of each channel
+        std::pmr::vector<T> frame;
+        std::pmr::vector<T> spectrum;
+        std::array<std::pair<size_t, size_t>, BandCount> bins;
+        std::pmr::vector<double> powers;
+    };
+}
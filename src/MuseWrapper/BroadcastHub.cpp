@@ -0,0 +1,625 @@
+#include "pch.h"
+#include "BroadcastHub.h"
+#include "AllocationTracking.h"
+#include "Clock.h"
+#include "Profiler.h"
+#include "Tracing.h"
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        constexpr int MaxEventsPerWait = 256;
+        constexpr int IdleWaitMs = 100;
+        constexpr int MaxFramesPerSend = 16;
+        constexpr size_t ReceiveChunk = 4096;
+    }
+
+    BroadcastFrame* BroadcastFrame::Create(const uint8_t* data, size_t length, const std::shared_ptr<SessionArena>& arena)
+    {
+        size_t size = sizeof(BroadcastFrame) + length;
+        void* memory = arena ? arena->allocate(size, alignof(BroadcastFrame)) : ::operator new(size);
+        BroadcastFrame* frame = new (memory) BroadcastFrame();
+        frame->length = length;
+        frame->arena = arena;
+        for (int i = 0; i < 4; i++)
+        {
+            frame->tcpHeader[i] = static_cast<uint8_t>(length >> (8 * i));
+        }
+        frame->webSocketHeaderLength = WebSocket::EncodeHeader(frame->webSocketHeader, WebSocket::Binary, length);
+        std::memcpy(reinterpret_cast<uint8_t*>(frame + 1), data, length);
+        return frame;
+    }
+
+    void BroadcastFrame::Release()
+    {
+        if (--references == 0)
+        {
+            // The arena may go with this frame, so it is released after the frame is handed back
+            std::shared_ptr<SessionArena> owner = std::move(arena);
+            size_t size = sizeof(BroadcastFrame) + length;
+            this->~BroadcastFrame();
+            if (owner)
+            {
+                owner->deallocate(this, size, alignof(BroadcastFrame));
+            }
+            else
+            {
+                ::operator delete(this);
+            }
+        }
+    }
+
+    BroadcastHub::BroadcastHub(const Options& options)
+        : options(options),
+          publishPolicy(options.publishPolicy),
+          subscriberPolicy(options.subscriberPolicy)
+    {
+        if (options.subscriberPolicy == OverflowPolicy::Block)
+        {
+            throw std::invalid_argument("Subscriber queues cannot block the hub thread");
+        }
+        Sockets::CreatePair(wakeWriter, wakeReader.socket);
+        poller.Add(wakeReader.socket, &wakeReader);
+
+        if (options.tcpPort >= 0)
+        {
+            tcpListener.socket = Sockets::Listen(static_cast<uint16_t>(options.tcpPort), options.loopbackOnly, tcpPort);
+            poller.Add(tcpListener.socket, &tcpListener);
+        }
+        if (options.webSocketPort >= 0)
+        {
+            webSocketListener.socket = Sockets::Listen(static_cast<uint16_t>(options.webSocketPort), options.loopbackOnly, webSocketPort);
+            poller.Add(webSocketListener.socket, &webSocketListener);
+        }
+
+        thread = std::thread(&BroadcastHub::Run, this);
+    }
+
+    BroadcastHub::~BroadcastHub()
+    {
+        running = false;
+        char wake = 0;
+        IoSlice slice{ &wake, 1 };
+        Sockets::Send(wakeWriter, &slice, 1);
+        thread.join();
+
+        for (auto& subscriber : subscribers)
+        {
+            Close(*subscriber);
+        }
+        SweepClosed();
+        for (BroadcastFrame* frame : pending)
+        {
+            frame->Release();
+        }
+        for (Endpoint* endpoint : { &tcpListener, &webSocketListener, &wakeReader })
+        {
+            if (endpoint->socket != InvalidSocket)
+            {
+                Sockets::Close(endpoint->socket);
+            }
+        }
+        Sockets::Close(wakeWriter);
+    }
+
+    void BroadcastHub::Publish(const uint8_t* data, size_t length, const std::shared_ptr<SessionArena>& arena)
+    {
+        MW_TRACE_SCOPE("hub.publish");
+        MW_ALLOCATION_STAGE("hub.publish");
+        BroadcastFrame* frame = BroadcastFrame::Create(data, length, arena);
+        framesPublished.fetch_add(1, std::memory_order_relaxed);
+        OverflowPolicy policy = publishPolicy.load(std::memory_order_relaxed);
+        size_t capacity = static_cast<size_t>(std::max(options.maxPendingFrames, 1));
+        bool wasEmpty;
+        {
+            // Frames still pending have only the publisher's reference, so they may be released here
+            std::unique_lock<std::mutex> guard(pendingLock);
+            if (policy == OverflowPolicy::Block && pending.size() >= capacity)
+            {
+                MW_TRACE_SCOPE("hub.blocked");
+                uint64_t startNs = MonotonicNanoseconds();
+                blockedPublishers++;
+                pendingRoom.wait(guard, [&]
+                {
+                    return pending.size() < capacity || publishPolicy.load(std::memory_order_relaxed) != OverflowPolicy::Block;
+                });
+                blockedPublishers--;
+                QueueCounters::Add(publishCounters.blockedNs, MonotonicNanoseconds() - startNs);
+                policy = publishPolicy.load(std::memory_order_relaxed);
+            }
+
+            if (policy == OverflowPolicy::LatestOnly)
+            {
+                for (BroadcastFrame* stale : pending)
+                {
+                    stale->Release();
+                }
+                QueueCounters::Add(publishCounters.coalesced, pending.size());
+                pending.clear();
+            }
+            else if (pending.size() >= capacity && policy == OverflowPolicy::DropNewest)
+            {
+                QueueCounters::Add(publishCounters.droppedNewest);
+                frame->Release();
+                return;
+            }
+            else if (pending.size() >= capacity)
+            {
+                pending.front()->Release();
+                pending.pop_front();
+                QueueCounters::Add(publishCounters.droppedOldest);
+            }
+            wasEmpty = pending.empty();
+            pending.push_back(frame);
+            QueueCounters::Add(publishCounters.accepted);
+        }
+
+        // One wake byte per batch; the hub drains everything pending when it wakes
+        if (wasEmpty)
+        {
+            char wake = 1;
+            IoSlice slice{ &wake, 1 };
+            Sockets::Send(wakeWriter, &slice, 1);
+        }
+    }
+
+    int BroadcastHub::AddMessageHandler(MessageHandler handler)
+    {
+        std::lock_guard<std::mutex> guard(handlerLock);
+        int id = nextHandlerId++;
+        messageHandlers.Update([&](std::vector<HandlerEntry>& next) { next.push_back(HandlerEntry{ id, std::move(handler) }); });
+        return id;
+    }
+
+    void BroadcastHub::RemoveMessageHandler(int id)
+    {
+        {
+            std::lock_guard<std::mutex> guard(handlerLock);
+            messageHandlers.Update([id](std::vector<HandlerEntry>& next)
+            {
+                next.erase(std::remove_if(next.begin(), next.end(), [id](const HandlerEntry& e) { return e.id == id; }), next.end());
+            });
+        }
+        // Callers free what the handler uses on return, so wait out a call on the hub thread
+        Epochs::Synchronize();
+    }
+
+    void BroadcastHub::SetOverflowPolicy(HubQueue queue, OverflowPolicy policy)
+    {
+        if (queue == HubQueue::Subscriber)
+        {
+            if (policy == OverflowPolicy::Block)
+            {
+                throw std::invalid_argument("Subscriber queues cannot block the hub thread");
+            }
+            subscriberPolicy.store(policy, std::memory_order_relaxed);
+            return;
+        }
+        publishPolicy.store(policy, std::memory_order_relaxed);
+        // Publishers blocked under the old policy keep waiting for room; wake them to drop instead
+        std::lock_guard<std::mutex> guard(pendingLock);
+        pendingRoom.notify_all();
+    }
+
+    QueueStats BroadcastHub::Stats(HubQueue queue) const
+    {
+        if (queue == HubQueue::Subscriber)
+        {
+            size_t perSubscriber = static_cast<size_t>(std::max(options.maxQueuedFrames, 2));
+            return subscriberCounters.Read(subscriberPolicy.load(std::memory_order_relaxed),
+                static_cast<size_t>(framesQueued.load(std::memory_order_relaxed)),
+                perSubscriber * subscriberCount.load(std::memory_order_relaxed));
+        }
+        size_t depth;
+        {
+            std::lock_guard<std::mutex> guard(pendingLock);
+            depth = pending.size();
+        }
+        return publishCounters.Read(publishPolicy.load(std::memory_order_relaxed), depth,
+            static_cast<size_t>(std::max(options.maxPendingFrames, 1)));
+    }
+
+    HubStats BroadcastHub::Stats() const
+    {
+        return HubStats{
+            framesPublished.load(std::memory_order_relaxed),
+            framesDelivered.load(std::memory_order_relaxed),
+            Stats(HubQueue::Publish).Dropped() + Stats(HubQueue::Subscriber).Dropped(),
+            bytesSent.load(std::memory_order_relaxed),
+            loopBusyNs.load(std::memory_order_relaxed),
+            subscriberCount.load(std::memory_order_relaxed),
+        };
+    }
+
+    void BroadcastHub::Run()
+    {
+        MW_TRACE_THREAD_NAME("MuseWrapper hub");
+        Profiler::ThreadRegistration profiled("MuseWrapper hub");
+        PollEvent events[MaxEventsPerWait];
+        while (running.load(std::memory_order_relaxed))
+        {
+            int count = poller.Wait(events, MaxEventsPerWait, IdleWaitMs);
+            uint64_t busyStart = MonotonicNanoseconds();
+
+            for (int i = 0; i < count; i++)
+            {
+                Endpoint* endpoint = static_cast<Endpoint*>(events[i].context);
+                switch (endpoint->kind)
+                {
+                case EndpointKind::TcpListener:
+                case EndpointKind::WebSocketListener:
+                    AcceptAll(*endpoint);
+                    break;
+                case EndpointKind::Wake:
+                    DrainWake();
+                    break;
+                case EndpointKind::Subscriber:
+                {
+                    Subscriber& subscriber = static_cast<Subscriber&>(*endpoint);
+                    if (subscriber.closing)
+                    {
+                        break;
+                    }
+                    if (events[i].readable || events[i].hangup)
+                    {
+                        HandleReadable(subscriber);
+                    }
+                    if (events[i].writable && !subscriber.closing)
+                    {
+                        subscriber.writable = true;
+                        Flush(subscriber);
+                    }
+                    break;
+                }
+                }
+            }
+
+            SweepClosed();
+            loopBusyNs.fetch_add(MonotonicNanoseconds() - busyStart, std::memory_order_relaxed);
+        }
+    }
+
+    void BroadcastHub::AcceptAll(Endpoint& listener)
+    {
+        SocketHandle socket;
+        while ((socket = Sockets::Accept(listener.socket)) != InvalidSocket)
+        {
+            auto subscriber = std::make_unique<Subscriber>();
+            subscriber->kind = EndpointKind::Subscriber;
+            subscriber->socket = socket;
+            subscriber->id = nextSubscriberId++;
+            subscriber->index = subscribers.size();
+            subscriber->webSocket = listener.kind == EndpointKind::WebSocketListener;
+            subscriber->streaming = !subscriber->webSocket;
+            subscriber->queue.resize(static_cast<size_t>(std::max(options.maxQueuedFrames, 2)));
+            poller.Add(socket, subscriber.get());
+            subscribers.push_back(std::move(subscriber));
+            subscriberCount.store(static_cast<uint32_t>(subscribers.size()), std::memory_order_relaxed);
+        }
+    }
+
+    void BroadcastHub::DrainWake()
+    {
+        char buffer[256];
+        while (Sockets::Receive(wakeReader.socket, buffer, sizeof(buffer)) > 0)
+        {
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(pendingLock);
+            draining.swap(pending);
+            if (blockedPublishers > 0)
+            {
+                pendingRoom.notify_all();
+            }
+        }
+        for (BroadcastFrame* frame : draining)
+        {
+            FanOut(frame);
+        }
+        draining.clear();
+    }
+
+    void BroadcastHub::FanOut(BroadcastFrame* frame)
+    {
+        for (auto& subscriber : subscribers)
+        {
+            if (subscriber->streaming && !subscriber->closing)
+            {
+                Enqueue(*subscriber, frame);
+                if (subscriber->writable)
+                {
+                    Flush(*subscriber);
+                }
+            }
+        }
+        frame->Release();
+    }
+
+    void BroadcastHub::Enqueue(Subscriber& subscriber, BroadcastFrame* frame)
+    {
+        size_t capacity = subscriber.queue.size();
+        OverflowPolicy policy = subscriberPolicy.load(std::memory_order_relaxed);
+        // A frame partially on the wire has to be finished, so it is never dropped or replaced
+        size_t kept = subscriber.sentOffset > 0 ? 1 : 0;
+        if (policy == OverflowPolicy::LatestOnly && subscriber.count > kept)
+        {
+            size_t stale = subscriber.count - kept;
+            for (size_t i = kept; i < subscriber.count; i++)
+            {
+                subscriber.queue[(subscriber.head + i) % capacity]->Release();
+            }
+            subscriber.count = kept;
+            Dequeued(stale);
+            QueueCounters::Add(subscriberCounters.coalesced, stale);
+        }
+        else if (subscriber.count == capacity)
+        {
+            if (policy == OverflowPolicy::DropNewest)
+            {
+                QueueCounters::Add(subscriberCounters.droppedNewest);
+                return;
+            }
+            size_t victim = (subscriber.head + kept) % capacity;
+            subscriber.queue[victim]->Release();
+            for (size_t i = victim; i != (subscriber.head + subscriber.count - 1) % capacity; i = (i + 1) % capacity)
+            {
+                subscriber.queue[i] = subscriber.queue[(i + 1) % capacity];
+            }
+            subscriber.count--;
+            Dequeued(1);
+            QueueCounters::Add(subscriberCounters.droppedOldest);
+        }
+
+        frame->AddRef();
+        subscriber.queue[(subscriber.head + subscriber.count) % capacity] = frame;
+        subscriber.count++;
+        framesQueued.fetch_add(1, std::memory_order_relaxed);
+        QueueCounters::Add(subscriberCounters.accepted);
+    }
+
+    bool BroadcastHub::FlushControl(Subscriber& subscriber)
+    {
+        while (subscriber.controlSent < subscriber.control.size())
+        {
+            IoSlice slice{ subscriber.control.data() + subscriber.controlSent, subscriber.control.size() - subscriber.controlSent };
+            intptr_t sent = Sockets::Send(subscriber.socket, &slice, 1);
+            if (sent < 0)
+            {
+                Close(subscriber);
+                return false;
+            }
+            if (sent == 0)
+            {
+                subscriber.writable = false;
+                poller.SetWriteInterest(subscriber.socket, true);
+                return false;
+            }
+            subscriber.controlSent += static_cast<size_t>(sent);
+            bytesSent.fetch_add(static_cast<uint64_t>(sent), std::memory_order_relaxed);
+        }
+        subscriber.control.clear();
+        subscriber.controlSent = 0;
+        return true;
+    }
+
+    void BroadcastHub::Flush(Subscriber& subscriber)
+    {
+        MW_TRACE_SCOPE("hub.send");
+        MW_ALLOCATION_STAGE("hub.send");
+        // Control output (handshake, pong, close) may only go out between frames
+        if (subscriber.sentOffset == 0 && !subscriber.control.empty() && !FlushControl(subscriber))
+        {
+            return;
+        }
+
+        size_t capacity = subscriber.queue.size();
+        while (subscriber.count > 0)
+        {
+            IoSlice slices[2 * MaxFramesPerSend];
+            int sliceCount = 0;
+            size_t skip = subscriber.sentOffset;
+            for (size_t i = 0; i < std::min(subscriber.count, static_cast<size_t>(MaxFramesPerSend)); i++)
+            {
+                const BroadcastFrame* frame = subscriber.queue[(subscriber.head + i) % capacity];
+                IoSlice parts[2] = {
+                    { frame->Header(subscriber.webSocket), frame->HeaderLength(subscriber.webSocket) },
+                    { frame->Payload(), frame->Length() },
+                };
+                for (IoSlice& part : parts)
+                {
+                    if (skip >= part.length)
+                    {
+                        skip -= part.length;
+                        continue;
+                    }
+                    slices[sliceCount++] = IoSlice{ static_cast<const uint8_t*>(part.data) + skip, part.length - skip };
+                    skip = 0;
+                }
+            }
+
+            intptr_t sent = Sockets::Send(subscriber.socket, slices, sliceCount);
+            if (sent < 0)
+            {
+                Close(subscriber);
+                return;
+            }
+            if (sent == 0)
+            {
+                subscriber.writable = false;
+                poller.SetWriteInterest(subscriber.socket, true);
+                return;
+            }
+            bytesSent.fetch_add(static_cast<uint64_t>(sent), std::memory_order_relaxed);
+
+            size_t remaining = static_cast<size_t>(sent);
+            while (remaining > 0)
+            {
+                BroadcastFrame* frame = subscriber.queue[subscriber.head];
+                size_t left = frame->HeaderLength(subscriber.webSocket) + frame->Length() - subscriber.sentOffset;
+                if (remaining < left)
+                {
+                    subscriber.sentOffset += remaining;
+                    break;
+                }
+                remaining -= left;
+                subscriber.sentOffset = 0;
+                frame->Release();
+                subscriber.head = (subscriber.head + 1) % capacity;
+                subscriber.count--;
+                Dequeued(1);
+                framesDelivered.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            if (subscriber.sentOffset > 0)
+            {
+                // Short write: the socket buffer is full, wait for the next writable edge
+                subscriber.writable = false;
+                poller.SetWriteInterest(subscriber.socket, true);
+                return;
+            }
+            if (!subscriber.control.empty() && !FlushControl(subscriber))
+            {
+                return;
+            }
+        }
+        poller.SetWriteInterest(subscriber.socket, false);
+    }
+
+    void BroadcastHub::HandleReadable(Subscriber& subscriber)
+    {
+        uint8_t buffer[ReceiveChunk];
+        while (!subscriber.closing)
+        {
+            intptr_t received = Sockets::Receive(subscriber.socket, buffer, sizeof(buffer));
+            if (received < 0)
+            {
+                Close(subscriber);
+                return;
+            }
+            if (received == 0)
+            {
+                return;
+            }
+            if (subscriber.webSocket)
+            {
+                HandleWebSocketData(subscriber, buffer, static_cast<size_t>(received));
+            }
+            // Raw TCP subscribers are send-only; anything they send is discarded
+        }
+    }
+
+    void BroadcastHub::HandleWebSocketData(Subscriber& subscriber, const uint8_t* data, size_t length)
+    {
+        if (!subscriber.streaming)
+        {
+            subscriber.request.append(reinterpret_cast<const char*>(data), length);
+            std::string response;
+            WebSocket::HandshakeResult result = WebSocket::ProcessHandshake(subscriber.request, response);
+            if (result == WebSocket::HandshakeResult::Incomplete)
+            {
+                return;
+            }
+            subscriber.control += response;
+            if (result == WebSocket::HandshakeResult::Rejected)
+            {
+                FlushControl(subscriber);
+                Close(subscriber);
+                return;
+            }
+
+            // Any bytes after the request belong to the first frames
+            size_t end = subscriber.request.find("\r\n\r\n") + 4;
+            std::string rest = subscriber.request.substr(end);
+            subscriber.request.clear();
+            subscriber.request.shrink_to_fit();
+            subscriber.streaming = true;
+            Flush(subscriber);
+            if (rest.empty() || subscriber.closing)
+            {
+                return;
+            }
+            data = reinterpret_cast<const uint8_t*>(rest.data());
+            length = rest.size();
+            HandleWebSocketData(subscriber, data, length);
+            return;
+        }
+
+        bool closeRequested = false;
+        bool valid = subscriber.decoder.Feed(data, length, [&](WebSocket::Opcode opcode, const uint8_t* payload, size_t payloadLength)
+        {
+            uint8_t header[WebSocket::MaxHeaderSize];
+            switch (opcode)
+            {
+            case WebSocket::Ping:
+                subscriber.control.append(reinterpret_cast<char*>(header), WebSocket::EncodeHeader(header, WebSocket::Pong, payloadLength));
+                subscriber.control.append(reinterpret_cast<const char*>(payload), payloadLength);
+                break;
+            case WebSocket::Close:
+                subscriber.control.append(reinterpret_cast<char*>(header), WebSocket::EncodeHeader(header, WebSocket::Close, 0));
+                closeRequested = true;
+                break;
+            case WebSocket::Text:
+            case WebSocket::Binary:
+            {
+                Epochs::ReadGuard reading;
+                for (const HandlerEntry& entry : messageHandlers.Read())
+                {
+                    entry.handler(subscriber.id, payload, payloadLength);
+                }
+                break;
+            }
+            default:
+                break;
+            }
+        });
+
+        if (!valid || closeRequested)
+        {
+            if (subscriber.sentOffset == 0)
+            {
+                FlushControl(subscriber);
+            }
+            Close(subscriber);
+            return;
+        }
+        if (!subscriber.control.empty() && subscriber.writable)
+        {
+            Flush(subscriber);
+        }
+    }
+
+    void BroadcastHub::Close(Subscriber& subscriber)
+    {
+        if (!subscriber.closing)
+        {
+            subscriber.closing = true;
+            closed.push_back(&subscriber);
+        }
+    }
+
+    void BroadcastHub::SweepClosed()
+    {
+        for (Subscriber* subscriber : closed)
+        {
+            poller.Remove(subscriber->socket);
+            Sockets::Close(subscriber->socket);
+            for (size_t i = 0; i < subscriber->count; i++)
+            {
+                subscriber->queue[(subscriber->head + i) % subscriber->queue.size()]->Release();
+            }
+            Dequeued(subscriber->count);
+
+            size_t index = subscriber->index;
+            if (index != subscribers.size() - 1)
+            {
+                subscribers[index] = std::move(subscribers.back());
+                subscribers[index]->index = index;
+            }
+            subscribers.pop_back();
+        }
+        closed.clear();
+        subscriberCount.store(static_cast<uint32_t>(subscribers.size()), std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include "Backpressure.h"
+#include "Poller.h"
+#include "Rcu.h"
+#include "SessionArena.h"
+#include "WebSocket.h"
+
+#include <condition_variable>
+#include <deque>
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Immutable, reference-counted message shared by every subscriber queue. The payload is stored
+    /// once with both wire headers so TCP and WebSocket subscribers send it with one gathered write.
+    /// After Publish hands it to the hub, only the hub thread touches the reference count.
+    /// </summary>
+    class BroadcastFrame
+    {
+    public:
+        /// <summary>
+        /// Copies the payload into a new frame, taken from arena when given (which the frame keeps
+        /// alive until its last release) and from the heap otherwise
+        /// </summary>
+        static BroadcastFrame* Create(const uint8_t* data, size_t length, const std::shared_ptr<SessionArena>& arena);
+
+        void AddRef() { references++; }
+        void Release();
+
+        const uint8_t* Payload() const { return reinterpret_cast<const uint8_t*>(this + 1); }
+        size_t Length() const { return length; }
+        const uint8_t* Header(bool webSocket) const { return webSocket ? webSocketHeader : tcpHeader; }
+        size_t HeaderLength(bool webSocket) const { return webSocket ? webSocketHeaderLength : sizeof(tcpHeader); }
+
+    private:
+        BroadcastFrame() = default;
+
+        int references = 1;
+        size_t length = 0;
+        std::shared_ptr<SessionArena> arena;
+        uint8_t tcpHeader[4];   // little-endian payload length
+        uint8_t webSocketHeader[WebSocket::MaxHeaderSize];
+        size_t webSocketHeaderLength = 0;
+    };
+
+    struct HubStats
+    {
+        uint64_t framesPublished;
+        uint64_t framesDelivered;
+        uint64_t framesDropped;     // lost on either queue, see QueueStats for where and why
+        uint64_t bytesSent;
+        uint64_t loopBusyNs;
+        uint32_t subscribers;
+    };
+
+    /// <summary>
+    /// The hub's bounded queues; values match the MW_HUB_QUEUE_* constants
+    /// </summary>
+    enum class HubQueue : int
+    {
+        Publish,        // frames published and not yet fanned out by the hub thread
+        Subscriber,     // each subscriber's frames not yet on the wire, counted together
+    };
+
+    /// <summary>
+    /// One-ingest, many-subscriber fan-out of metric frames over raw TCP (length-prefixed) and
+    /// WebSocket (binary messages). A single hub thread owns every socket.
+    ///
+    /// Both of the hub's queues are bounded, each with its own OverflowPolicy. By default slow
+    /// subscribers lose their oldest queued frames, and so does the publish queue if the hub thread
+    /// falls behind. Subscribers cannot block: the hub thread would stall every other subscriber on
+    /// the slowest one. A publisher that would rather wait uses Block on the publish queue, which the
+    /// hub thread empties at its own pace whatever its subscribers do.
+    /// </summary>
+    class BroadcastHub
+    {
+    public:
+        struct Options
+        {
+            int tcpPort = -1;           // -1 disables, 0 picks an ephemeral port
+            int webSocketPort = -1;
+            bool loopbackOnly = true;
+            int maxQueuedFrames = 8;                                    // per subscriber
+            int maxPendingFrames = 256;                                 // published, not yet fanned out
+            OverflowPolicy publishPolicy = OverflowPolicy::DropOldest;
+            OverflowPolicy subscriberPolicy = OverflowPolicy::DropOldest;
+        };
+
+        using MessageHandler = std::function<void(int subscriberId, const uint8_t* data, size_t length)>;
+
+        explicit BroadcastHub(const Options& options);
+        ~BroadcastHub();
+
+        BroadcastHub(const BroadcastHub&) = delete;
+        BroadcastHub& operator=(const BroadcastHub&) = delete;
+
+        /// <summary>
+        /// Copies the payload into a shared frame and queues it for every subscriber; callable from any
+        /// thread. A publisher with a session arena passes it so its frames come from there.
+        /// </summary>
+        void Publish(const uint8_t* data, size_t length, const std::shared_ptr<SessionArena>& arena = nullptr);
+
+        /// <summary>
+        /// Adds a receiver of the text/binary messages sent by WebSocket subscribers, invoked on the hub
+        /// thread after any handlers added before it; returns its id
+        /// </summary>
+        int AddMessageHandler(MessageHandler handler);
+
+        /// <summary>
+        /// Removes a handler; once this returns it is no longer running and will not be called again.
+        /// Throws inside an Epochs::ReadGuard, e.g. from a handler or a packet listener, since it waits
+        /// for the hub thread's reads.
+        /// </summary>
+        void RemoveMessageHandler(int id);
+
+        /// <summary>
+        /// Trace id for the next published message, unique among every publisher sharing the hub so an
+        /// acknowledgement names exactly one of them
+        /// </summary>
+        uint64_t NextTrace() { return nextTrace.fetch_add(1, std::memory_order_relaxed); }
+
+        /// <summary>
+        /// Changes what one queue does with frames arriving while it is full; throws for Block on
+        /// subscriber queues
+        /// </summary>
+        void SetOverflowPolicy(HubQueue queue, OverflowPolicy policy);
+
+        uint16_t TcpPort() const { return tcpPort; }
+        uint16_t WebSocketPort() const { return webSocketPort; }
+        HubStats Stats() const;
+        QueueStats Stats(HubQueue queue) const;
+
+    private:
+        enum class EndpointKind
+        {
+            TcpListener,
+            WebSocketListener,
+            Wake,
+            Subscriber,
+        };
+
+        struct Endpoint
+        {
+            EndpointKind kind;
+            SocketHandle socket = InvalidSocket;
+        };
+
+        struct Subscriber : Endpoint
+        {
+            int id = 0;
+            size_t index = 0;
+            bool webSocket = false;
+            bool streaming = false;
+            bool writable = true;
+            bool closing = false;
+            std::string request;
+            std::string control;
+            size_t controlSent = 0;
+            WebSocket::Decoder decoder;
+            std::vector<BroadcastFrame*> queue;
+            size_t head = 0;
+            size_t count = 0;
+            size_t sentOffset = 0;
+        };
+
+        void Run();
+        void AcceptAll(Endpoint& listener);
+        void DrainWake();
+        void FanOut(BroadcastFrame* frame);
+        void Enqueue(Subscriber& subscriber, BroadcastFrame* frame);
+        void Dequeued(size_t frames) { framesQueued.fetch_sub(frames, std::memory_order_relaxed); }
+        void HandleReadable(Subscriber& subscriber);
+        void HandleWebSocketData(Subscriber& subscriber, const uint8_t* data, size_t length);
+        void Flush(Subscriber& subscriber);
+        bool FlushControl(Subscriber& subscriber);
+        void Close(Subscriber& subscriber);
+        void SweepClosed();
+
+        Options options;
+        Poller poller;
+        Endpoint tcpListener{ EndpointKind::TcpListener };
+        Endpoint webSocketListener{ EndpointKind::WebSocketListener };
+        Endpoint wakeReader{ EndpointKind::Wake };
+        SocketHandle wakeWriter = InvalidSocket;
+        uint16_t tcpPort = 0;
+        uint16_t webSocketPort = 0;
+
+        std::vector<std::unique_ptr<Subscriber>> subscribers;
+        std::vector<Subscriber*> closed;
+        int nextSubscriberId = 1;
+
+        mutable std::mutex pendingLock;
+        std::condition_variable pendingRoom;            // for publishers blocked on a full publish queue
+        std::deque<BroadcastFrame*> pending;            // guarded by pendingLock; a deque so drop-oldest is O(1)
+        int blockedPublishers = 0;                      // guarded by pendingLock
+        std::deque<BroadcastFrame*> draining;
+        std::atomic<OverflowPolicy> publishPolicy;
+        std::atomic<OverflowPolicy> subscriberPolicy;
+        QueueCounters publishCounters;
+        QueueCounters subscriberCounters;
+        std::atomic<uint64_t> framesQueued{ 0 };        // in subscriber queues
+
+        struct HandlerEntry
+        {
+            int id;
+            MessageHandler handler;
+        };
+
+        std::mutex handlerLock;                 // serialises handler changes; the hub thread reads the snapshot
+        Snapshot<std::vector<HandlerEntry>> messageHandlers;
+        int nextHandlerId = 1;                  // guarded by handlerLock
+        std::atomic<uint64_t> nextTrace{ 1 };
+
+        std::atomic<bool> running{ true };
+        std::atomic<uint64_t> framesPublished{ 0 };
+        std::atomic<uint64_t> framesDelivered{ 0 };
+        std::atomic<uint64_t> bytesSent{ 0 };
+        std::atomic<uint64_t> loopBusyNs{ 0 };
+        std::atomic<uint32_t> subscriberCount{ 0 };
+        std::thread thread;
+    };
+}
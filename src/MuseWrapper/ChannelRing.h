@@ -0,0 +1,132 @@
+#pragma once
+
+#include <memory_resource>
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Per-channel circular time series stored structure-of-arrays: each channel has its own
+    /// contiguous row starting on a 64-byte boundary, with a power-of-two capacity. Every sample is
+    /// written twice, at its slot and one capacity further on, so the newest N samples of a channel
+    /// are always one contiguous oldest-first run and DSP kernels can stream over them without
+    /// unrolling the ring.
+    ///
+    /// One thread pushes. Other threads may copy recent samples with CopyLatest, which checks the
+    /// write count afterwards and fails rather than return samples overwritten during the copy.
+    /// </summary>
+    template <typename T>
+    class ChannelRing
+    {
+    public:
+        static constexpr size_t Alignment = 64;
+
+        ChannelRing(int channels, size_t capacity, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+            : channels(channels),
+              memory(memory)
+        {
+            if (channels <= 0 || capacity == 0)
+            {
+                throw std::invalid_argument("A channel ring needs at least one channel and one sample");
+            }
+            this->capacity = 1;
+            while (this->capacity < capacity)
+            {
+                this->capacity <<= 1;
+            }
+            mask = this->capacity - 1;
+            constexpr size_t perLine = Alignment / sizeof(T);
+            stride = (2 * this->capacity + perLine - 1) / perLine * perLine;
+            bytes = stride * static_cast<size_t>(channels) * sizeof(T);
+            data = static_cast<T*>(memory->allocate(bytes, Alignment));
+            std::fill(data, data + stride * static_cast<size_t>(channels), T());
+        }
+
+        ~ChannelRing()
+        {
+            memory->deallocate(data, bytes, Alignment);
+        }
+
+        /// <summary>
+        /// Capacity for which CopyLatest can return at least the last seconds of samples at rate
+        /// </summary>
+        static size_t CapacityFor(double seconds, double rate)
+        {
+            return static_cast<size_t>(std::ceil(seconds * rate)) + 1;
+        }
+
+        ChannelRing(const ChannelRing&) = delete;
+        ChannelRing& operator=(const ChannelRing&) = delete;
+
+        int Channels() const { return channels; }
+        size_t Capacity() const { return capacity; }
+
+        /// <summary>
+        /// Samples pushed since construction or the last Reset
+        /// </summary>
+        uint64_t Count() const { return written.load(std::memory_order_acquire); }
+        size_t Filled() const { return static_cast<size_t>(std::min<uint64_t>(Count(), capacity)); }
+
+        /// <summary>
+        /// Writer only: appends one sample for every channel
+        /// </summary>
+        void Push(const T* values)
+        {
+            uint64_t count = written.load(std::memory_order_relaxed);
+            size_t slot = static_cast<size_t>(count) & mask;
+            for (int c = 0; c < channels; c++)
+            {
+                T* row = Row(c);
+                row[slot] = values[c];
+                row[slot + capacity] = values[c];
+            }
+            written.store(count + 1, std::memory_order_release);
+        }
+
+        /// <summary>
+        /// Writer only: the newest length (at most Capacity) samples of a channel, oldest first.
+        /// Samples not yet written read as zero.
+        /// </summary>
+        const T* Latest(int channel, size_t length) const
+        {
+            size_t end = (static_cast<size_t>(written.load(std::memory_order_relaxed)) & mask) + capacity;
+            return Row(channel) + (end - length);
+        }
+
+        /// <summary>
+        /// Any thread: copies the newest samples of a channel, oldest first, up to length and at most
+        /// Capacity - 1. Returns the number copied, or 0 if the writer lapped the copy.
+        /// </summary>
+        size_t CopyLatest(int channel, T* out, size_t length) const
+        {
+            uint64_t before = written.load(std::memory_order_acquire);
+            size_t count = static_cast<size_t>(std::min<uint64_t>({ before, static_cast<uint64_t>(length), capacity - 1 }));
+            size_t start = static_cast<size_t>(before - count) & mask;
+            std::memcpy(out, Row(channel) + start, count * sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // The slot being filled next overwrites sample (after - capacity)
+            uint64_t after = written.load(std::memory_order_relaxed);
+            return after - (before - count) < capacity ? count : 0;
+        }
+
+        /// <summary>
+        /// Writer only: forgets every sample
+        /// </summary>
+        void Reset()
+        {
+            std::fill(data, data + stride * static_cast<size_t>(channels), T());
+            written.store(0, std::memory_order_release);
+        }
+
+    private:
+        T* Row(int channel) const { return data + static_cast<size_t>(channel) * stride; }
+
+        int channels;
+        size_t capacity = 0;
+        size_t mask = 0;
+        size_t stride = 0;      // elements per row, a whole number of cache lines
+        size_t bytes = 0;
+        std::pmr::memory_resource* memory;
+        T* data = nullptr;
+        std::atomic<uint64_t> written{ 0 };
+    };
+}
@@ -0,0 +1,60 @@
+// ChartApi.cpp : Exported entry points for downsampled chart queries over recordings.
+#include "pch.h"
+#include "ApiSupport.h"
+#include "ChartSource.h"
+
+using namespace MuseWrapper;
+
+namespace
+{
+    HandleTable<ChartSource> charts;
+}
+
+int MwChartOpen(const char* recordingPath, int* handleOut, int64_t* durationUsOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(recordingPath != nullptr && handleOut != nullptr, "recordingPath and handleOut are required");
+        auto chart = std::make_shared<ChartSource>(recordingPath);
+        if (durationUsOut != nullptr)
+        {
+            const std::vector<RecordingBlock>& blocks = chart->Reader().Blocks();
+            *durationUsOut = blocks.empty() ? 0 : blocks.back().lastTimestampUs - chart->Reader().SyncTimestampUs();
+        }
+        *handleOut = charts.Add(std::move(chart));
+        return MW_OK;
+    });
+}
+
+int MwChartClose(int handle, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        charts.Remove(handle);
+        return MW_OK;
+    });
+}
+
+int MwChartQuery(int handle, int packetType, int channel, int64_t fromUs, int64_t toUs, int width, int mode, MwChartPoint* pointsOut, int maxPoints, int* countOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(packetType >= 0 && packetType < PacketTypeCount, "Unknown packet type");
+        Require(mode == MW_CHART_LTTB || mode == MW_CHART_MINMAX, "Unknown chart mode");
+        Require(width > 0 && fromUs <= toUs, "width must be positive and fromUs <= toUs");
+        Require(pointsOut != nullptr && countOut != nullptr, "pointsOut and countOut are required");
+        Require(maxPoints >= (mode == MW_CHART_MINMAX ? 2 * width : width), "maxPoints must hold width points (2 * width for min/max)");
+
+        std::shared_ptr<ChartSource> chart = charts.Get(handle);
+        int64_t sync = chart->Reader().SyncTimestampUs();
+        std::vector<ChartSample> points;
+        chart->Query(static_cast<MuseDataPacketType>(packetType), channel, sync + fromUs, sync + toUs, width,
+            mode == MW_CHART_MINMAX ? ChartMode::MinMax : ChartMode::Lttb, points);
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            pointsOut[i] = { points[i].timestampUs - sync, points[i].value };
+        }
+        *countOut = static_cast<int>(points.size());
+        return points.empty() ? MW_NO_DATA : MW_OK;
+    });
+}
@@ -0,0 +1,241 @@
+// ChartSource.cpp : Downsampled chart queries over recorded sessions.
+#include "pch.h"
+#include "ChartSource.h"
+#include "Downsampling.h"
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        struct NodeBuilder
+        {
+            int64_t startUs = 0;
+            int64_t minUs = 0;
+            int64_t maxUs = 0;
+            float min = 0.0f;
+            float max = 0.0f;
+            size_t count = 0;
+        };
+
+        template <typename Level>
+        void Append(Level& level, const NodeBuilder& node)
+        {
+            level.startUs.push_back(node.startUs);
+            level.minUs.push_back(node.minUs);
+            level.maxUs.push_back(node.maxUs);
+            level.min.push_back(node.min);
+            level.max.push_back(node.max);
+        }
+
+        void Merge(NodeBuilder& node, int64_t startUs, int64_t minUs, float min, int64_t maxUs, float max)
+        {
+            if (node.count++ == 0)
+            {
+                node = { startUs, minUs, maxUs, min, max, 1 };
+                return;
+            }
+            if (min < node.min)
+            {
+                node.min = min;
+                node.minUs = minUs;
+            }
+            if (max > node.max)
+            {
+                node.max = max;
+                node.maxUs = maxUs;
+            }
+        }
+
+        // Nodes [first, last) of a level whose span can overlap [fromUs, toUs]
+        template <typename Level>
+        void NodeRange(const Level& level, int64_t fromUs, int64_t toUs, size_t& first, size_t& last)
+        {
+            auto begin = level.startUs.begin();
+            auto firstIt = std::upper_bound(begin, level.startUs.end(), fromUs);
+            first = static_cast<size_t>(firstIt - begin);
+            first = first > 0 ? first - 1 : 0;
+            last = static_cast<size_t>(std::upper_bound(begin, level.startUs.end(), toUs) - begin);
+        }
+    }
+
+    ChartSource::ChartSource(const std::string& path)
+        : reader(path)
+    {
+    }
+
+    std::shared_ptr<const ChartSource::Pyramid> ChartSource::GetPyramid(MuseDataPacketType packetType)
+    {
+        size_t type = static_cast<size_t>(packetType);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (pyramids[type] != nullptr)
+            {
+                return pyramids[type];
+            }
+        }
+
+        std::lock_guard<std::mutex> build(buildLock);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (pyramids[type] != nullptr)
+            {
+                return pyramids[type];
+            }
+        }
+        std::shared_ptr<const Pyramid> pyramid = Build(packetType);
+        std::lock_guard<std::mutex> guard(lock);
+        pyramids[type] = pyramid;
+        return pyramid;
+    }
+
+    std::shared_ptr<const ChartSource::Pyramid> ChartSource::Build(MuseDataPacketType packetType)
+    {
+        auto pyramid = std::make_shared<Pyramid>();
+        std::vector<NodeBuilder> nodes;
+        std::vector<StoredPacket> block;
+        uint8_t type = static_cast<uint8_t>(packetType);
+
+        for (size_t b = 0; b < reader.Blocks().size(); b++)
+        {
+            reader.ReadBlock(b, block);
+            for (const StoredPacket& packet : block)
+            {
+                if (packet.type != type)
+                {
+                    continue;
+                }
+                // ReadBlock refuses longer packets; bounded here too since values is a fixed array
+                size_t valueCount = std::min<size_t>(packet.valueCount, MaxPacketValues);
+                if (valueCount > pyramid->channels.size())
+                {
+                    pyramid->channels.resize(valueCount, std::vector<Level>(1));
+                    nodes.resize(valueCount);
+                }
+                for (size_t channel = 0; channel < valueCount; channel++)
+                {
+                    NodeBuilder& node = nodes[channel];
+                    float value = packet.values[channel];
+                    Merge(node, packet.timestampUs, packet.timestampUs, value, packet.timestampUs, value);
+                    if (node.count == FanOut)
+                    {
+                        Append(pyramid->channels[channel][0], node);
+                        node.count = 0;
+                    }
+                }
+            }
+        }
+
+        for (size_t channel = 0; channel < pyramid->channels.size(); channel++)
+        {
+            std::vector<Level>& levels = pyramid->channels[channel];
+            if (nodes[channel].count > 0)
+            {
+                Append(levels[0], nodes[channel]);
+            }
+            while (levels.back().startUs.size() > FanOut)
+            {
+                Level next;
+                const Level& below = levels.back();
+                NodeBuilder node;
+                for (size_t i = 0; i < below.startUs.size(); i++)
+                {
+                    Merge(node, below.startUs[i], below.minUs[i], below.min[i], below.maxUs[i], below.max[i]);
+                    if (node.count == FanOut || i + 1 == below.startUs.size())
+                    {
+                        Append(next, node);
+                        node.count = 0;
+                    }
+                }
+                levels.push_back(std::move(next));
+            }
+        }
+        return pyramid;
+    }
+
+    void ChartSource::ReadRaw(MuseDataPacketType packetType, int channel, int64_t fromUs, int64_t toUs,
+        std::vector<int64_t>& timestamps, std::vector<float>& values)
+    {
+        std::vector<StoredPacket> block;
+        uint8_t type = static_cast<uint8_t>(packetType);
+        const std::vector<RecordingBlock>& blocks = reader.Blocks();
+        for (size_t b = reader.FindBlock(fromUs); b < blocks.size() && blocks[b].firstTimestampUs <= toUs; b++)
+        {
+            reader.ReadBlock(b, block);
+            for (const StoredPacket& packet : block)
+            {
+                if (packet.type == type && std::min<int>(packet.valueCount, MaxPacketValues) > channel
+                    && packet.timestampUs >= fromUs && packet.timestampUs <= toUs)
+                {
+                    timestamps.push_back(packet.timestampUs);
+                    values.push_back(packet.values[channel]);
+                }
+            }
+        }
+    }
+
+    void ChartSource::Query(MuseDataPacketType packetType, int channel, int64_t fromUs, int64_t toUs, int width, ChartMode mode,
+        std::vector<ChartSample>& points)
+    {
+        std::shared_ptr<const Pyramid> pyramid = GetPyramid(packetType);
+        if (channel < 0 || static_cast<size_t>(channel) >= pyramid->channels.size() || width <= 0 || toUs < fromUs)
+        {
+            return;
+        }
+        const std::vector<Level>& levels = pyramid->channels[static_cast<size_t>(channel)];
+        size_t pixels = static_cast<size_t>(width);
+
+        // Short ranges are cheap enough to decimate exactly from the raw samples
+        size_t first;
+        size_t last;
+        NodeRange(levels[0], fromUs, toUs, first, last);
+        size_t rawLimit = std::max<size_t>(65536, 32 * pixels);
+        std::vector<int64_t> timestamps;
+        std::vector<float> values;
+        if ((last - first) * FanOut <= rawLimit)
+        {
+            ReadRaw(packetType, channel, fromUs, toUs, timestamps, values);
+        }
+        else
+        {
+            // Otherwise use the finest level with at most 8 nodes per pixel; each node contributes its extremes
+            size_t level = 0;
+            while (level + 1 < levels.size() && last - first > 8 * pixels)
+            {
+                level++;
+                NodeRange(levels[level], fromUs, toUs, first, last);
+            }
+            const Level& nodes = levels[level];
+            timestamps.reserve(2 * (last - first));
+            values.reserve(2 * (last - first));
+            for (size_t i = first; i < last; i++)
+            {
+                bool minFirst = nodes.minUs[i] <= nodes.maxUs[i];
+                int64_t times[2] = { minFirst ? nodes.minUs[i] : nodes.maxUs[i], minFirst ? nodes.maxUs[i] : nodes.minUs[i] };
+                float extremes[2] = { minFirst ? nodes.min[i] : nodes.max[i], minFirst ? nodes.max[i] : nodes.min[i] };
+                for (int k = 0; k < (times[0] == times[1] ? 1 : 2); k++)
+                {
+                    if (times[k] >= fromUs && times[k] <= toUs)
+                    {
+                        timestamps.push_back(times[k]);
+                        values.push_back(extremes[k]);
+                    }
+                }
+            }
+        }
+
+        std::vector<double> x(timestamps.size());
+        for (size_t i = 0; i < timestamps.size(); i++)
+        {
+            x[i] = static_cast<double>(timestamps[i] - fromUs);
+        }
+        std::vector<size_t> selected(mode == ChartMode::MinMax ? 2 * pixels : pixels);
+        size_t count = mode == ChartMode::MinMax
+            ? MinMaxDecimate(x.data(), values.data(), x.size(), 0.0, static_cast<double>(toUs - fromUs), pixels, selected.data())
+            : LargestTriangleThreeBuckets(x.data(), values.data(), x.size(), pixels, selected.data());
+        points.reserve(points.size() + count);
+        for (size_t i = 0; i < count; i++)
+        {
+            points.push_back({ timestamps[selected[i]], values[selected[i]] });
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "SessionRecording.h"
+
+namespace MuseWrapper
+{
+    enum class ChartMode : int
+    {
+        Lttb,
+        MinMax,
+    };
+
+    struct ChartSample
+    {
+        int64_t timestampUs;
+        float value;
+    };
+
+    /// <summary>
+    /// Answers chart queries over a recording. The first query for a packet type reads the recording once
+    /// and builds a min/max pyramid per channel (fan-out 16); later queries over long ranges run on
+    /// pyramid nodes in O(width), while short ranges are decimated from the raw samples.
+    /// Queries may run concurrently.
+    /// </summary>
+    class ChartSource
+    {
+    public:
+        static constexpr size_t FanOut = 16;
+
+        explicit ChartSource(const std::string& path);
+
+        /// <summary>
+        /// Reduces channel of packetType over [fromUs, toUs] (absolute packet timestamps) to about width points
+        /// (2 * width for MinMax), appending them to points in time order
+        /// </summary>
+        void Query(MuseDataPacketType packetType, int channel, int64_t fromUs, int64_t toUs, int width, ChartMode mode,
+            std::vector<ChartSample>& points);
+
+        RecordingReader& Reader() { return reader; }
+
+    private:
+        struct Level
+        {
+            std::vector<int64_t> startUs;
+            std::vector<int64_t> minUs;
+            std::vector<int64_t> maxUs;
+            std::vector<float> min;
+            std::vector<float> max;
+        };
+
+        struct Pyramid
+        {
+            // levels[0] aggregates FanOut raw samples per node, each further level FanOut nodes of the one below
+            std::vector<std::vector<Level>> channels;
+        };
+
+        std::shared_ptr<const Pyramid> GetPyramid(MuseDataPacketType packetType);
+        std::shared_ptr<const Pyramid> Build(MuseDataPacketType packetType);
+        void ReadRaw(MuseDataPacketType packetType, int channel, int64_t fromUs, int64_t toUs,
+            std::vector<int64_t>& timestamps, std::vector<float>& values);
+
+        RecordingReader reader;
+        std::mutex lock;
+        std::mutex buildLock;
+        std::array<std::shared_ptr<const Pyramid>, PacketTypeCount> pyramids;
+    };
+}
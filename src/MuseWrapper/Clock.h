@@ -0,0 +1,13 @@
+#pragma once
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Monotonic high-resolution time in nanoseconds, used for all pipeline timestamps
+    /// </summary>
+    inline uint64_t MonotonicNanoseconds()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+}
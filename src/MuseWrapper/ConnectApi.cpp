@@ -0,0 +1,153 @@
+// ConnectApi.cpp : Exported entry points for the native connection state machine.
+#include "pch.h"
+#include "ApiHandles.h"
+#include "ApiSupport.h"
+#include "DeviceConnection.h"
+
+using namespace MuseWrapper;
+
+namespace
+{
+    constexpr int64_t MsToNs = 1'000'000;
+
+    HandleTable<DeviceConnection> connections;
+
+    std::mutex libmuseLock;
+    std::shared_ptr<const LibmuseBinding> libmuse;     // guarded by libmuseLock
+
+    std::shared_ptr<const LibmuseBinding> LoadedLibmuse()
+    {
+        std::lock_guard<std::mutex> guard(libmuseLock);
+        if (!libmuse)
+        {
+            throw ApiError(MW_FAILURE, "Call MwLibmuseLoad before connecting");
+        }
+        return libmuse;
+    }
+
+    ConnectOptions ToOptions(const MwConnectOptions* settings)
+    {
+        ConnectOptions options;
+        if (settings == nullptr)
+        {
+            return options;
+        }
+        Require(settings->attempts >= 1 && settings->configurationReads >= 1, "attempts and configurationReads must be at least 1");
+        Require(settings->attemptTimeoutMs > 0 && settings->disconnectTimeoutMs > 0, "Timeouts must be positive");
+        Require(settings->backoffMs >= 0 && settings->maxBackoffMs >= 0 && settings->configurationRetryMs >= 0, "Delays cannot be negative");
+        options.preset = settings->preset;
+        options.attempts = settings->attempts;
+        options.attemptTimeoutNs = static_cast<uint64_t>(settings->attemptTimeoutMs * MsToNs);
+        options.backoffNs = static_cast<uint64_t>(settings->backoffMs * MsToNs);
+        options.maxBackoffNs = static_cast<uint64_t>(settings->maxBackoffMs * MsToNs);
+        options.disconnectTimeoutNs = static_cast<uint64_t>(settings->disconnectTimeoutMs * MsToNs);
+        options.configurationReads = settings->configurationReads;
+        options.configurationRetryNs = static_cast<uint64_t>(settings->configurationRetryMs * MsToNs);
+        return options;
+    }
+}
+
+int MwLibmuseLoad(const char* path, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        std::string requested = path != nullptr ? path : "";
+        std::lock_guard<std::mutex> guard(libmuseLock);
+        if (libmuse)
+        {
+            // Connections keep the library they were started with, so switching mid-session is refused
+            if (!requested.empty() && requested != libmuse->Path())
+            {
+                throw ApiError(MW_INVALID_ARGUMENT, "libmuse is already loaded from " + libmuse->Path());
+            }
+            return MW_OK;
+        }
+        libmuse = LibmuseBinding::Load(requested);
+        return MW_OK;
+    });
+}
+
+int MwConnectGetDefaultOptions(MwConnectOptions* optionsOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(optionsOut != nullptr, "optionsOut is required");
+        ConnectOptions options;
+        optionsOut->preset = options.preset;
+        optionsOut->attempts = options.attempts;
+        optionsOut->attemptTimeoutMs = static_cast<int32_t>(options.attemptTimeoutNs / MsToNs);
+        optionsOut->backoffMs = static_cast<int32_t>(options.backoffNs / MsToNs);
+        optionsOut->maxBackoffMs = static_cast<int32_t>(options.maxBackoffNs / MsToNs);
+        optionsOut->disconnectTimeoutMs = static_cast<int32_t>(options.disconnectTimeoutNs / MsToNs);
+        optionsOut->configurationReads = options.configurationReads;
+        optionsOut->configurationRetryMs = static_cast<int32_t>(options.configurationRetryNs / MsToNs);
+        return MW_OK;
+    });
+}
+
+int MwConnectStart(const char* macAddress, const MwConnectOptions* options, MwConnectCallback callback, void* context, int* handleOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(macAddress != nullptr && macAddress[0] != '\0', "macAddress is required");
+        Require(handleOut != nullptr, "handleOut is required");
+        ConnectOptions settings = ToOptions(options);
+
+        // The handle is only known once the connection exists; it is set before the connection starts
+        auto handle = std::make_shared<int>(0);
+        DeviceConnection::PhaseCallback onPhase;
+        if (callback != nullptr)
+        {
+            onPhase = [callback, context, handle](ConnectPhase phase, const std::string& message)
+            {
+                callback(*handle, static_cast<int>(phase), message.c_str(), context);
+            };
+        }
+        auto connection = DeviceConnection::Create(LoadedLibmuse(), SharedTimerWheel(), macAddress, settings, std::move(onPhase));
+        *handle = connections.Add(connection);
+        connection->Start();
+        *handleOut = *handle;
+        return MW_OK;
+    });
+}
+
+int MwConnectDestroy(int handle, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        connections.Remove(handle);
+        return MW_OK;
+    });
+}
+
+int MwConnectGetStatus(int handle, MwConnectStatus* statusOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(statusOut != nullptr, "statusOut is required");
+        ConnectStatus status = connections.Get(handle)->Status();
+        statusOut->connectedNs = static_cast<int64_t>(status.connectedNs);
+        statusOut->readyNs = static_cast<int64_t>(status.readyNs);
+        statusOut->phase = static_cast<int32_t>(status.phase);
+        statusOut->connectionState = static_cast<int32_t>(status.connectionState);
+        statusOut->attempts = status.attempts;
+        statusOut->configurationReads = status.configurationReads;
+        return MW_OK;
+    });
+}
+
+int MwConnectGetConfiguration(int handle, char* jsonOut, int jsonLen, int* lengthOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(lengthOut != nullptr, "lengthOut is required");
+        std::string json = connections.Get(handle)->Configuration();
+        if (json.empty())
+        {
+            throw ApiError(MW_NO_DATA, "The configuration has not been read yet");
+        }
+        *lengthOut = static_cast<int>(json.size()) + 1;
+        WriteError(jsonOut, jsonLen, json.c_str());     // same truncating copy the JSON needs
+        return MW_OK;
+    });
+}
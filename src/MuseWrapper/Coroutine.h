@@ -0,0 +1,76 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Owning handle to a coroutine that starts suspended and stays suspended at its end, so its owner
+    /// decides which thread runs it and when its frame is freed. There is no result: coroutines that
+    /// can fail catch their own errors. Destroying the Task destroys the frame wherever it is
+    /// suspended, so the owner must make sure nothing is about to resume it.
+    /// </summary>
+    class Task
+    {
+    public:
+        struct promise_type
+        {
+            Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+
+        Task() = default;
+
+        Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+        Task& operator=(Task&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+                handle = std::exchange(other.handle, nullptr);
+            }
+            return *this;
+        }
+
+        ~Task()
+        {
+            Reset();
+        }
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        /// <summary>
+        /// Runs the coroutine until its first suspension point
+        /// </summary>
+        void Start()
+        {
+            handle.resume();
+        }
+
+        bool Done() const
+        {
+            return !handle || handle.done();
+        }
+
+    private:
+        explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+        void Reset()
+        {
+            if (handle)
+            {
+                handle.destroy();
+                handle = nullptr;
+            }
+        }
+
+        std::coroutine_handle<promise_type> handle;
+    };
+}
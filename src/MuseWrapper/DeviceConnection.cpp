@@ -0,0 +1,407 @@
+#include "pch.h"
+#include "DeviceConnection.h"
+#include "Clock.h"
+#include "Rcu.h"
+#include "TimerWheel.h"
+#include "Tracing.h"
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        using ConnectionTable = std::unordered_map<std::string, DeviceConnection*>;
+
+        // Connections by MAC, read by the one libmuse listener shared by every device
+        struct Registry
+        {
+            std::mutex writeLock;
+            Snapshot<ConnectionTable> connections;
+        };
+
+        // Never destroyed: libmuse may still report connection changes while statics are torn down
+        Registry& Connections()
+        {
+            static Registry* registry = new Registry();
+            return *registry;
+        }
+
+        // The value after "key": in libmuse's flat connection JSON; quotes are stripped from strings
+        std::string JsonField(const char* json, const char* key)
+        {
+            std::string pattern = std::string("\"") + key + "\":";
+            const char* found = std::strstr(json, pattern.c_str());
+            if (found == nullptr)
+            {
+                return std::string();
+            }
+            const char* value = found + pattern.size();
+            while (*value == ' ')
+            {
+                value++;
+            }
+            if (*value == '"')
+            {
+                const char* end = std::strchr(++value, '"');
+                return end != nullptr ? std::string(value, end) : std::string();
+            }
+            const char* end = value;
+            while (*end != '\0' && *end != ',' && *end != '}')
+            {
+                end++;
+            }
+            return std::string(value, end);
+        }
+
+        std::string Seconds(uint64_t ns)
+        {
+            char text[32];
+            std::snprintf(text, sizeof(text), "%.1f s", static_cast<double>(ns) / 1e9);
+            return text;
+        }
+    }
+
+    std::shared_ptr<DeviceConnection> DeviceConnection::Create(std::shared_ptr<const LibmuseBinding> libmuse, TimerWheel& wheel,
+        const std::string& mac, const ConnectOptions& options, PhaseCallback onPhase)
+    {
+        if (options.attempts < 1 || options.configurationReads < 1)
+        {
+            throw std::invalid_argument("attempts and configurationReads must be at least 1");
+        }
+        std::shared_ptr<DeviceConnection> connection(new DeviceConnection(std::move(libmuse), wheel, mac, options, std::move(onPhase)),
+            &DeviceConnection::Destroy);
+
+        Registry& registry = Connections();
+        {
+            std::lock_guard<std::mutex> guard(registry.writeLock);
+            if (registry.connections.Read().count(mac) != 0)
+            {
+                throw std::logic_error(mac + " is already being connected");
+            }
+            registry.connections.Update([&](ConnectionTable& table) { table.emplace(mac, connection.get()); });
+        }
+        connection->registered = true;
+        connection->libmuse->RegisterConnectionListener(mac, &DeviceConnection::OnConnectionPacket);
+        connection->task = connection->Run();
+        return connection;
+    }
+
+    void DeviceConnection::Start()
+    {
+        // Timers due in the same tick fire in no guaranteed order, so events queued since Create may be
+        // drained before the first step. With nothing awaiting they only record the state, and Run starts
+        // by reading the current state from libmuse, so none is missed either way.
+        startNs = MonotonicNanoseconds();
+        wheel.Schedule(0, 0, [weak = weak_from_this()](uint64_t)
+        {
+            if (auto self = weak.lock())
+            {
+                self->task.Start();
+            }
+        });
+    }
+
+    DeviceConnection::DeviceConnection(std::shared_ptr<const LibmuseBinding> libmuse, TimerWheel& wheel, const std::string& mac,
+        const ConnectOptions& options, PhaseCallback onPhase)
+        : libmuse(std::move(libmuse)), wheel(wheel), mac(mac), options(options), onPhase(std::move(onPhase))
+    {
+    }
+
+    void DeviceConnection::Destroy(DeviceConnection* connection)
+    {
+        // The destructor synchronises with readers, which cannot be done from inside a read; wheel
+        // callbacks run outside any read
+        if (Epochs::Reading())
+        {
+            connection->wheel.Schedule(0, 0, [connection](uint64_t) { delete connection; });
+            return;
+        }
+        delete connection;
+    }
+
+    DeviceConnection::~DeviceConnection()
+    {
+        if (!registered)
+        {
+            return;
+        }
+        Registry& registry = Connections();
+        {
+            std::lock_guard<std::mutex> guard(registry.writeLock);
+            registry.connections.Update([this](ConnectionTable& table) { table.erase(mac); });
+        }
+        // The listener may be queueing an event on this connection right now
+        Epochs::Synchronize();
+        try
+        {
+            libmuse->UnregisterConnectionListener(mac, &DeviceConnection::OnConnectionPacket);
+        }
+        catch (const std::exception&)
+        {
+            // The device is gone from libmuse's list; there is nothing left to unregister from
+        }
+
+        // Wheel callbacks hold a strong reference while they run, so none is running here and any
+        // still scheduled find the connection gone
+        if (timer != 0)
+        {
+            wheel.Cancel(timer);
+        }
+    }
+
+    ConnectStatus DeviceConnection::Status() const
+    {
+        std::lock_guard<std::mutex> guard(statusLock);
+        return status;
+    }
+
+    std::string DeviceConnection::Configuration() const
+    {
+        std::lock_guard<std::mutex> guard(statusLock);
+        return configuration;
+    }
+
+    Task DeviceConnection::Run()
+    {
+        try
+        {
+            // Every later state arrives as an event
+            state = static_cast<ConnectionState>(libmuse->GetConnectionState(mac));
+            {
+                std::lock_guard<std::mutex> guard(statusLock);
+                status.connectionState = state;
+            }
+
+            if (state == ConnectionState::Connected || state == ConnectionState::Connecting)
+            {
+                SetPhase(ConnectPhase::Disconnecting, "Dropping the previous link");
+                libmuse->Disconnect(mac);
+                if (co_await WaitForState(ConnectionState::Disconnected, options.disconnectTimeoutNs) != WaitResult::Reached)
+                {
+                    SetPhase(ConnectPhase::Failed, "Still connected " + Seconds(options.disconnectTimeoutNs) + " after disconnecting");
+                    co_return;
+                }
+            }
+
+            libmuse->SetPreset(mac, options.preset);
+            libmuse->EnableDataTransmission(mac, true);
+
+            for (int attempt = 1; ; attempt++)
+            {
+                {
+                    std::lock_guard<std::mutex> guard(statusLock);
+                    status.attempts = attempt;
+                }
+                SetPhase(ConnectPhase::Connecting, "Attempt " + std::to_string(attempt) + " of " + std::to_string(options.attempts));
+                if (state != ConnectionState::Connected)
+                {
+                    libmuse->RunAsynchronously(mac);
+                }
+
+                WaitResult result = co_await WaitForState(ConnectionState::Connected, options.attemptTimeoutNs);
+                if (result == WaitResult::Reached)
+                {
+                    break;
+                }
+                if (attempt == options.attempts)
+                {
+                    SetPhase(ConnectPhase::Failed, "Not connected after " + std::to_string(attempt) + " attempts");
+                    co_return;
+                }
+                if (result == WaitResult::TimedOut)
+                {
+                    // Stop libmuse's own attempt so the next one starts clean
+                    libmuse->Disconnect(mac);
+                    co_await WaitForState(ConnectionState::Disconnected, options.disconnectTimeoutNs);
+                }
+                int doublings = std::min(attempt - 1, 16);
+                co_await Delay(std::min(options.backoffNs << doublings, options.maxBackoffNs));
+            }
+
+            {
+                std::lock_guard<std::mutex> guard(statusLock);
+                status.connectedNs = MonotonicNanoseconds() - startNs;
+            }
+            SetPhase(ConnectPhase::Configuring, "Connected");
+
+            // libmuse has no event for the configuration arriving, so it is read on a short timer
+            for (int read = 1; ; read++)
+            {
+                {
+                    std::lock_guard<std::mutex> guard(statusLock);
+                    status.configurationReads = read;
+                }
+                std::string json;
+                std::string failure;
+                try
+                {
+                    json = libmuse->GetMuseConfiguration(mac);
+                }
+                catch (const std::runtime_error& e)
+                {
+                    failure = e.what();
+                }
+                if (failure.empty())
+                {
+                    std::lock_guard<std::mutex> guard(statusLock);
+                    configuration = std::move(json);
+                    break;
+                }
+                if (read == options.configurationReads)
+                {
+                    SetPhase(ConnectPhase::Failed, failure);
+                    co_return;
+                }
+
+                co_await Delay(options.configurationRetryNs);
+                if (state != ConnectionState::Connected)
+                {
+                    SetPhase(ConnectPhase::Failed, "Disconnected while reading the configuration");
+                    co_return;
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> guard(statusLock);
+                status.readyNs = MonotonicNanoseconds() - startNs;
+            }
+            SetPhase(ConnectPhase::Ready, "Configured and streaming");
+        }
+        catch (const std::exception& e)
+        {
+            SetPhase(ConnectPhase::Failed, e.what());
+        }
+    }
+
+    void DeviceConnection::Suspend(std::coroutine_handle<> handle, std::optional<ConnectionState> target, uint64_t timeoutNs)
+    {
+        waiting = handle;
+        awaited = target;
+        wakeResult = WaitResult::TimedOut;
+        timer = wheel.Schedule(timeoutNs, 0, [weak = weak_from_this()](uint64_t)
+        {
+            if (auto self = weak.lock())
+            {
+                self->timer = 0;
+                self->Wake(WaitResult::TimedOut);
+            }
+        });
+    }
+
+    void DeviceConnection::Wake(WaitResult result)
+    {
+        if (timer != 0)
+        {
+            wheel.Cancel(timer);
+            timer = 0;
+        }
+        awaited.reset();
+        wakeResult = result;
+        if (std::coroutine_handle<> resumed = std::exchange(waiting, nullptr))
+        {
+            resumed.resume();
+        }
+    }
+
+    void DeviceConnection::SetPhase(ConnectPhase phase, const std::string& message)
+    {
+        {
+            std::lock_guard<std::mutex> guard(statusLock);
+            status.phase = phase;
+        }
+        if (onPhase)
+        {
+            onPhase(phase, message);
+        }
+    }
+
+    void MW_LIBMUSE_CALL DeviceConnection::OnConnectionPacket(const char* json)
+    {
+        if (json == nullptr)
+        {
+            return;
+        }
+        std::string mac = JsonField(json, "bluetoothMac");
+        std::string current = JsonField(json, "currentConnectionState");
+        if (mac.empty() || current.empty())
+        {
+            return;
+        }
+
+        Epochs::ReadGuard reading;
+        const ConnectionTable& table = Connections().connections.Read();
+        auto found = table.find(mac);
+        if (found != table.end())
+        {
+            found->second->QueueEvent(static_cast<ConnectionState>(std::atoi(current.c_str())));
+        }
+    }
+
+    void DeviceConnection::QueueEvent(ConnectionState next)
+    {
+        bool schedule;
+        {
+            std::lock_guard<std::mutex> guard(eventLock);
+            events.push_back(next);
+            schedule = !drainScheduled;
+            drainScheduled = true;
+        }
+        // Timers due in the same tick fire in no particular order, so one callback takes the events in turn
+        if (schedule)
+        {
+            wheel.Schedule(0, 0, [weak = weak_from_this()](uint64_t)
+            {
+                if (auto self = weak.lock())
+                {
+                    self->DrainEvents();
+                }
+            });
+        }
+    }
+
+    void DeviceConnection::DrainEvents()
+    {
+        for (;;)
+        {
+            ConnectionState next;
+            {
+                std::lock_guard<std::mutex> guard(eventLock);
+                if (events.empty())
+                {
+                    drainScheduled = false;
+                    return;
+                }
+                next = events.front();
+                events.pop_front();
+            }
+            OnConnectionEvent(next);
+        }
+    }
+
+    void DeviceConnection::OnConnectionEvent(ConnectionState next)
+    {
+        MW_TRACE_SCOPE("connect.event");
+        state = next;
+        ConnectPhase phase;
+        {
+            std::lock_guard<std::mutex> guard(statusLock);
+            status.connectionState = next;
+            phase = status.phase;
+        }
+
+        if (waiting && awaited.has_value())
+        {
+            if (next == *awaited)
+            {
+                Wake(WaitResult::Reached);
+            }
+            else if (next == ConnectionState::Disconnected)
+            {
+                Wake(WaitResult::Dropped);
+            }
+        }
+        else if (phase == ConnectPhase::Ready && next == ConnectionState::Disconnected)
+        {
+            SetPhase(ConnectPhase::Lost, "Disconnected");
+        }
+    }
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "Coroutine.h"
+#include "LibmuseBinding.h"
+#include "MuseTypes.h"
+
+#include <deque>
+#include <optional>
+
+namespace MuseWrapper
+{
+    class TimerWheel;
+
+    enum class ConnectPhase : int
+    {
+        Idle,
+        Disconnecting,      // dropping a stale link before connecting afresh
+        Connecting,
+        Configuring,        // connected, reading the configuration
+        Ready,
+        Failed,
+        Lost,               // disconnected after having been ready
+    };
+
+    struct ConnectOptions
+    {
+        int preset = 21;                                // PRESET_21, as MuseDevice.ConnectAsync sets
+        int attempts = 3;
+        uint64_t attemptTimeoutNs = 30'000'000'000;     // for Connected after RunAsynchronously
+        uint64_t backoffNs = 1'000'000'000;             // after a failed attempt, doubled each time
+        uint64_t maxBackoffNs = 8'000'000'000;
+        uint64_t disconnectTimeoutNs = 5'000'000'000;
+        int configurationReads = 5;
+        uint64_t configurationRetryNs = 500'000'000;
+    };
+
+    struct ConnectStatus
+    {
+        ConnectPhase phase = ConnectPhase::Idle;
+        ConnectionState connectionState = ConnectionState::Unknown;
+        int attempts = 0;
+        int configurationReads = 0;
+        uint64_t connectedNs = 0;       // from start to Connected, 0 until then
+        uint64_t readyNs = 0;           // from start to Ready
+    };
+
+    /// <summary>
+    /// Brings one headband from whatever state libmuse has it in to connected, configured and
+    /// streaming: disconnect if needed, set the preset, enable data, connect with bounded retries
+    /// and backoff, then read the configuration with bounded retries. This is the sequence of
+    /// MuseDevice.ConnectAsync, written as a coroutine that suspends until the libmuse connection
+    /// event it needs arrives or a timer-wheel timeout or backoff expires, so nothing polls.
+    ///
+    /// The coroutine only ever runs on the timer wheel's thread. libmuse connection events are queued
+    /// from libmuse's thread and handed over in order in one wheel callback, which also keeps libmuse
+    /// calls out of libmuse's own listener. The phase callback runs there as well and may destroy the
+    /// connection. Destroying it stops the state machine but leaves the link as it is. Destruction
+    /// waits for libmuse listener calls in progress, so when the last reference goes inside an
+    /// Epochs::ReadGuard (a packet listener, a hub message handler) it is finished on the wheel thread.
+    /// </summary>
+    class DeviceConnection : public std::enable_shared_from_this<DeviceConnection>
+    {
+    public:
+        using PhaseCallback = std::function<void(ConnectPhase phase, const std::string& message)>;
+
+        /// <summary>
+        /// Registers for the device's connection events; throws if libmuse rejects the registration
+        /// or another connection is already driving the device
+        /// </summary>
+        static std::shared_ptr<DeviceConnection> Create(std::shared_ptr<const LibmuseBinding> libmuse, TimerWheel& wheel,
+            const std::string& mac, const ConnectOptions& options, PhaseCallback onPhase);
+
+        ~DeviceConnection();
+
+        DeviceConnection(const DeviceConnection&) = delete;
+        DeviceConnection& operator=(const DeviceConnection&) = delete;
+
+        /// <summary>
+        /// Starts connecting on the wheel thread; call once
+        /// </summary>
+        void Start();
+
+        ConnectStatus Status() const;
+
+        /// <summary>
+        /// Configuration JSON read while configuring, empty until then
+        /// </summary>
+        std::string Configuration() const;
+
+    private:
+        enum class WaitResult
+        {
+            Reached,
+            Dropped,            // disconnected while waiting for another state
+            TimedOut,
+        };
+
+        // Resumes on the awaited connection state, a disconnect, or the timeout, whichever comes first
+        struct StateAwaiter
+        {
+            DeviceConnection& owner;
+            ConnectionState target;
+            uint64_t timeoutNs;
+
+            bool await_ready() const { return owner.state == target; }
+            void await_suspend(std::coroutine_handle<> handle) { owner.Suspend(handle, target, timeoutNs); }
+            WaitResult await_resume() const { return owner.state == target ? WaitResult::Reached : owner.wakeResult; }
+        };
+
+        struct DelayAwaiter
+        {
+            DeviceConnection& owner;
+            uint64_t delayNs;
+
+            bool await_ready() const { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { owner.Suspend(handle, std::nullopt, delayNs); }
+            void await_resume() const {}
+        };
+
+        DeviceConnection(std::shared_ptr<const LibmuseBinding> libmuse, TimerWheel& wheel, const std::string& mac,
+            const ConnectOptions& options, PhaseCallback onPhase);
+
+        // Deleter of the connection's shared_ptr
+        static void Destroy(DeviceConnection* connection);
+
+        Task Run();
+        StateAwaiter WaitForState(ConnectionState target, uint64_t timeoutNs) { return StateAwaiter{ *this, target, timeoutNs }; }
+        DelayAwaiter Delay(uint64_t delayNs) { return DelayAwaiter{ *this, delayNs }; }
+
+        void Suspend(std::coroutine_handle<> handle, std::optional<ConnectionState> target, uint64_t timeoutNs);
+        void Wake(WaitResult result);
+        void SetPhase(ConnectPhase phase, const std::string& message);
+
+        // From libmuse's thread
+        static void MW_LIBMUSE_CALL OnConnectionPacket(const char* json);
+        void QueueEvent(ConnectionState next);
+
+        // On the wheel thread
+        void DrainEvents();
+        void OnConnectionEvent(ConnectionState next);
+
+        std::shared_ptr<const LibmuseBinding> libmuse;
+        TimerWheel& wheel;
+        std::string mac;
+        ConnectOptions options;
+        PhaseCallback onPhase;
+        uint64_t startNs = 0;
+        bool registered = false;        // in the connection table and libmuse's listeners
+
+        // Wheel thread only
+        Task task;
+        ConnectionState state = ConnectionState::Unknown;
+        std::coroutine_handle<> waiting;
+        std::optional<ConnectionState> awaited;
+        WaitResult wakeResult = WaitResult::Reached;
+        uint64_t timer = 0;             // timeout or delay the coroutine is waiting on, 0 if none
+
+        std::mutex eventLock;
+        std::deque<ConnectionState> events;     // guarded by eventLock
+        bool drainScheduled = false;            // guarded by eventLock
+
+        mutable std::mutex statusLock;
+        ConnectStatus status;                   // guarded by statusLock
+        std::string configuration;              // guarded by statusLock
+    };
+}
@@ -0,0 +1,192 @@
+// Downsampling.cpp : Point-reduction algorithms for charting long brain-data series.
+#include "pch.h"
+#include "Downsampling.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MW_DOWNSAMPLE_SSE2 1
+#endif
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        // Index in [first, last) of the point forming the largest triangle with (ax, ay) and (cx, cy).
+        // The doubled area |(ax - cx)(y - ay) - (ax - x)(cy - ay)| is linear in (x, y): |k1 y + k2 x + k0|.
+        size_t LargestTriangle(const double* x, const float* y, size_t first, size_t last, double ax, double ay, double cx, double cy)
+        {
+            double k1 = ax - cx;
+            double k2 = cy - ay;
+            double k0 = -k1 * ay - k2 * ax;
+            double bestArea = -1.0;
+            size_t best = first;
+            size_t i = first;
+
+#ifdef MW_DOWNSAMPLE_SSE2
+            if (last - first >= 4)
+            {
+                const __m128d signMask = _mm_set1_pd(-0.0);
+                const __m128d vk0 = _mm_set1_pd(k0);
+                const __m128d vk1 = _mm_set1_pd(k1);
+                const __m128d vk2 = _mm_set1_pd(k2);
+                const __m128d step = _mm_set1_pd(2.0);
+                __m128d index = _mm_set_pd(static_cast<double>(first + 1), static_cast<double>(first));
+                __m128d bestAreas = _mm_set1_pd(-1.0);
+                __m128d bestIndices = index;
+                for (; i + 2 <= last; i += 2)
+                {
+                    __m128d xs = _mm_loadu_pd(x + i);
+                    __m128d ys = _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + i))));
+                    __m128d area = _mm_andnot_pd(signMask, _mm_add_pd(_mm_add_pd(_mm_mul_pd(vk1, ys), _mm_mul_pd(vk2, xs)), vk0));
+                    __m128d better = _mm_cmpgt_pd(area, bestAreas);
+                    bestAreas = _mm_or_pd(_mm_and_pd(better, area), _mm_andnot_pd(better, bestAreas));
+                    bestIndices = _mm_or_pd(_mm_and_pd(better, index), _mm_andnot_pd(better, bestIndices));
+                    index = _mm_add_pd(index, step);
+                }
+
+                double areas[2];
+                double indices[2];
+                _mm_storeu_pd(areas, bestAreas);
+                _mm_storeu_pd(indices, bestIndices);
+                int lane = areas[1] > areas[0] || (areas[1] == areas[0] && indices[1] < indices[0]) ? 1 : 0;
+                bestArea = areas[lane];
+                best = static_cast<size_t>(indices[lane]);
+            }
+#endif
+
+            for (; i < last; i++)
+            {
+                double area = std::abs(k1 * y[i] + k2 * x[i] + k0);
+                if (area > bestArea)
+                {
+                    bestArea = area;
+                    best = i;
+                }
+            }
+            return best;
+        }
+
+        void BucketMinMax(const float* y, size_t first, size_t last, size_t& minIndex, size_t& maxIndex)
+        {
+            float low = y[first];
+            float high = y[first];
+            size_t i = first + 1;
+
+#ifdef MW_DOWNSAMPLE_SSE2
+            if (last - i >= 8)
+            {
+                __m128 lows = _mm_set1_ps(low);
+                __m128 highs = lows;
+                for (; i + 4 <= last; i += 4)
+                {
+                    __m128 values = _mm_loadu_ps(y + i);
+                    lows = _mm_min_ps(lows, values);
+                    highs = _mm_max_ps(highs, values);
+                }
+                float lanes[4];
+                _mm_storeu_ps(lanes, lows);
+                low = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+                _mm_storeu_ps(lanes, highs);
+                high = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+            }
+#endif
+
+            for (; i < last; i++)
+            {
+                low = std::min(low, y[i]);
+                high = std::max(high, y[i]);
+            }
+
+            // Recover positions with an early-exit scan; the extremes are usually found well before the end
+            minIndex = static_cast<size_t>(std::find(y + first, y + last, low) - y);
+            maxIndex = static_cast<size_t>(std::find(y + first, y + last, high) - y);
+        }
+    }
+
+    size_t LargestTriangleThreeBuckets(const double* x, const float* y, size_t count, size_t threshold, size_t* selected)
+    {
+        if (count <= threshold)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                selected[i] = i;
+            }
+            return count;
+        }
+        if (threshold < 3)
+        {
+            // Too few points for triangles: keep the endpoints
+            size_t written = 0;
+            if (threshold >= 1)
+            {
+                selected[written++] = 0;
+            }
+            if (threshold >= 2)
+            {
+                selected[written++] = count - 1;
+            }
+            return written;
+        }
+
+        double bucketSize = static_cast<double>(count - 2) / static_cast<double>(threshold - 2);
+        size_t written = 0;
+        size_t a = 0;
+        selected[written++] = 0;
+        for (size_t bucket = 0; bucket < threshold - 2; bucket++)
+        {
+            size_t first = static_cast<size_t>(bucket * bucketSize) + 1;
+            size_t last = std::min(static_cast<size_t>((bucket + 1) * bucketSize) + 1, count - 1);
+            size_t nextFirst = last;
+            size_t nextLast = std::min(static_cast<size_t>((bucket + 2) * bucketSize) + 1, count);
+
+            double cx = 0.0;
+            double cy = 0.0;
+            for (size_t i = nextFirst; i < nextLast; i++)
+            {
+                cx += x[i];
+                cy += y[i];
+            }
+            double span = static_cast<double>(std::max<size_t>(nextLast - nextFirst, 1));
+            cx /= span;
+            cy /= span;
+
+            a = LargestTriangle(x, y, first, last, x[a], y[a], cx, cy);
+            selected[written++] = a;
+        }
+        selected[written++] = count - 1;
+        return written;
+    }
+
+    size_t MinMaxDecimate(const double* x, const float* y, size_t count, double from, double to, size_t width, size_t* selected)
+    {
+        if (width == 0 || count == 0 || !(to > from))
+        {
+            return 0;
+        }
+        double columnWidth = (to - from) / static_cast<double>(width);
+        size_t written = 0;
+        size_t first = static_cast<size_t>(std::lower_bound(x, x + count, from) - x);
+        for (size_t column = 0; column < width && first < count; column++)
+        {
+            double end = column + 1 == width ? to : from + columnWidth * static_cast<double>(column + 1);
+            size_t last = static_cast<size_t>(std::lower_bound(x + first, x + count, end) - x);
+            if (column + 1 == width)
+            {
+                last = static_cast<size_t>(std::upper_bound(x + first, x + count, to) - x);
+            }
+            if (last > first)
+            {
+                size_t minIndex;
+                size_t maxIndex;
+                BucketMinMax(y, first, last, minIndex, maxIndex);
+                selected[written++] = std::min(minIndex, maxIndex);
+                if (minIndex != maxIndex)
+                {
+                    selected[written++] = std::max(minIndex, maxIndex);
+                }
+            }
+            first = last;
+        }
+        return written;
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Largest-Triangle-Three-Buckets: picks threshold indices of the series (x ascending) that best preserve
+    /// its visual shape, always keeping the first and last sample. Returns the number of indices written.
+    /// </summary>
+    size_t LargestTriangleThreeBuckets(const double* x, const float* y, size_t count, size_t threshold, size_t* selected);
+
+    /// <summary>
+    /// Splits [from, to) into width equal columns and keeps the minimum and maximum sample of each, in time
+    /// order (one index when they coincide). Writes at most 2 * width indices and returns the number written.
+    /// </summary>
+    size_t MinMaxDecimate(const double* x, const float* y, size_t count, double from, double to, size_t width, size_t* selected);
+}
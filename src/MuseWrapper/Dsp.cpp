@@ -0,0 +1,141 @@
+#include "pch.h"
+#include "Dsp.h"
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        constexpr double Pi = 3.14159265358979323846;
+    }
+
+    template <typename T>
+    Biquad<T>::Biquad(double b0, double b1, double b2, double a0, double a1, double a2)
+        : b0(static_cast<T>(b0 / a0)), b1(static_cast<T>(b1 / a0)), b2(static_cast<T>(b2 / a0)),
+          a1(static_cast<T>(a1 / a0)), a2(static_cast<T>(a2 / a0))
+    {
+    }
+
+    template <typename T>
+    Biquad<T> Biquad<T>::Notch(double sampleRate, double frequency, double q)
+    {
+        double w0 = 2.0 * Pi * frequency / sampleRate;
+        double alpha = std::sin(w0) / (2.0 * q);
+        double cosW0 = std::cos(w0);
+        return Biquad(1.0, -2.0 * cosW0, 1.0, 1.0 + alpha, -2.0 * cosW0, 1.0 - alpha);
+    }
+
+    template <typename T>
+    Biquad<T> Biquad<T>::HighPass(double sampleRate, double frequency, double q)
+    {
+        double w0 = 2.0 * Pi * frequency / sampleRate;
+        double alpha = std::sin(w0) / (2.0 * q);
+        double cosW0 = std::cos(w0);
+        return Biquad((1.0 + cosW0) / 2.0, -(1.0 + cosW0), (1.0 + cosW0) / 2.0, 1.0 + alpha, -2.0 * cosW0, 1.0 - alpha);
+    }
+
+    template <typename T>
+    void Biquad<T>::Process(const T* input, T* output, size_t count)
+    {
+        // Keep the state in registers for the whole block
+        T s1 = z1;
+        T s2 = z2;
+        for (size_t i = 0; i < count; i++)
+        {
+            T x = input[i];
+            T y = b0 * x + s1;
+            s1 = b1 * x - a1 * y + s2;
+            s2 = b2 * x - a2 * y;
+            output[i] = y;
+        }
+        z1 = s1;
+        z2 = s2;
+    }
+
+    template <typename T>
+    RealFft<T>::RealFft(size_t size, std::pmr::memory_resource* memory)
+        : size(size),
+          reversed(memory),
+          twiddles(memory),
+          splitTwiddles(memory),
+          scratch(memory)
+    {
+        if (size < 4 || (size & (size - 1)) != 0)
+        {
+            throw std::invalid_argument("FFT size must be a power of two of at least 4");
+        }
+
+        size_t half = size / 2;
+        int bits = 0;
+        while ((static_cast<size_t>(1) << bits) < half)
+        {
+            bits++;
+        }
+        reversed.resize(half);
+        for (size_t i = 0; i < half; i++)
+        {
+            uint32_t r = 0;
+            for (int b = 0; b < bits; b++)
+            {
+                r |= static_cast<uint32_t>((i >> b) & 1) << (bits - 1 - b);
+            }
+            reversed[i] = r;
+        }
+
+        twiddles.resize(half / 2);
+        for (size_t k = 0; k < half / 2; k++)
+        {
+            twiddles[k] = std::complex<T>(std::polar(1.0, -2.0 * Pi * static_cast<double>(k) / static_cast<double>(half)));
+        }
+        splitTwiddles.resize(half);
+        for (size_t k = 0; k < half; k++)
+        {
+            splitTwiddles[k] = std::complex<T>(std::polar(1.0, -2.0 * Pi * static_cast<double>(k) / static_cast<double>(size)));
+        }
+        scratch.resize(half);
+    }
+
+    template <typename T>
+    void RealFft<T>::PowerSpectrum(const T* input, T* power)
+    {
+        size_t half = size / 2;
+        std::complex<T>* z = scratch.data();
+
+        // Pack even/odd samples as real/imaginary parts, already in bit-reversed order
+        for (size_t i = 0; i < half; i++)
+        {
+            size_t r = reversed[i];
+            z[r] = std::complex<T>(input[2 * i], input[2 * i + 1]);
+        }
+
+        for (size_t span = 1; span < half; span <<= 1)
+        {
+            size_t stride = half / (2 * span);
+            for (size_t start = 0; start < half; start += 2 * span)
+            {
+                for (size_t k = 0; k < span; k++)
+                {
+                    std::complex<T> t = twiddles[k * stride] * z[start + k + span];
+                    z[start + k + span] = z[start + k] - t;
+                    z[start + k] += t;
+                }
+            }
+        }
+
+        // Split the half-size transform into the spectrum of the real signal
+        power[0] = (z[0].real() + z[0].imag()) * (z[0].real() + z[0].imag());
+        power[half] = (z[0].real() - z[0].imag()) * (z[0].real() - z[0].imag());
+        for (size_t k = 1; k < half; k++)
+        {
+            std::complex<T> a = z[k];
+            std::complex<T> b = std::conj(z[half - k]);
+            std::complex<T> even = T(0.5) * (a + b);
+            std::complex<T> odd = std::complex<T>(T(0), T(-0.5)) * (a - b);
+            power[k] = std::norm(even + splitTwiddles[k] * odd);
+        }
+    }
+
+    template class Biquad<float>;
+    template class Biquad<double>;
+    template class RealFft<float>;
+    template class RealFft<double>;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <complex>
+#include <memory_resource>
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Second-order IIR section in transposed direct form II, designed from the RBJ audio EQ cookbook.
+    /// Coefficients are designed in double and rounded once to T, the sample and state type.
+    /// </summary>
+    template <typename T = double>
+    class Biquad
+    {
+    public:
+        static Biquad Notch(double sampleRate, double frequency, double q);
+        static Biquad HighPass(double sampleRate, double frequency, double q);
+
+        T Process(T x)
+        {
+            T y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            return y;
+        }
+
+        /// <summary>
+        /// Filters a block of samples; input and output may alias
+        /// </summary>
+        void Process(const T* input, T* output, size_t count);
+
+        void Reset() { z1 = T(); z2 = T(); }
+
+    private:
+        Biquad(double b0, double b1, double b2, double a0, double a1, double a2);
+
+        T b0, b1, b2, a1, a2;
+        T z1 = T();
+        T z2 = T();
+    };
+
+    /// <summary>
+    /// FFT of real signals of a fixed power-of-two size, computed as a half-size complex FFT plus a
+    /// split step. Twiddles and the bit-reversal permutation are precomputed; the scratch buffer
+    /// makes an instance single-threaded. T is the sample and arithmetic type; twiddles are computed
+    /// in double and rounded once.
+    /// </summary>
+    template <typename T = double>
+    class RealFft
+    {
+    public:
+        explicit RealFft(size_t size, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+        size_t Size() const { return size; }
+
+        /// <summary>
+        /// Writes |X[k]|^2 for k = 0 .. size/2 (size/2 + 1 bins)
+        /// </summary>
+        void PowerSpectrum(const T* input, T* power);
+
+    private:
+        size_t size;
+        std::pmr::vector<uint32_t> reversed;
+        std::pmr::vector<std::complex<T>> twiddles;
+        std::pmr::vector<std::complex<T>> splitTwiddles;
+        std::pmr::vector<std::complex<T>> scratch;
+    };
+}
@@ -0,0 +1,317 @@
+#include "pch.h"
+#include "DspPool.h"
+#include "Profiler.h"
+#include "ThreadScheduling.h"
+#include "Tracing.h"
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        constexpr auto IdleWait = std::chrono::milliseconds(10);
+
+        // Client states; only the worker that dequeued a client moves it out of Queued or Running
+        enum ClientState : int
+        {
+            Idle,
+            Queued,
+            Running,
+            RunningDirty,   // scheduled again while running: queued once the batch returns
+        };
+    }
+
+    class DspPool::Client
+    {
+    public:
+        std::function<bool()> drain;
+        int home = 0;
+        std::atomic<int> state{ Idle };
+        std::atomic<bool> removed{ false };
+    };
+
+    DspPool::DspPool(const Options& options)
+    {
+        int count = options.workers;
+        if (count <= 0)
+        {
+            count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+        }
+        for (int cpu : options.cpus)
+        {
+            if (cpu < 0)
+            {
+                throw std::invalid_argument("CPU numbers cannot be negative");
+            }
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            workers.push_back(std::make_unique<Worker>());
+        }
+        try
+        {
+            for (int i = 0; i < count; i++)
+            {
+                Worker& worker = *workers[static_cast<size_t>(i)];
+                worker.thread = std::thread(&DspPool::Work, this, i);
+                if (!options.cpus.empty())
+                {
+                    SetThreadAffinity(worker.thread, { options.cpus[static_cast<size_t>(i) % options.cpus.size()] });
+                }
+            }
+        }
+        catch (...)
+        {
+            Stop();
+            throw;
+        }
+    }
+
+    DspPool::~DspPool()
+    {
+        Stop();
+    }
+
+    void DspPool::Stop()
+    {
+        stopping = true;
+        for (std::unique_ptr<Worker>& worker : workers)
+        {
+            {
+                std::lock_guard<std::mutex> guard(worker->lock);
+                worker->wake = true;
+            }
+            worker->signal.notify_one();
+        }
+        for (std::unique_ptr<Worker>& worker : workers)
+        {
+            if (worker->thread.joinable())
+            {
+                worker->thread.join();
+            }
+        }
+    }
+
+    DspPool::Client* DspPool::Register(std::function<bool()> drain)
+    {
+        auto client = std::make_unique<Client>();
+        client->drain = std::move(drain);
+
+        std::lock_guard<std::mutex> guard(clientsLock);
+        auto home = std::min_element(workers.begin(), workers.end(),
+            [](const std::unique_ptr<Worker>& a, const std::unique_ptr<Worker>& b) { return a->clients < b->clients; });
+        client->home = static_cast<int>(home - workers.begin());
+        (*home)->clients++;
+        clients.push_back(std::move(client));
+        return clients.back().get();
+    }
+
+    void DspPool::Unregister(Client* client)
+    {
+        // Once removed is set no worker queues the client again, so after this sweep the only
+        // reference left is a worker already running it
+        client->removed = true;
+        for (std::unique_ptr<Worker>& worker : workers)
+        {
+            std::lock_guard<std::mutex> guard(worker->lock);
+            auto erased = std::remove(worker->tasks.begin(), worker->tasks.end(), client);
+            worker->tasks.erase(erased, worker->tasks.end());
+            worker->depth.store(worker->tasks.size(), std::memory_order_relaxed);
+        }
+
+        std::unique_lock<std::mutex> guard(clientsLock);
+        settled.wait(guard, [client]
+        {
+            int state = client->state.load();
+            return state != Running && state != RunningDirty;
+        });
+        workers[static_cast<size_t>(client->home)]->clients--;
+        auto found = std::find_if(clients.begin(), clients.end(), [client](const std::unique_ptr<Client>& c) { return c.get() == client; });
+        clients.erase(found);
+    }
+
+    void DspPool::Schedule(Client* client)
+    {
+        int state = client->state.load();
+        while (true)
+        {
+            if (state == Queued || state == RunningDirty)
+            {
+                return;
+            }
+            int next = state == Idle ? Queued : RunningDirty;
+            if (client->state.compare_exchange_weak(state, next))
+            {
+                if (next == Queued)
+                {
+                    Enqueue(client);
+                }
+                return;
+            }
+        }
+    }
+
+    DspPoolStats DspPool::Stats() const
+    {
+        std::lock_guard<std::mutex> guard(clientsLock);
+        return DspPoolStats{
+            batches.load(std::memory_order_relaxed),
+            steals.load(std::memory_order_relaxed),
+            static_cast<int>(workers.size()),
+            static_cast<int>(clients.size()),
+        };
+    }
+
+    void DspPool::Enqueue(Client* client)
+    {
+        Worker& home = *workers[static_cast<size_t>(client->home)];
+        size_t depth;
+        {
+            std::lock_guard<std::mutex> guard(home.lock);
+            if (client->removed.load())
+            {
+                return;
+            }
+            home.tasks.push_back(client);
+            depth = home.tasks.size();
+            home.depth.store(depth, std::memory_order_relaxed);
+        }
+        home.signal.notify_one();
+
+        // The home worker is a batch behind: wake the least loaded other worker to take some of it
+        if (depth >= StealThreshold && workers.size() > 1)
+        {
+            Worker* thief = nullptr;
+            for (std::unique_ptr<Worker>& worker : workers)
+            {
+                if (worker.get() != &home && (thief == nullptr || worker->depth.load(std::memory_order_relaxed) < thief->depth.load(std::memory_order_relaxed)))
+                {
+                    thief = worker.get();
+                }
+            }
+            {
+                std::lock_guard<std::mutex> guard(thief->lock);
+                thief->wake = true;
+            }
+            thief->signal.notify_one();
+        }
+    }
+
+    DspPool::Client* DspPool::Pop(Worker& worker)
+    {
+        std::lock_guard<std::mutex> guard(worker.lock);
+        if (worker.tasks.empty())
+        {
+            return nullptr;
+        }
+        Client* client = worker.tasks.front();
+        worker.tasks.pop_front();
+        worker.depth.store(worker.tasks.size(), std::memory_order_relaxed);
+        // Marked running under the deque lock so Unregister's sweep either removes it or waits for it
+        client->state.store(Running);
+        return client;
+    }
+
+    DspPool::Client* DspPool::Steal(int thief)
+    {
+        Worker* victim = nullptr;
+        size_t deepest = StealThreshold - 1;
+        for (size_t i = 0; i < workers.size(); i++)
+        {
+            size_t depth = workers[i]->depth.load(std::memory_order_relaxed);
+            if (static_cast<int>(i) != thief && depth > deepest)
+            {
+                victim = workers[i].get();
+                deepest = depth;
+            }
+        }
+        if (victim == nullptr)
+        {
+            return nullptr;
+        }
+
+        // Taken from the back: the client its owner would reach last
+        std::lock_guard<std::mutex> guard(victim->lock);
+        if (victim->tasks.size() < StealThreshold)
+        {
+            return nullptr;
+        }
+        Client* client = victim->tasks.back();
+        victim->tasks.pop_back();
+        victim->depth.store(victim->tasks.size(), std::memory_order_relaxed);
+        client->state.store(Running);
+        steals.fetch_add(1, std::memory_order_relaxed);
+        return client;
+    }
+
+    void DspPool::RunClient(Client* client, int index)
+    {
+        bool more;
+        {
+            MW_TRACE_SCOPE("dsp_pool.batch");
+            more = client->drain();
+        }
+        batches.fetch_add(1, std::memory_order_relaxed);
+
+        // Once the client is back in a deque it may be unregistered at any moment, so it is not touched after that
+        int homeIndex = client->home;
+        Worker& home = *workers[static_cast<size_t>(homeIndex)];
+        bool queued = false;
+        bool removed;
+        {
+            std::lock_guard<std::mutex> guard(home.lock);
+            removed = client->removed.load();
+            int running = Running;
+            if (removed)
+            {
+                client->state.store(Idle);
+            }
+            else if (more || !client->state.compare_exchange_strong(running, Idle))
+            {
+                // Work is left, or more arrived during the batch
+                client->state.store(Queued);
+                home.tasks.push_back(client);
+                home.depth.store(home.tasks.size(), std::memory_order_relaxed);
+                queued = true;
+            }
+        }
+        if (queued && homeIndex != index)
+        {
+            home.signal.notify_one();
+        }
+        if (removed)
+        {
+            {
+                std::lock_guard<std::mutex> guard(clientsLock);
+            }
+            settled.notify_all();
+        }
+    }
+
+    void DspPool::Work(int index)
+    {
+        MW_TRACE_THREAD_NAME("MuseWrapper dsp");
+        Profiler::ThreadRegistration profiled("MuseWrapper dsp");
+        Worker& self = *workers[static_cast<size_t>(index)];
+        while (!stopping.load())
+        {
+            Client* client = Pop(self);
+            if (client == nullptr)
+            {
+                client = Steal(index);
+            }
+            if (client != nullptr)
+            {
+                RunClient(client, index);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> guard(self.lock);
+            if (self.tasks.empty() && !self.wake && !stopping.load())
+            {
+                self.signal.wait_for(guard, IdleWait);
+            }
+            self.wake = false;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+
+namespace MuseWrapper
+{
+    struct DspPoolStats
+    {
+        uint64_t batches;       // client drains run
+        uint64_t steals;        // of those, run by a worker other than the client's home
+        int workers;
+        int clients;
+    };
+
+    /// <summary>
+    /// Fixed set of worker threads shared by the per-device DSP of every headband, instead of a thread
+    /// per device. Each registered client (one device's pipeline) has a home worker, the one with the
+    /// fewest clients when it registered, and is always queued there, so a device's filter and band
+    /// power state stays in that worker's cache. Each worker has its own deque; a worker that runs out
+    /// of work only steals from another whose deque holds at least StealThreshold clients, i.e. one
+    /// that is a whole batch behind, and a stolen client still goes back to its home worker next time.
+    ///
+    /// A client runs on at most one worker at a time, in batches: its drain function processes a
+    /// bounded amount of work and returns whether more is waiting, so a busy device cannot starve the
+    /// others on its worker. Workers can be pinned to CPUs to keep capture off the cores an encoder uses.
+    /// </summary>
+    class DspPool
+    {
+    public:
+        static constexpr size_t StealThreshold = 2;
+
+        struct Options
+        {
+            int workers = 0;            // 0: one fewer than the hardware threads, at least one
+            std::vector<int> cpus;      // worker i is pinned to cpus[i % cpus.size()]; empty leaves scheduling to the OS
+        };
+
+        class Client;
+
+        explicit DspPool(const Options& options);
+        ~DspPool();
+
+        DspPool(const DspPool&) = delete;
+        DspPool& operator=(const DspPool&) = delete;
+
+        /// <summary>
+        /// Adds a client; drain runs on a worker after each Schedule and must return true while work remains
+        /// </summary>
+        Client* Register(std::function<bool()> drain);
+
+        /// <summary>
+        /// Removes a client, waiting for a drain already running to return. The client must not be scheduled again.
+        /// </summary>
+        void Unregister(Client* client);
+
+        /// <summary>
+        /// Any thread: queues a client on its home worker unless it is already queued. A client that is
+        /// running is drained again once the current batch returns.
+        /// </summary>
+        void Schedule(Client* client);
+
+        DspPoolStats Stats() const;
+        int Workers() const { return static_cast<int>(workers.size()); }
+
+    private:
+        struct alignas(64) Worker
+        {
+            std::mutex lock;
+            std::condition_variable signal;
+            std::deque<Client*> tasks;              // guarded by lock
+            std::atomic<size_t> depth{ 0 };         // tasks.size(), readable without the lock
+            bool wake = false;                      // guarded by lock: asked to look for work to steal
+            int clients = 0;                        // guarded by clientsLock
+            std::thread thread;
+        };
+
+        void Work(int index);
+        Client* Pop(Worker& worker);
+        Client* Steal(int thief);
+        void RunClient(Client* client, int index);
+        void Enqueue(Client* client);
+        void Stop();
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::atomic<bool> stopping{ false };
+
+        mutable std::mutex clientsLock;
+        std::condition_variable settled;    // a removed client's drain returned
+        std::vector<std::unique_ptr<Client>> clients;
+
+        std::atomic<uint64_t> batches{ 0 };
+        std::atomic<uint64_t> steals{ 0 };
+    };
+}
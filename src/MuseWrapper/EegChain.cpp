@@ -0,0 +1,95 @@
+#include "pch.h"
+#include "EegChain.h"
+#include "BandPower.h"
+
+#include <type_traits>
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        constexpr double NotchQ = 30.0;
+        constexpr double HighPassFrequency = 1.0;
+        constexpr double HighPassQ = 0.7071;
+
+        template <typename T>
+        class BasicEegChain final : public EegChain
+        {
+        public:
+            BasicEegChain(const IngestPipeline::Options& options, std::pmr::memory_resource* memory)
+                : notches(memory),
+                  highPasses(memory),
+                  bandPower(options.eegChannels, options.eegSampleRate, memory),
+                  filtered(static_cast<size_t>(options.eegChannels), memory),
+                  history(options.eegChannels, ChannelRing<T>::CapacityFor(options.historySeconds, options.eegSampleRate), memory)
+            {
+                notches.reserve(static_cast<size_t>(options.eegChannels));
+                highPasses.reserve(static_cast<size_t>(options.eegChannels));
+                for (int c = 0; c < options.eegChannels; c++)
+                {
+                    if (options.notchFrequency > 0.0)
+                    {
+                        notches.push_back(Biquad<T>::Notch(options.eegSampleRate, options.notchFrequency, NotchQ));
+                    }
+                    highPasses.push_back(Biquad<T>::HighPass(options.eegSampleRate, HighPassFrequency, HighPassQ));
+                }
+            }
+
+            void Filter(const MusePacket& packet) override
+            {
+                int channels = static_cast<int>(filtered.size());
+                int present = std::min(packet.valueCount, channels);
+                for (int c = 0; c < channels; c++)
+                {
+                    T x = c < present && !std::isnan(packet.values[c]) ? static_cast<T>(packet.values[c]) : T();
+                    if (!notches.empty())
+                    {
+                        x = notches[c].Process(x);
+                    }
+                    filtered[c] = highPasses[c].Process(x);
+                }
+                history.Push(filtered.data());
+            }
+
+            void LastFiltered(double* out) const override
+            {
+                std::copy(filtered.begin(), filtered.end(), out);
+            }
+
+            bool UpdateBandPower() override { return bandPower.AddSample(filtered.data()); }
+            const double* Powers() const override { return bandPower.Powers(); }
+            uint64_t HistoryCount() const override { return history.Count(); }
+
+            size_t CopyHistory(int channel, double* out, size_t length) const override
+            {
+                if constexpr (std::is_same_v<T, double>)
+                {
+                    return history.CopyLatest(channel, out, length);
+                }
+                else
+                {
+                    std::vector<T> values(std::min(length, history.Capacity()));
+                    size_t copied = history.CopyLatest(channel, values.data(), values.size());
+                    std::copy_n(values.begin(), copied, out);
+                    return copied;
+                }
+            }
+
+        private:
+            std::pmr::vector<Biquad<T>> notches;
+            std::pmr::vector<Biquad<T>> highPasses;
+            BandPowerEstimator<T> bandPower;
+            std::pmr::vector<T> filtered;
+            ChannelRing<T> history;
+        };
+    }
+
+    std::unique_ptr<EegChain> EegChain::Create(const IngestPipeline::Options& options, std::pmr::memory_resource* memory)
+    {
+        if (options.precision == IngestPipeline::SamplePrecision::Float)
+        {
+            return std::make_unique<BasicEegChain<float>>(options, memory);
+        }
+        return std::make_unique<BasicEegChain<double>>(options, memory);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "IngestPipeline.h"
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// The EEG half of the ingest worker: notch and high-pass filters, band power and the filtered
+    /// history, all in the sample type chosen by IngestPipeline::Options::precision. Values are
+    /// converted from libmuse's double once, on the way in; band powers come out in double either way.
+    /// Single-threaded apart from CopyHistory.
+    /// </summary>
+    class EegChain
+    {
+    public:
+        static std::unique_ptr<EegChain> Create(const IngestPipeline::Options& options,
+            std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+        virtual ~EegChain() = default;
+
+        /// <summary>
+        /// Converts one packet's values to the chain's sample type, filters them and appends them to the history
+        /// </summary>
+        virtual void Filter(const MusePacket& packet) = 0;
+
+        /// <summary>
+        /// The samples from the last Filter, one per channel
+        /// </summary>
+        virtual void LastFiltered(double* out) const = 0;
+
+        /// <summary>
+        /// Adds the last filtered sample to band power; true when new powers are available
+        /// </summary>
+        virtual bool UpdateBandPower() = 0;
+
+        /// <summary>
+        /// Latest band powers indexed [channel * BandCount + band]
+        /// </summary>
+        virtual const double* Powers() const = 0;
+
+        /// <summary>
+        /// Any thread: see ChannelRing::CopyLatest
+        /// </summary>
+        virtual size_t CopyHistory(int channel, double* out, size_t length) const = 0;
+        virtual uint64_t HistoryCount() const = 0;
+    };
+}
@@ -0,0 +1,127 @@
+#include "pch.h"
+#include "FrameBuffer.h"
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        inline uint32_t Div255(uint32_t x)
+        {
+            x += 128;
+            return (x + (x >> 8)) >> 8;
+        }
+
+        inline uint32_t Premultiply(Color color, uint32_t coverage)
+        {
+            uint32_t alpha = Div255(color.a * coverage);
+            return (alpha << 24) | (Div255(color.r * alpha) << 16) | (Div255(color.g * alpha) << 8) | Div255(color.b * alpha);
+        }
+
+        // Source-over for premultiplied pixels: dst = src + dst * (1 - srcAlpha)
+        inline uint32_t BlendOver(uint32_t src, uint32_t dst)
+        {
+            uint32_t inverse = 255 - (src >> 24);
+            uint32_t rb = (dst & 0x00FF00FF) * inverse;
+            uint32_t ag = ((dst >> 8) & 0x00FF00FF) * inverse;
+            rb = ((rb + 0x00800080 + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+            ag = (ag + 0x00800080 + ((ag >> 8) & 0x00FF00FF)) & 0xFF00FF00;
+            return src + (rb | ag);
+        }
+    }
+
+    bool FrameBuffer::ClipRect(Rect& rect) const
+    {
+        int x0 = std::max(rect.x, 0);
+        int y0 = std::max(rect.y, 0);
+        int x1 = std::min(rect.x + rect.w, width);
+        int y1 = std::min(rect.y + rect.h, height);
+        rect = Rect{ x0, y0, x1 - x0, y1 - y0 };
+        return rect.w > 0 && rect.h > 0;
+    }
+
+    void FrameBuffer::Clear(Color color)
+    {
+        uint32_t value = Premultiply(color, 255);
+        for (int y = 0; y < height; y++)
+        {
+            std::fill_n(Row(y), width, value);
+        }
+    }
+
+    void FrameBuffer::FillRect(Rect rect, Color color)
+    {
+        if (color.a == 0 || !ClipRect(rect))
+        {
+            return;
+        }
+
+        uint32_t value = Premultiply(color, 255);
+        for (int y = rect.y; y < rect.y + rect.h; y++)
+        {
+            uint32_t* row = Row(y) + rect.x;
+            if (color.a == 255)
+            {
+                std::fill_n(row, rect.w, value);
+                continue;
+            }
+            for (int x = 0; x < rect.w; x++)
+            {
+                row[x] = BlendOver(value, row[x]);
+            }
+        }
+    }
+
+    void FrameBuffer::BlendMask(const uint8_t* mask, int maskStride, int maskWidth, int maskHeight, int x, int y, Color color)
+    {
+        Rect clipped{ x, y, maskWidth, maskHeight };
+        if (!ClipRect(clipped))
+        {
+            return;
+        }
+
+        uint32_t solid = Premultiply(color, 255);
+        for (int row = clipped.y; row < clipped.y + clipped.h; row++)
+        {
+            const uint8_t* coverage = mask + static_cast<size_t>(row - y) * maskStride + (clipped.x - x);
+            uint32_t* dst = Row(row) + clipped.x;
+            for (int col = 0; col < clipped.w; col++)
+            {
+                uint8_t c = coverage[col];
+                if (c == 0)
+                {
+                    continue;
+                }
+                dst[col] = BlendOver(c == 255 ? solid : Premultiply(color, c), dst[col]);
+            }
+        }
+    }
+
+    void FrameBuffer::DrawSparkline(Rect rect, const float* values, int count, float minValue, float maxValue, Color color)
+    {
+        if (count < 2 || rect.w < 2 || rect.h < 1)
+        {
+            return;
+        }
+
+        float range = maxValue > minValue ? maxValue - minValue : 1.0f;
+        auto toY = [&](float value)
+        {
+            float t = std::clamp((value - minValue) / range, 0.0f, 1.0f);
+            return rect.y + rect.h - 1 - static_cast<int>(t * (rect.h - 1) + 0.5f);
+        };
+
+        // One vertical span per column between the previous and current sample keeps the line gapless
+        int previousY = toY(values[0]);
+        for (int column = 0; column < rect.w; column++)
+        {
+            float position = static_cast<float>(column) * (count - 1) / (rect.w - 1);
+            int index = std::min(static_cast<int>(position), count - 2);
+            float fraction = position - index;
+            int currentY = toY(values[index] + (values[index + 1] - values[index]) * fraction);
+            int top = std::min(previousY, currentY);
+            int bottom = std::max(previousY, currentY);
+            FillRect(Rect{ rect.x + column, top, 1, bottom - top + 1 }, color);
+            previousY = currentY;
+        }
+    }
+}
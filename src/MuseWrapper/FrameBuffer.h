@@ -0,0 +1,69 @@
+#pragma once
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Straight-alpha colour; converted to premultiplied BGRA when drawn
+    /// </summary>
+    struct Color
+    {
+        uint8_t r, g, b, a;
+
+        static constexpr Color Rgb(uint32_t rgb, uint8_t alpha = 255)
+        {
+            return Color{ static_cast<uint8_t>(rgb >> 16), static_cast<uint8_t>(rgb >> 8), static_cast<uint8_t>(rgb), alpha };
+        }
+    };
+
+    struct Rect
+    {
+        int x, y, w, h;
+    };
+
+    /// <summary>
+    /// Non-owning view over a premultiplied BGRA8 surface with software drawing primitives
+    /// </summary>
+    class FrameBuffer
+    {
+    public:
+        static constexpr int BytesPerPixel = 4;
+
+        FrameBuffer() = default;
+        FrameBuffer(uint8_t* pixels, int width, int height, int stride)
+            : pixels(pixels), width(width), height(height), stride(stride) {}
+
+        uint8_t* Pixels() const { return pixels; }
+        int Width() const { return width; }
+        int Height() const { return height; }
+        int Stride() const { return stride; }
+
+        /// <summary>
+        /// Fills the whole surface, replacing existing pixels
+        /// </summary>
+        void Clear(Color color);
+
+        /// <summary>
+        /// Alpha-blends a solid rectangle, clipped to the surface
+        /// </summary>
+        void FillRect(Rect rect, Color color);
+
+        /// <summary>
+        /// Alpha-blends an 8-bit coverage mask (e.g. a glyph from the atlas) at the given position
+        /// </summary>
+        void BlendMask(const uint8_t* mask, int maskStride, int maskWidth, int maskHeight, int x, int y, Color color);
+
+        /// <summary>
+        /// Draws a connected line through the values, scaled from [minValue, maxValue] into the rectangle
+        /// </summary>
+        void DrawSparkline(Rect rect, const float* values, int count, float minValue, float maxValue, Color color);
+
+    private:
+        uint32_t* Row(int y) const { return reinterpret_cast<uint32_t*>(pixels + static_cast<size_t>(y) * stride); }
+        bool ClipRect(Rect& rect) const;
+
+        uint8_t* pixels = nullptr;
+        int width = 0;
+        int height = 0;
+        int stride = 0;
+    };
+}
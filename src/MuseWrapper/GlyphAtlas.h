@@ -0,0 +1,35 @@
+#pragma once
+
+#include "FrameBuffer.h"
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Printable ASCII rasterised once into a single 8-bit coverage atlas at an integer scale
+    /// </summary>
+    class GlyphAtlas
+    {
+    public:
+        static constexpr int FirstChar = 32;
+        static constexpr int LastChar = 126;
+        static constexpr int GlyphColumns = 5;
+        static constexpr int GlyphRows = 7;
+
+        explicit GlyphAtlas(int scale);
+
+        int Advance() const { return (GlyphColumns + 1) * scale; }
+        int LineHeight() const { return (GlyphRows + 1) * scale; }
+        int TextHeight() const { return GlyphRows * scale; }
+        int MeasureText(const char* text) const;
+
+        /// <summary>
+        /// Draws a single line of text with its top-left corner at (x, y); non-ASCII characters render as '?'
+        /// </summary>
+        void DrawText(FrameBuffer& target, int x, int y, const char* text, Color color) const;
+
+    private:
+        int scale;
+        int atlasStride;
+        std::vector<uint8_t> coverage;
+    };
+}
@@ -0,0 +1,108 @@
+// HubApi.cpp : Exported entry points for the spectator broadcast hub.
+#include "pch.h"
+#include "ApiHandles.h"
+#include "ApiSupport.h"
+#include "BroadcastHub.h"
+
+using namespace MuseWrapper;
+
+namespace
+{
+    HandleTable<BroadcastHub> hubs;
+}
+
+HandleTable<BroadcastHub>& MuseWrapper::HubHandles()
+{
+    return hubs;
+}
+
+int MwHubCreate(int tcpPort, int webSocketPort, int loopbackOnly, int maxQueuedFrames, int* handleOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(handleOut != nullptr, "handleOut is required");
+        Require(tcpPort <= 65535 && webSocketPort <= 65535, "Port is out of range");
+        Require(tcpPort >= 0 || webSocketPort >= 0, "At least one of tcpPort and webSocketPort must be enabled");
+        BroadcastHub::Options options;
+        options.tcpPort = tcpPort;
+        options.webSocketPort = webSocketPort;
+        options.loopbackOnly = loopbackOnly != 0;
+        options.maxQueuedFrames = maxQueuedFrames > 0 ? maxQueuedFrames : options.maxQueuedFrames;
+        *handleOut = hubs.Add(std::make_shared<BroadcastHub>(options));
+        return MW_OK;
+    });
+}
+
+int MwHubDestroy(int handle, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        hubs.Remove(handle);
+        return MW_OK;
+    });
+}
+
+int MwHubGetPorts(int handle, int* tcpPortOut, int* webSocketPortOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        std::shared_ptr<BroadcastHub> hub = hubs.Get(handle);
+        if (tcpPortOut != nullptr)
+        {
+            *tcpPortOut = hub->TcpPort();
+        }
+        if (webSocketPortOut != nullptr)
+        {
+            *webSocketPortOut = hub->WebSocketPort();
+        }
+        return MW_OK;
+    });
+}
+
+int MwHubPublish(int handle, const uint8_t* data, int length, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(data != nullptr && length > 0, "data is required");
+        hubs.Get(handle)->Publish(data, static_cast<size_t>(length));
+        return MW_OK;
+    });
+}
+
+int MwHubGetStats(int handle, MwHubStats* statsOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(statsOut != nullptr, "statsOut is required");
+        HubStats stats = hubs.Get(handle)->Stats();
+        statsOut->framesPublished = static_cast<int64_t>(stats.framesPublished);
+        statsOut->framesDelivered = static_cast<int64_t>(stats.framesDelivered);
+        statsOut->framesDropped = static_cast<int64_t>(stats.framesDropped);
+        statsOut->bytesSent = static_cast<int64_t>(stats.bytesSent);
+        statsOut->loopBusyNs = static_cast<int64_t>(stats.loopBusyNs);
+        statsOut->subscribers = static_cast<int32_t>(stats.subscribers);
+        return MW_OK;
+    });
+}
+
+int MwHubSetOverflowPolicy(int handle, int queue, int policy, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(queue == MW_HUB_QUEUE_PUBLISH || queue == MW_HUB_QUEUE_SUBSCRIBER, "Unknown hub queue");
+        Require(queue != MW_HUB_QUEUE_SUBSCRIBER || policy != MW_OVERFLOW_BLOCK, "Subscriber queues cannot block the hub thread");
+        hubs.Get(handle)->SetOverflowPolicy(static_cast<HubQueue>(queue), ToOverflowPolicy(policy));
+        return MW_OK;
+    });
+}
+
+int MwHubGetQueueStats(int handle, int queue, MwQueueStats* statsOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(queue == MW_HUB_QUEUE_PUBLISH || queue == MW_HUB_QUEUE_SUBSCRIBER, "Unknown hub queue");
+        Require(statsOut != nullptr, "statsOut is required");
+        CopyQueueStats(hubs.Get(handle)->Stats(static_cast<HubQueue>(queue)), statsOut);
+        return MW_OK;
+    });
+}
@@ -0,0 +1,66 @@
+#include "pch.h"
+#include "Id3Metadata.h"
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        const char PrivOwner[] = "com.neurospectator.braindata";
+        constexpr size_t Id3HeaderSize = 10;
+        constexpr size_t FrameHeaderSize = 10;
+
+        void WriteSyncSafe(uint8_t* out, uint32_t value)
+        {
+            out[0] = static_cast<uint8_t>((value >> 21) & 0x7F);
+            out[1] = static_cast<uint8_t>((value >> 14) & 0x7F);
+            out[2] = static_cast<uint8_t>((value >> 7) & 0x7F);
+            out[3] = static_cast<uint8_t>(value & 0x7F);
+        }
+
+        template <typename T>
+        void AppendLittleEndian(std::vector<uint8_t>& out, T value)
+        {
+            uint8_t bytes[sizeof(T)];
+            std::memcpy(bytes, &value, sizeof(T));
+            // All supported targets are little-endian; the payload format is fixed LE
+            out.insert(out.end(), bytes, bytes + sizeof(T));
+        }
+    }
+
+    void Id3Metadata::BuildTag(std::vector<uint8_t>& tag, const MusePacket* packets, size_t count)
+    {
+        count = std::min(count, MaxPacketsPerTag);
+        tag.clear();
+        tag.resize(Id3HeaderSize + FrameHeaderSize);
+
+        tag.insert(tag.end(), PrivOwner, PrivOwner + sizeof(PrivOwner));
+        tag.push_back(PayloadVersion);
+        AppendLittleEndian(tag, static_cast<uint16_t>(count));
+        for (size_t i = 0; i < count; i++)
+        {
+            const MusePacket& packet = packets[i];
+            int valueCount = std::clamp(packet.valueCount, 0, MaxPacketValues);
+            tag.push_back(static_cast<uint8_t>(packet.type));
+            tag.push_back(static_cast<uint8_t>(valueCount));
+            AppendLittleEndian(tag, packet.timestampUs);
+            for (int v = 0; v < valueCount; v++)
+            {
+                AppendLittleEndian(tag, static_cast<float>(packet.values[v]));
+            }
+        }
+
+        uint32_t frameSize = static_cast<uint32_t>(tag.size() - Id3HeaderSize - FrameHeaderSize);
+        uint8_t* header = tag.data();
+        std::memcpy(header, "ID3", 3);
+        header[3] = 4;  // ID3v2.4
+        header[4] = 0;
+        header[5] = 0;  // no flags
+        WriteSyncSafe(header + 6, frameSize + FrameHeaderSize);
+
+        uint8_t* frame = header + Id3HeaderSize;
+        std::memcpy(frame, "PRIV", 4);
+        WriteSyncSafe(frame + 4, frameSize);
+        frame[8] = 0;
+        frame[9] = 0;
+    }
+}
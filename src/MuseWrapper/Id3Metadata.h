@@ -0,0 +1,26 @@
+#pragma once
+
+#include "MuseTypes.h"
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Builds ID3v2.4 tags carrying brain-data packets in a PRIV frame, the payload format
+    /// HLS players expose as timed metadata cues.
+    ///
+    /// PRIV owner "com.neurospectator.braindata", payload (little-endian):
+    ///   uint8 version (1), uint16 packetCount, then per packet:
+    ///   uint8 packetType, uint8 valueCount, int64 timestampUs, float32 values[valueCount]
+    /// </summary>
+    class Id3Metadata
+    {
+    public:
+        static constexpr uint8_t PayloadVersion = 1;
+        static constexpr size_t MaxPacketsPerTag = 1024;
+
+        /// <summary>
+        /// Replaces the contents of 'tag' with a complete ID3 tag for the packets
+        /// </summary>
+        static void BuildTag(std::vector<uint8_t>& tag, const MusePacket* packets, size_t count);
+    };
+}
@@ -0,0 +1,255 @@
+// IngestApi.cpp : Exported entry points for the native ingest pipeline and its latency tracing.
+#include "pch.h"
+#include "ApiHandles.h"
+#include "ApiSupport.h"
+#include "Clock.h"
+#include "DspPool.h"
+#include "IngestPipeline.h"
+#include "PacketTiming.h"
+
+using namespace MuseWrapper;
+
+namespace
+{
+    constexpr int MaxEegChannels = MaxPacketValues;
+
+    HandleTable<IngestPipeline> pipelines;
+}
+
+HandleTable<IngestPipeline>& MuseWrapper::IngestHandles()
+{
+    return pipelines;
+}
+
+int MwClockNanoseconds(int64_t* nowOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(nowOut != nullptr, "nowOut is required");
+        *nowOut = static_cast<int64_t>(MonotonicNanoseconds());
+        return MW_OK;
+    });
+}
+
+int MwIngestCreate(int eegChannels, double eegSampleRate, double notchFrequency, int bandSource, int* handleOut, char* errorOut, int errorLen)
+{
+    return MwIngestCreateWithPrecision(eegChannels, eegSampleRate, notchFrequency, bandSource, MW_PRECISION_DOUBLE, handleOut, errorOut, errorLen);
+}
+
+int MwIngestCreateWithPrecision(int eegChannels, double eegSampleRate, double notchFrequency, int bandSource, int precision, int* handleOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(handleOut != nullptr, "handleOut is required");
+        Require(eegChannels > 0 && eegChannels <= MaxEegChannels, "eegChannels is out of range");
+        Require(eegSampleRate > 0.0, "eegSampleRate must be positive");
+        Require(notchFrequency >= 0.0 && notchFrequency < eegSampleRate / 2.0, "notchFrequency must be below the Nyquist frequency");
+        Require(bandSource == MW_BANDS_EEG || bandSource == MW_BANDS_LIBMUSE, "Unknown band source");
+        Require(precision == MW_PRECISION_DOUBLE || precision == MW_PRECISION_FLOAT, "Unknown sample precision");
+        IngestPipeline::Options options;
+        options.eegChannels = eegChannels;
+        options.eegSampleRate = eegSampleRate;
+        options.notchFrequency = notchFrequency;
+        options.bandSource = bandSource == MW_BANDS_EEG ? IngestPipeline::BandSource::Eeg : IngestPipeline::BandSource::Libmuse;
+        options.precision = precision == MW_PRECISION_FLOAT ? IngestPipeline::SamplePrecision::Float : IngestPipeline::SamplePrecision::Double;
+        *handleOut = pipelines.Add(std::make_shared<IngestPipeline>(options));
+        return MW_OK;
+    });
+}
+
+int MwIngestDestroy(int handle, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        pipelines.Remove(handle);
+        return MW_OK;
+    });
+}
+
+int MwIngestAttachOverlay(int handle, int overlayHandle, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        std::shared_ptr<IngestPipeline> pipeline = pipelines.Get(handle);
+        pipeline->AttachOverlay(overlayHandle != 0 ? OverlayHandles().Get(overlayHandle) : nullptr);
+        return MW_OK;
+    });
+}
+
+int MwIngestAttachHub(int handle, int hubHandle, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        std::shared_ptr<IngestPipeline> pipeline = pipelines.Get(handle);
+        pipeline->AttachHub(hubHandle != 0 ? HubHandles().Get(hubHandle) : nullptr);
+        return MW_OK;
+    });
+}
+
+int MwIngestAttachPool(int handle, int poolHandle, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        std::shared_ptr<IngestPipeline> pipeline = pipelines.Get(handle);
+        pipeline->AttachPool(poolHandle != 0 ? PoolHandles().Get(poolHandle) : nullptr);
+        return MW_OK;
+    });
+}
+
+int MwIngestSetThreadScheduling(int handle, int priority, const int* cpus, int cpuCount, int* appliedPriorityOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(priority >= MW_PRIORITY_NORMAL && priority <= MW_PRIORITY_REALTIME, "Unknown priority");
+        Require(cpuCount >= 0 && (cpus != nullptr || cpuCount == 0), "Invalid CPU list");
+        std::shared_ptr<IngestPipeline> pipeline = pipelines.Get(handle);
+        ThreadScheduling scheduling;
+        scheduling.priority = static_cast<ThreadPriority>(priority);
+        scheduling.cpus.assign(cpus, cpus + cpuCount);
+        ThreadPriority applied = pipeline->SetWorkerScheduling(scheduling);
+        if (appliedPriorityOut != nullptr)
+        {
+            *appliedPriorityOut = static_cast<int>(applied);
+        }
+        return MW_OK;
+    });
+}
+
+int MwIngestAddListener(int handle, int packetType, MwPacketListener listener, void* context, int* listenerIdOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(listener != nullptr && listenerIdOut != nullptr, "listener and listenerIdOut are required");
+        Require(packetType == MW_PACKET_ANY || (packetType >= 0 && packetType < PacketTypeCount), "Unknown packet type");
+        std::optional<MuseDataPacketType> type;
+        if (packetType != MW_PACKET_ANY)
+        {
+            type = static_cast<MuseDataPacketType>(packetType);
+        }
+        *listenerIdOut = pipelines.Get(handle)->AddListener(type, [listener, context](const MusePacket& packet)
+        {
+            listener(static_cast<int>(packet.type), packet.timestampUs, packet.values, packet.valueCount, context);
+        });
+        return MW_OK;
+    });
+}
+
+int MwIngestRemoveListener(int handle, int listenerId, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(pipelines.Get(handle)->RemoveListener(listenerId), "Unknown listener");
+        return MW_OK;
+    });
+}
+
+int MwIngestSetOverflowPolicy(int handle, int policy, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        pipelines.Get(handle)->SetOverflowPolicy(ToOverflowPolicy(policy));
+        return MW_OK;
+    });
+}
+
+int MwIngestGetQueueStats(int handle, MwQueueStats* statsOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(statsOut != nullptr, "statsOut is required");
+        CopyQueueStats(pipelines.Get(handle)->Stats().queue, statsOut);
+        return MW_OK;
+    });
+}
+
+int MwIngestPushPacket(int handle, int packetType, int64_t timestampUs, const double* values, int numValues, int64_t callbackNs, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(packetType >= 0 && packetType < PacketTypeCount, "Unknown packet type");
+        Require(numValues >= 0 && numValues <= MaxPacketValues && (values != nullptr || numValues == 0), "Invalid packet values");
+        MusePacket packet = { static_cast<MuseDataPacketType>(packetType), numValues, timestampUs, {} };
+        std::copy_n(values, numValues, packet.values);
+        return pipelines.Get(handle)->Push(packet, static_cast<uint64_t>(std::max<int64_t>(0, callbackNs))) ? MW_OK : MW_QUEUE_FULL;
+    });
+}
+
+int MwIngestGetMetrics(int handle, double* focusOut, double* bandsOut, int bandCount, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(bandsOut != nullptr || bandCount == 0, "bandsOut is required when bandCount > 0");
+        double focus;
+        std::array<double, BandCount> bands;
+        pipelines.Get(handle)->LatestMetrics(focus, bands);
+        if (focusOut != nullptr)
+        {
+            *focusOut = focus;
+        }
+        std::copy_n(bands.begin(), std::clamp(bandCount, 0, BandCount), bandsOut);
+        return MW_OK;
+    });
+}
+
+int MwIngestCopyHistory(int handle, int series, int channel, double* valuesOut, int count, int* copiedOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(series == MW_HISTORY_EEG || series == MW_HISTORY_BANDS, "Unknown history series");
+        Require(valuesOut != nullptr && count > 0, "valuesOut is required");
+        Require(copiedOut != nullptr, "copiedOut is required");
+        std::shared_ptr<IngestPipeline> pipeline = pipelines.Get(handle);
+        HistorySeries kind = series == MW_HISTORY_EEG ? HistorySeries::Eeg : HistorySeries::Bands;
+        Require(channel >= 0 && channel < pipeline->HistoryChannels(kind), "channel is out of range");
+        size_t copied = pipeline->CopyHistory(kind, channel, valuesOut, static_cast<size_t>(count));
+        *copiedOut = static_cast<int>(copied);
+        return copied > 0 ? MW_OK : MW_NO_DATA;
+    });
+}
+
+int MwIngestGetLatency(int handle, int stage, MwLatencyStats* statsOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(stage >= 0 && stage < LatencyStageCount, "Unknown latency stage");
+        Require(statsOut != nullptr, "statsOut is required");
+        CopyLatency(pipelines.Get(handle)->Latency(static_cast<LatencyStage>(stage)), statsOut);
+        return MW_OK;
+    });
+}
+
+int MwIngestResetLatency(int handle, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        pipelines.Get(handle)->ResetLatency();
+        return MW_OK;
+    });
+}
+
+int MwIngestGetStats(int handle, MwIngestStats* statsOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(statsOut != nullptr, "statsOut is required");
+        IngestStats stats = pipelines.Get(handle)->Stats();
+        statsOut->packetsIngested = static_cast<int64_t>(stats.packetsIngested);
+        statsOut->packetsDropped = static_cast<int64_t>(stats.packetsDropped);
+        statsOut->metricsPublished = static_cast<int64_t>(stats.metricsPublished);
+        statsOut->acksReceived = static_cast<int64_t>(stats.acksReceived);
+        statsOut->arenaBytesReserved = static_cast<int64_t>(stats.arena.bytesReserved);
+        statsOut->arenaBytesInUse = static_cast<int64_t>(stats.arena.bytesInUse);
+        statsOut->arenaPeakBytesInUse = static_cast<int64_t>(stats.arena.peakBytesInUse);
+        return MW_OK;
+    });
+}
+
+int MwIngestAttachTiming(int handle, int timingHandle, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        std::shared_ptr<IngestPipeline> pipeline = pipelines.Get(handle);
+        pipeline->AttachTiming(timingHandle != 0 ? TimingHandles().Get(timingHandle) : nullptr);
+        return MW_OK;
+    });
+}
@@ -0,0 +1,708 @@
+#include "pch.h"
+#include "IngestPipeline.h"
+#include "AllocationTracking.h"
+#include "Clock.h"
+#include "EegChain.h"
+#include "Profiler.h"
+#include "Tracing.h"
+
+#include <bit>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <limits>
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        constexpr auto IdleWait = std::chrono::milliseconds(10);
+        constexpr double MetricsRate = 10.0;    // band power updates per second, from either source
+        constexpr int HistoryReadAttempts = 4;
+
+        size_t RoundUpToPowerOfTwo(size_t value)
+        {
+            size_t size = 1;
+            while (size < value)
+            {
+                size <<= 1;
+            }
+            return size;
+        }
+
+        int64_t WallClockMicroseconds()
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        // Start of the value following "key": in a flat JSON object, or nullptr if the key is absent
+        const char* FindValue(const std::string& text, const char* key)
+        {
+            size_t at = text.find(key);
+            if (at == std::string::npos)
+            {
+                return nullptr;
+            }
+            at = text.find(':', at + std::strlen(key));
+            return at != std::string::npos ? text.c_str() + at + 1 : nullptr;
+        }
+
+        // Reads the number following "key": in a flat JSON object; returns false if the key is absent
+        bool FindNumber(const std::string& text, const char* key, double& value)
+        {
+            const char* start = FindValue(text, key);
+            if (start == nullptr)
+            {
+                return false;
+            }
+            char* end = nullptr;
+            value = std::strtod(start, &end);
+            return end != start;
+        }
+
+        // As FindNumber for a non-negative integer that fits in 64 bits; false for anything else
+        bool FindInteger(const std::string& text, const char* key, uint64_t& value)
+        {
+            const char* start = FindValue(text, key);
+            while (start != nullptr && (*start == ' ' || *start == '\t'))
+            {
+                start++;
+            }
+            // strtoull would accept and negate a minus sign
+            if (start == nullptr || !std::isdigit(static_cast<unsigned char>(*start)))
+            {
+                return false;
+            }
+            char* end = nullptr;
+            errno = 0;
+            value = std::strtoull(start, &end, 10);
+            return errno != ERANGE && *end != '.' && *end != 'e' && *end != 'E';
+        }
+    }
+
+    IngestPipeline::IngestPipeline(const Options& options)
+        : options(options),
+          arena(std::make_shared<SessionArena>()),
+          capacity(RoundUpToPowerOfTwo(options.queueCapacity)),
+          queue(capacity * 2, arena.get()),
+          overflowPolicy(options.overflowPolicy),
+          bandHistory(BandCount, ChannelRing<double>::CapacityFor(options.historySeconds, MetricsRate), arena.get())
+    {
+        eeg = EegChain::Create(options, arena.get());
+        StartWorker();
+    }
+
+    IngestPipeline::~IngestPipeline()
+    {
+        if (pool)
+        {
+            pool->Unregister(poolClient);
+        }
+        else
+        {
+            StopWorker();
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(sinkLock);
+            if (sinks.Read().hub)
+            {
+                sinks.Read().hub->RemoveMessageHandler(hubHandlerId);
+            }
+        }
+        // Retired sink snapshots still hold the overlay and hub; let them go with the pipeline
+        Epochs::Synchronize();
+    }
+
+    bool IngestPipeline::Push(const MusePacket& packet, uint64_t callbackNs)
+    {
+        MW_ALLOCATION_STAGE("ingest.push");
+        Item item{ packet, callbackNs, MonotonicNanoseconds() };
+
+        int64_t wallUs = WallClockMicroseconds();
+        if (packet.timestampUs > 0 && wallUs >= packet.timestampUs)
+        {
+            histograms[static_cast<int>(LatencyStage::Transport)].Record(static_cast<uint64_t>(wallUs - packet.timestampUs) * 1000);
+        }
+        if (callbackNs != 0)
+        {
+            Record(LatencyStage::Callback, callbackNs, item.ingestNs);
+        }
+
+        // Managed callers may push from thread-pool threads, so producers are serialised
+        OverflowPolicy policy = overflowPolicy.load(std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> guard(pushLock);
+            if (timing)
+            {
+                timing->Record(packet, item.ingestNs);
+            }
+            if (!Enqueue(item, policy))
+            {
+                return false;
+            }
+            if (pool)
+            {
+                pool->Schedule(poolClient);
+            }
+        }
+
+        // Pairs with the fence in Run: either the worker sees the item or we see it waiting
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed))
+        {
+            std::lock_guard<std::mutex> guard(wakeLock);
+            wakeSignal.notify_one();
+        }
+        return true;
+    }
+
+    void IngestPipeline::AttachPool(std::shared_ptr<DspPool> pool)
+    {
+        // Packets pushed during the switch wait in the queue for whichever worker comes next
+        std::lock_guard<std::mutex> guard(pushLock);
+        if (this->pool)
+        {
+            this->pool->Unregister(poolClient);
+            poolClient = nullptr;
+        }
+        else
+        {
+            StopWorker();
+        }
+
+        this->pool = std::move(pool);
+        if (this->pool)
+        {
+            poolClient = this->pool->Register([this] { return Drain(PoolBatch); });
+            if (HasWork())
+            {
+                this->pool->Schedule(poolClient);
+            }
+        }
+        else
+        {
+            StartWorker();
+        }
+    }
+
+    ThreadPriority IngestPipeline::SetWorkerScheduling(const ThreadScheduling& scheduling)
+    {
+        std::lock_guard<std::mutex> guard(pushLock);
+        if (pool)
+        {
+            throw std::logic_error("The pipeline is drained by a shared DSP pool, whose workers keep their own scheduling");
+        }
+        // Priority and MMCSS apply to the calling thread, so the worker is restarted to take them up
+        StopWorker();
+        workerScheduling = scheduling;
+        try
+        {
+            return StartWorker();
+        }
+        catch (...)
+        {
+            // The new worker runs unrestricted; record that rather than what was asked for
+            workerScheduling = ThreadScheduling();
+            throw;
+        }
+    }
+
+    void IngestPipeline::SetOverflowPolicy(OverflowPolicy policy)
+    {
+        overflowPolicy.store(policy, std::memory_order_relaxed);
+        // A producer blocked under the old policy carries on under the new one
+        WakeProducer();
+    }
+
+    void IngestPipeline::AttachOverlay(std::shared_ptr<OverlaySource> overlay)
+    {
+        std::lock_guard<std::mutex> guard(sinkLock);
+        sinks.Update([&](Sinks& next) { next.overlay = std::move(overlay); });
+    }
+
+    void IngestPipeline::AttachHub(std::shared_ptr<BroadcastHub> hub)
+    {
+        std::lock_guard<std::mutex> guard(sinkLock);
+        if (sinks.Read().hub)
+        {
+            sinks.Read().hub->RemoveMessageHandler(hubHandlerId);
+        }
+        // Trace ids come from the hub, so this handler only matches acknowledgements of our own messages
+        hubHandlerId = hub ? hub->AddMessageHandler([this](int, const uint8_t* data, size_t length) { HandleAck(data, length); }) : 0;
+        sinks.Update([&](Sinks& next) { next.hub = std::move(hub); });
+    }
+
+    int IngestPipeline::AddListener(std::optional<MuseDataPacketType> packetType, PacketListener listener)
+    {
+        std::lock_guard<std::mutex> guard(sinkLock);
+        int id = nextListenerId++;
+        sinks.Update([&](Sinks& next) { next.listeners.push_back(Listener{ id, packetType, std::move(listener) }); });
+        return id;
+    }
+
+    bool IngestPipeline::RemoveListener(int id)
+    {
+        {
+            std::lock_guard<std::mutex> guard(sinkLock);
+            const std::vector<Listener>& listeners = sinks.Read().listeners;
+            if (std::none_of(listeners.begin(), listeners.end(), [id](const Listener& l) { return l.id == id; }))
+            {
+                return false;
+            }
+            sinks.Update([id](Sinks& next)
+            {
+                next.listeners.erase(std::remove_if(next.listeners.begin(), next.listeners.end(),
+                    [id](const Listener& l) { return l.id == id; }), next.listeners.end());
+            });
+        }
+        // The worker may still be inside the old snapshot's copy of the listener
+        Epochs::Synchronize();
+        return true;
+    }
+
+    void IngestPipeline::AttachTiming(std::shared_ptr<PacketTimingMonitor> timing)
+    {
+        std::lock_guard<std::mutex> guard(pushLock);
+        this->timing = std::move(timing);
+    }
+
+    void IngestPipeline::LatestMetrics(double& focus, std::array<double, BandCount>& bands) const
+    {
+        std::lock_guard<std::mutex> guard(metricsLock);
+        focus = this->focus;
+        bands = this->bands;
+    }
+
+    void IngestPipeline::ResetLatency()
+    {
+        for (LatencyHistogram& histogram : histograms)
+        {
+            histogram.Reset();
+        }
+    }
+
+    size_t IngestPipeline::CopyHistory(HistorySeries series, int channel, double* out, size_t length) const
+    {
+        // A copy only fails when the worker laps it, so a retry straight away almost always succeeds
+        for (int attempt = 0; attempt < HistoryReadAttempts; attempt++)
+        {
+            bool eegSeries = series == HistorySeries::Eeg;
+            size_t copied = eegSeries ? eeg->CopyHistory(channel, out, length) : bandHistory.CopyLatest(channel, out, length);
+            if (copied > 0 || (eegSeries ? eeg->HistoryCount() : bandHistory.Count()) == 0)
+            {
+                return copied;
+            }
+        }
+        return 0;
+    }
+
+    IngestStats IngestPipeline::Stats() const
+    {
+        QueueStats queueStats = queueCounters.Read(overflowPolicy.load(std::memory_order_relaxed), QueueDepth(), capacity);
+        return IngestStats{
+            queueStats.accepted,
+            queueStats.Dropped(),
+            metricsPublished.load(std::memory_order_relaxed),
+            acksReceived.load(std::memory_order_relaxed),
+            arena->Stats(),
+            queueStats,
+        };
+    }
+
+    size_t IngestPipeline::QueueDepth() const
+    {
+        return Waiting() + static_cast<size_t>(std::popcount(latestPending.load(std::memory_order_relaxed)));
+    }
+
+    size_t IngestPipeline::Waiting() const
+    {
+        // Packets the consumer is about to skip no longer count against the capacity
+        size_t queued = queue.Size();
+        size_t evicting = static_cast<size_t>(evictionsPending.load(std::memory_order_relaxed));
+        return queued > evicting ? queued - evicting : 0;
+    }
+
+    bool IngestPipeline::Enqueue(const Item& item, OverflowPolicy policy)
+    {
+        if (policy == OverflowPolicy::Block)
+        {
+            WaitForRoom();
+            policy = overflowPolicy.load(std::memory_order_relaxed);
+        }
+
+        if (policy == OverflowPolicy::LatestOnly)
+        {
+            int type = static_cast<int>(item.packet.type);
+            uint64_t bit = uint64_t{ 1 } << type;
+            std::lock_guard<std::mutex> guard(latestLock);
+            if ((latestPending.load(std::memory_order_relaxed) & bit) != 0)
+            {
+                QueueCounters::Add(queueCounters.coalesced);
+            }
+            latest[type] = item;
+            latestPending.fetch_or(bit, std::memory_order_release);
+            QueueCounters::Add(queueCounters.accepted);
+            return true;
+        }
+
+        bool full = Waiting() >= capacity;
+        if ((full && policy == OverflowPolicy::DropNewest) || !queue.TryPush(item))
+        {
+            // Drop-oldest ends up here only once the reserve is full as well, i.e. the consumer has stalled
+            QueueCounters::Add(queueCounters.droppedNewest);
+            return false;
+        }
+        if (full && policy == OverflowPolicy::DropOldest)
+        {
+            evictionsPending.fetch_add(1, std::memory_order_relaxed);
+        }
+        QueueCounters::Add(queueCounters.accepted);
+        return true;
+    }
+
+    void IngestPipeline::WaitForRoom()
+    {
+        if (Waiting() < capacity)
+        {
+            return;
+        }
+        MW_TRACE_SCOPE("ingest.blocked");
+        uint64_t startNs = MonotonicNanoseconds();
+        {
+            std::unique_lock<std::mutex> guard(roomLock);
+            while (true)
+            {
+                producerBlocked.store(true, std::memory_order_relaxed);
+                // Pairs with the fence in Drain: either the consumer sees us blocked or we see the room it made
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (Waiting() < capacity || overflowPolicy.load(std::memory_order_relaxed) != OverflowPolicy::Block)
+                {
+                    break;
+                }
+                roomSignal.wait_for(guard, IdleWait);
+            }
+            producerBlocked.store(false, std::memory_order_relaxed);
+        }
+        QueueCounters::Add(queueCounters.blockedNs, MonotonicNanoseconds() - startNs);
+    }
+
+    void IngestPipeline::WakeProducer()
+    {
+        std::lock_guard<std::mutex> guard(roomLock);
+        roomSignal.notify_one();
+    }
+
+    ThreadPriority IngestPipeline::StartWorker()
+    {
+        running = true;
+        std::promise<ThreadPriority> started;
+        std::future<ThreadPriority> applied = started.get_future();
+        worker = std::thread(&IngestPipeline::Run, this, &started);
+        return applied.get();
+    }
+
+    void IngestPipeline::StopWorker()
+    {
+        running = false;
+        {
+            std::lock_guard<std::mutex> guard(wakeLock);
+            wakeSignal.notify_one();
+        }
+        worker.join();
+    }
+
+    void IngestPipeline::Run(std::promise<ThreadPriority>* started)
+    {
+        MW_TRACE_THREAD_NAME("MuseWrapper ingest");
+        Profiler::ThreadRegistration profiled("MuseWrapper ingest");
+        // StartWorker waits on started, so workerScheduling cannot change underneath; started is gone once set
+        std::optional<ScopedThreadScheduling> scheduled;
+        try
+        {
+            scheduled.emplace(workerScheduling);
+            started->set_value(scheduled->Applied());
+        }
+        catch (...)
+        {
+            started->set_exception(std::current_exception());
+        }
+
+        while (true)
+        {
+            Drain(std::numeric_limits<size_t>::max());
+            if (!running.load())
+            {
+                break;
+            }
+
+            std::unique_lock<std::mutex> guard(wakeLock);
+            waiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!HasWork() && running.load())
+            {
+                wakeSignal.wait_for(guard, IdleWait);
+            }
+            waiting.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    bool IngestPipeline::Drain(size_t maxItems)
+    {
+        if (!HasWork())
+        {
+            return false;
+        }
+        MW_TRACE_SCOPE("ingest.batch");
+        MW_ALLOCATION_STAGE("ingest.batch");
+        MW_TRACE_COUNTER("ingest.queue_depth", queue.Size());
+        Item item;
+        for (size_t i = 0; i < maxItems && queue.TryPop(item);)
+        {
+            // Drop-oldest evictions come off the head as they are asked for, so a long batch skips ahead too
+            if (evictionsPending.load(std::memory_order_relaxed) != 0)
+            {
+                evictionsPending.fetch_sub(1, std::memory_order_relaxed);
+                QueueCounters::Add(queueCounters.droppedOldest);
+                continue;
+            }
+            Process(item, MonotonicNanoseconds());
+            i++;
+            // Unfenced, so a blocked producer may sleep on until the check below; this only wakes it sooner
+            if (producerBlocked.load(std::memory_order_relaxed))
+            {
+                WakeProducer();
+            }
+        }
+        if (latestPending.load(std::memory_order_acquire) != 0)
+        {
+            DrainLatest();
+        }
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (producerBlocked.load(std::memory_order_relaxed))
+        {
+            WakeProducer();
+        }
+        return HasWork();
+    }
+
+    void IngestPipeline::DrainLatest()
+    {
+        size_t count = 0;
+        {
+            std::lock_guard<std::mutex> guard(latestLock);
+            uint64_t pending = latestPending.exchange(0, std::memory_order_relaxed);
+            for (; pending != 0; pending &= pending - 1)
+            {
+                latestTaken[count++] = latest[std::countr_zero(pending)];
+            }
+        }
+        // Slots are per type, so restore arrival order across types
+        std::sort(latestTaken.begin(), latestTaken.begin() + count,
+            [](const Item& a, const Item& b) { return a.ingestNs < b.ingestNs; });
+        for (size_t i = 0; i < count; i++)
+        {
+            Process(latestTaken[i], MonotonicNanoseconds());
+        }
+    }
+
+    void IngestPipeline::Process(const Item& item, uint64_t dequeuedNs)
+    {
+        Record(LatencyStage::Queue, item.ingestNs, dequeuedNs);
+        const MusePacket& packet = item.packet;
+        Dispatch(packet);
+
+        if (packet.type == MuseDataPacketType::Eeg && options.bandSource == BandSource::Eeg)
+        {
+            {
+                MW_TRACE_SCOPE("dsp.filter");
+                MW_ALLOCATION_STAGE("dsp.filter");
+                eeg->Filter(packet);
+            }
+            uint64_t filteredNs = MonotonicNanoseconds();
+            Record(LatencyStage::Filter, dequeuedNs, filteredNs);
+
+            bool updated;
+            {
+                MW_TRACE_SCOPE("dsp.band_power");
+                MW_ALLOCATION_STAGE("dsp.band_power");
+                updated = eeg->UpdateBandPower();
+            }
+            if (updated)
+            {
+                uint64_t bandNs = MonotonicNanoseconds();
+                Record(LatencyStage::BandPower, filteredNs, bandNs);
+                UpdateMetrics(eeg->Powers(), options.eegChannels, item, bandNs);
+            }
+            return;
+        }
+
+        int band = static_cast<int>(packet.type) - static_cast<int>(MuseDataPacketType::AlphaAbsolute);
+        if (band >= 0 && band < BandCount && options.bandSource == BandSource::Libmuse)
+        {
+            // libmuse marks bad channels with NaN; average the rest
+            double sum = 0.0;
+            int valid = 0;
+            for (int c = 0; c < packet.valueCount; c++)
+            {
+                if (!std::isnan(packet.values[c]))
+                {
+                    sum += packet.values[c];
+                    valid++;
+                }
+            }
+            if (valid == 0)
+            {
+                return;
+            }
+            libmuseBands[band] = sum / valid;
+            libmuseBandTimestamps[band] = packet.timestampUs;
+
+            // libmuse sends the five bands with one timestamp; update once the set is complete
+            for (int b = 0; b < BandCount; b++)
+            {
+                if (libmuseBandTimestamps[b] != packet.timestampUs)
+                {
+                    return;
+                }
+            }
+            UpdateMetrics(libmuseBands.data(), 1, item, MonotonicNanoseconds());
+        }
+    }
+
+    void IngestPipeline::UpdateMetrics(const double* absolute, int channels, const Item& item, uint64_t stageStartNs)
+    {
+        MW_TRACE_SCOPE("ingest.metrics");
+        MW_ALLOCATION_STAGE("ingest.metrics");
+        std::array<double, BandCount> linear = {};
+        double total = 0.0;
+        for (int b = 0; b < BandCount; b++)
+        {
+            for (int c = 0; c < channels; c++)
+            {
+                linear[b] += std::pow(10.0, absolute[c * BandCount + b]);
+            }
+            total += linear[b];
+        }
+
+        std::array<double, BandCount> relative = {};
+        for (int b = 0; b < BandCount; b++)
+        {
+            relative[b] = total > 0.0 ? linear[b] / total : 0.0;
+        }
+        // Same definition as the managed BrainDataOBSHelper: beta / (alpha + beta)
+        double alphaBeta = relative[static_cast<int>(Band::Alpha)] + relative[static_cast<int>(Band::Beta)];
+        double newFocus = alphaBeta > 0.0 ? relative[static_cast<int>(Band::Beta)] / alphaBeta : 0.0;
+        {
+            std::lock_guard<std::mutex> guard(metricsLock);
+            focus = newFocus;
+            bands = relative;
+        }
+        bandHistory.Push(relative.data());
+
+        uint64_t metricsNs = MonotonicNanoseconds();
+        Record(LatencyStage::Metrics, stageStartNs, metricsNs);
+        Publish(item, metricsNs);
+    }
+
+    void IngestPipeline::Publish(const Item& item, uint64_t metricsNs)
+    {
+        MW_TRACE_SCOPE("ingest.publish");
+        MW_ALLOCATION_STAGE("ingest.publish");
+        Epochs::ReadGuard reading;
+        const Sinks& targets = sinks.Read();
+        const std::shared_ptr<OverlaySource>& overlayTarget = targets.overlay;
+        const std::shared_ptr<BroadcastHub>& hubTarget = targets.hub;
+
+        double currentFocus;
+        std::array<double, BandCount> currentBands;
+        LatestMetrics(currentFocus, currentBands);
+
+        if (overlayTarget)
+        {
+            std::array<float, BandCount> values;
+            for (int b = 0; b < BandCount; b++)
+            {
+                values[b] = static_cast<float>(currentBands[b]);
+            }
+            overlayTarget->SetMetrics(static_cast<float>(currentFocus), values.data(), BandCount, item.ingestNs);
+        }
+
+        if (hubTarget)
+        {
+            uint64_t trace = hubTarget->NextTrace();
+            char message[256];
+            int length = std::snprintf(message, sizeof(message),
+                "{\"trace\":%llu,\"focus\":%.4f,\"bands\":[%.4f,%.4f,%.4f,%.4f,%.4f]}",
+                static_cast<unsigned long long>(trace), currentFocus,
+                currentBands[0], currentBands[1], currentBands[2], currentBands[3], currentBands[4]);
+            {
+                std::lock_guard<std::mutex> guard(ackLock);
+                uint64_t startNs = item.callbackNs != 0 ? std::min(item.callbackNs, item.ingestNs) : item.ingestNs;
+                pendingAcks[trace % PendingAckSlots] = PendingAck{ trace, startNs, MonotonicNanoseconds() };
+            }
+            hubTarget->Publish(reinterpret_cast<const uint8_t*>(message), static_cast<size_t>(length), arena);
+        }
+
+        uint64_t publishedNs = MonotonicNanoseconds();
+        Record(LatencyStage::Publish, metricsNs, publishedNs);
+        Record(LatencyStage::Native, item.ingestNs, publishedNs);
+        metricsPublished.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void IngestPipeline::Dispatch(const MusePacket& packet)
+    {
+        Epochs::ReadGuard reading;
+        const std::vector<Listener>& listeners = sinks.Read().listeners;
+        if (listeners.empty())
+        {
+            return;
+        }
+        MW_TRACE_SCOPE("ingest.listeners");
+        for (const Listener& listener : listeners)
+        {
+            if (!listener.packetType || *listener.packetType == packet.type)
+            {
+                listener.callback(packet);
+            }
+        }
+    }
+
+    void IngestPipeline::HandleAck(const uint8_t* data, size_t length)
+    {
+        uint64_t receivedNs = MonotonicNanoseconds();
+        std::string text(reinterpret_cast<const char*>(data), length);
+        // The peer is untrusted: anything but a trace id in range is ignored
+        uint64_t trace;
+        if (!FindInteger(text, "\"ack\"", trace) || trace == 0)
+        {
+            return;
+        }
+
+        PendingAck pending;
+        {
+            std::lock_guard<std::mutex> guard(ackLock);
+            pending = pendingAcks[trace % PendingAckSlots];
+        }
+        if (pending.trace != trace)
+        {
+            return;     // another pipeline's on a shared hub, or too old: the slot has been reused
+        }
+
+        acksReceived.fetch_add(1, std::memory_order_relaxed);
+        Record(LatencyStage::OverlayAck, pending.publishNs, receivedNs);
+        Record(LatencyStage::EndToEnd, pending.startNs, receivedNs);
+        double renderUs;
+        // NaN, infinities and anything over a day are dropped rather than cast
+        if (FindNumber(text, "\"renderUs\"", renderUs) && std::isfinite(renderUs) && renderUs >= 0.0 && renderUs < 86'400e6)
+        {
+            histograms[static_cast<int>(LatencyStage::Render)].Record(static_cast<uint64_t>(renderUs * 1000.0));
+        }
+    }
+
+    void IngestPipeline::Record(LatencyStage stage, uint64_t fromNs, uint64_t toNs)
+    {
+        histograms[static_cast<int>(stage)].Record(toNs > fromNs ? toNs - fromNs : 0);
+    }
+}
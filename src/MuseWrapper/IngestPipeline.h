@@ -0,0 +1,302 @@
+#pragma once
+
+#include "Backpressure.h"
+#include "BroadcastHub.h"
+#include "ChannelRing.h"
+#include "DspPool.h"
+#include "LatencyHistogram.h"
+#include "MuseTypes.h"
+#include "OverlaySource.h"
+#include "PacketTiming.h"
+#include "Rcu.h"
+#include "SessionArena.h"
+#include "SpscQueue.h"
+#include "ThreadScheduling.h"
+
+#include <condition_variable>
+#include <future>
+#include <optional>
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Pipeline stages with a latency histogram; values match the MW_STAGE_* constants
+    /// </summary>
+    enum class LatencyStage : int
+    {
+        Transport,      // device timestamp -> ingest, on the wall clock (includes any clock offset)
+        Callback,       // libmuse callback -> ingest, when the caller supplies its callback stamp
+        Queue,          // ingest -> dequeued by the pipeline worker
+        Filter,         // notch and high-pass of one EEG sample
+        BandPower,      // band power update triggered by a sample
+        Metrics,        // relative bands and focus from band powers
+        Publish,        // hand-off to the native overlay and the broadcast hub
+        OverlayAck,     // publish -> acknowledgement from the overlay page
+        Render,         // overlay page's own receive-to-rendered time, as reported in the ack
+        Native,         // ingest -> publish
+        EndToEnd,       // earliest stamp -> acknowledgement from the overlay page
+        Count,
+    };
+
+    constexpr int LatencyStageCount = static_cast<int>(LatencyStage::Count);
+
+    /// <summary>
+    /// Time series kept by the pipeline; values match the MW_HISTORY_* constants
+    /// </summary>
+    enum class HistorySeries : int
+    {
+        Eeg,        // notched and high-passed EEG, one row per channel (EEG band source only)
+        Bands,      // relative band powers, one row per Band, at the metrics rate
+    };
+
+    class EegChain;
+
+    struct IngestStats
+    {
+        uint64_t packetsIngested;
+        uint64_t packetsDropped;        // every packet lost to the queue's overflow policy
+        uint64_t metricsPublished;
+        uint64_t acksReceived;
+        ArenaStats arena;
+        QueueStats queue;
+    };
+
+    /// <summary>
+    /// Called on the pipeline worker for every dequeued packet of the type it was added for
+    /// </summary>
+    using PacketListener = std::function<void(const MusePacket& packet)>;
+
+    /// <summary>
+    /// Native ingest path for one headband: packets from the libmuse callback are stamped and queued,
+    /// and a worker filters EEG, computes band powers and focus, and publishes them to an attached
+    /// native overlay and broadcast hub. Every packet carries its ingest stamp through each stage, so
+    /// per-stage latency is measured on the pipeline's own clock (MonotonicNanoseconds).
+    ///
+    /// Published hub messages are JSON: {"trace":N,"focus":F,"bands":[alpha,beta,delta,theta,gamma]}.
+    /// An overlay page closes the loop by sending {"ack":N,"renderUs":R} on the same WebSocket once the
+    /// update is on screen, R being its own message-to-frame time (e.g. measured up to the next
+    /// requestAnimationFrame callback).
+    ///
+    /// The queue, filter and band power state and every published frame live in the pipeline's own
+    /// SessionArena, which goes back to the heap in one piece once the pipeline and the last of its
+    /// frames still queued on the hub are gone.
+    ///
+    /// The queue holds at most Options::queueCapacity packets, and what happens to the next one is the
+    /// queue's OverflowPolicy: Block holds the pushing callback until the worker makes room,
+    /// DropNewest refuses it, DropOldest has the worker skip the oldest queued packet before its next
+    /// batch (the queue keeps as much again in reserve for the packets waiting on those evictions,
+    /// and refuses packets once that is full as well), and LatestOnly keeps only the newest packet of
+    /// each type, which suits consumers of libmuse band packets rather than of raw EEG.
+    ///
+    /// The worker is a thread of the pipeline's own, which SetWorkerScheduling can raise above a
+    /// busy encoder and keep to chosen CPUs, until AttachPool moves the queue onto a DspPool shared
+    /// with other headbands, where it is drained in batches of at most PoolBatch packets.
+    ///
+    /// The overlay, hub and packet listeners form one Snapshot that the worker reads without a lock;
+    /// attaching a sink or adding a listener publishes a new copy, so UI-driven registration never
+    /// stalls the data path.
+    /// </summary>
+    class IngestPipeline
+    {
+    public:
+        enum class BandSource
+        {
+            Eeg,        // band powers computed here from raw EEG
+            Libmuse,    // libmuse *_ABSOLUTE packets
+        };
+
+        enum class SamplePrecision
+        {
+            Double,     // EEG filtered, analysed and kept as libmuse delivers it
+            Float,      // converted to float once at ingest; half the memory traffic, twice the SIMD lanes
+        };
+
+        struct Options
+        {
+            int eegChannels = 4;
+            double eegSampleRate = 256.0;
+            double notchFrequency = 60.0;   // 0 disables the notch
+            BandSource bandSource = BandSource::Eeg;
+            size_t queueCapacity = 4096;
+            OverflowPolicy overflowPolicy = OverflowPolicy::DropNewest;
+            double historySeconds = 8.0;    // at least this much of each HistorySeries is kept
+            SamplePrecision precision = SamplePrecision::Double;
+        };
+
+        explicit IngestPipeline(const Options& options);
+
+        /// <summary>
+        /// Waits for readers of the sinks and the hub's handlers, so the last reference must not be
+        /// released inside an Epochs::ReadGuard (a packet listener or hub message handler)
+        /// </summary>
+        ~IngestPipeline();
+
+        IngestPipeline(const IngestPipeline&) = delete;
+        IngestPipeline& operator=(const IngestPipeline&) = delete;
+
+        /// <summary>
+        /// Stamps and queues a packet; returns false if the overflow policy refused it.
+        /// callbackNs is the MonotonicNanoseconds time the libmuse callback fired, or 0 if unknown.
+        /// </summary>
+        bool Push(const MusePacket& packet, uint64_t callbackNs);
+
+        /// <summary>
+        /// Drains the queue on a shared pool instead of the pipeline's own thread, or on its own thread again when null
+        /// </summary>
+        void AttachPool(std::shared_ptr<DspPool> pool);
+
+        /// <summary>
+        /// Sets the priority and CPUs of the pipeline's own worker, which drains the libmuse callbacks'
+        /// queue and runs the first processing stages, by restarting it; returns the priority it got.
+        /// Throws while the pipeline is attached to a pool, and when the CPUs are refused, in which
+        /// case the worker runs unrestricted.
+        /// </summary>
+        ThreadPriority SetWorkerScheduling(const ThreadScheduling& scheduling);
+
+        /// <summary>
+        /// Changes what happens to packets pushed while the queue is full; packets already queued stay
+        /// </summary>
+        void SetOverflowPolicy(OverflowPolicy policy);
+
+        void AttachOverlay(std::shared_ptr<OverlaySource> overlay);
+
+        /// <summary>
+        /// Publishes metrics to the hub and adds a message handler for the overlay acknowledgements of
+        /// what this pipeline published; several pipelines may share one hub
+        /// </summary>
+        void AttachHub(std::shared_ptr<BroadcastHub> hub);
+
+        /// <summary>
+        /// Records every pushed packet's arrival in the device's timing monitor
+        /// </summary>
+        void AttachTiming(std::shared_ptr<PacketTimingMonitor> timing);
+
+        /// <summary>
+        /// Adds a listener for one packet type, or for every type without one; returns its id
+        /// </summary>
+        int AddListener(std::optional<MuseDataPacketType> packetType, PacketListener listener);
+
+        /// <summary>
+        /// Removes a listener and waits for a call already in progress, so whatever it captured can be
+        /// freed on return. Cannot be called from a listener. Returns false for an unknown id.
+        /// </summary>
+        bool RemoveListener(int id);
+
+        /// <summary>
+        /// Latest focus (0-1) and relative band powers (0-1), in Band order
+        /// </summary>
+        void LatestMetrics(double& focus, std::array<double, BandCount>& bands) const;
+
+        /// <summary>
+        /// Copies up to length of the newest values of one row of a series, oldest first; returns the
+        /// number copied (0 if there are none yet)
+        /// </summary>
+        size_t CopyHistory(HistorySeries series, int channel, double* out, size_t length) const;
+        int HistoryChannels(HistorySeries series) const { return series == HistorySeries::Eeg ? options.eegChannels : BandCount; }
+
+        LatencySummary Latency(LatencyStage stage) const { return histograms[static_cast<int>(stage)].Summarise(); }
+        void ResetLatency();
+        IngestStats Stats() const;
+        size_t QueueDepth() const;
+        size_t QueueCapacity() const { return capacity; }
+
+    private:
+        struct Item
+        {
+            MusePacket packet;
+            uint64_t callbackNs;
+            uint64_t ingestNs;
+        };
+
+        struct PendingAck
+        {
+            uint64_t trace;
+            uint64_t startNs;
+            uint64_t publishNs;
+        };
+
+        static constexpr size_t PendingAckSlots = 64;
+        static constexpr size_t PoolBatch = 64;     // a quarter of a second of EEG at 256 Hz
+
+        ThreadPriority StartWorker();
+        void StopWorker();
+        void Run(std::promise<ThreadPriority>* started);
+        bool Enqueue(const Item& item, OverflowPolicy policy);
+        void WaitForRoom();
+        void WakeProducer();
+        size_t Waiting() const;
+        bool HasWork() const { return queue.Size() != 0 || latestPending.load(std::memory_order_relaxed) != 0; }
+        bool Drain(size_t maxItems);
+        void DrainLatest();
+        void Process(const Item& item, uint64_t dequeuedNs);
+        void UpdateMetrics(const double* absolute, int channels, const Item& item, uint64_t stageStartNs);
+        void Publish(const Item& item, uint64_t metricsNs);
+        void Dispatch(const MusePacket& packet);
+        void HandleAck(const uint8_t* data, size_t length);
+        void Record(LatencyStage stage, uint64_t fromNs, uint64_t toNs);
+
+        Options options;
+        std::shared_ptr<SessionArena> arena;    // shared with published frames, so declared first and freed last
+        size_t capacity;                        // packets the queue holds before its overflow policy applies
+        SpscQueue<Item> queue;                  // twice capacity, the reserve for drop-oldest
+        std::atomic<OverflowPolicy> overflowPolicy;
+        std::atomic<uint64_t> evictionsPending{ 0 };    // oldest packets the consumer is to skip
+        QueueCounters queueCounters;
+        std::mutex pushLock;
+        std::shared_ptr<PacketTimingMonitor> timing;   // guarded by pushLock
+        std::shared_ptr<DspPool> pool;                  // guarded by pushLock; null while the own thread runs
+        DspPool::Client* poolClient = nullptr;          // guarded by pushLock
+        ThreadScheduling workerScheduling;              // guarded by pushLock; taken up when the own thread starts
+        std::mutex wakeLock;
+        std::condition_variable wakeSignal;
+        std::atomic<bool> waiting{ false };
+        std::atomic<bool> running{ false };
+        std::mutex roomLock;
+        std::condition_variable roomSignal;
+        std::atomic<bool> producerBlocked{ false };
+
+        // Latest-only slots, one per packet type
+        std::mutex latestLock;
+        std::array<Item, PacketTypeCount> latest = {};     // guarded by latestLock
+        std::atomic<uint64_t> latestPending{ 0 };           // bit per type with a slot not yet taken
+        static_assert(PacketTypeCount <= 64, "latestPending has a bit per packet type");
+
+        // Worker state
+        std::unique_ptr<EegChain> eeg;      // filters, band power and EEG history in options.precision
+        std::array<Item, PacketTypeCount> latestTaken = {};
+        std::array<double, BandCount> libmuseBands = {};
+        std::array<int64_t, BandCount> libmuseBandTimestamps = {};
+        ChannelRing<double> bandHistory;
+
+        mutable std::mutex metricsLock;
+        double focus = 0.0;
+        std::array<double, BandCount> bands = {};
+
+        struct Listener
+        {
+            int id;
+            std::optional<MuseDataPacketType> packetType;
+            PacketListener callback;
+        };
+
+        struct Sinks
+        {
+            std::shared_ptr<OverlaySource> overlay;
+            std::shared_ptr<BroadcastHub> hub;
+            std::vector<Listener> listeners;
+        };
+
+        std::mutex sinkLock;                // serialises sink updates; readers use the snapshot alone
+        Snapshot<Sinks> sinks;
+        int nextListenerId = 1;             // guarded by sinkLock
+        int hubHandlerId = 0;               // guarded by sinkLock; this pipeline's handler on sinks' hub
+
+        std::mutex ackLock;
+        std::array<PendingAck, PendingAckSlots> pendingAcks = {};
+
+        std::array<LatencyHistogram, LatencyStageCount> histograms;
+        std::atomic<uint64_t> metricsPublished{ 0 };
+        std::atomic<uint64_t> acksReceived{ 0 };
+        std::thread worker;
+    };
+}
@@ -0,0 +1,107 @@
+#include "pch.h"
+#include "LatencyHistogram.h"
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        constexpr uint64_t HalfSubBuckets = uint64_t{ 1 } << (LatencyHistogram::SubBucketBits - 1);
+
+        int HighestBit(uint64_t value)
+        {
+            int bit = 63;
+            while ((value >> bit) == 0)
+            {
+                bit--;
+            }
+            return bit;
+        }
+    }
+
+    size_t LatencyHistogram::BucketIndex(uint64_t value)
+    {
+        if (value < (uint64_t{ 1 } << SubBucketBits))
+        {
+            return static_cast<size_t>(value);
+        }
+        // Keep the top SubBucketBits bits; the shift is the bucket's magnitude
+        int shift = HighestBit(value) - (SubBucketBits - 1);
+        return static_cast<size_t>(shift * HalfSubBuckets + (value >> shift));
+    }
+
+    uint64_t LatencyHistogram::BucketLowerBound(size_t index)
+    {
+        if (index < (size_t{ 1 } << SubBucketBits))
+        {
+            return index;
+        }
+        uint64_t shift = index / HalfSubBuckets - 1;
+        return (index - shift * HalfSubBuckets) << shift;
+    }
+
+    void LatencyHistogram::Record(uint64_t valueNs)
+    {
+        buckets[BucketIndex(valueNs)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(valueNs, std::memory_order_relaxed);
+
+        uint64_t current = min.load(std::memory_order_relaxed);
+        while (valueNs < current && !min.compare_exchange_weak(current, valueNs, std::memory_order_relaxed))
+        {
+        }
+        current = max.load(std::memory_order_relaxed);
+        while (valueNs > current && !max.compare_exchange_weak(current, valueNs, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    LatencySummary LatencyHistogram::Summarise() const
+    {
+        LatencySummary summary = {};
+        std::array<uint64_t, BucketCount> counts;   // on the stack: summaries run on recording threads
+        uint64_t total = 0;
+        for (size_t i = 0; i < BucketCount; i++)
+        {
+            counts[i] = buckets[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+        if (total == 0)
+        {
+            return summary;
+        }
+
+        summary.count = total;
+        summary.minNs = min.load(std::memory_order_relaxed);
+        summary.maxNs = max.load(std::memory_order_relaxed);
+        summary.meanNs = static_cast<double>(sum.load(std::memory_order_relaxed)) / static_cast<double>(std::max<uint64_t>(1, count.load(std::memory_order_relaxed)));
+
+        const double quantiles[] = { 0.50, 0.90, 0.99, 0.999 };
+        uint64_t* outputs[] = { &summary.p50Ns, &summary.p90Ns, &summary.p99Ns, &summary.p999Ns };
+        size_t bucket = 0;
+        uint64_t seen = counts[0];
+        for (int q = 0; q < 4; q++)
+        {
+            uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantiles[q] * static_cast<double>(total))));
+            while (seen < rank && bucket + 1 < BucketCount)
+            {
+                seen += counts[++bucket];
+            }
+            uint64_t low = BucketLowerBound(bucket);
+            uint64_t high = bucket + 1 < BucketCount ? BucketLowerBound(bucket + 1) : low;
+            *outputs[q] = std::clamp(low + (high - low) / 2, summary.minNs, summary.maxNs);
+        }
+        return summary;
+    }
+
+    void LatencyHistogram::Reset()
+    {
+        for (auto& bucket : buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count.store(0, std::memory_order_relaxed);
+        sum.store(0, std::memory_order_relaxed);
+        min.store(UINT64_MAX, std::memory_order_relaxed);
+        max.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+namespace MuseWrapper
+{
+    struct LatencySummary
+    {
+        uint64_t count;
+        uint64_t minNs;
+        uint64_t maxNs;
+        double meanNs;
+        uint64_t p50Ns;
+        uint64_t p90Ns;
+        uint64_t p99Ns;
+        uint64_t p999Ns;
+    };
+
+    /// <summary>
+    /// Log-linear histogram of nanosecond latencies: exact below 32 ns, then 16 sub-buckets per
+    /// power of two (at most ~6% relative error) up to 2^64. Record is wait-free (relaxed atomic
+    /// increments), so stages on different threads can share one histogram without locking.
+    /// </summary>
+    class LatencyHistogram
+    {
+    public:
+        static constexpr int SubBucketBits = 5;
+        static constexpr size_t BucketCount = (64 - SubBucketBits + 2) << (SubBucketBits - 1);
+
+        void Record(uint64_t valueNs);
+
+        /// <summary>
+        /// Percentiles report the midpoint of the bucket holding the rank. Concurrent records may be
+        /// partially included; a summary taken while idle is exact.
+        /// </summary>
+        LatencySummary Summarise() const;
+
+        void Reset();
+
+        static size_t BucketIndex(uint64_t value);
+        static uint64_t BucketLowerBound(size_t index);
+
+    private:
+        std::array<std::atomic<uint64_t>, BucketCount> buckets = {};
+        std::atomic<uint64_t> count{ 0 };
+        std::atomic<uint64_t> sum{ 0 };
+        std::atomic<uint64_t> min{ UINT64_MAX };
+        std::atomic<uint64_t> max{ 0 };
+    };
+}
@@ -0,0 +1,142 @@
+#include "pch.h"
+#include "LibmuseBinding.h"
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        constexpr int ErrorLength = 512;
+
+#ifdef _WIN32
+        constexpr const char* DefaultPath = "Libmuse.dll";
+#else
+        constexpr const char* DefaultPath = "libLibmuse.so";
+#endif
+
+        void Check(int result, const char* call, const char* error)
+        {
+            if (result != 0)
+            {
+                throw std::runtime_error(std::string(call) + " failed: " + (error[0] != '\0' ? error : "no message"));
+            }
+        }
+    }
+
+    std::unique_ptr<LibmuseBinding> LibmuseBinding::Load(const std::string& path)
+    {
+        std::unique_ptr<LibmuseBinding> binding(new LibmuseBinding());
+        binding->path = path.empty() ? DefaultPath : path;
+
+#ifdef _WIN32
+        binding->module = LoadLibraryA(binding->path.c_str());
+        if (binding->module == nullptr)
+        {
+            throw std::runtime_error("Cannot load " + binding->path + " (error " + std::to_string(GetLastError()) + ")");
+        }
+#else
+        binding->module = dlopen(binding->path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (binding->module == nullptr)
+        {
+            const char* reason = dlerror();
+            throw std::runtime_error("Cannot load " + binding->path + ": " + (reason != nullptr ? reason : "unknown error"));
+        }
+#endif
+
+        binding->registerConnectionListener = reinterpret_cast<ListenerCall>(binding->Resolve("IxRegisterConnectionListener"));
+        binding->unregisterConnectionListener = reinterpret_cast<ListenerCall>(binding->Resolve("IxUnregisterConnectionListener"));
+        binding->setPreset = reinterpret_cast<IntCall>(binding->Resolve("IxSetPreset"));
+        binding->enableDataTransmission = reinterpret_cast<IntCall>(binding->Resolve("IxEnableDataTransmission"));
+        binding->runAsynchronously = reinterpret_cast<MacCall>(binding->Resolve("IxRunAsynchronously"));
+        binding->disconnect = reinterpret_cast<MacCall>(binding->Resolve("IxDisconnect"));
+        binding->getConnectionState = reinterpret_cast<IntOutCall>(binding->Resolve("IxGetConnectionState"));
+        binding->getMuseConfiguration = reinterpret_cast<JsonCall>(binding->Resolve("IxGetMuseConfiguration"));
+        return binding;
+    }
+
+    LibmuseBinding::~LibmuseBinding()
+    {
+#ifdef _WIN32
+        FreeLibrary(static_cast<HMODULE>(module));
+#else
+        dlclose(module);
+#endif
+    }
+
+    void* LibmuseBinding::Resolve(const char* name) const
+    {
+#ifdef _WIN32
+        void* symbol = reinterpret_cast<void*>(GetProcAddress(static_cast<HMODULE>(module), name));
+#else
+        void* symbol = dlsym(module, name);
+#endif
+        if (symbol == nullptr)
+        {
+            throw std::runtime_error(path + " does not export " + name);
+        }
+        return symbol;
+    }
+
+    void LibmuseBinding::RegisterConnectionListener(const std::string& mac, ApiCallback listener) const
+    {
+        char error[ErrorLength] = {};
+        Check(registerConnectionListener(mac.c_str(), listener, error, ErrorLength), "IxRegisterConnectionListener", error);
+    }
+
+    void LibmuseBinding::UnregisterConnectionListener(const std::string& mac, ApiCallback listener) const
+    {
+        char error[ErrorLength] = {};
+        Check(unregisterConnectionListener(mac.c_str(), listener, error, ErrorLength), "IxUnregisterConnectionListener", error);
+    }
+
+    void LibmuseBinding::SetPreset(const std::string& mac, int preset) const
+    {
+        char error[ErrorLength] = {};
+        Check(setPreset(mac.c_str(), preset, error, ErrorLength), "IxSetPreset", error);
+    }
+
+    void LibmuseBinding::EnableDataTransmission(const std::string& mac, bool enable) const
+    {
+        char error[ErrorLength] = {};
+        Check(enableDataTransmission(mac.c_str(), enable ? 1 : 0, error, ErrorLength), "IxEnableDataTransmission", error);
+    }
+
+    void LibmuseBinding::RunAsynchronously(const std::string& mac) const
+    {
+        char error[ErrorLength] = {};
+        Check(runAsynchronously(mac.c_str(), error, ErrorLength), "IxRunAsynchronously", error);
+    }
+
+    void LibmuseBinding::Disconnect(const std::string& mac) const
+    {
+        char error[ErrorLength] = {};
+        Check(disconnect(mac.c_str(), error, ErrorLength), "IxDisconnect", error);
+    }
+
+    int LibmuseBinding::GetConnectionState(const std::string& mac) const
+    {
+        char error[ErrorLength] = {};
+        int state = 0;
+        Check(getConnectionState(mac.c_str(), &state, error, ErrorLength), "IxGetConnectionState", error);
+        return state;
+    }
+
+    std::string LibmuseBinding::GetMuseConfiguration(const std::string& mac) const
+    {
+        char error[ErrorLength] = {};
+        std::string json(1024, '\0');
+        int result = getMuseConfiguration(mac.c_str(), json.data(), static_cast<int>(json.size()), error, ErrorLength);
+        // A positive result is the buffer size libmuse needs
+        if (result > 0)
+        {
+            json.assign(static_cast<size_t>(result), '\0');
+            result = getMuseConfiguration(mac.c_str(), json.data(), static_cast<int>(json.size()), error, ErrorLength);
+        }
+        Check(result, "IxGetMuseConfiguration", error);
+        json.resize(std::strlen(json.c_str()));
+        return json;
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+namespace MuseWrapper
+{
+    // Same calling convention as libmuse's exports and listeners (stdcall on x86 Windows)
+#if defined(_WIN32)
+#define MW_LIBMUSE_CALL __stdcall
+#else
+#define MW_LIBMUSE_CALL
+#endif
+
+    /// <summary>
+    /// The libmuse Ix* entry points the native connection state machine drives, resolved at run time
+    /// from the same Libmuse.dll / libLibmuse.so the managed side binds, so MuseWrapper neither links
+    /// libmuse nor needs it for anything else. Each call throws std::runtime_error with libmuse's
+    /// message when it fails.
+    /// </summary>
+    class LibmuseBinding
+    {
+    public:
+        using ApiCallback = void (MW_LIBMUSE_CALL*)(const char* jsonArgs);
+
+        /// <summary>
+        /// Loads the library at path, or libmuse's default name when path is empty; throws when it or
+        /// one of the entry points cannot be found
+        /// </summary>
+        static std::unique_ptr<LibmuseBinding> Load(const std::string& path);
+
+        ~LibmuseBinding();
+
+        LibmuseBinding(const LibmuseBinding&) = delete;
+        LibmuseBinding& operator=(const LibmuseBinding&) = delete;
+
+        const std::string& Path() const { return path; }
+
+        void RegisterConnectionListener(const std::string& mac, ApiCallback listener) const;
+        void UnregisterConnectionListener(const std::string& mac, ApiCallback listener) const;
+        void SetPreset(const std::string& mac, int preset) const;
+        void EnableDataTransmission(const std::string& mac, bool enable) const;
+        void RunAsynchronously(const std::string& mac) const;
+        void Disconnect(const std::string& mac) const;
+        int GetConnectionState(const std::string& mac) const;
+
+        /// <summary>
+        /// The device's configuration JSON; throws while libmuse does not have it yet
+        /// </summary>
+        std::string GetMuseConfiguration(const std::string& mac) const;
+
+    private:
+        using MacCall = int (MW_LIBMUSE_CALL*)(const char* mac, char* errorOut, int errorLen);
+        using ListenerCall = int (MW_LIBMUSE_CALL*)(const char* mac, ApiCallback listener, char* errorOut, int errorLen);
+        using IntCall = int (MW_LIBMUSE_CALL*)(const char* mac, int value, char* errorOut, int errorLen);
+        using IntOutCall = int (MW_LIBMUSE_CALL*)(const char* mac, int* valueOut, char* errorOut, int errorLen);
+        using JsonCall = int (MW_LIBMUSE_CALL*)(const char* mac, char* jsonOut, int jsonLen, char* errorOut, int errorLen);
+
+        LibmuseBinding() = default;
+
+        void* Resolve(const char* name) const;
+
+        std::string path;
+        void* module = nullptr;
+
+        ListenerCall registerConnectionListener = nullptr;
+        ListenerCall unregisterConnectionListener = nullptr;
+        IntCall setPreset = nullptr;
+        IntCall enableDataTransmission = nullptr;
+        MacCall runAsynchronously = nullptr;
+        MacCall disconnect = nullptr;
+        IntOutCall getConnectionState = nullptr;
+        JsonCall getMuseConfiguration = nullptr;
+    };
+}
@@ -0,0 +1,98 @@
+// MetricsApi.cpp : Exported entry points for the shared-memory metrics page read by external monitors.
+#include "pch.h"
+#include "ApiHandles.h"
+#include "ApiSupport.h"
+#include "MetricsPage.h"
+#include "ReplayServer.h"
+
+using namespace MuseWrapper;
+
+namespace
+{
+    HandleTable<MetricsPage> pages;
+
+    // Sums every live hub and recording, so the page needs no registration for them
+    void CollectProcessMetrics(ProcessMetrics& metrics)
+    {
+        for (const auto& hub : HubHandles().Snapshot())
+        {
+            HubStats stats = hub->Stats();
+            metrics.hubCount++;
+            metrics.hubSubscribers += stats.subscribers;
+            metrics.hubFramesPublished += stats.framesPublished;
+            metrics.hubFramesDropped += stats.framesDropped;
+            metrics.hubBytesSent += stats.bytesSent;
+            metrics.hubBusyNs += stats.loopBusyNs;
+        }
+        for (const auto& writer : RecordingHandles().Snapshot())
+        {
+            metrics.recordingsOpen++;
+            metrics.recordingBacklogPackets += writer->Backlog();
+            metrics.recordingPacketsWritten += writer->PacketsWritten();
+        }
+        ReplayStats replay = SharedReplayServer().Stats();
+        metrics.replaySessions = static_cast<uint64_t>(replay.sessions);
+        metrics.replayBlockHits = replay.blockHits;
+        metrics.replayBlockMisses = replay.blockMisses;
+    }
+}
+
+int MwMetricsCreate(const char* segmentName, int intervalMs, int* handleOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(segmentName != nullptr && handleOut != nullptr, "segmentName and handleOut are required");
+        Require(intervalMs > 0, "intervalMs must be positive");
+        *handleOut = pages.Add(std::make_shared<MetricsPage>(segmentName, static_cast<uint64_t>(intervalMs) * 1'000'000, CollectProcessMetrics, SharedTimerWheel()));
+        return MW_OK;
+    });
+}
+
+int MwMetricsDestroy(int handle, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        pages.Remove(handle);
+        return MW_OK;
+    });
+}
+
+int MwMetricsAddDevice(int handle, const char* deviceName, int ingestHandle, int timingHandle, int* slotOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(deviceName != nullptr && slotOut != nullptr, "deviceName and slotOut are required");
+        std::shared_ptr<MetricsPage> page = pages.Get(handle);
+        *slotOut = page->AddDevice(deviceName,
+            ingestHandle != 0 ? IngestHandles().Get(ingestHandle) : nullptr,
+            timingHandle != 0 ? TimingHandles().Get(timingHandle) : nullptr);
+        return MW_OK;
+    });
+}
+
+int MwMetricsRemoveDevice(int handle, int slot, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        pages.Get(handle)->RemoveDevice(slot);
+        return MW_OK;
+    });
+}
+
+int MwMetricsSetDeviceStatus(int handle, int slot, int connectionState, double rssi, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        pages.Get(handle)->SetDeviceStatus(slot, connectionState, rssi);
+        return MW_OK;
+    });
+}
+
+int MwMetricsUpdate(int handle, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        pages.Get(handle)->Update();
+        return MW_OK;
+    });
+}
@@ -0,0 +1,202 @@
+#include "pch.h"
+#include "MetricsPage.h"
+#include "Clock.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        uint64_t UnixMilliseconds()
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+        }
+
+        uint64_t ProcessId()
+        {
+#ifdef _WIN32
+            return GetCurrentProcessId();
+#else
+            return static_cast<uint64_t>(getpid());
+#endif
+        }
+
+        double Rate(uint64_t current, uint64_t previous, double seconds)
+        {
+            return seconds > 0.0 && current >= previous ? static_cast<double>(current - previous) / seconds : 0.0;
+        }
+
+        // Total time spent in a stage, recovered from its histogram
+        double StageNs(const IngestPipeline& ingest, LatencyStage stage)
+        {
+            LatencySummary summary = ingest.Latency(stage);
+            return summary.meanNs * static_cast<double>(summary.count);
+        }
+    }
+
+    MetricsPage::MetricsPage(const std::string& name, uint64_t intervalNs, Collector collector, TimerWheel& timers)
+        : memory(SharedMemory::Create(name, sizeof(MetricsPageLayout))),
+          page(reinterpret_cast<MetricsPageLayout*>(memory->Data())),
+          intervalNs(intervalNs),
+          collector(std::move(collector)),
+          timers(timers)
+    {
+        std::memset(static_cast<void*>(page), 0, sizeof(MetricsPageLayout));
+        new (&page->sequence) std::atomic<uint64_t>(0);
+        page->version = Version;
+        page->pageBytes = sizeof(MetricsPageLayout);
+        page->deviceBlockBytes = sizeof(MetricsDeviceBlock);
+        page->deviceSlots = MetricsDeviceSlots;
+        page->packetTypeSlots = MetricsPacketTypeSlots;
+        page->processId = ProcessId();
+        page->intervalNs = intervalNs;
+        Update();
+
+        // Magic last: a reader that sees it also sees a complete first page
+        std::atomic_thread_fence(std::memory_order_release);
+        page->magic = Magic;
+        timer = timers.Schedule(intervalNs, intervalNs, [this](uint64_t) { Update(); });
+    }
+
+    MetricsPage::~MetricsPage()
+    {
+        timers.Cancel(timer);
+    }
+
+    int MetricsPage::AddDevice(const std::string& name, std::shared_ptr<IngestPipeline> ingest, std::shared_ptr<PacketTimingMonitor> timing)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (int slot = 0; slot < MetricsDeviceSlots; slot++)
+        {
+            Device& device = devices[slot];
+            if (!device.inUse)
+            {
+                device = Device{};
+                device.inUse = true;
+                device.name = name;
+                device.ingest = std::move(ingest);
+                device.timing = std::move(timing);
+                return slot;
+            }
+        }
+        throw std::runtime_error("All " + std::to_string(MetricsDeviceSlots) + " metrics device slots are in use");
+    }
+
+    void MetricsPage::RemoveDevice(int slot)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (slot < 0 || slot >= MetricsDeviceSlots || !devices[slot].inUse)
+        {
+            throw std::invalid_argument("Unknown metrics device slot " + std::to_string(slot));
+        }
+        devices[slot] = Device{};
+    }
+
+    void MetricsPage::SetDeviceStatus(int slot, int connectionState, double rssi)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (slot < 0 || slot >= MetricsDeviceSlots || !devices[slot].inUse)
+        {
+            throw std::invalid_argument("Unknown metrics device slot " + std::to_string(slot));
+        }
+        devices[slot].connectionState = connectionState;
+        devices[slot].rssi = rssi;
+    }
+
+    void MetricsPage::Update()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        Publish(MonotonicNanoseconds());
+    }
+
+    void MetricsPage::Publish(uint64_t nowNs)
+    {
+        // Gather everything first so the page is odd for as short a time as possible
+        ProcessMetrics process = {};
+        if (collector)
+        {
+            collector(process);
+        }
+        double seconds = lastPublishNs != 0 ? static_cast<double>(nowNs - lastPublishNs) / 1e9 : 0.0;
+        std::array<MetricsDeviceBlock, MetricsDeviceSlots> blocks = {};
+        uint64_t connected = 0;
+        for (int slot = 0; slot < MetricsDeviceSlots; slot++)
+        {
+            if (devices[slot].inUse)
+            {
+                FillDevice(devices[slot], blocks[slot], seconds);
+                connected += devices[slot].connectionState == static_cast<int>(ConnectionState::Connected) ? 1 : 0;
+            }
+        }
+
+        uint64_t sequence = page->sequence.load(std::memory_order_relaxed);
+        page->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        page->updateCount++;
+        page->updatedUnixMs = UnixMilliseconds();
+        page->connectedDevices = connected;
+        page->hubCount = process.hubCount;
+        page->hubSubscribers = process.hubSubscribers;
+        page->hubFramesPublished = process.hubFramesPublished;
+        page->hubFramesDropped = process.hubFramesDropped;
+        page->hubBytesSent = process.hubBytesSent;
+        page->hubBytesPerSecond = Rate(process.hubBytesSent, lastProcess.hubBytesSent, seconds);
+        page->hubBusyFraction = Rate(process.hubBusyNs, lastProcess.hubBusyNs, seconds) / 1e9;
+        page->recordingsOpen = process.recordingsOpen;
+        page->recordingBacklogPackets = process.recordingBacklogPackets;
+        page->recordingPacketsWritten = process.recordingPacketsWritten;
+        page->recordingPacketsPerSecond = Rate(process.recordingPacketsWritten, lastProcess.recordingPacketsWritten, seconds);
+        page->replaySessions = process.replaySessions;
+        page->replayBlockHits = process.replayBlockHits;
+        page->replayBlockMisses = process.replayBlockMisses;
+        std::memcpy(static_cast<void*>(page->devices), blocks.data(), sizeof(page->devices));
+
+        page->sequence.store(sequence + 2, std::memory_order_release);
+        lastProcess = process;
+        lastPublishNs = nowNs;
+    }
+
+    void MetricsPage::FillDevice(Device& device, MetricsDeviceBlock& block, double seconds)
+    {
+        size_t length = std::min(device.name.size(), sizeof(block.name) - 1);
+        std::memcpy(block.name, device.name.data(), length);
+        block.inUse = 1;
+        block.connectionState = device.connectionState;
+        block.rssi = device.rssi;
+
+        if (device.timing)
+        {
+            for (int type = 0; type < PacketTypeCount; type++)
+            {
+                PacketTotals totals = device.timing->Totals(static_cast<MuseDataPacketType>(type));
+                block.packetsTotal[type] = totals.packets;
+                block.packetsPerSecond[type] = Rate(totals.packets, device.lastPackets[type], seconds);
+                block.missingSamples += totals.missingSamples;
+                device.lastPackets[type] = totals.packets;
+            }
+            block.droppedEegSamples = device.timing->Totals(MuseDataPacketType::Eeg).droppedSamples;
+            block.droppedAccelerometerSamples = device.timing->Totals(MuseDataPacketType::Accelerometer).droppedSamples;
+        }
+
+        if (device.ingest)
+        {
+            const IngestPipeline& ingest = *device.ingest;
+            block.queueDepth = ingest.QueueDepth();
+            block.queueCapacity = ingest.QueueCapacity();
+            block.queueDropped = ingest.Stats().packetsDropped;
+            block.filterP99Ns = ingest.Latency(LatencyStage::Filter).p99Ns;
+            block.bandPowerP99Ns = ingest.Latency(LatencyStage::BandPower).p99Ns;
+            block.endToEndP99Ns = ingest.Latency(LatencyStage::EndToEnd).p99Ns;
+
+            // Latency resets make the running total drop; skip that interval rather than report garbage
+            double dspNs = StageNs(ingest, LatencyStage::Filter) + StageNs(ingest, LatencyStage::BandPower) + StageNs(ingest, LatencyStage::Metrics);
+            block.dspBusyFraction = seconds > 0.0 && dspNs >= device.lastDspNs ? (dspNs - device.lastDspNs) / (seconds * 1e9) : 0.0;
+            device.lastDspNs = dspNs;
+        }
+    }
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "IngestPipeline.h"
+#include "PacketTiming.h"
+#include "SharedMemory.h"
+#include "TimerWheel.h"
+
+#include <cstddef>
+
+namespace MuseWrapper
+{
+    constexpr int MetricsDeviceSlots = 8;
+    constexpr int MetricsPacketTypeSlots = 48;    // room for libmuse packet types added after PacketTypeCount
+
+    static_assert(PacketTypeCount <= MetricsPacketTypeSlots, "Metrics page has too few packet type slots");
+
+    /// <summary>
+    /// One headband's counters. Rates are per second over the last update interval; totals are since
+    /// the device was added.
+    /// </summary>
+    struct MetricsDeviceBlock
+    {
+        char name[64];                  // UTF-8, null-terminated; empty when the slot is unused
+        int32_t inUse;
+        int32_t connectionState;        // ConnectionState values
+        double rssi;                    // dBm, as reported by libmuse
+        uint64_t packetsTotal[MetricsPacketTypeSlots];
+        double packetsPerSecond[MetricsPacketTypeSlots];
+        uint64_t queueDepth;
+        uint64_t queueCapacity;
+        uint64_t queueDropped;
+        uint64_t droppedEegSamples;
+        uint64_t droppedAccelerometerSamples;
+        uint64_t missingSamples;
+        double dspBusyFraction;         // share of one core spent filtering, in band power and metrics
+        uint64_t filterP99Ns;
+        uint64_t bandPowerP99Ns;
+        uint64_t endToEndP99Ns;
+    };
+
+    /// <summary>
+    /// Layout of the shared metrics segment, for external monitors to map read-only. All fields are
+    /// little-endian and naturally aligned. 'sequence' is a seqlock: odd while the page is being
+    /// written, so a reader copies the page between two equal, even reads of it and retries
+    /// otherwise. Readers must check magic and version; fields are only ever appended within a
+    /// version, and pageBytes / deviceBlockBytes give the sizes the writer was built with.
+    /// </summary>
+    struct MetricsPageLayout
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t pageBytes;
+        uint32_t deviceBlockBytes;
+        uint32_t deviceSlots;
+        uint32_t packetTypeSlots;
+        std::atomic<uint64_t> sequence;
+        uint64_t updateCount;
+        uint64_t updatedUnixMs;
+        uint64_t intervalNs;
+        uint64_t processId;
+        uint64_t connectedDevices;
+
+        uint64_t hubCount;
+        uint64_t hubSubscribers;
+        uint64_t hubFramesPublished;
+        uint64_t hubFramesDropped;
+        uint64_t hubBytesSent;
+        double hubBytesPerSecond;
+        double hubBusyFraction;         // share of one core used by hub event loops
+
+        uint64_t recordingsOpen;
+        uint64_t recordingBacklogPackets;
+        uint64_t recordingPacketsWritten;
+        double recordingPacketsPerSecond;
+
+        uint64_t replaySessions;
+        uint64_t replayBlockHits;
+        uint64_t replayBlockMisses;
+
+        MetricsDeviceBlock devices[MetricsDeviceSlots];
+    };
+
+    static_assert(sizeof(MetricsDeviceBlock) % 8 == 0 && offsetof(MetricsPageLayout, devices) % 8 == 0,
+        "Metrics page fields must stay 8-byte aligned");
+
+    /// <summary>
+    /// Process-wide figures gathered for each update; filled by the owner of the handle tables
+    /// </summary>
+    struct ProcessMetrics
+    {
+        uint64_t hubCount;
+        uint64_t hubSubscribers;
+        uint64_t hubFramesPublished;
+        uint64_t hubFramesDropped;
+        uint64_t hubBytesSent;
+        uint64_t hubBusyNs;
+        uint64_t recordingsOpen;
+        uint64_t recordingBacklogPackets;
+        uint64_t recordingPacketsWritten;
+        uint64_t replaySessions;
+        uint64_t replayBlockHits;
+        uint64_t replayBlockMisses;
+    };
+
+    /// <summary>
+    /// Publishes MuseWrapper's counters into a named shared-memory segment (MetricsPageLayout) every
+    /// interval from a timer on the given wheel, so sidecar monitors can read them without locks,
+    /// syscalls or any call into the application.
+    /// </summary>
+    class MetricsPage
+    {
+    public:
+        static constexpr uint32_t Magic = 0x504D574D; // "MWMP"
+        static constexpr uint32_t Version = 1;
+
+        using Collector = std::function<void(ProcessMetrics&)>;
+
+        MetricsPage(const std::string& name, uint64_t intervalNs, Collector collector, TimerWheel& timers);
+        ~MetricsPage();
+
+        MetricsPage(const MetricsPage&) = delete;
+        MetricsPage& operator=(const MetricsPage&) = delete;
+
+        /// <summary>
+        /// Claims a device slot; ingest and timing may be null. Throws if every slot is taken.
+        /// </summary>
+        int AddDevice(const std::string& name, std::shared_ptr<IngestPipeline> ingest, std::shared_ptr<PacketTimingMonitor> timing);
+        void RemoveDevice(int slot);
+
+        /// <summary>
+        /// Connection state and RSSI come from libmuse on the managed side
+        /// </summary>
+        void SetDeviceStatus(int slot, int connectionState, double rssi);
+
+        /// <summary>
+        /// Publishes immediately instead of waiting for the next interval
+        /// </summary>
+        void Update();
+
+    private:
+        struct Device
+        {
+            bool inUse = false;
+            std::string name;
+            std::shared_ptr<IngestPipeline> ingest;
+            std::shared_ptr<PacketTimingMonitor> timing;
+            int connectionState = 0;
+            double rssi = 0.0;
+            std::array<uint64_t, MetricsPacketTypeSlots> lastPackets = {};
+            double lastDspNs = 0.0;
+        };
+
+        void Publish(uint64_t nowNs);
+        void FillDevice(Device& device, MetricsDeviceBlock& block, double seconds);
+
+        std::unique_ptr<SharedMemory> memory;
+        MetricsPageLayout* page;
+        uint64_t intervalNs;
+        Collector collector;
+
+        std::mutex lock;                // guards devices and publishing
+        std::array<Device, MetricsDeviceSlots> devices;
+        uint64_t lastPublishNs = 0;
+        ProcessMetrics lastProcess = {};
+
+        TimerWheel& timers;
+        uint64_t timer = 0;
+    };
+}
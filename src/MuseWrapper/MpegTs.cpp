@@ -0,0 +1,212 @@
+#include "pch.h"
+#include "MpegTs.h"
+
+namespace MuseWrapper
+{
+    namespace MpegTs
+    {
+        namespace
+        {
+            constexpr size_t WriteBufferPackets = 4096;
+
+            struct CrcTable
+            {
+                uint32_t entries[256];
+
+                CrcTable()
+                {
+                    for (uint32_t i = 0; i < 256; i++)
+                    {
+                        uint32_t crc = i << 24;
+                        for (int bit = 0; bit < 8; bit++)
+                        {
+                            crc = (crc & 0x80000000) != 0 ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+                        }
+                        entries[i] = crc;
+                    }
+                }
+            };
+
+            const CrcTable crcTable;
+        }
+
+        int PayloadOffset(const uint8_t* packet)
+        {
+            uint8_t control = (packet[3] >> 4) & 0x03;
+            if ((control & 0x01) == 0)
+            {
+                return -1;
+            }
+            int offset = 4;
+            if ((control & 0x02) != 0)
+            {
+                offset += 1 + packet[4];
+            }
+            return offset < PacketSize ? offset : -1;
+        }
+
+        bool ReadPesPts(const uint8_t* pes, int length, uint64_t& pts)
+        {
+            if (length < 14 || pes[0] != 0 || pes[1] != 0 || pes[2] != 1 || (pes[7] & 0x80) == 0)
+            {
+                return false;
+            }
+            const uint8_t* p = pes + 9;
+            pts = (static_cast<uint64_t>(p[0] & 0x0E) << 29)
+                | (static_cast<uint64_t>(p[1]) << 22)
+                | (static_cast<uint64_t>(p[2] & 0xFE) << 14)
+                | (static_cast<uint64_t>(p[3]) << 7)
+                | (static_cast<uint64_t>(p[4]) >> 1);
+            return true;
+        }
+
+        uint32_t Crc32(const uint8_t* data, size_t length)
+        {
+            uint32_t crc = 0xFFFFFFFF;
+            for (size_t i = 0; i < length; i++)
+            {
+                crc = (crc << 8) ^ crcTable.entries[((crc >> 24) ^ data[i]) & 0xFF];
+            }
+            return crc;
+        }
+
+        TsWriter::TsWriter(const std::string& path)
+            : buffer(WriteBufferPackets * PacketSize)
+        {
+            file = std::fopen(path.c_str(), "wb");
+            if (file == nullptr)
+            {
+                throw std::runtime_error("Cannot open " + path + " for writing");
+            }
+        }
+
+        TsWriter::~TsWriter()
+        {
+            if (file != nullptr)
+            {
+                try
+                {
+                    Flush();
+                }
+                catch (const std::exception&)
+                {
+                    // Also runs while unwinding from a failed remux; Close is where write errors are reported
+                }
+                std::fclose(file);
+            }
+        }
+
+        void TsWriter::Close()
+        {
+            if (file != nullptr)
+            {
+                Flush();
+                int result = std::fclose(file);
+                file = nullptr;
+                if (result != 0)
+                {
+                    throw std::runtime_error("Failed to close transport stream output");
+                }
+            }
+        }
+
+        void TsWriter::Flush()
+        {
+            if (used > 0 && std::fwrite(buffer.data(), 1, used, file) != used)
+            {
+                throw std::runtime_error("Failed to write transport stream output");
+            }
+            used = 0;
+        }
+
+        void TsWriter::WritePacket(const uint8_t* packet)
+        {
+            if (used == buffer.size())
+            {
+                Flush();
+            }
+            std::memcpy(buffer.data() + used, packet, PacketSize);
+            used += PacketSize;
+            bytesWritten += PacketSize;
+        }
+
+        void TsWriter::WriteSection(uint16_t pid, uint8_t& continuity, const uint8_t* section, size_t length)
+        {
+            uint8_t packet[PacketSize];
+            size_t written = 0;
+            bool first = true;
+            while (written < length || first)
+            {
+                packet[0] = SyncByte;
+                packet[1] = static_cast<uint8_t>((first ? 0x40 : 0x00) | (pid >> 8));
+                packet[2] = static_cast<uint8_t>(pid);
+                packet[3] = static_cast<uint8_t>(0x10 | (continuity++ & 0x0F));
+                size_t offset = 4;
+                if (first)
+                {
+                    packet[offset++] = 0; // pointer_field
+                }
+                size_t chunk = std::min(length - written, static_cast<size_t>(PacketSize) - offset);
+                std::memcpy(packet + offset, section + written, chunk);
+                std::memset(packet + offset + chunk, 0xFF, PacketSize - offset - chunk);
+                written += chunk;
+                first = false;
+                WritePacket(packet);
+            }
+        }
+
+        void TsWriter::WritePes(uint16_t pid, uint8_t& continuity, const uint8_t* pes, size_t length, const uint64_t* pcr)
+        {
+            uint8_t packet[PacketSize];
+            size_t written = 0;
+            bool first = true;
+            while (written < length)
+            {
+                packet[0] = SyncByte;
+                packet[1] = static_cast<uint8_t>((first ? 0x40 : 0x00) | (pid >> 8));
+                packet[2] = static_cast<uint8_t>(pid);
+
+                size_t adaptation = first && pcr != nullptr ? 8 : 0;
+                size_t remaining = length - written;
+                size_t capacity = PacketSize - 4 - adaptation;
+                if (remaining < capacity)
+                {
+                    // Stuff the adaptation field so the payload ends exactly at the packet boundary
+                    adaptation += capacity - remaining;
+                    capacity = remaining;
+                }
+
+                packet[3] = static_cast<uint8_t>((adaptation > 0 ? 0x30 : 0x10) | (continuity++ & 0x0F));
+                size_t offset = 4;
+                if (adaptation > 0)
+                {
+                    packet[4] = static_cast<uint8_t>(adaptation - 1);
+                    if (adaptation > 1)
+                    {
+                        bool withPcr = first && pcr != nullptr;
+                        packet[5] = withPcr ? 0x10 : 0x00;
+                        size_t fill = 6;
+                        if (withPcr)
+                        {
+                            uint64_t base = *pcr % PtsWrap;
+                            packet[6] = static_cast<uint8_t>(base >> 25);
+                            packet[7] = static_cast<uint8_t>(base >> 17);
+                            packet[8] = static_cast<uint8_t>(base >> 9);
+                            packet[9] = static_cast<uint8_t>(base >> 1);
+                            packet[10] = static_cast<uint8_t>(((base & 1) << 7) | 0x7E);
+                            packet[11] = 0;
+                            fill = 12;
+                        }
+                        std::memset(packet + fill, 0xFF, 4 + adaptation - fill);
+                    }
+                    offset += adaptation;
+                }
+
+                std::memcpy(packet + offset, pes + written, capacity);
+                written += capacity;
+                first = false;
+                WritePacket(packet);
+            }
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+namespace MuseWrapper
+{
+    namespace MpegTs
+    {
+        constexpr int PacketSize = 188;
+        constexpr uint8_t SyncByte = 0x47;
+        constexpr uint16_t PatPid = 0x0000;
+        constexpr uint16_t NullPid = 0x1FFF;
+        constexpr uint8_t StreamTypeMetadataPes = 0x15;
+        constexpr uint8_t PrivateStream1 = 0xBD;
+        constexpr uint64_t PtsClockHz = 90000;
+        constexpr uint64_t PtsWrap = 1ull << 33;
+
+        inline uint16_t Pid(const uint8_t* packet) { return static_cast<uint16_t>(((packet[1] & 0x1F) << 8) | packet[2]); }
+        inline bool PayloadUnitStart(const uint8_t* packet) { return (packet[1] & 0x40) != 0; }
+        inline uint8_t ContinuityCounter(const uint8_t* packet) { return packet[3] & 0x0F; }
+
+        /// <summary>
+        /// Offset of the payload within a packet, or -1 if the packet carries none
+        /// </summary>
+        int PayloadOffset(const uint8_t* packet);
+
+        /// <summary>
+        /// Extracts the PTS from the start of a PES packet
+        /// </summary>
+        bool ReadPesPts(const uint8_t* pes, int length, uint64_t& pts);
+
+        /// <summary>
+        /// CRC-32/MPEG-2 as used by PSI sections
+        /// </summary>
+        uint32_t Crc32(const uint8_t* data, size_t length);
+
+        /// <summary>
+        /// Buffered transport-stream file writer that splits sections and PES packets into 188-byte packets
+        /// </summary>
+        class TsWriter
+        {
+        public:
+            explicit TsWriter(const std::string& path);
+            ~TsWriter();
+
+            TsWriter(const TsWriter&) = delete;
+            TsWriter& operator=(const TsWriter&) = delete;
+
+            void WritePacket(const uint8_t* packet);
+
+            /// <summary>
+            /// Writes a PSI section (pointer field included) starting a new payload unit
+            /// </summary>
+            void WriteSection(uint16_t pid, uint8_t& continuity, const uint8_t* section, size_t length);
+
+            /// <summary>
+            /// Writes a PES packet, optionally carrying a PCR in the first packet's adaptation field
+            /// </summary>
+            void WritePes(uint16_t pid, uint8_t& continuity, const uint8_t* pes, size_t length, const uint64_t* pcr = nullptr);
+
+            /// <summary>
+            /// Flushes and closes the file, throwing if either fails; destruction without Close flushes
+            /// too but ignores errors
+            /// </summary>
+            void Close();
+            uint64_t BytesWritten() const { return bytesWritten; }
+
+        private:
+            void Flush();
+
+            std::FILE* file = nullptr;
+            std::vector<uint8_t> buffer;
+            size_t used = 0;
+            uint64_t bytesWritten = 0;
+        };
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+namespace MuseWrapper
+{
+    // Mirrors of the libmuse enums in Services/BCI/Muse/Core/Enums.cs; values must stay in sync
+
+    enum class ConnectionState : int
+    {
+        Unknown,
+        Connected,
+        Connecting,
+        Disconnected,
+        NeedsUpdate,
+        NeedsLicense,
+    };
+
+    enum class MuseDataPacketType : int
+    {
+        Accelerometer,
+        Gyro,
+        Eeg,
+        DroppedAccelerometer,
+        DroppedEeg,
+        Quantization,
+        Battery,
+        DrlRef,
+        AlphaAbsolute,
+        BetaAbsolute,
+        DeltaAbsolute,
+        ThetaAbsolute,
+        GammaAbsolute,
+        AlphaRelative,
+        BetaRelative,
+        DeltaRelative,
+        ThetaRelative,
+        GammaRelative,
+        AlphaScore,
+        BetaScore,
+        DeltaScore,
+        ThetaScore,
+        GammaScore,
+        IsGood,
+        Hsi,
+        HsiPrecision,
+        Artifacts,
+        Magnetometer,
+        Pressure,
+        Temperature,
+        UltraViolet,
+        NotchFilteredEeg,
+        VarianceEeg,
+        VarianceNotchFilteredEeg,
+        Ppg,
+        IsPpgGood,
+        IsHeartGood,
+        Thermistor,
+        IsThermistorGood,
+        AvgBodyTemperature,
+        CloudComputed,
+        Count,
+    };
+
+    constexpr int PacketTypeCount = static_cast<int>(MuseDataPacketType::Count);
+
+    /// <summary>
+    /// Largest value count libmuse delivers in one packet (EEG with auxiliary channels)
+    /// </summary>
+    constexpr int MaxPacketValues = 8;
+
+    /// <summary>
+    /// One libmuse data packet as delivered to IxRegisterDataListener callbacks
+    /// </summary>
+    struct MusePacket
+    {
+        MuseDataPacketType type;
+        int valueCount;
+        int64_t timestampUs;
+        double values[MaxPacketValues];
+    };
+}
@@ -0,0 +1,381 @@
+// MuseWrapper.h : Exported C API of the MuseWrapper native library.
+//
+// Every entry point follows the libmuse Ix* convention used by Native.cs: the
+// return value is MW_OK (0) on success or a negative MW_* status on failure, in
+// which case a null-terminated message is written to errorOut (at most errorLen
+// bytes). Objects are referenced by integer handles, like libmuse readers and writers.
+// errorOut may be null: the status and message of each thread's latest failure are
+// also kept per thread and read back with MwGetLastError, so concurrent callers need
+// no shared error buffer.
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(MUSEWRAPPER_STATIC)
+#define MUSEWRAPPER_API
+#elif defined(_WIN32)
+#ifdef MUSEWRAPPER_EXPORTS
+#define MUSEWRAPPER_API __declspec(dllexport)
+#else
+#define MUSEWRAPPER_API __declspec(dllimport)
+#endif
+#else
+#define MUSEWRAPPER_API __attribute__((visibility("default")))
+#endif
+
+#define MW_OK                    0
+#define MW_FAILURE              -1
+#define MW_INVALID_HANDLE       -2
+#define MW_INVALID_ARGUMENT     -3
+#define MW_NO_DATA              -4
+#define MW_QUEUE_FULL           -5
+
+#define MW_CHART_LTTB            0
+#define MW_CHART_MINMAX          1
+
+#define MW_BANDS_EEG             0
+#define MW_BANDS_LIBMUSE         1
+
+#define MW_PRECISION_DOUBLE      0
+#define MW_PRECISION_FLOAT       1
+
+#define MW_PACKET_ANY           -1
+
+#define MW_THREAD_BUFFER_STRING  0
+#define MW_THREAD_BUFFER_ERROR   1
+#define MW_THREAD_BUFFER_COUNT   2
+
+#define MW_PRIORITY_NORMAL       0
+#define MW_PRIORITY_HIGH         1      // nice -10 on Linux, THREAD_PRIORITY_HIGHEST on Windows
+#define MW_PRIORITY_REALTIME     2      // SCHED_FIFO on Linux, MMCSS "Pro Audio" on Windows
+
+#define MW_OVERFLOW_BLOCK        0      // the producer waits for room
+#define MW_OVERFLOW_DROP_OLDEST  1
+#define MW_OVERFLOW_DROP_NEWEST  2
+#define MW_OVERFLOW_LATEST_ONLY  3      // only the newest item (per packet type for ingest) waits
+
+#define MW_HUB_QUEUE_PUBLISH     0
+#define MW_HUB_QUEUE_SUBSCRIBER  1
+
+#define MW_CONNECT_IDLE          0
+#define MW_CONNECT_DISCONNECTING 1
+#define MW_CONNECT_CONNECTING    2
+#define MW_CONNECT_CONFIGURING   3
+#define MW_CONNECT_READY         4
+#define MW_CONNECT_FAILED        5
+#define MW_CONNECT_LOST          6
+
+#define MW_HISTORY_EEG           0
+#define MW_HISTORY_BANDS         1
+
+#define MW_TRACE_CHROME_JSON     0
+#define MW_TRACE_PERFETTO        1
+
+// Latency stages of the ingest pipeline (see IngestPipeline.h for the exact span of each)
+#define MW_STAGE_TRANSPORT       0
+#define MW_STAGE_CALLBACK        1
+#define MW_STAGE_QUEUE           2
+#define MW_STAGE_FILTER          3
+#define MW_STAGE_BAND_POWER      4
+#define MW_STAGE_METRICS         5
+#define MW_STAGE_PUBLISH         6
+#define MW_STAGE_OVERLAY_ACK     7
+#define MW_STAGE_RENDER          8
+#define MW_STAGE_NATIVE          9
+#define MW_STAGE_END_TO_END     10
+#define MW_STAGE_COUNT          11
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    typedef struct MwHubStats
+    {
+        int64_t framesPublished;
+        int64_t framesDelivered;
+        int64_t framesDropped;
+        int64_t bytesSent;
+        int64_t loopBusyNs;
+        int32_t subscribers;
+    } MwHubStats;
+
+    // What one bounded queue did with the items offered to it; dropped items are split by cause
+    typedef struct MwQueueStats
+    {
+        int64_t accepted;
+        int64_t droppedNewest;      // refused on arrival
+        int64_t droppedOldest;      // evicted to make room
+        int64_t coalesced;          // replaced by a newer item before being taken
+        int64_t blockedNs;          // producers' total wait for room
+        int32_t depth;
+        int32_t capacity;
+        int32_t policy;             // MW_OVERFLOW_*
+    } MwQueueStats;
+
+    typedef struct MwPacket
+    {
+        int32_t packetType;
+        int32_t valueCount;
+        int64_t timestampUs;
+        double values[8];
+    } MwPacket;
+
+    typedef struct MwReplayStats
+    {
+        int64_t blockHits;
+        int64_t blockMisses;
+        int64_t blocksPrefetched;
+        int32_t sessions;
+        int32_t recordings;
+    } MwReplayStats;
+
+    typedef struct MwChartPoint
+    {
+        int64_t positionUs;
+        double value;
+    } MwChartPoint;
+
+    typedef struct MwLatencyStats
+    {
+        int64_t count;
+        int64_t minNs;
+        int64_t maxNs;
+        double meanNs;
+        int64_t p50Ns;
+        int64_t p90Ns;
+        int64_t p99Ns;
+        int64_t p999Ns;
+    } MwLatencyStats;
+
+    typedef struct MwIngestStats
+    {
+        int64_t packetsIngested;
+        int64_t packetsDropped;
+        int64_t metricsPublished;
+        int64_t acksReceived;
+        int64_t arenaBytesReserved;     // session arena chunks taken from the heap
+        int64_t arenaBytesInUse;
+        int64_t arenaPeakBytesInUse;
+    } MwIngestStats;
+
+    // Called on the pipeline worker with each dequeued packet; values are only valid during the call
+    typedef void (*MwPacketListener)(int packetType, int64_t timestampUs, const double* values, int numValues, void* context);
+
+    // Called on the timer thread; must return quickly
+    typedef void (*MwTimerCallback)(int64_t timer, void* context);
+
+    typedef struct MwTimerStats
+    {
+        int64_t active;
+        int64_t fired;
+        int64_t wakeups;                // times the timer thread woke up
+        int64_t cascaded;               // timers moved down a wheel level
+    } MwTimerStats;
+
+    // Called on the timer thread at each phase change (MW_CONNECT_*); message is only valid during the call
+    typedef void (*MwConnectCallback)(int connection, int phase, const char* message, void* context);
+
+    typedef struct MwConnectOptions
+    {
+        int32_t preset;                 // libmuse preset, 21 for PRESET_21
+        int32_t attempts;               // connection attempts before failing
+        int32_t attemptTimeoutMs;       // wait for Connected after each attempt
+        int32_t backoffMs;              // pause after a failed attempt, doubled each time
+        int32_t maxBackoffMs;
+        int32_t disconnectTimeoutMs;    // wait for Disconnected when dropping a stale link
+        int32_t configurationReads;     // IxGetMuseConfiguration attempts once connected
+        int32_t configurationRetryMs;
+    } MwConnectOptions;
+
+    typedef struct MwConnectStatus
+    {
+        int64_t connectedNs;            // from start to Connected, 0 until then
+        int64_t readyNs;                // from start to MW_CONNECT_READY, 0 until then
+        int32_t phase;
+        int32_t connectionState;        // libmuse ConnectionState
+        int32_t attempts;
+        int32_t configurationReads;
+    } MwConnectStatus;
+
+    typedef struct MwPoolStats
+    {
+        int64_t batches;                // pipeline drains run
+        int64_t steals;                 // drains run away from the pipeline's home worker
+        int32_t workers;
+        int32_t clients;                // attached pipelines
+    } MwPoolStats;
+
+    typedef struct MwPacketTimingStats
+    {
+        int64_t intervalNs;
+        double nominalRate;
+        int64_t packets;
+        int64_t missingSamples;
+        int64_t droppedSamples;
+        int64_t outOfOrder;
+        int64_t totalPackets;
+        int64_t totalMissingSamples;
+        int64_t totalDroppedSamples;
+        MwLatencyStats interArrival;
+        MwLatencyStats timestampJitter;
+    } MwPacketTimingStats;
+
+    typedef struct MwAllocationStats
+    {
+        int64_t allocations;
+        int64_t frees;
+        int64_t bytesAllocated;
+        int64_t liveBytes;
+        int64_t peakBytes;
+        int64_t poolAllocations;
+        int64_t poolBytesAllocated;
+        int64_t poolLiveBytes;
+        int64_t elapsedNs;
+    } MwAllocationStats;
+
+    typedef struct MwAllocationStageStats
+    {
+        int64_t allocations;
+        int64_t bytes;
+        int64_t poolAllocations;
+        int64_t poolBytes;
+    } MwAllocationStageStats;
+
+    // per-thread error state and scratch buffers: MwGetLastError returns the status of the calling thread's latest
+    // failed call (MW_OK if none) and copies its message; a thread buffer is native memory owned by the calling thread,
+    // valid until it asks for a larger one of the same kind or exits, for passing to calls that write strings
+    MUSEWRAPPER_API int MwGetLastError(char* messageOut, int messageLen);
+    MUSEWRAPPER_API int MwGetThreadBuffer(int buffer, int minLength, char** bufferOut, int* lengthOut, char* errorOut, int errorLen);
+
+    // overlay renderer
+    MUSEWRAPPER_API int MwOverlayCreate(const char* ringName, int width, int height, int slotCount, int* handleOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwOverlayDestroy(int handle, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwOverlaySetMetrics(int handle, double focus, const double* bands, int bandCount, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwOverlayShowEvent(int handle, const char* text, int durationMs, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwOverlayRenderFrame(int handle, int* publishedOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwOverlayGetLatency(int handle, MwLatencyStats* statsOut, char* errorOut, int errorLen);
+
+    // overlay frame ring (consumer side)
+    MUSEWRAPPER_API int MwFrameRingOpen(const char* ringName, int* handleOut, int* widthOut, int* heightOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwFrameRingClose(int handle, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwFrameRingReadLatest(int handle, uint8_t* pixelsOut, int pixelsLen, int64_t* sequenceOut, int64_t* timestampOut, char* errorOut, int errorLen);
+
+    // timed-metadata muxer
+    MUSEWRAPPER_API int MwTsMuxerCreate(const char* outputPath, const char* inputPath, int64_t syncTimestampUs, int* handleOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwTsMuxerAddPacket(int handle, int packetType, int64_t timestampUs, const double* values, int numValues, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwTsMuxerClose(int handle, int64_t* packetsWrittenOut, char* errorOut, int errorLen);
+
+    // spectator broadcast hub
+    MUSEWRAPPER_API int MwHubCreate(int tcpPort, int webSocketPort, int loopbackOnly, int maxQueuedFrames, int* handleOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwHubDestroy(int handle, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwHubGetPorts(int handle, int* tcpPortOut, int* webSocketPortOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwHubPublish(int handle, const uint8_t* data, int length, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwHubGetStats(int handle, MwHubStats* statsOut, char* errorOut, int errorLen);
+    // overflow policy (MW_OVERFLOW_*) of one hub queue (MW_HUB_QUEUE_*); subscriber queues cannot block the hub thread
+    MUSEWRAPPER_API int MwHubSetOverflowPolicy(int handle, int queue, int policy, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwHubGetQueueStats(int handle, int queue, MwQueueStats* statsOut, char* errorOut, int errorLen);
+
+    // session recording
+    MUSEWRAPPER_API int MwRecordingCreate(const char* path, int64_t syncTimestampUs, int* handleOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwRecordingAddPacket(int handle, int packetType, int64_t timestampUs, const double* values, int numValues, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwRecordingClose(int handle, int64_t* packetsWrittenOut, char* errorOut, int errorLen);
+
+    // VOD replay
+    MUSEWRAPPER_API int MwReplayOpen(const char* recordingPath, int* handleOut, int64_t* durationUsOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwReplayClose(int handle, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwReplaySetPlayback(int handle, int64_t positionUs, double rate, int paused, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwReplayRead(int handle, MwPacket* packetsOut, int maxPackets, int* countOut, int64_t* positionUsOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwReplayGetStats(MwReplayStats* statsOut, char* errorOut, int errorLen);
+
+    // chart downsampling (positions are relative to the recording's sync timestamp, as for replay)
+    MUSEWRAPPER_API int MwChartOpen(const char* recordingPath, int* handleOut, int64_t* durationUsOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwChartClose(int handle, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwChartQuery(int handle, int packetType, int channel, int64_t fromUs, int64_t toUs, int width, int mode, MwChartPoint* pointsOut, int maxPoints, int* countOut, char* errorOut, int errorLen);
+
+    // ingest pipeline and latency tracing (timestamps are MwClockNanoseconds values)
+    MUSEWRAPPER_API int MwClockNanoseconds(int64_t* nowOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwIngestCreate(int eegChannels, double eegSampleRate, double notchFrequency, int bandSource, int* handleOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwIngestCreateWithPrecision(int eegChannels, double eegSampleRate, double notchFrequency, int bandSource, int precision, int* handleOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwIngestDestroy(int handle, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwIngestAttachOverlay(int handle, int overlayHandle, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwIngestAttachHub(int handle, int hubHandle, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwIngestAttachPool(int handle, int poolHandle, char* errorOut, int errorLen);
+    // priority (MW_PRIORITY_*) and CPUs of the pipeline's own worker thread, which drains pushed packets and runs the first
+    // processing stages; a priority the process may not use falls back a level and appliedPriorityOut reports what took effect
+    MUSEWRAPPER_API int MwIngestSetThreadScheduling(int handle, int priority, const int* cpus, int cpuCount, int* appliedPriorityOut, char* errorOut, int errorLen);
+    // what MwIngestPushPacket does while the queue is full (MW_OVERFLOW_*, MW_OVERFLOW_DROP_NEWEST by default);
+    // a refused packet returns MW_QUEUE_FULL and MW_OVERFLOW_BLOCK makes the caller wait for the worker
+    MUSEWRAPPER_API int MwIngestSetOverflowPolicy(int handle, int policy, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwIngestGetQueueStats(int handle, MwQueueStats* statsOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwIngestPushPacket(int handle, int packetType, int64_t timestampUs, const double* values, int numValues, int64_t callbackNs, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwIngestGetMetrics(int handle, double* focusOut, double* bandsOut, int bandCount, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwIngestCopyHistory(int handle, int series, int channel, double* valuesOut, int count, int* copiedOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwIngestGetLatency(int handle, int stage, MwLatencyStats* statsOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwIngestResetLatency(int handle, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwIngestGetStats(int handle, MwIngestStats* statsOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwIngestAttachTiming(int handle, int timingHandle, char* errorOut, int errorLen);
+    // packet listeners (packetType MW_PACKET_ANY for all); remove waits for a call in progress and cannot be called from a listener
+    MUSEWRAPPER_API int MwIngestAddListener(int handle, int packetType, MwPacketListener listener, void* context, int* listenerIdOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwIngestRemoveListener(int handle, int listenerId, char* errorOut, int errorLen);
+
+    // shared DSP worker pool: pipelines attached with MwIngestAttachPool are drained here instead of on a thread each
+    // (workers 0 = one fewer than the hardware threads; worker i is pinned to cpus[i % cpuCount] when cpuCount > 0)
+    MUSEWRAPPER_API int MwPoolCreate(int workers, const int* cpus, int cpuCount, int* handleOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwPoolDestroy(int handle, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwPoolGetStats(int handle, MwPoolStats* statsOut, char* errorOut, int errorLen);
+
+    // timers on one shared native wheel (1 ms resolution; periodMs 0 for one-shot); cancel waits for a running
+    // callback unless called from one, and reschedule moves the next deadline, e.g. for reconnect backoff
+    MUSEWRAPPER_API int MwTimerStart(int delayMs, int periodMs, MwTimerCallback callback, void* context, int64_t* timerOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwTimerReschedule(int64_t timer, int delayMs, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwTimerCancel(int64_t timer, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwTimerGetStats(MwTimerStats* statsOut, char* errorOut, int errorLen);
+
+    // native connection state machine: disconnect if needed, preset, data enable, connect and read the configuration
+    // with bounded retries, resuming on libmuse connection events and timer-wheel timeouts instead of polling.
+    // libmuse is loaded at run time (path null for Libmuse.dll / libLibmuse.so); options null for the defaults.
+    // Destroying a connection stops it without disconnecting the headband.
+    MUSEWRAPPER_API int MwLibmuseLoad(const char* path, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwConnectGetDefaultOptions(MwConnectOptions* optionsOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwConnectStart(const char* macAddress, const MwConnectOptions* options, MwConnectCallback callback, void* context, int* handleOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwConnectDestroy(int handle, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwConnectGetStatus(int handle, MwConnectStatus* statusOut, char* errorOut, int errorLen);
+    // lengthOut receives the buffer size the JSON needs; MW_NO_DATA until the configuration has been read
+    MUSEWRAPPER_API int MwConnectGetConfiguration(int handle, char* jsonOut, int jsonLen, int* lengthOut, char* errorOut, int errorLen);
+
+    // packet timing: per-device inter-arrival, timestamp jitter and dropped data over rotating intervals
+    MUSEWRAPPER_API int MwTimingCreate(int intervalMs, int* handleOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwTimingDestroy(int handle, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwTimingSetNominalRate(int handle, int packetType, double rateHz, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwTimingRecordPacket(int handle, int packetType, int64_t timestampUs, const double* values, int numValues, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwTimingRotate(int handle, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwTimingGetStats(int handle, int packetType, MwPacketTimingStats* statsOut, char* errorOut, int errorLen);
+
+    // activity tracing (only recorded in builds with MUSEWRAPPER_TRACING defined)
+    MUSEWRAPPER_API int MwTraceStart(int bufferMegabytesPerThread, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwTraceStop(char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwTraceWrite(const char* path, int format, char* errorOut, int errorLen);
+
+    // shared-memory metrics page for external monitors (layout in MetricsPage.h)
+    MUSEWRAPPER_API int MwMetricsCreate(const char* segmentName, int intervalMs, int* handleOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwMetricsDestroy(int handle, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwMetricsAddDevice(int handle, const char* deviceName, int ingestHandle, int timingHandle, int* slotOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwMetricsRemoveDevice(int handle, int slot, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwMetricsSetDeviceStatus(int handle, int slot, int connectionState, double rssi, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwMetricsUpdate(int handle, char* errorOut, int errorLen);
+
+    // allocation tracking (only counted in builds with MUSEWRAPPER_ALLOCATION_TRACKING defined)
+    MUSEWRAPPER_API int MwAllocationReset(int captureCallSites, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwAllocationGetStats(MwAllocationStats* statsOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwAllocationGetStage(int index, char* nameOut, int nameLen, MwAllocationStageStats* statsOut, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwAllocationWriteReport(const char* path, int callSites, char* errorOut, int errorLen);
+
+    // sampling profiler of MuseWrapper's threads, written as folded stacks for flame graphs
+    MUSEWRAPPER_API int MwProfilerStart(int frequencyHz, char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwProfilerStop(char* errorOut, int errorLen);
+    MUSEWRAPPER_API int MwProfilerWrite(const char* path, int reset, int64_t* samplesOut, char* errorOut, int errorLen);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,139 @@
+// OverlayApi.cpp : Exported entry points for the native overlay renderer and its frame ring.
+#include "pch.h"
+#include "ApiHandles.h"
+#include "ApiSupport.h"
+#include "OverlaySource.h"
+
+using namespace MuseWrapper;
+
+namespace
+{
+    constexpr int MaxOverlayDimension = 4096;
+
+    HandleTable<OverlaySource> overlays;
+    HandleTable<SharedFrameRing> frameRings;
+}
+
+HandleTable<OverlaySource>& MuseWrapper::OverlayHandles()
+{
+    return overlays;
+}
+
+int MwOverlayCreate(const char* ringName, int width, int height, int slotCount, int* handleOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(ringName != nullptr && handleOut != nullptr, "ringName and handleOut are required");
+        Require(width > 0 && height > 0 && width <= MaxOverlayDimension && height <= MaxOverlayDimension, "Overlay size is out of range");
+        *handleOut = overlays.Add(std::make_shared<OverlaySource>(ringName, width, height, std::max(slotCount, 2)));
+        return MW_OK;
+    });
+}
+
+int MwOverlayDestroy(int handle, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        overlays.Remove(handle);
+        return MW_OK;
+    });
+}
+
+int MwOverlaySetMetrics(int handle, double focus, const double* bands, int bandCount, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(bands != nullptr || bandCount == 0, "bands is required when bandCount > 0");
+        float values[BandCount] = {};
+        for (int i = 0; i < std::min(bandCount, BandCount); i++)
+        {
+            values[i] = static_cast<float>(bands[i]);
+        }
+        overlays.Get(handle)->SetMetrics(static_cast<float>(focus), values, BandCount);
+        return MW_OK;
+    });
+}
+
+int MwOverlayShowEvent(int handle, const char* text, int durationMs, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(text != nullptr && durationMs > 0, "text and a positive duration are required");
+        overlays.Get(handle)->ShowEvent(text, static_cast<uint64_t>(durationMs) * 1'000'000);
+        return MW_OK;
+    });
+}
+
+int MwOverlayRenderFrame(int handle, int* publishedOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        bool published = overlays.Get(handle)->RenderFrame();
+        if (publishedOut != nullptr)
+        {
+            *publishedOut = published ? 1 : 0;
+        }
+        return MW_OK;
+    });
+}
+
+int MwOverlayGetLatency(int handle, MwLatencyStats* statsOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(statsOut != nullptr, "statsOut is required");
+        CopyLatency(overlays.Get(handle)->FrameLatency(), statsOut);
+        return MW_OK;
+    });
+}
+
+int MwFrameRingOpen(const char* ringName, int* handleOut, int* widthOut, int* heightOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(ringName != nullptr && handleOut != nullptr, "ringName and handleOut are required");
+        std::shared_ptr<SharedFrameRing> ring = SharedFrameRing::Open(ringName);
+        if (widthOut != nullptr)
+        {
+            *widthOut = ring->Width();
+        }
+        if (heightOut != nullptr)
+        {
+            *heightOut = ring->Height();
+        }
+        *handleOut = frameRings.Add(std::move(ring));
+        return MW_OK;
+    });
+}
+
+int MwFrameRingClose(int handle, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        frameRings.Remove(handle);
+        return MW_OK;
+    });
+}
+
+int MwFrameRingReadLatest(int handle, uint8_t* pixelsOut, int pixelsLen, int64_t* sequenceOut, int64_t* timestampOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(pixelsOut != nullptr && pixelsLen > 0, "pixelsOut is required");
+        uint64_t sequence = 0;
+        uint64_t timestamp = 0;
+        if (!frameRings.Get(handle)->ReadLatest(pixelsOut, static_cast<size_t>(pixelsLen), sequence, timestamp))
+        {
+            return MW_NO_DATA;
+        }
+        if (sequenceOut != nullptr)
+        {
+            *sequenceOut = static_cast<int64_t>(sequence);
+        }
+        if (timestampOut != nullptr)
+        {
+            *timestampOut = static_cast<int64_t>(timestamp);
+        }
+        return MW_OK;
+    });
+}
@@ -0,0 +1,154 @@
+#include "pch.h"
+#include "OverlayRenderer.h"
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        // Palette matches the HTML overlay produced by BrainDataVisualisationService
+        constexpr Color PanelColor = Color::Rgb(0x1E1E1E, 200);
+        constexpr Color TextColor = Color::Rgb(0xFFFFFF);
+        constexpr Color MutedTextColor = Color::Rgb(0xAAAAAA);
+        constexpr Color TrackColor = Color::Rgb(0x444444);
+        constexpr Color FocusColor = Color::Rgb(0x92D36E);
+        constexpr Color BannerColor = Color::Rgb(0xE5A23C, 230);
+        constexpr Color Transparent = Color{ 0, 0, 0, 0 };
+
+        constexpr uint64_t BannerFadeNs = 500'000'000;
+
+        const char* const BandLabels[BandCount] = { "ALPHA", "BETA", "DELTA", "THETA", "GAMMA" };
+        constexpr Color BandColors[BandCount] =
+        {
+            Color::Rgb(0x6EA8D3), Color::Rgb(0x92D36E), Color::Rgb(0xB36ED3), Color::Rgb(0xD3B36E), Color::Rgb(0xD36E6E),
+        };
+    }
+
+    OverlayRenderer::OverlayRenderer(int width, int height)
+        : width(width),
+          height(height),
+          padding(std::max(4, height / 40)),
+          titleFont(std::max(2, height / 120)),
+          labelFont(std::max(1, height / 200))
+    {
+    }
+
+    void OverlayRenderer::SetMetrics(float focus, const float* bands, int bandCount)
+    {
+        this->focus = std::clamp(focus, 0.0f, 1.0f);
+        for (int i = 0; i < BandCount; i++)
+        {
+            this->bands[i] = i < bandCount ? std::clamp(bands[i], 0.0f, 1.0f) : 0.0f;
+            bandHistory[i][historyHead] = this->bands[i];
+        }
+        focusHistory[historyHead] = this->focus;
+        historyHead = (historyHead + 1) % HistoryLength;
+        historyCount = std::min(historyCount + 1, HistoryLength);
+        dirty = true;
+    }
+
+    void OverlayRenderer::ShowEvent(const std::string& text, uint64_t durationNs, uint64_t nowNs)
+    {
+        eventText = text;
+        eventEndNs = nowNs + durationNs;
+        eventVisible = true;
+        dirty = true;
+    }
+
+    bool OverlayRenderer::IsDirty(uint64_t nowNs) const
+    {
+        // The banner needs frames while fading and one more once it has gone
+        return dirty || (eventVisible && nowNs + BannerFadeNs >= eventEndNs);
+    }
+
+    void OverlayRenderer::CopyHistory(const std::array<float, HistoryLength>& source, float* ordered) const
+    {
+        int start = (historyHead - historyCount + HistoryLength) % HistoryLength;
+        for (int i = 0; i < historyCount; i++)
+        {
+            ordered[i] = source[(start + i) % HistoryLength];
+        }
+    }
+
+    void OverlayRenderer::Render(FrameBuffer& target, uint64_t nowNs)
+    {
+        char text[32];
+        int innerWidth = width - 2 * padding;
+
+        target.Clear(Transparent);
+        target.FillRect(Rect{ 0, 0, width, height }, PanelColor);
+
+        int y = padding;
+        titleFont.DrawText(target, padding, y, "BRAIN DATA", TextColor);
+        y += titleFont.LineHeight() + padding;
+
+        // Focus meter
+        snprintf(text, sizeof(text), "%d%%", static_cast<int>(focus * 100.0f));
+        labelFont.DrawText(target, padding, y, "FOCUS", MutedTextColor);
+        titleFont.DrawText(target, width - padding - titleFont.MeasureText(text), y, text, FocusColor);
+        y += titleFont.LineHeight();
+        int meterHeight = std::max(4, labelFont.LineHeight());
+        target.FillRect(Rect{ padding, y, innerWidth, meterHeight }, TrackColor);
+        target.FillRect(Rect{ padding, y, static_cast<int>(innerWidth * focus), meterHeight }, FocusColor);
+        y += meterHeight + padding;
+
+        // Band bars
+        int labelWidth = labelFont.MeasureText("GAMMA") + padding;
+        int barHeight = std::max(3, labelFont.TextHeight());
+        for (int i = 0; i < BandCount; i++)
+        {
+            labelFont.DrawText(target, padding, y, BandLabels[i], MutedTextColor);
+            int barWidth = innerWidth - labelWidth;
+            target.FillRect(Rect{ padding + labelWidth, y, barWidth, barHeight }, TrackColor);
+            target.FillRect(Rect{ padding + labelWidth, y, static_cast<int>(barWidth * bands[i]), barHeight }, BandColors[i]);
+            y += labelFont.LineHeight() + padding / 2;
+        }
+        y += padding / 2;
+
+        // Sparklines share the remaining space above the banner strip
+        int bannerHeight = labelFont.LineHeight() + padding;
+        Rect chart{ padding, y, innerWidth, height - y - bannerHeight - 2 * padding };
+        if (chart.h > 8 && historyCount >= 2)
+        {
+            float ordered[HistoryLength];
+            for (int i : { static_cast<int>(Band::Alpha), static_cast<int>(Band::Beta) })
+            {
+                CopyHistory(bandHistory[i], ordered);
+                Color faded = BandColors[i];
+                faded.a = 140;
+                target.DrawSparkline(chart, ordered, historyCount, 0.0f, 1.0f, faded);
+            }
+            CopyHistory(focusHistory, ordered);
+            target.DrawSparkline(chart, ordered, historyCount, 0.0f, 1.0f, FocusColor);
+        }
+
+        DrawEventBanner(target, nowNs);
+        dirty = false;
+    }
+
+    void OverlayRenderer::DrawEventBanner(FrameBuffer& target, uint64_t nowNs)
+    {
+        if (!eventVisible)
+        {
+            return;
+        }
+        if (nowNs >= eventEndNs)
+        {
+            eventVisible = false;
+            return;
+        }
+
+        Color background = BannerColor;
+        Color foreground = Color::Rgb(0x000000);
+        uint64_t remaining = eventEndNs - nowNs;
+        if (remaining < BannerFadeNs)
+        {
+            background.a = static_cast<uint8_t>(background.a * remaining / BannerFadeNs);
+            foreground.a = static_cast<uint8_t>(255 * remaining / BannerFadeNs);
+        }
+
+        int bannerHeight = labelFont.LineHeight() + padding;
+        int top = height - bannerHeight - padding;
+        target.FillRect(Rect{ padding, top, width - 2 * padding, bannerHeight }, background);
+        labelFont.DrawText(target, 2 * padding, top + (bannerHeight - labelFont.TextHeight()) / 2, eventText.c_str(), foreground);
+    }
+}
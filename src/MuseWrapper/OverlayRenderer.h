@@ -0,0 +1,75 @@
+#pragma once
+
+#include "FrameBuffer.h"
+#include "GlyphAtlas.h"
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Frequency bands in the same order as BrainWaveTypes on the managed side
+    /// </summary>
+    enum class Band : int
+    {
+        Alpha,
+        Beta,
+        Delta,
+        Theta,
+        Gamma,
+        Count,
+    };
+
+    constexpr int BandCount = static_cast<int>(Band::Count);
+
+    /// <summary>
+    /// Rasterises the brain-data metrics panel (focus meter, band bars, sparklines, event banner)
+    /// </summary>
+    class OverlayRenderer
+    {
+    public:
+        static constexpr int HistoryLength = 120;
+
+        OverlayRenderer(int width, int height);
+
+        /// <summary>
+        /// Records the latest focus (0-1) and relative band powers (0-1) and appends them to the sparkline history
+        /// </summary>
+        void SetMetrics(float focus, const float* bands, int bandCount);
+
+        /// <summary>
+        /// Shows a banner (e.g. "Significant focus increase") until the duration elapses
+        /// </summary>
+        void ShowEvent(const std::string& text, uint64_t durationNs, uint64_t nowNs);
+
+        /// <summary>
+        /// True when the next frame would differ from the last one rendered
+        /// </summary>
+        bool IsDirty(uint64_t nowNs) const;
+
+        void Render(FrameBuffer& target, uint64_t nowNs);
+
+        int Width() const { return width; }
+        int Height() const { return height; }
+
+    private:
+        void CopyHistory(const std::array<float, HistoryLength>& source, float* ordered) const;
+        void DrawEventBanner(FrameBuffer& target, uint64_t nowNs);
+
+        int width;
+        int height;
+        int padding;
+        GlyphAtlas titleFont;
+        GlyphAtlas labelFont;
+
+        float focus = 0.0f;
+        std::array<float, BandCount> bands = {};
+        std::array<float, HistoryLength> focusHistory = {};
+        std::array<std::array<float, HistoryLength>, BandCount> bandHistory = {};
+        int historyHead = 0;
+        int historyCount = 0;
+
+        std::string eventText;
+        uint64_t eventEndNs = 0;
+        bool eventVisible = false;
+        bool dirty = true;
+    };
+}
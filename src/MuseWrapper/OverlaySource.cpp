@@ -0,0 +1,53 @@
+#include "pch.h"
+#include "OverlaySource.h"
+#include "AllocationTracking.h"
+#include "Clock.h"
+#include "Tracing.h"
+
+namespace MuseWrapper
+{
+    OverlaySource::OverlaySource(const std::string& ringName, int width, int height, int slotCount)
+        : renderer(width, height),
+          ring(SharedFrameRing::Create(ringName, width, height, slotCount))
+    {
+    }
+
+    void OverlaySource::SetMetrics(float focus, const float* bands, int bandCount, uint64_t ingestNs)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        renderer.SetMetrics(focus, bands, bandCount);
+        if (pendingIngestNs == 0)
+        {
+            pendingIngestNs = ingestNs;
+        }
+    }
+
+    void OverlaySource::ShowEvent(const std::string& text, uint64_t durationNs)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        renderer.ShowEvent(text, durationNs, MonotonicNanoseconds());
+    }
+
+    bool OverlaySource::RenderFrame()
+    {
+        MW_TRACE_SCOPE("overlay.render");
+        MW_ALLOCATION_STAGE("overlay.render");
+        std::lock_guard<std::mutex> guard(lock);
+        uint64_t now = MonotonicNanoseconds();
+        if (!renderer.IsDirty(now))
+        {
+            return false;
+        }
+
+        FrameBuffer target = ring->BeginWrite();
+        renderer.Render(target, now);
+        ring->EndWrite(now);
+        if (pendingIngestNs != 0)
+        {
+            uint64_t publishedNs = MonotonicNanoseconds();
+            frameLatency.Record(publishedNs > pendingIngestNs ? publishedNs - pendingIngestNs : 0);
+            pendingIngestNs = 0;
+        }
+        return true;
+    }
+}
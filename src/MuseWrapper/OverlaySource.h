@@ -0,0 +1,39 @@
+#pragma once
+
+#include "LatencyHistogram.h"
+#include "OverlayRenderer.h"
+#include "SharedFrameRing.h"
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Native replacement for the OBS browser source: renders the metrics panel and publishes
+    /// frames into a named shared-memory ring for a capture plugin or local consumer
+    /// </summary>
+    class OverlaySource
+    {
+    public:
+        OverlaySource(const std::string& ringName, int width, int height, int slotCount);
+
+        /// <summary>
+        /// ingestNs, when non-zero, is the pipeline ingest stamp of the packet behind these metrics;
+        /// the next published frame records ingest-to-frame latency for the oldest pending stamp
+        /// </summary>
+        void SetMetrics(float focus, const float* bands, int bandCount, uint64_t ingestNs = 0);
+        void ShowEvent(const std::string& text, uint64_t durationNs);
+
+        /// <summary>
+        /// Renders and publishes a frame if anything changed since the last one; returns whether a frame was published
+        /// </summary>
+        bool RenderFrame();
+
+        LatencySummary FrameLatency() const { return frameLatency.Summarise(); }
+
+    private:
+        std::mutex lock;
+        OverlayRenderer renderer;
+        std::unique_ptr<SharedFrameRing> ring;
+        uint64_t pendingIngestNs = 0;
+        LatencyHistogram frameLatency;
+    };
+}
@@ -0,0 +1,270 @@
+#include "pch.h"
+#include "PacketTiming.h"
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        // Timestamp jumps beyond this (reconnects, clock resets) are treated as a new stream, not loss
+        constexpr int64_t DiscontinuityUs = 5'000'000;
+
+        // Far beyond any real gap; larger, NaN or infinite counts are not trusted
+        constexpr double MaxDroppedSamples = 1e12;
+
+        double DefaultRate(MuseDataPacketType type)
+        {
+            switch (type)
+            {
+            case MuseDataPacketType::Eeg:
+                return 256.0;
+            case MuseDataPacketType::Accelerometer:
+            case MuseDataPacketType::Gyro:
+                return 52.0;
+            case MuseDataPacketType::Ppg:
+                return 64.0;
+            default:
+                break;
+            }
+            // Band powers, scores, headband fit and artifacts are all derived at 10 Hz
+            int value = static_cast<int>(type);
+            if ((value >= static_cast<int>(MuseDataPacketType::AlphaAbsolute) && value <= static_cast<int>(MuseDataPacketType::Hsi))
+                || type == MuseDataPacketType::HsiPrecision || type == MuseDataPacketType::Artifacts)
+            {
+                return 10.0;
+            }
+            return 0.0;
+        }
+
+        // Stream a DROPPED_* packet reports against, or Count if the type is not a drop report
+        MuseDataPacketType DroppedStream(MuseDataPacketType type)
+        {
+            switch (type)
+            {
+            case MuseDataPacketType::DroppedEeg:
+                return MuseDataPacketType::Eeg;
+            case MuseDataPacketType::DroppedAccelerometer:
+                return MuseDataPacketType::Accelerometer;
+            default:
+                return MuseDataPacketType::Count;
+            }
+        }
+
+        // libmuse puts the number of samples lost in the first value; a missing or unusable count is one
+        uint64_t DroppedSamples(const MusePacket& packet)
+        {
+            double count = packet.valueCount > 0 ? packet.values[0] : 0.0;
+            return std::isfinite(count) && count >= 1.0 && count <= MaxDroppedSamples ? static_cast<uint64_t>(count) : 1;
+        }
+    }
+
+    void PacketTimingMonitor::IntervalSet::Reset()
+    {
+        interArrival.Reset();
+        timestampJitter.Reset();
+        packets.store(0, std::memory_order_relaxed);
+        missingSamples.store(0, std::memory_order_relaxed);
+        droppedSamples.store(0, std::memory_order_relaxed);
+        outOfOrder.store(0, std::memory_order_relaxed);
+    }
+
+    PacketTimingMonitor::PacketTimingMonitor(uint64_t intervalNs)
+        : intervalNs(intervalNs), nextRotationNs(0), intervalStartNs(0)
+    {
+        for (int i = 0; i < PacketTypeCount; i++)
+        {
+            nominalRates[i].store(DefaultRate(static_cast<MuseDataPacketType>(i)), std::memory_order_relaxed);
+        }
+    }
+
+    PacketTimingMonitor::~PacketTimingMonitor()
+    {
+        for (auto& stream : streams)
+        {
+            delete stream.load();
+        }
+    }
+
+    void PacketTimingMonitor::Record(const MusePacket& packet, uint64_t arrivalNs)
+    {
+        int typeIndex = static_cast<int>(packet.type);
+        if (typeIndex < 0 || typeIndex >= PacketTypeCount)
+        {
+            return;
+        }
+
+        int64_t ticket = phaser.WriterEnter();
+        int active = WriterReaderPhaser::ActiveIndex(ticket);
+        MuseDataPacketType target = DroppedStream(packet.type);
+        if (target != MuseDataPacketType::Count)
+        {
+            uint64_t dropped = DroppedSamples(packet);
+            Stream& stream = StreamFor(target);
+            stream.sets[active].droppedSamples.fetch_add(dropped, std::memory_order_relaxed);
+            stream.totalDroppedSamples.fetch_add(dropped, std::memory_order_relaxed);
+        }
+        else
+        {
+            Stream& stream = StreamFor(packet.type);
+            RecordArrival(stream, stream.sets[active], packet, arrivalNs, packet.type);
+        }
+        phaser.WriterExit(ticket);
+
+        // The intervals close on the recording thread unless a reader got there first
+        if (arrivalNs >= nextRotationNs.load(std::memory_order_relaxed))
+        {
+            std::unique_lock<std::mutex> guard(rotateLock, std::try_to_lock);
+            if (guard.owns_lock() && arrivalNs >= nextRotationNs.load(std::memory_order_relaxed))
+            {
+                RotateLocked(arrivalNs);
+            }
+        }
+    }
+
+    void PacketTimingMonitor::RecordArrival(Stream& stream, IntervalSet& set, const MusePacket& packet, uint64_t arrivalNs, MuseDataPacketType type)
+    {
+        set.packets.fetch_add(1, std::memory_order_relaxed);
+        stream.totalPackets.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t previousArrival = stream.lastArrivalNs.exchange(arrivalNs, std::memory_order_relaxed);
+        if (previousArrival != 0 && arrivalNs >= previousArrival)
+        {
+            set.interArrival.Record(arrivalNs - previousArrival);
+        }
+
+        int64_t previousTimestamp = stream.lastTimestampUs.exchange(packet.timestampUs, std::memory_order_relaxed);
+        double rate = nominalRates[static_cast<int>(type)].load(std::memory_order_relaxed);
+        if (previousTimestamp == 0 || packet.timestampUs <= 0)
+        {
+            return;
+        }
+        int64_t deltaUs = packet.timestampUs - previousTimestamp;
+        if (deltaUs < 0)
+        {
+            set.outOfOrder.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (rate <= 0.0 || deltaUs > DiscontinuityUs)
+        {
+            return;
+        }
+
+        // A period longer than any gap measured cannot be checked; skipping it also keeps the casts below in range
+        double periodUs = 1e6 / rate;
+        if (periodUs > static_cast<double>(DiscontinuityUs))
+        {
+            return;
+        }
+        set.timestampJitter.Record(static_cast<uint64_t>(std::fabs(static_cast<double>(deltaUs) - periodUs) * 1000.0));
+        int64_t periods = std::llround(static_cast<double>(deltaUs) / periodUs);
+        if (periods > 1)
+        {
+            uint64_t missing = static_cast<uint64_t>(periods - 1);
+            set.missingSamples.fetch_add(missing, std::memory_order_relaxed);
+            stream.totalMissingSamples.fetch_add(missing, std::memory_order_relaxed);
+        }
+    }
+
+    PacketTimingMonitor::Stream& PacketTimingMonitor::StreamFor(MuseDataPacketType type)
+    {
+        std::atomic<Stream*>& slot = streams[static_cast<int>(type)];
+        Stream* stream = slot.load(std::memory_order_acquire);
+        if (stream)
+        {
+            return *stream;
+        }
+
+        // First packet of this type: racing creators agree on one stream and the loser frees its copy
+        Stream* created = new Stream();
+        if (slot.compare_exchange_strong(stream, created, std::memory_order_acq_rel))
+        {
+            return *created;
+        }
+        delete created;
+        return *stream;
+    }
+
+    void PacketTimingMonitor::SetNominalRate(MuseDataPacketType type, double rateHz)
+    {
+        if (!std::isfinite(rateHz) || rateHz < 0.0 || rateHz > MaxNominalRateHz)
+        {
+            throw std::invalid_argument("Nominal rate must be between 0 and 1 MHz");
+        }
+        nominalRates[static_cast<int>(type)].store(rateHz, std::memory_order_relaxed);
+    }
+
+    void PacketTimingMonitor::Rotate(uint64_t nowNs)
+    {
+        std::lock_guard<std::mutex> guard(rotateLock);
+        RotateLocked(nowNs);
+    }
+
+    void PacketTimingMonitor::RotateLocked(uint64_t nowNs)
+    {
+        // The very first call only starts the clock; there is nothing to report yet
+        if (intervalStartNs == 0)
+        {
+            intervalStartNs = nowNs;
+            nextRotationNs.store(nowNs + intervalNs, std::memory_order_relaxed);
+            return;
+        }
+
+        int finished = phaser.FlipPhase();
+        for (int i = 0; i < PacketTypeCount; i++)
+        {
+            Stream* stream = streams[i].load(std::memory_order_acquire);
+            if (!stream)
+            {
+                continue;
+            }
+            IntervalSet& set = stream->sets[finished];
+            PacketTimingSummary& summary = stream->completed;
+            summary.packets = set.packets.load(std::memory_order_relaxed);
+            summary.missingSamples = set.missingSamples.load(std::memory_order_relaxed);
+            summary.droppedSamples = set.droppedSamples.load(std::memory_order_relaxed);
+            summary.outOfOrder = set.outOfOrder.load(std::memory_order_relaxed);
+            summary.interArrival = set.interArrival.Summarise();
+            summary.timestampJitter = set.timestampJitter.Summarise();
+            set.Reset();
+        }
+
+        lastIntervalNs = nowNs - intervalStartNs;
+        intervalStartNs = nowNs;
+        nextRotationNs.store(nowNs + intervalNs, std::memory_order_relaxed);
+    }
+
+    PacketTimingSummary PacketTimingMonitor::Snapshot(MuseDataPacketType type, uint64_t nowNs)
+    {
+        std::lock_guard<std::mutex> guard(rotateLock);
+        if (nowNs >= nextRotationNs.load(std::memory_order_relaxed))
+        {
+            RotateLocked(nowNs);
+        }
+
+        PacketTimingSummary summary = {};
+        Stream* stream = streams[static_cast<int>(type)].load(std::memory_order_acquire);
+        if (stream)
+        {
+            summary = stream->completed;
+            summary.totalPackets = stream->totalPackets.load(std::memory_order_relaxed);
+            summary.totalMissingSamples = stream->totalMissingSamples.load(std::memory_order_relaxed);
+            summary.totalDroppedSamples = stream->totalDroppedSamples.load(std::memory_order_relaxed);
+        }
+        summary.intervalNs = lastIntervalNs;
+        summary.nominalRate = nominalRates[static_cast<int>(type)].load(std::memory_order_relaxed);
+        return summary;
+    }
+
+    PacketTotals PacketTimingMonitor::Totals(MuseDataPacketType type) const
+    {
+        const Stream* stream = streams[static_cast<int>(type)].load(std::memory_order_acquire);
+        if (!stream)
+        {
+            return PacketTotals{};
+        }
+        return PacketTotals{
+            stream->totalPackets.load(std::memory_order_relaxed),
+            stream->totalMissingSamples.load(std::memory_order_relaxed),
+            stream->totalDroppedSamples.load(std::memory_order_relaxed),
+        };
+    }
+}
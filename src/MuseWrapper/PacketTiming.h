@@ -0,0 +1,109 @@
+#pragma once
+
+#include "LatencyHistogram.h"
+#include "MuseTypes.h"
+#include "WriterReaderPhaser.h"
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Arrival statistics of one packet type over one interval, plus running totals
+    /// </summary>
+    struct PacketTimingSummary
+    {
+        uint64_t intervalNs;            // length of the interval reported, 0 before the first rotation
+        double nominalRate;             // Hz, 0 if the type has no nominal rate
+        uint64_t packets;
+        uint64_t missingSamples;        // estimated from device timestamp gaps against the nominal rate
+        uint64_t droppedSamples;        // reported by libmuse DROPPED_* packets
+        uint64_t outOfOrder;            // packets whose timestamp went backwards
+        uint64_t totalPackets;
+        uint64_t totalMissingSamples;
+        uint64_t totalDroppedSamples;
+        LatencySummary interArrival;    // host arrival to arrival
+        LatencySummary timestampJitter; // |device timestamp delta - nominal period|
+    };
+
+    /// <summary>
+    /// Running totals of one packet type, readable at any time without rotating
+    /// </summary>
+    struct PacketTotals
+    {
+        uint64_t packets;
+        uint64_t missingSamples;
+        uint64_t droppedSamples;
+    };
+
+    /// <summary>
+    /// Per-device Bluetooth jitter and data-loss monitor. Every packet type gets its own inter-arrival
+    /// and timestamp-jitter histograms, and DROPPED_EEG / DROPPED_ACCELEROMETER sample counts are
+    /// charged to the EEG and accelerometer streams. Recording is wait-free; the histograms are
+    /// double-buffered and swapped every interval, so a snapshot is a copy of the summary computed
+    /// when the last interval closed. An interval closes on the first record or snapshot after it
+    /// has elapsed, or on an explicit Rotate.
+    /// </summary>
+    class PacketTimingMonitor
+    {
+    public:
+        static constexpr double MaxNominalRateHz = 1e6;
+
+        explicit PacketTimingMonitor(uint64_t intervalNs);
+        ~PacketTimingMonitor();
+
+        PacketTimingMonitor(const PacketTimingMonitor&) = delete;
+        PacketTimingMonitor& operator=(const PacketTimingMonitor&) = delete;
+
+        /// <summary>
+        /// arrivalNs is the MonotonicNanoseconds time the packet reached the host
+        /// </summary>
+        void Record(const MusePacket& packet, uint64_t arrivalNs);
+
+        /// <summary>
+        /// Overrides the default rate (e.g. 256 Hz EEG, 52 Hz accelerometer); 0 disables gap tracking.
+        /// Timestamps are in microseconds, so rates above MaxNominalRateHz are refused.
+        /// </summary>
+        void SetNominalRate(MuseDataPacketType type, double rateHz);
+
+        void Rotate(uint64_t nowNs);
+        PacketTimingSummary Snapshot(MuseDataPacketType type, uint64_t nowNs);
+        PacketTotals Totals(MuseDataPacketType type) const;
+
+    private:
+        struct IntervalSet
+        {
+            LatencyHistogram interArrival;
+            LatencyHistogram timestampJitter;
+            std::atomic<uint64_t> packets{ 0 };
+            std::atomic<uint64_t> missingSamples{ 0 };
+            std::atomic<uint64_t> droppedSamples{ 0 };
+            std::atomic<uint64_t> outOfOrder{ 0 };
+
+            void Reset();
+        };
+
+        struct Stream
+        {
+            std::array<IntervalSet, 2> sets;
+            std::atomic<uint64_t> lastArrivalNs{ 0 };
+            std::atomic<int64_t> lastTimestampUs{ 0 };
+            std::atomic<uint64_t> totalPackets{ 0 };
+            std::atomic<uint64_t> totalMissingSamples{ 0 };
+            std::atomic<uint64_t> totalDroppedSamples{ 0 };
+            PacketTimingSummary completed = {};     // guarded by rotateLock
+        };
+
+        Stream& StreamFor(MuseDataPacketType type);
+        void RecordArrival(Stream& stream, IntervalSet& set, const MusePacket& packet, uint64_t arrivalNs, MuseDataPacketType type);
+        void RotateLocked(uint64_t nowNs);
+
+        uint64_t intervalNs;
+        WriterReaderPhaser phaser;
+        std::array<std::atomic<Stream*>, PacketTypeCount> streams = {};
+        std::array<std::atomic<double>, PacketTypeCount> nominalRates = {};
+        std::atomic<uint64_t> nextRotationNs;
+
+        std::mutex rotateLock;
+        uint64_t intervalStartNs;
+        uint64_t lastIntervalNs = 0;
+    };
+}
@@ -0,0 +1,128 @@
+#include "pch.h"
+#include "Poller.h"
+
+#ifndef _WIN32
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
+namespace MuseWrapper
+{
+#ifdef _WIN32
+    Poller::Poller()
+    {
+        Sockets::Initialize();
+    }
+
+    Poller::~Poller() = default;
+
+    void Poller::Add(SocketHandle socket, void* context)
+    {
+        indices[socket] = descriptors.size();
+        descriptors.push_back(WSAPOLLFD{ socket, POLLRDNORM, 0 });
+        contexts.push_back(context);
+    }
+
+    void Poller::Remove(SocketHandle socket)
+    {
+        auto it = indices.find(socket);
+        if (it == indices.end())
+        {
+            return;
+        }
+        size_t index = it->second;
+        indices.erase(it);
+        if (index != descriptors.size() - 1)
+        {
+            descriptors[index] = descriptors.back();
+            contexts[index] = contexts.back();
+            indices[descriptors[index].fd] = index;
+        }
+        descriptors.pop_back();
+        contexts.pop_back();
+    }
+
+    void Poller::SetWriteInterest(SocketHandle socket, bool enabled)
+    {
+        auto it = indices.find(socket);
+        if (it != indices.end())
+        {
+            descriptors[it->second].events = static_cast<SHORT>(POLLRDNORM | (enabled ? POLLWRNORM : 0));
+        }
+    }
+
+    int Poller::Wait(PollEvent* events, int maxEvents, int timeoutMs)
+    {
+        if (descriptors.empty())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+            return 0;
+        }
+        if (WSAPoll(descriptors.data(), static_cast<ULONG>(descriptors.size()), timeoutMs) <= 0)
+        {
+            return 0;
+        }
+
+        int count = 0;
+        for (size_t i = 0; i < descriptors.size() && count < maxEvents; i++)
+        {
+            SHORT revents = descriptors[i].revents;
+            if (revents == 0)
+            {
+                continue;
+            }
+            events[count++] = PollEvent{ contexts[i], (revents & POLLRDNORM) != 0, (revents & POLLWRNORM) != 0,
+                (revents & (POLLHUP | POLLERR | POLLNVAL)) != 0 };
+        }
+        return count;
+    }
+#else
+    Poller::Poller()
+    {
+        epoll = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll < 0)
+        {
+            throw std::runtime_error("epoll_create1 failed");
+        }
+    }
+
+    Poller::~Poller()
+    {
+        close(epoll);
+    }
+
+    void Poller::Add(SocketHandle socket, void* context)
+    {
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.ptr = context;
+        if (epoll_ctl(epoll, EPOLL_CTL_ADD, socket, &event) != 0)
+        {
+            throw std::runtime_error("epoll_ctl add failed");
+        }
+    }
+
+    void Poller::Remove(SocketHandle socket)
+    {
+        epoll_ctl(epoll, EPOLL_CTL_DEL, socket, nullptr);
+    }
+
+    void Poller::SetWriteInterest(SocketHandle, bool)
+    {
+        // Edge-triggered EPOLLOUT is registered permanently and only fires on transitions
+    }
+
+    int Poller::Wait(PollEvent* events, int maxEvents, int timeoutMs)
+    {
+        constexpr int BatchSize = 256;
+        epoll_event ready[BatchSize];
+        int count = epoll_wait(epoll, ready, std::min(maxEvents, BatchSize), timeoutMs);
+        for (int i = 0; i < count; i++)
+        {
+            events[i] = PollEvent{ ready[i].data.ptr, (ready[i].events & EPOLLIN) != 0, (ready[i].events & EPOLLOUT) != 0,
+                (ready[i].events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) != 0 };
+        }
+        return std::max(count, 0);
+    }
+#endif
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Socket.h"
+
+namespace MuseWrapper
+{
+    struct PollEvent
+    {
+        void* context;
+        bool readable;
+        bool writable;
+        bool hangup;
+    };
+
+    /// <summary>
+    /// Socket readiness multiplexer. Linux uses edge-triggered epoll, so callers must read and
+    /// write until the socket would block; Windows falls back to level-triggered WSAPoll, where
+    /// write interest is only registered while a socket has queued output.
+    /// </summary>
+    class Poller
+    {
+    public:
+        Poller();
+        ~Poller();
+
+        Poller(const Poller&) = delete;
+        Poller& operator=(const Poller&) = delete;
+
+        void Add(SocketHandle socket, void* context);
+        void Remove(SocketHandle socket);
+
+        /// <summary>
+        /// Declares whether the caller is waiting for the socket to become writable
+        /// </summary>
+        void SetWriteInterest(SocketHandle socket, bool enabled);
+
+        /// <summary>
+        /// Waits up to timeoutMs and returns the number of events written
+        /// </summary>
+        int Wait(PollEvent* events, int maxEvents, int timeoutMs);
+
+    private:
+#ifdef _WIN32
+        std::vector<WSAPOLLFD> descriptors;
+        std::vector<void*> contexts;
+        std::unordered_map<SocketHandle, size_t> indices;
+#else
+        int epoll = -1;
+#endif
+    };
+}
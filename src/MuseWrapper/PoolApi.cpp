@@ -0,0 +1,57 @@
+// PoolApi.cpp : Exported entry points for the shared DSP worker pool.
+#include "pch.h"
+#include "ApiHandles.h"
+#include "ApiSupport.h"
+#include "DspPool.h"
+
+using namespace MuseWrapper;
+
+namespace
+{
+    constexpr int MaxWorkers = 256;
+
+    HandleTable<DspPool> pools;
+}
+
+HandleTable<DspPool>& MuseWrapper::PoolHandles()
+{
+    return pools;
+}
+
+int MwPoolCreate(int workers, const int* cpus, int cpuCount, int* handleOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(handleOut != nullptr, "handleOut is required");
+        Require(workers >= 0 && workers <= MaxWorkers, "workers is out of range");
+        Require(cpuCount >= 0 && (cpus != nullptr || cpuCount == 0), "Invalid CPU list");
+        DspPool::Options options;
+        options.workers = workers;
+        options.cpus.assign(cpus, cpus + cpuCount);
+        *handleOut = pools.Add(std::make_shared<DspPool>(options));
+        return MW_OK;
+    });
+}
+
+int MwPoolDestroy(int handle, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        pools.Remove(handle);
+        return MW_OK;
+    });
+}
+
+int MwPoolGetStats(int handle, MwPoolStats* statsOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(statsOut != nullptr, "statsOut is required");
+        DspPoolStats stats = pools.Get(handle)->Stats();
+        statsOut->batches = static_cast<int64_t>(stats.batches);
+        statsOut->steals = static_cast<int64_t>(stats.steals);
+        statsOut->workers = stats.workers;
+        statsOut->clients = stats.clients;
+        return MW_OK;
+    });
+}
@@ -0,0 +1,573 @@
+#include "pch.h"
+#include "Profiler.h"
+#include "WriterReaderPhaser.h"
+
+#include <cstdio>
+#include <map>
+
+#ifdef _WIN32
+#include <dbghelp.h>
+#pragma comment(lib, "Dbghelp.lib")
+#else
+#include <cerrno>
+#include <csignal>
+#include <ctime>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && !defined(sigev_notify_thread_id)
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+namespace MuseWrapper
+{
+    namespace Profiler
+    {
+        namespace
+        {
+#if (defined(_WIN32) && defined(_M_X64)) || (defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__)))
+            constexpr bool Supported = true;
+#else
+            constexpr bool Supported = false;
+#endif
+
+            constexpr size_t TableSlots = 8192;         // power of two
+            constexpr size_t TableProbes = 64;
+
+            struct StackSlot
+            {
+                std::atomic<uint64_t> key{ 0 };
+                std::atomic<bool> ready{ false };       // thread, depth and frames written
+                int thread = 0;
+                int depth = 0;
+                std::array<uintptr_t, MaxFrames> frames = {};
+                std::atomic<uint64_t> count{ 0 };
+            };
+
+            struct StackTable
+            {
+                std::array<StackSlot, TableSlots> slots;
+                std::atomic<uint64_t> samples{ 0 };
+                std::atomic<uint64_t> dropped{ 0 };
+
+                void Clear()
+                {
+                    for (StackSlot& slot : slots)
+                    {
+                        slot.ready.store(false, std::memory_order_relaxed);
+                        slot.count.store(0, std::memory_order_relaxed);
+                        slot.key.store(0, std::memory_order_relaxed);
+                    }
+                    samples.store(0, std::memory_order_relaxed);
+                    dropped.store(0, std::memory_order_relaxed);
+                }
+            };
+
+            struct ThreadEntry
+            {
+                bool inUse = false;
+                const char* name = nullptr;
+#ifdef _WIN32
+                HANDLE handle = nullptr;
+#else
+                pid_t tid = 0;
+                pthread_t handle = {};
+                uintptr_t stackLow = 0;
+                uintptr_t stackHigh = 0;
+                timer_t timer = {};
+                bool timerArmed = false;
+#endif
+            };
+
+            // Two tables so Write with reset can swap them under writers; allocated on first Start and
+            // kept for the life of the process, since a late signal may still be writing
+            std::atomic<StackTable*> tables{ nullptr };
+            WriterReaderPhaser phaser;
+
+            std::mutex threadLock;          // guards threads, frequency and the timers
+            std::array<ThreadEntry, MaxThreads> threads;
+            std::atomic<bool> running{ false };
+            int frequency = 0;
+
+            std::mutex writeLock;           // serialises Write
+
+            // Runs in signal context on Linux: only lock-free atomics and plain stores
+            void RecordSample(int thread, const uintptr_t* frames, int depth)
+            {
+                StackTable* base = tables.load(std::memory_order_acquire);
+                if (base == nullptr)
+                {
+                    return;
+                }
+                int64_t ticket = phaser.WriterEnter();
+                StackTable& table = base[WriterReaderPhaser::ActiveIndex(ticket)];
+                table.samples.fetch_add(1, std::memory_order_relaxed);
+
+                // FNV-1a over the thread and its return addresses; 0 marks an empty slot
+                uint64_t key = (14695981039346656037ull ^ static_cast<uint64_t>(thread)) * 1099511628211ull;
+                for (int i = 0; i < depth; i++)
+                {
+                    key = (key ^ frames[i]) * 1099511628211ull;
+                }
+                key |= 1;
+
+                bool recorded = false;
+                for (size_t probe = 0; probe < TableProbes && !recorded; probe++)
+                {
+                    StackSlot& slot = table.slots[(key + probe) & (TableSlots - 1)];
+                    uint64_t existing = slot.key.load(std::memory_order_acquire);
+                    if (existing == 0 && slot.key.compare_exchange_strong(existing, key, std::memory_order_acq_rel))
+                    {
+                        slot.thread = thread;
+                        slot.depth = depth;
+                        std::copy_n(frames, depth, slot.frames.begin());
+                        slot.ready.store(true, std::memory_order_release);
+                        existing = key;
+                    }
+                    if (existing == key)
+                    {
+                        slot.count.fetch_add(1, std::memory_order_relaxed);
+                        recorded = true;
+                    }
+                }
+                if (!recorded)
+                {
+                    table.dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+                phaser.WriterExit(ticket);
+            }
+
+#ifdef _WIN32
+            std::thread sampler;
+
+            // Unwinds a suspended thread with the image unwind tables. Nothing here may allocate: the
+            // thread could be suspended holding the heap lock.
+            int CaptureSuspended(HANDLE handle, uintptr_t* frames)
+            {
+                int depth = 0;
+#ifdef _M_X64
+                CONTEXT context = {};
+                context.ContextFlags = CONTEXT_CONTROL | CONTEXT_INTEGER;
+                if (!GetThreadContext(handle, &context))
+                {
+                    return 0;
+                }
+                while (depth < MaxFrames && context.Rip != 0)
+                {
+                    frames[depth++] = static_cast<uintptr_t>(context.Rip);
+                    DWORD64 imageBase;
+                    PRUNTIME_FUNCTION function = RtlLookupFunctionEntry(context.Rip, &imageBase, nullptr);
+                    if (function == nullptr)
+                    {
+                        // Leaf function: the return address is on top of the stack
+                        context.Rip = *reinterpret_cast<DWORD64*>(context.Rsp);
+                        context.Rsp += 8;
+                        continue;
+                    }
+                    PVOID handlerData;
+                    DWORD64 establisherFrame;
+                    RtlVirtualUnwind(UNW_FLAG_NHANDLER, imageBase, context.Rip, function, &context, &handlerData, &establisherFrame, nullptr);
+                }
+#endif
+                return depth;
+            }
+
+            void RunSampler(int hz)
+            {
+                auto period = std::chrono::nanoseconds(1'000'000'000 / hz);
+                auto next = std::chrono::steady_clock::now();
+                std::array<uintptr_t, MaxFrames> frames;
+                while (running.load(std::memory_order_relaxed))
+                {
+                    {
+                        std::lock_guard<std::mutex> guard(threadLock);
+                        for (int i = 0; i < MaxThreads; i++)
+                        {
+                            ThreadEntry& entry = threads[static_cast<size_t>(i)];
+                            if (!entry.inUse || SuspendThread(entry.handle) == static_cast<DWORD>(-1))
+                            {
+                                continue;
+                            }
+                            int depth = CaptureSuspended(entry.handle, frames.data());
+                            ResumeThread(entry.handle);
+                            if (depth > 0)
+                            {
+                                RecordSample(i, frames.data(), depth);
+                            }
+                        }
+                    }
+                    // Sleep granularity is the system timer resolution, which caps the real rate
+                    next += period;
+                    auto now = std::chrono::steady_clock::now();
+                    if (now - next > 4 * period)
+                    {
+                        next = now;
+                    }
+                    std::this_thread::sleep_until(next);
+                }
+            }
+#elif defined(__linux__)
+            thread_local ThreadEntry* currentThread = nullptr;
+            bool handlerInstalled = false;
+
+            void HandleSignal(int, siginfo_t*, void* context)
+            {
+                int savedErrno = errno;
+                ThreadEntry* entry = currentThread;
+                if (entry != nullptr && running.load(std::memory_order_relaxed))
+                {
+                    const ucontext_t* user = static_cast<const ucontext_t*>(context);
+#if defined(__x86_64__)
+                    uintptr_t pc = static_cast<uintptr_t>(user->uc_mcontext.gregs[REG_RIP]);
+                    uintptr_t fp = static_cast<uintptr_t>(user->uc_mcontext.gregs[REG_RBP]);
+#else
+                    uintptr_t pc = static_cast<uintptr_t>(user->uc_mcontext.pc);
+                    uintptr_t fp = static_cast<uintptr_t>(user->uc_mcontext.regs[29]);
+#endif
+                    uintptr_t frames[MaxFrames];
+                    int depth = 0;
+                    frames[depth++] = pc;
+                    // Each frame holds the caller's frame pointer then the return address. Frames only
+                    // move up the thread's own stack, which also stops the walk at code built without
+                    // frame pointers.
+                    while (depth < MaxFrames && fp >= entry->stackLow && fp + 2 * sizeof(uintptr_t) <= entry->stackHigh
+                        && fp % sizeof(uintptr_t) == 0)
+                    {
+                        const uintptr_t* frame = reinterpret_cast<const uintptr_t*>(fp);
+                        if (frame[1] == 0)
+                        {
+                            break;
+                        }
+                        frames[depth++] = frame[1];
+                        if (frame[0] <= fp)
+                        {
+                            break;
+                        }
+                        fp = frame[0];
+                    }
+                    RecordSample(static_cast<int>(entry - threads.data()), frames, depth);
+                }
+                errno = savedErrno;
+            }
+
+            // Called with threadLock held
+            void ArmTimer(ThreadEntry& entry)
+            {
+                clockid_t clock;
+                if (pthread_getcpuclockid(entry.handle, &clock) != 0)
+                {
+                    return;
+                }
+                sigevent event = {};
+                event.sigev_notify = SIGEV_THREAD_ID;
+                event.sigev_signo = SIGPROF;
+                event.sigev_notify_thread_id = entry.tid;
+                if (timer_create(clock, &event, &entry.timer) != 0)
+                {
+                    return;
+                }
+                long periodNs = 1'000'000'000L / frequency;
+                itimerspec spec = {};
+                spec.it_interval.tv_sec = periodNs / 1'000'000'000L;
+                spec.it_interval.tv_nsec = periodNs % 1'000'000'000L;
+                spec.it_value = spec.it_interval;
+                timer_settime(entry.timer, 0, &spec, nullptr);
+                entry.timerArmed = true;
+            }
+
+            void DisarmTimer(ThreadEntry& entry)
+            {
+                if (entry.timerArmed)
+                {
+                    timer_delete(entry.timer);
+                    entry.timerArmed = false;
+                }
+            }
+#endif
+
+            std::string DescribeFrame(uintptr_t address, bool returnAddress)
+            {
+                // Return addresses point after the call; look up the call itself
+                uintptr_t lookup = returnAddress ? address - 1 : address;
+                char text[512];
+#ifdef _WIN32
+                static bool symbolsLoaded = SymInitialize(GetCurrentProcess(), nullptr, TRUE) != FALSE;
+                alignas(SYMBOL_INFO) char buffer[sizeof(SYMBOL_INFO) + 256];
+                SYMBOL_INFO* symbol = reinterpret_cast<SYMBOL_INFO*>(buffer);
+                symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+                symbol->MaxNameLen = 256;
+                DWORD64 displacement;
+                if (symbolsLoaded && SymFromAddr(GetCurrentProcess(), lookup, &displacement, symbol))
+                {
+                    return symbol->Name;
+                }
+                HMODULE module = nullptr;
+                char path[MAX_PATH] = "?";
+                if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                    reinterpret_cast<LPCSTR>(lookup), &module))
+                {
+                    GetModuleFileNameA(module, path, MAX_PATH);
+                }
+                const char* name = std::strrchr(path, '\\') ? std::strrchr(path, '\\') + 1 : path;
+                std::snprintf(text, sizeof(text), "%s+0x%llx", name, static_cast<unsigned long long>(lookup - reinterpret_cast<uintptr_t>(module)));
+                return text;
+#else
+                Dl_info info = {};
+                if (dladdr(reinterpret_cast<void*>(lookup), &info) != 0 && info.dli_sname != nullptr)
+                {
+                    int status = 0;
+                    char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+                    std::string name = status == 0 && demangled ? demangled : info.dli_sname;
+                    std::free(demangled);
+                    return name;
+                }
+                if (info.dli_fname != nullptr)
+                {
+                    const char* name = std::strrchr(info.dli_fname, '/') ? std::strrchr(info.dli_fname, '/') + 1 : info.dli_fname;
+                    std::snprintf(text, sizeof(text), "%s+0x%llx", name,
+                        static_cast<unsigned long long>(lookup - reinterpret_cast<uintptr_t>(info.dli_fbase)));
+                    return text;
+                }
+                std::snprintf(text, sizeof(text), "0x%llx", static_cast<unsigned long long>(lookup));
+                return text;
+#endif
+            }
+
+            // Folded-stack frames are separated by ';', so a name must not contain one
+            std::string FoldedName(std::string name)
+            {
+                std::replace(name.begin(), name.end(), ';', ':');
+                return name;
+            }
+        }
+
+        void Start(int frequencyHz)
+        {
+            if (!Supported)
+            {
+                throw std::runtime_error("The sampling profiler is only available on Linux (x86-64, AArch64) and Windows x64");
+            }
+            if (frequencyHz < 1 || frequencyHz > 1000)
+            {
+                throw std::invalid_argument("Profiler frequency must be 1-1000 Hz");
+            }
+            std::lock_guard<std::mutex> guard(threadLock);
+            if (running.load())
+            {
+                return;
+            }
+            if (tables.load() == nullptr)
+            {
+                tables.store(new StackTable[2], std::memory_order_release);
+            }
+            frequency = frequencyHz;
+            running.store(true);
+#ifdef _WIN32
+            sampler = std::thread(RunSampler, frequencyHz);
+#elif defined(__linux__)
+            if (!handlerInstalled)
+            {
+                struct sigaction action = {};
+                action.sa_sigaction = HandleSignal;
+                action.sa_flags = SA_SIGINFO | SA_RESTART;
+                sigemptyset(&action.sa_mask);
+                if (sigaction(SIGPROF, &action, nullptr) != 0)
+                {
+                    running.store(false);
+                    throw std::runtime_error("Cannot install the SIGPROF handler");
+                }
+                handlerInstalled = true;
+            }
+            for (ThreadEntry& entry : threads)
+            {
+                if (entry.inUse)
+                {
+                    ArmTimer(entry);
+                }
+            }
+#endif
+        }
+
+        void Stop()
+        {
+#ifdef _WIN32
+            std::thread stopping;
+            {
+                std::lock_guard<std::mutex> guard(threadLock);
+                running.store(false);
+                stopping = std::move(sampler);
+            }
+            if (stopping.joinable())
+            {
+                stopping.join();
+            }
+#else
+            std::lock_guard<std::mutex> guard(threadLock);
+            running.store(false);
+#ifdef __linux__
+            for (ThreadEntry& entry : threads)
+            {
+                DisarmTimer(entry);
+            }
+#endif
+#endif
+        }
+
+        bool Running()
+        {
+            return running.load(std::memory_order_relaxed);
+        }
+
+        Stats Write(const std::string& path, bool reset)
+        {
+            std::lock_guard<std::mutex> guard(writeLock);
+            Stats stats = {};
+            StackTable* base = tables.load(std::memory_order_acquire);
+
+            std::array<const char*, MaxThreads> names = {};
+            {
+                std::lock_guard<std::mutex> threadGuard(threadLock);
+                for (int i = 0; i < MaxThreads; i++)
+                {
+                    names[static_cast<size_t>(i)] = threads[static_cast<size_t>(i)].name;
+                }
+            }
+
+            // Between resets the inactive table is empty, so reading both gives the running totals;
+            // with reset, writers move to the other table and the one they left is read and cleared
+            std::vector<StackTable*> sources;
+            if (base != nullptr)
+            {
+                if (reset)
+                {
+                    sources.push_back(&base[phaser.FlipPhase()]);
+                }
+                else
+                {
+                    sources.push_back(&base[0]);
+                    sources.push_back(&base[1]);
+                }
+            }
+
+            std::map<std::string, uint64_t> folded;
+            std::unordered_map<uintptr_t, std::string> symbols;
+            for (StackTable* table : sources)
+            {
+                stats.samples += table->samples.load(std::memory_order_relaxed);
+                stats.droppedSamples += table->dropped.load(std::memory_order_relaxed);
+                for (const StackSlot& slot : table->slots)
+                {
+                    uint64_t count = slot.count.load(std::memory_order_relaxed);
+                    if (count == 0 || !slot.ready.load(std::memory_order_acquire))
+                    {
+                        continue;
+                    }
+                    stats.distinctStacks++;
+                    const char* threadName = names[static_cast<size_t>(slot.thread)];
+                    std::string line = FoldedName(threadName ? threadName : "thread " + std::to_string(slot.thread));
+                    for (int i = slot.depth - 1; i >= 0; i--)
+                    {
+                        uintptr_t address = slot.frames[static_cast<size_t>(i)];
+                        auto symbol = symbols.find(address);
+                        if (symbol == symbols.end())
+                        {
+                            symbol = symbols.emplace(address, FoldedName(DescribeFrame(address, i > 0))).first;
+                        }
+                        line += ';';
+                        line += symbol->second;
+                    }
+                    folded[line] += count;
+                }
+            }
+            if (reset && !sources.empty())
+            {
+                sources.front()->Clear();
+            }
+
+            std::FILE* file = std::fopen(path.c_str(), "wb");
+            if (file == nullptr)
+            {
+                throw std::runtime_error("Cannot create profile " + path);
+            }
+            for (const auto& entry : folded)
+            {
+                std::fprintf(file, "%s %llu\n", entry.first.c_str(), static_cast<unsigned long long>(entry.second));
+            }
+            if (std::fclose(file) != 0)
+            {
+                throw std::runtime_error("Failed to write profile " + path);
+            }
+            return stats;
+        }
+
+        ThreadRegistration::ThreadRegistration(const char* name) : slot(-1)
+        {
+            if (!Supported)
+            {
+                return;
+            }
+            std::lock_guard<std::mutex> guard(threadLock);
+            for (int i = 0; i < MaxThreads; i++)
+            {
+                ThreadEntry& entry = threads[static_cast<size_t>(i)];
+                if (entry.inUse)
+                {
+                    continue;
+                }
+#ifdef _WIN32
+                if (!DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &entry.handle,
+                    THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION, FALSE, 0))
+                {
+                    return;
+                }
+#elif defined(__linux__)
+                entry.tid = static_cast<pid_t>(syscall(SYS_gettid));
+                entry.handle = pthread_self();
+                pthread_attr_t attributes;
+                if (pthread_getattr_np(entry.handle, &attributes) == 0)
+                {
+                    void* low = nullptr;
+                    size_t size = 0;
+                    pthread_attr_getstack(&attributes, &low, &size);
+                    pthread_attr_destroy(&attributes);
+                    entry.stackLow = reinterpret_cast<uintptr_t>(low);
+                    entry.stackHigh = entry.stackLow + size;
+                }
+                // Touching the thread-local here also makes sure it is allocated before a signal reads it
+                currentThread = &entry;
+                if (running.load())
+                {
+                    ArmTimer(entry);
+                }
+#endif
+                entry.name = name;
+                entry.inUse = true;
+                slot = i;
+                return;
+            }
+        }
+
+        ThreadRegistration::~ThreadRegistration()
+        {
+            if (slot < 0)
+            {
+                return;
+            }
+            std::lock_guard<std::mutex> guard(threadLock);
+            ThreadEntry& entry = threads[static_cast<size_t>(slot)];
+#ifdef _WIN32
+            CloseHandle(entry.handle);
+            entry.handle = nullptr;
+#elif defined(__linux__)
+            DisarmTimer(entry);
+            currentThread = nullptr;
+#endif
+            entry.inUse = false;
+        }
+    }
+}
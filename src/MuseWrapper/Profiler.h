@@ -0,0 +1,60 @@
+#pragma once
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Sampling profiler for MuseWrapper's own threads, cheap enough to leave running so the stacks
+    /// behind an intermittent stutter are already collected when it happens. Threads opt in with a
+    /// ThreadRegistration for their lifetime.
+    ///
+    /// On Linux each registered thread gets a timer on its CPU-time clock that raises SIGPROF on that
+    /// thread; the handler walks frame pointers (build with -fno-omit-frame-pointer for full stacks).
+    /// On Windows x64 a sampler thread suspends each registered thread in turn and unwinds it with the
+    /// image unwind tables, at up to the system timer resolution. Either way stacks are counted in a
+    /// fixed-size lock-free table, and Write exports them as folded stacks ("thread;outer;inner count"),
+    /// the input flamegraph.pl, speedscope and Perfetto take.
+    /// </summary>
+    namespace Profiler
+    {
+        constexpr int MaxFrames = 32;
+        constexpr int MaxThreads = 64;
+
+        struct Stats
+        {
+            uint64_t samples;
+            uint64_t droppedSamples;        // table full, or a thread beyond MaxThreads
+            uint64_t distinctStacks;
+        };
+
+        /// <summary>
+        /// Starts sampling every registered thread at frequencyHz (1-1000). Samples collected before
+        /// an earlier Stop are kept until the next Write with reset.
+        /// </summary>
+        void Start(int frequencyHz);
+        void Stop();
+        bool Running();
+
+        /// <summary>
+        /// Writes the folded stacks collected so far. With reset, counting restarts from zero so each
+        /// file covers only the time since the previous one.
+        /// </summary>
+        Stats Write(const std::string& path, bool reset);
+
+        /// <summary>
+        /// Makes the calling thread visible to the profiler until destroyed. Name must be a string
+        /// literal; it becomes the root frame of the thread's stacks.
+        /// </summary>
+        class ThreadRegistration
+        {
+        public:
+            explicit ThreadRegistration(const char* name);
+            ~ThreadRegistration();
+
+            ThreadRegistration(const ThreadRegistration&) = delete;
+            ThreadRegistration& operator=(const ThreadRegistration&) = delete;
+
+        private:
+            int slot;
+        };
+    }
+}
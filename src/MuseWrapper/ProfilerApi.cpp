@@ -0,0 +1,39 @@
+// ProfilerApi.cpp : Exported entry points for the sampling profiler.
+#include "pch.h"
+#include "ApiSupport.h"
+#include "Profiler.h"
+
+using namespace MuseWrapper;
+
+int MwProfilerStart(int frequencyHz, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(frequencyHz >= 1 && frequencyHz <= 1000, "frequencyHz must be 1-1000");
+        Profiler::Start(frequencyHz);
+        return MW_OK;
+    });
+}
+
+int MwProfilerStop(char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Profiler::Stop();
+        return MW_OK;
+    });
+}
+
+int MwProfilerWrite(const char* path, int reset, int64_t* samplesOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(path != nullptr, "path is required");
+        Profiler::Stats stats = Profiler::Write(path, reset != 0);
+        if (samplesOut != nullptr)
+        {
+            *samplesOut = static_cast<int64_t>(stats.samples);
+        }
+        return MW_OK;
+    });
+}
@@ -0,0 +1,197 @@
+#include "pch.h"
+#include "Rcu.h"
+
+#include <limits>
+
+namespace MuseWrapper
+{
+    namespace Epochs
+    {
+        namespace
+        {
+            constexpr int OverflowSlot = -2;
+            constexpr int Unclaimed = -1;
+
+            struct alignas(64) ReaderSlot
+            {
+                std::atomic<uint64_t> epoch{ 0 };       // 0 while the owner is not reading
+                std::atomic<bool> owned{ false };
+            };
+
+            struct RetiredObject
+            {
+                uint64_t epoch;                         // the epoch it was replaced in
+                void* object;
+                void (*deleter)(void*);
+            };
+
+            struct Domain
+            {
+                std::atomic<uint64_t> epoch{ 1 };
+                std::array<ReaderSlot, MaxReaders> slots;
+                std::atomic<int> overflowReaders{ 0 };
+                std::mutex retiredLock;
+                std::vector<RetiredObject> retired;     // guarded by retiredLock
+            };
+
+            // Never destroyed: threads may still read while static destructors run at exit
+            Domain& Instance()
+            {
+                static Domain* domain = new Domain();
+                return *domain;
+            }
+
+            struct ThreadState
+            {
+                int slot = Unclaimed;
+                int depth = 0;
+
+                ~ThreadState()
+                {
+                    if (slot >= 0)
+                    {
+                        ReaderSlot& reader = Instance().slots[static_cast<size_t>(slot)];
+                        reader.epoch.store(0, std::memory_order_release);
+                        reader.owned.store(false, std::memory_order_release);
+                    }
+                }
+            };
+
+            thread_local ThreadState current;
+
+            int ClaimSlot(Domain& domain)
+            {
+                for (int i = 0; i < MaxReaders; i++)
+                {
+                    bool expected = false;
+                    if (domain.slots[static_cast<size_t>(i)].owned.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+                    {
+                        return i;
+                    }
+                }
+                return OverflowSlot;
+            }
+
+            // Oldest epoch a reader may have entered in; anything retired before it is unreachable
+            uint64_t OldestActiveEpoch(Domain& domain)
+            {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (domain.overflowReaders.load(std::memory_order_seq_cst) != 0)
+                {
+                    return 0;
+                }
+                uint64_t oldest = std::numeric_limits<uint64_t>::max();
+                for (ReaderSlot& slot : domain.slots)
+                {
+                    uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+                    if (epoch != 0)
+                    {
+                        oldest = std::min(oldest, epoch);
+                    }
+                }
+                return oldest;
+            }
+
+            void Reclaim(Domain& domain)
+            {
+                std::vector<RetiredObject> freeable;
+                {
+                    std::lock_guard<std::mutex> guard(domain.retiredLock);
+                    if (domain.retired.empty())
+                    {
+                        return;
+                    }
+                    uint64_t oldest = OldestActiveEpoch(domain);
+                    auto kept = std::partition(domain.retired.begin(), domain.retired.end(),
+                        [oldest](const RetiredObject& r) { return r.epoch >= oldest; });
+                    freeable.assign(kept, domain.retired.end());
+                    domain.retired.erase(kept, domain.retired.end());
+                }
+                // Deleters run outside the lock: they may release objects that retire snapshots of their own
+                for (const RetiredObject& r : freeable)
+                {
+                    r.deleter(r.object);
+                }
+            }
+        }
+
+        ReadGuard::ReadGuard()
+        {
+            if (current.depth++ != 0)
+            {
+                return;
+            }
+            Domain& domain = Instance();
+            if (current.slot == Unclaimed)
+            {
+                current.slot = ClaimSlot(domain);
+            }
+            if (current.slot >= 0)
+            {
+                // The fence orders the published epoch before every load of a snapshot pointer
+                domain.slots[static_cast<size_t>(current.slot)].epoch.store(domain.epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+            else
+            {
+                domain.overflowReaders.fetch_add(1, std::memory_order_seq_cst);
+            }
+        }
+
+        ReadGuard::~ReadGuard()
+        {
+            if (--current.depth != 0)
+            {
+                return;
+            }
+            Domain& domain = Instance();
+            if (current.slot >= 0)
+            {
+                domain.slots[static_cast<size_t>(current.slot)].epoch.store(0, std::memory_order_release);
+            }
+            else
+            {
+                domain.overflowReaders.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        void Retire(void* object, void (*deleter)(void*))
+        {
+            Domain& domain = Instance();
+            // A reader that loaded the old pointer published its epoch before the swap, so it is at most this one
+            uint64_t epoch = domain.epoch.fetch_add(1, std::memory_order_seq_cst);
+            {
+                std::lock_guard<std::mutex> guard(domain.retiredLock);
+                domain.retired.push_back(RetiredObject{ epoch, object, deleter });
+            }
+            Reclaim(domain);
+        }
+
+        void Synchronize()
+        {
+            if (current.depth != 0)
+            {
+                throw std::logic_error("Cannot wait for readers from inside a read");
+            }
+            Domain& domain = Instance();
+            uint64_t epoch = domain.epoch.fetch_add(1, std::memory_order_seq_cst);
+            while (OldestActiveEpoch(domain) <= epoch)
+            {
+                std::this_thread::yield();
+            }
+            Reclaim(domain);
+        }
+
+        bool Reading()
+        {
+            return current.depth != 0;
+        }
+
+        size_t PendingRetired()
+        {
+            Domain& domain = Instance();
+            std::lock_guard<std::mutex> guard(domain.retiredLock);
+            return domain.retired.size();
+        }
+    }
+}
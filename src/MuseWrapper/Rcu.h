@@ -0,0 +1,94 @@
+#pragma once
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Epoch-based reclamation for read-mostly tables such as the pipeline's sinks and packet listeners.
+    /// Readers enter a ReadGuard, which only publishes the current epoch in a per-thread slot, and
+    /// then read an immutable Snapshot without taking a lock. Writers copy the table, publish the
+    /// copy and retire the old one, which is deleted once every reader that could still see it has
+    /// left its guard.
+    ///
+    /// Each reading thread takes one of MaxReaders slots on its first read and gives it back when it
+    /// exits. Threads beyond that share a single counter instead, which is still correct but holds
+    /// back reclamation while any of them is reading.
+    /// </summary>
+    namespace Epochs
+    {
+        constexpr int MaxReaders = 128;
+
+        /// <summary>
+        /// Marks the calling thread as reading until destroyed. Guards nest.
+        /// </summary>
+        class ReadGuard
+        {
+        public:
+            ReadGuard();
+            ~ReadGuard();
+
+            ReadGuard(const ReadGuard&) = delete;
+            ReadGuard& operator=(const ReadGuard&) = delete;
+        };
+
+        /// <summary>
+        /// Deletes object once no reader can still hold it; deleter is called on the writer that
+        /// happens to reclaim it
+        /// </summary>
+        void Retire(void* object, void (*deleter)(void*));
+
+        /// <summary>
+        /// Waits until every read that started before the call has finished, then reclaims what it
+        /// can. Used when the caller is about to free something a reader may still be using. Throws
+        /// when called inside a ReadGuard, which would wait for itself.
+        /// </summary>
+        void Synchronize();
+
+        /// <summary>
+        /// Whether the calling thread is inside a ReadGuard, where Synchronize would throw
+        /// </summary>
+        bool Reading();
+
+        /// <summary>
+        /// Objects retired but not yet deleted
+        /// </summary>
+        size_t PendingRetired();
+    }
+
+    /// <summary>
+    /// An immutable T replaced as a whole. Read returns the current copy, valid until the caller's
+    /// ReadGuard ends; Update copies it, applies the change and publishes the copy. Updates must be
+    /// serialised by the owner, which already holds a lock for them.
+    /// </summary>
+    template <typename T>
+    class Snapshot
+    {
+    public:
+        Snapshot() : current(new T()) {}
+
+        // No readers may be left: owners stop the threads that read before destroying the snapshot
+        ~Snapshot()
+        {
+            delete current.load(std::memory_order_relaxed);
+        }
+
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+
+        const T& Read() const
+        {
+            return *current.load(std::memory_order_acquire);
+        }
+
+        template <typename Change>
+        void Update(Change&& change)
+        {
+            auto next = std::make_unique<T>(*current.load(std::memory_order_relaxed));
+            change(*next);
+            T* old = current.exchange(next.release(), std::memory_order_seq_cst);
+            Epochs::Retire(old, [](void* object) { delete static_cast<T*>(object); });
+        }
+
+    private:
+        std::atomic<T*> current;
+    };
+}
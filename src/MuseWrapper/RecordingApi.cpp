@@ -0,0 +1,154 @@
+// RecordingApi.cpp : Exported entry points for writing session recordings and replaying them against VOD playback.
+#include "pch.h"
+#include "ApiHandles.h"
+#include "ApiSupport.h"
+#include "Clock.h"
+#include "ReplayServer.h"
+
+using namespace MuseWrapper;
+
+namespace
+{
+    HandleTable<RecordingWriter> writers;
+    HandleTable<ReplaySession> sessions;
+
+    ReplayServer& Server()
+    {
+        static ReplayServer server(ReplayServer::Options{});
+        return server;
+    }
+}
+
+HandleTable<RecordingWriter>& MuseWrapper::RecordingHandles()
+{
+    return writers;
+}
+
+ReplayServer& MuseWrapper::SharedReplayServer()
+{
+    return Server();
+}
+
+int MwRecordingCreate(const char* path, int64_t syncTimestampUs, int* handleOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(path != nullptr && handleOut != nullptr, "path and handleOut are required");
+        *handleOut = writers.Add(std::make_shared<RecordingWriter>(path, syncTimestampUs));
+        return MW_OK;
+    });
+}
+
+int MwRecordingAddPacket(int handle, int packetType, int64_t timestampUs, const double* values, int numValues, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(packetType >= 0 && packetType < PacketTypeCount, "Unknown packet type");
+        Require(numValues >= 0 && numValues <= MaxPacketValues && (values != nullptr || numValues == 0), "Invalid packet values");
+        MusePacket packet = { static_cast<MuseDataPacketType>(packetType), numValues, timestampUs, {} };
+        std::copy_n(values, numValues, packet.values);
+        writers.Get(handle)->AddPacket(packet);
+        return MW_OK;
+    });
+}
+
+int MwRecordingClose(int handle, int64_t* packetsWrittenOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        std::shared_ptr<RecordingWriter> writer = writers.Remove(handle);
+        writer->Finish();
+        if (packetsWrittenOut != nullptr)
+        {
+            *packetsWrittenOut = static_cast<int64_t>(writer->PacketsWritten());
+        }
+        return MW_OK;
+    });
+}
+
+int MwReplayOpen(const char* recordingPath, int* handleOut, int64_t* durationUsOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(recordingPath != nullptr && handleOut != nullptr, "recordingPath and handleOut are required");
+        std::shared_ptr<ReplaySession> session = Server().OpenSession(recordingPath);
+        if (durationUsOut != nullptr)
+        {
+            *durationUsOut = session->DurationUs();
+        }
+        *handleOut = sessions.Add(std::move(session));
+        return MW_OK;
+    });
+}
+
+int MwReplayClose(int handle, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Server().CloseSession(sessions.Remove(handle));
+        return MW_OK;
+    });
+}
+
+int MwReplaySetPlayback(int handle, int64_t positionUs, double rate, int paused, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(rate > 0.0 && rate <= 16.0, "rate must be in (0, 16]");
+        sessions.Get(handle)->SetPlayback(positionUs, rate, paused != 0, MonotonicNanoseconds());
+        Server().Notify();
+        return MW_OK;
+    });
+}
+
+int MwReplayRead(int handle, MwPacket* packetsOut, int maxPackets, int* countOut, int64_t* positionUsOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(packetsOut != nullptr && maxPackets > 0 && countOut != nullptr, "packetsOut, maxPackets and countOut are required");
+        std::shared_ptr<ReplaySession> session = sessions.Get(handle);
+
+        MusePacket packets[64];
+        int total = 0;
+        int64_t positionUs = 0;
+        uint64_t now = MonotonicNanoseconds();
+        while (total < maxPackets)
+        {
+            int count = session->Read(packets, std::min(maxPackets - total, 64), now, positionUs);
+            for (int i = 0; i < count; i++)
+            {
+                MwPacket& out = packetsOut[total + i];
+                out.packetType = static_cast<int32_t>(packets[i].type);
+                out.valueCount = packets[i].valueCount;
+                out.timestampUs = packets[i].timestampUs;
+                std::copy_n(packets[i].values, MaxPacketValues, out.values);
+            }
+            total += count;
+            if (count < 64)
+            {
+                break;
+            }
+        }
+        *countOut = total;
+        if (positionUsOut != nullptr)
+        {
+            *positionUsOut = positionUs;
+        }
+        return MW_OK;
+    });
+}
+
+int MwReplayGetStats(MwReplayStats* statsOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(statsOut != nullptr, "statsOut is required");
+        ReplayStats stats = Server().Stats();
+        statsOut->blockHits = static_cast<int64_t>(stats.blockHits);
+        statsOut->blockMisses = static_cast<int64_t>(stats.blockMisses);
+        statsOut->blocksPrefetched = static_cast<int64_t>(stats.blocksPrefetched);
+        statsOut->sessions = stats.sessions;
+        statsOut->recordings = stats.recordings;
+        return MW_OK;
+    });
+}
@@ -0,0 +1,320 @@
+// ReplayServer.cpp : Serves recorded brain data in step with spectators' VOD playback.
+#include "pch.h"
+#include "AllocationTracking.h"
+#include "Clock.h"
+#include "Profiler.h"
+#include "ReplayServer.h"
+#include "Tracing.h"
+
+namespace MuseWrapper
+{
+    ReplayRecording::ReplayRecording(const std::string& path, size_t cacheBlocks)
+        : reader(path), cacheBlocks(std::max<size_t>(cacheBlocks, 2))
+    {
+    }
+
+    std::shared_ptr<const ReplayRecording::Block> ReplayRecording::Lookup(size_t blockIndex)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = cache.find(blockIndex);
+        if (it == cache.end())
+        {
+            return nullptr;
+        }
+        recent.splice(recent.begin(), recent, it->second.second);
+        return it->second.first;
+    }
+
+    std::shared_ptr<const ReplayRecording::Block> ReplayRecording::Load(size_t blockIndex)
+    {
+        // Read outside the cache lock so sessions hitting other blocks are not held up by disk I/O
+        auto block = std::make_shared<Block>();
+        reader.ReadBlock(blockIndex, *block);
+
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = cache.find(blockIndex);
+        if (it != cache.end())
+        {
+            return it->second.first;
+        }
+        recent.push_front(blockIndex);
+        cache.emplace(blockIndex, std::make_pair(block, recent.begin()));
+        if (cache.size() > cacheBlocks)
+        {
+            cache.erase(recent.back());
+            recent.pop_back();
+        }
+        return block;
+    }
+
+    std::shared_ptr<const ReplayRecording::Block> ReplayRecording::GetBlock(size_t blockIndex)
+    {
+        if (auto block = Lookup(blockIndex))
+        {
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return block;
+        }
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return Load(blockIndex);
+    }
+
+    bool ReplayRecording::Prefetch(size_t blockIndex)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (cache.count(blockIndex) != 0)
+            {
+                return false;
+            }
+        }
+        Load(blockIndex);
+        return true;
+    }
+
+    ReplaySession::ReplaySession(std::shared_ptr<ReplayRecording> recording)
+        : recording(std::move(recording))
+    {
+    }
+
+    int64_t ReplaySession::PositionAt(uint64_t nowNs) const
+    {
+        if (paused || nowNs <= anchorNs)
+        {
+            return anchorPositionUs;
+        }
+        return anchorPositionUs + static_cast<int64_t>(static_cast<double>(nowNs - anchorNs) / 1000.0 * rate);
+    }
+
+    void ReplaySession::SetPlayback(int64_t positionUs, double playbackRate, bool isPaused, uint64_t nowNs)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        int64_t expected = PositionAt(nowNs);
+        if (positionUs < expected - SeekToleranceUs || positionUs > expected + SeekToleranceUs)
+        {
+            seekPending = true;
+        }
+        anchorPositionUs = positionUs;
+        anchorNs = nowNs;
+        rate = playbackRate;
+        paused = isPaused;
+    }
+
+    void ReplaySession::Locate(int64_t timestampUs)
+    {
+        RecordingReader& reader = recording->Reader();
+        blockIndex = reader.FindBlock(timestampUs);
+        packetIndex = 0;
+        block.reset();
+        if (blockIndex < reader.Blocks().size())
+        {
+            block = recording->GetBlock(blockIndex);
+            auto it = std::lower_bound(block->begin(), block->end(), timestampUs,
+                [](const StoredPacket& packet, int64_t value) { return packet.timestampUs < value; });
+            packetIndex = static_cast<size_t>(it - block->begin());
+        }
+    }
+
+    int ReplaySession::Read(MusePacket* packets, int maxPackets, uint64_t nowNs, int64_t& positionUs)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        positionUs = PositionAt(nowNs);
+        int64_t target = recording->Reader().SyncTimestampUs() + positionUs;
+        if (seekPending)
+        {
+            Locate(target - SeekPrimeUs);
+            seekPending = false;
+        }
+
+        size_t blockCount = recording->Reader().Blocks().size();
+        int count = 0;
+        while (count < maxPackets)
+        {
+            if (block == nullptr)
+            {
+                if (blockIndex >= blockCount)
+                {
+                    break;
+                }
+                block = recording->GetBlock(blockIndex);
+            }
+            if (packetIndex >= block->size())
+            {
+                blockIndex++;
+                packetIndex = 0;
+                block.reset();
+                continue;
+            }
+
+            const StoredPacket& stored = (*block)[packetIndex];
+            if (stored.timestampUs > target)
+            {
+                break;
+            }
+            MusePacket& packet = packets[count++];
+            packet.type = static_cast<MuseDataPacketType>(stored.type);
+            packet.valueCount = stored.valueCount;
+            packet.timestampUs = stored.timestampUs;
+            for (int i = 0; i < stored.valueCount; i++)
+            {
+                packet.values[i] = stored.values[i];
+            }
+            packetIndex++;
+        }
+        return count;
+    }
+
+    void ReplaySession::PrefetchWindow(int64_t aheadUs, uint64_t nowNs, int64_t& fromUs, int64_t& toUs)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        fromUs = recording->Reader().SyncTimestampUs() + PositionAt(nowNs) - (seekPending ? SeekPrimeUs : 0);
+        toUs = fromUs + static_cast<int64_t>(static_cast<double>(aheadUs) * std::max(rate, 1.0));
+    }
+
+    int64_t ReplaySession::DurationUs() const
+    {
+        const std::vector<RecordingBlock>& blocks = recording->Reader().Blocks();
+        return blocks.empty() ? 0 : blocks.back().lastTimestampUs - recording->Reader().SyncTimestampUs();
+    }
+
+    ReplayServer::ReplayServer(Options options)
+        : options(options)
+    {
+    }
+
+    ReplayServer::~ReplayServer()
+    {
+        std::lock_guard<std::mutex> guard(lifecycle);
+        Stop();
+    }
+
+    std::shared_ptr<ReplaySession> ReplayServer::OpenSession(const std::string& path)
+    {
+        std::lock_guard<std::mutex> life(lifecycle);
+        std::shared_ptr<ReplaySession> session;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            std::shared_ptr<ReplayRecording> recording = recordings[path].lock();
+            if (recording == nullptr)
+            {
+                recording = std::make_shared<ReplayRecording>(path, options.cacheBlocksPerRecording);
+                recordings[path] = recording;
+            }
+            session = std::make_shared<ReplaySession>(std::move(recording));
+            sessions.push_back(session);
+        }
+        if (!worker.joinable())
+        {
+            worker = std::thread(&ReplayServer::Run, this);
+        }
+        Notify();
+        return session;
+    }
+
+    void ReplayServer::CloseSession(const std::shared_ptr<ReplaySession>& session)
+    {
+        std::lock_guard<std::mutex> life(lifecycle);
+        bool idle;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            sessions.erase(std::remove(sessions.begin(), sessions.end(), session), sessions.end());
+            for (auto it = recordings.begin(); it != recordings.end();)
+            {
+                it = it->second.expired() ? recordings.erase(it) : std::next(it);
+            }
+            idle = sessions.empty();
+        }
+        if (idle)
+        {
+            Stop();
+        }
+    }
+
+    void ReplayServer::Stop()
+    {
+        if (!worker.joinable())
+        {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+        stopping = false;
+    }
+
+    void ReplayServer::Notify()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            notified = true;
+        }
+        wake.notify_one();
+    }
+
+    ReplayStats ReplayServer::Stats()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        ReplayStats stats = {};
+        stats.blocksPrefetched = blocksPrefetched.load(std::memory_order_relaxed);
+        stats.sessions = static_cast<int>(sessions.size());
+        for (auto& entry : recordings)
+        {
+            if (auto recording = entry.second.lock())
+            {
+                stats.recordings++;
+                stats.blockHits += recording->Hits();
+                stats.blockMisses += recording->Misses();
+            }
+        }
+        return stats;
+    }
+
+    void ReplayServer::Run()
+    {
+        MW_TRACE_THREAD_NAME("MuseWrapper replay prefetch");
+        Profiler::ThreadRegistration profiled("MuseWrapper replay prefetch");
+        std::vector<std::shared_ptr<ReplaySession>> snapshot;
+        std::unique_lock<std::mutex> guard(lock);
+        while (!stopping)
+        {
+            wake.wait_for(guard, std::chrono::milliseconds(options.prefetchIntervalMs), [&] { return stopping || notified; });
+            notified = false;
+            if (stopping)
+            {
+                break;
+            }
+            snapshot = sessions;
+            guard.unlock();
+            MW_TRACE_SCOPE("replay.prefetch");
+            MW_ALLOCATION_STAGE("replay.prefetch");
+
+            uint64_t now = MonotonicNanoseconds();
+            for (auto& session : snapshot)
+            {
+                int64_t from;
+                int64_t to;
+                session->PrefetchWindow(options.prefetchAheadUs, now, from, to);
+                ReplayRecording& recording = session->Recording();
+                const std::vector<RecordingBlock>& blocks = recording.Reader().Blocks();
+                try
+                {
+                    for (size_t i = recording.Reader().FindBlock(from); i < blocks.size() && blocks[i].firstTimestampUs <= to; i++)
+                    {
+                        if (recording.Prefetch(i))
+                        {
+                            blocksPrefetched.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+                }
+                catch (const std::exception&)
+                {
+                    // Read errors surface to the session when it reaches the block
+                }
+            }
+            snapshot.clear();
+            guard.lock();
+        }
+    }
+}
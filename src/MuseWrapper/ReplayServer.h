@@ -0,0 +1,155 @@
+#pragma once
+
+#include "SessionRecording.h"
+
+#include <condition_variable>
+#include <list>
+
+namespace MuseWrapper
+{
+    struct ReplayStats
+    {
+        uint64_t blockHits;
+        uint64_t blockMisses;
+        uint64_t blocksPrefetched;
+        int sessions;
+        int recordings;
+    };
+
+    /// <summary>
+    /// A recording opened for replay with an LRU cache of decoded blocks shared by every session watching it
+    /// </summary>
+    class ReplayRecording
+    {
+    public:
+        using Block = std::vector<StoredPacket>;
+
+        ReplayRecording(const std::string& path, size_t cacheBlocks);
+
+        RecordingReader& Reader() { return reader; }
+
+        /// <summary>
+        /// Returns the block, reading it synchronously on a cache miss
+        /// </summary>
+        std::shared_ptr<const Block> GetBlock(size_t blockIndex);
+
+        /// <summary>
+        /// Loads the block into the cache ahead of need; returns whether a read was performed
+        /// </summary>
+        bool Prefetch(size_t blockIndex);
+
+        uint64_t Hits() const { return hits.load(std::memory_order_relaxed); }
+        uint64_t Misses() const { return misses.load(std::memory_order_relaxed); }
+
+    private:
+        std::shared_ptr<const Block> Lookup(size_t blockIndex);
+        std::shared_ptr<const Block> Load(size_t blockIndex);
+
+        RecordingReader reader;
+        size_t cacheBlocks;
+        std::mutex lock;
+        std::list<size_t> recent;
+        std::unordered_map<size_t, std::pair<std::shared_ptr<const Block>, std::list<size_t>::iterator>> cache;
+        std::atomic<uint64_t> hits{ 0 };
+        std::atomic<uint64_t> misses{ 0 };
+    };
+
+    /// <summary>
+    /// One spectator's replay of a recording, following the position and rate of their VOD player.
+    /// Between SetPlayback calls the play head is extrapolated from the monotonic clock, so Read
+    /// delivers packets up to the current video frame without waiting for the next position report.
+    /// </summary>
+    class ReplaySession
+    {
+    public:
+        /// <summary>
+        /// Packets from this far before a seek target are re-delivered so meters and sparklines fill immediately
+        /// </summary>
+        static constexpr int64_t SeekPrimeUs = 1'000'000;
+
+        /// <summary>
+        /// Position reports within this distance of the extrapolated play head are treated as drift, not a seek
+        /// </summary>
+        static constexpr int64_t SeekToleranceUs = 250'000;
+
+        explicit ReplaySession(std::shared_ptr<ReplayRecording> recording);
+
+        void SetPlayback(int64_t positionUs, double rate, bool paused, uint64_t nowNs);
+
+        /// <summary>
+        /// Copies up to maxPackets packets between the last read and the play head; call again while it returns maxPackets
+        /// </summary>
+        int Read(MusePacket* packets, int maxPackets, uint64_t nowNs, int64_t& positionUs);
+
+        /// <summary>
+        /// Play-head window the prefetcher should keep cached, as absolute packet timestamps
+        /// </summary>
+        void PrefetchWindow(int64_t aheadUs, uint64_t nowNs, int64_t& fromUs, int64_t& toUs);
+
+        ReplayRecording& Recording() { return *recording; }
+        int64_t DurationUs() const;
+
+    private:
+        int64_t PositionAt(uint64_t nowNs) const;
+        void Locate(int64_t timestampUs);
+
+        std::shared_ptr<ReplayRecording> recording;
+        std::mutex lock;
+        int64_t anchorPositionUs = 0;
+        uint64_t anchorNs = 0;
+        double rate = 1.0;
+        bool paused = true;
+        bool seekPending = true;
+
+        size_t blockIndex = 0;
+        size_t packetIndex = 0;
+        std::shared_ptr<const ReplayRecording::Block> block;
+    };
+
+    /// <summary>
+    /// Serves many concurrent replay sessions from one process. Recordings are opened once and shared;
+    /// a background thread keeps the blocks ahead of every play head in cache so Read rarely touches disk.
+    /// The thread runs only while sessions exist.
+    /// </summary>
+    class ReplayServer
+    {
+    public:
+        struct Options
+        {
+            size_t cacheBlocksPerRecording = 256;
+            int64_t prefetchAheadUs = 4'000'000;
+            int prefetchIntervalMs = 20;
+        };
+
+        explicit ReplayServer(Options options);
+        ~ReplayServer();
+
+        std::shared_ptr<ReplaySession> OpenSession(const std::string& path);
+        void CloseSession(const std::shared_ptr<ReplaySession>& session);
+
+        /// <summary>
+        /// Wakes the prefetcher, e.g. after a seek moved a play head outside the cached range
+        /// </summary>
+        void Notify();
+
+        /// <summary>
+        /// Cache counters cover the recordings currently open
+        /// </summary>
+        ReplayStats Stats();
+
+    private:
+        void Run();
+        void Stop();
+
+        Options options;
+        std::mutex lifecycle;
+        std::mutex lock;
+        std::condition_variable wake;
+        std::thread worker;
+        bool stopping = false;
+        bool notified = false;
+        std::vector<std::shared_ptr<ReplaySession>> sessions;
+        std::unordered_map<std::string, std::weak_ptr<ReplayRecording>> recordings;
+        std::atomic<uint64_t> blocksPrefetched{ 0 };
+    };
+}
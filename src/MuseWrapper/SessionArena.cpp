@@ -0,0 +1,124 @@
+#include "pch.h"
+#include "SessionArena.h"
+#include "AllocationTracking.h"
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        constexpr size_t ChunkAlignment = 64;
+
+        // Size class of a request, or -1 for one served straight from the bump pointer
+        int ClassIndex(size_t bytes, size_t alignment)
+        {
+            if (bytes > SessionArena::MaxClassBytes || alignment > alignof(std::max_align_t))
+            {
+                return -1;
+            }
+            int index = 0;
+            size_t size = SessionArena::MinClassBytes;
+            while (size < bytes)
+            {
+                size <<= 1;
+                index++;
+            }
+            return index;
+        }
+
+        size_t ClassBytes(int index)
+        {
+            return SessionArena::MinClassBytes << index;
+        }
+    }
+
+    SessionArena::SessionArena(size_t chunkBytes)
+        : chunkBytes(std::max(chunkBytes, MaxClassBytes))
+    {
+    }
+
+    SessionArena::~SessionArena()
+    {
+        for (void* chunk : chunks)
+        {
+            ::operator delete(chunk, std::align_val_t(ChunkAlignment));
+        }
+    }
+
+    ArenaStats SessionArena::Stats() const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return stats;
+    }
+
+    void* SessionArena::do_allocate(size_t bytes, size_t alignment)
+    {
+        int index = ClassIndex(bytes, alignment);
+        size_t rounded = index >= 0 ? ClassBytes(index) : bytes;
+        void* memory;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (index >= 0 && freeLists[index] != nullptr)
+            {
+                FreeBlock* block = freeLists[index];
+                freeLists[index] = block->next;
+                memory = block;
+                stats.reused++;
+            }
+            else
+            {
+                memory = Carve(rounded, std::max(alignment, alignof(std::max_align_t)));
+            }
+            stats.allocations++;
+            stats.bytesInUse += rounded;
+            stats.peakBytesInUse = std::max(stats.peakBytesInUse, stats.bytesInUse);
+        }
+        MW_ALLOCATION_POOL_ALLOCATE(rounded);
+        return memory;
+    }
+
+    void SessionArena::do_deallocate(void* memory, size_t bytes, size_t alignment)
+    {
+        int index = ClassIndex(bytes, alignment);
+        size_t rounded = index >= 0 ? ClassBytes(index) : bytes;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            // Blocks above the largest class stay carved until the arena goes
+            if (index >= 0)
+            {
+                FreeBlock* block = static_cast<FreeBlock*>(memory);
+                block->next = freeLists[index];
+                freeLists[index] = block;
+            }
+            stats.bytesInUse -= rounded;
+        }
+        MW_ALLOCATION_POOL_FREE(rounded);
+    }
+
+    void* SessionArena::Carve(size_t bytes, size_t alignment)
+    {
+        if (alignment > ChunkAlignment)
+        {
+            throw std::bad_alloc();
+        }
+
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+        if (cursor != nullptr && aligned + bytes <= reinterpret_cast<uintptr_t>(limit))
+        {
+            cursor = reinterpret_cast<uint8_t*>(aligned + bytes);
+            return reinterpret_cast<void*>(aligned);
+        }
+
+        // A request bigger than a chunk gets a chunk of its own and leaves the current one open
+        size_t size = std::max(bytes, chunkBytes);
+        chunks.reserve(chunks.size() + 1);
+        uint8_t* chunk = static_cast<uint8_t*>(::operator new(size, std::align_val_t(ChunkAlignment)));
+        chunks.push_back(chunk);
+        stats.bytesReserved += size;
+        if (size == chunkBytes)
+        {
+            cursor = chunk + bytes;
+            limit = chunk + size;
+        }
+        return chunk;
+    }
+}
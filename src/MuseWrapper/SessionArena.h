@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory_resource>
+
+namespace MuseWrapper
+{
+    struct ArenaStats
+    {
+        uint64_t bytesReserved;     // chunk memory taken from the heap
+        uint64_t bytesInUse;        // handed out and not yet returned, rounded to size classes
+        uint64_t peakBytesInUse;
+        uint64_t allocations;
+        uint64_t reused;            // allocations served from a free list
+    };
+
+    /// <summary>
+    /// Memory for one device session: a monotonic arena of fixed-size chunks carved into power-of-two
+    /// size classes (16 bytes to 4 KB), with a free list per class so blocks freed mid-session are
+    /// reused by the next request of the same class instead of growing the arena. Larger requests are
+    /// bump-allocated and only come back with the arena. Nothing is returned to the heap until the
+    /// arena is destroyed, when every chunk is released at once, so an eight-hour stream's footprint
+    /// is set by its first minutes and sessions on other devices never share an allocator lock.
+    ///
+    /// It is a std::pmr::memory_resource so session containers can draw from it directly. The lock
+    /// only sees the session's own pipeline worker and the hub thread releasing its frames.
+    /// </summary>
+    class SessionArena : public std::pmr::memory_resource
+    {
+    public:
+        static constexpr size_t MinClassBytes = 16;
+        static constexpr size_t MaxClassBytes = 4096;
+        static constexpr size_t DefaultChunkBytes = 64 * 1024;
+
+        explicit SessionArena(size_t chunkBytes = DefaultChunkBytes);
+        ~SessionArena() override;
+
+        SessionArena(const SessionArena&) = delete;
+        SessionArena& operator=(const SessionArena&) = delete;
+
+        ArenaStats Stats() const;
+
+    private:
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        static constexpr int ClassCount = 9;    // 16, 32, ... 4096
+
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* memory, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+        void* Carve(size_t bytes, size_t alignment);
+
+        size_t chunkBytes;
+        mutable std::mutex lock;
+        std::vector<void*> chunks;
+        uint8_t* cursor = nullptr;
+        uint8_t* limit = nullptr;
+        std::array<FreeBlock*, ClassCount> freeLists = {};
+        ArenaStats stats = {};
+    };
+}
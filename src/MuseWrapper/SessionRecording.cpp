@@ -0,0 +1,289 @@
+// SessionRecording.cpp : Block-indexed brain-data recordings used for VOD replay.
+#include "pch.h"
+#include "SessionRecording.h"
+#include "AllocationTracking.h"
+#include "Tracing.h"
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        constexpr uint32_t RecordingMagic = 0x4352574D; // 'MWRC'
+        constexpr uint32_t RecordingVersion = 1;
+        constexpr uint32_t MaxBlockPackets = 1 << 20;   // far above what a writer uses; guards recovery of corrupt headers
+
+        struct FileHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            int64_t syncTimestampUs;
+            uint32_t blockPackets;
+            uint32_t reserved0;
+            int64_t reserved1;
+        };
+
+        struct FileFooter
+        {
+            int64_t indexOffset;
+            uint32_t blockCount;
+            uint32_t magic;
+        };
+
+        bool SeekTo(std::FILE* file, int64_t offset, int origin = SEEK_SET)
+        {
+#ifdef _WIN32
+            return _fseeki64(file, offset, origin) == 0;
+#else
+            return fseeko(file, static_cast<off_t>(offset), origin) == 0;
+#endif
+        }
+
+        int64_t Tell(std::FILE* file)
+        {
+#ifdef _WIN32
+            return _ftelli64(file);
+#else
+            return static_cast<int64_t>(ftello(file));
+#endif
+        }
+    }
+
+    RecordingWriter::RecordingWriter(const std::string& path, int64_t syncTimestampUs)
+    {
+        file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("Cannot open " + path + " for writing");
+        }
+        FileHeader header = { RecordingMagic, RecordingVersion, syncTimestampUs, BlockPackets, 0, 0 };
+        if (std::fwrite(&header, sizeof(header), 1, file) != 1)
+        {
+            std::fclose(file);
+            throw std::runtime_error("Failed to write recording header");
+        }
+        offset = sizeof(header);
+        block.reserve(BlockPackets);
+    }
+
+    RecordingWriter::~RecordingWriter()
+    {
+        if (file != nullptr)
+        {
+            try
+            {
+                Finish();
+            }
+            catch (const std::exception&)
+            {
+                // The recording stays readable through footer-less recovery
+            }
+        }
+    }
+
+    void RecordingWriter::AddPacket(const MusePacket& packet)
+    {
+        if (file == nullptr)
+        {
+            if (failed)
+            {
+                throw std::runtime_error("Recording stopped after a failed write");
+            }
+            throw std::logic_error("Recording already finished");
+        }
+        StoredPacket stored = {};
+        stored.type = static_cast<uint8_t>(packet.type);
+        stored.valueCount = static_cast<uint8_t>(std::clamp(packet.valueCount, 0, MaxPacketValues));
+        stored.timestampUs = packet.timestampUs;
+        for (int i = 0; i < stored.valueCount; i++)
+        {
+            stored.values[i] = static_cast<float>(packet.values[i]);
+        }
+        block.push_back(stored);
+        backlog.store(block.size(), std::memory_order_relaxed);
+        if (block.size() >= BlockPackets)
+        {
+            FlushBlock();
+        }
+    }
+
+    void RecordingWriter::FlushBlock()
+    {
+        if (block.empty())
+        {
+            return;
+        }
+        MW_TRACE_SCOPE("recording.flush_block");
+        MW_ALLOCATION_STAGE("recording.flush_block");
+
+        // Packet types are timestamped independently by libmuse and arrive slightly out of order;
+        // sort within the block and pull stragglers from before the previous block up to its end.
+        // Insertion sort is stable, linear on a nearly sorted block and, unlike std::stable_sort,
+        // needs no temporary buffer on every flush.
+        for (size_t i = 1; i < block.size(); i++)
+        {
+            StoredPacket packet = block[i];
+            size_t j = i;
+            while (j > 0 && block[j - 1].timestampUs > packet.timestampUs)
+            {
+                block[j] = block[j - 1];
+                j--;
+            }
+            block[j] = packet;
+        }
+        for (StoredPacket& packet : block)
+        {
+            packet.timestampUs = std::max(packet.timestampUs, lastTimestampUs);
+        }
+        lastTimestampUs = block.back().timestampUs;
+
+        if (std::fwrite(block.data(), sizeof(StoredPacket), block.size(), file) != block.size())
+        {
+            // Retrying would grow the block without bound on a full disk, so the recording stops here
+            std::fclose(file);
+            file = nullptr;
+            failed = true;
+            block.clear();
+            backlog.store(0, std::memory_order_relaxed);
+            throw std::runtime_error("Failed to write recording block");
+        }
+        index.push_back({ block.front().timestampUs, block.back().timestampUs, offset, static_cast<uint32_t>(block.size()), 0 });
+        offset += static_cast<int64_t>(block.size() * sizeof(StoredPacket));
+        packetsWritten.fetch_add(block.size(), std::memory_order_relaxed);
+        block.clear();
+        backlog.store(0, std::memory_order_relaxed);
+    }
+
+    void RecordingWriter::Finish()
+    {
+        if (file == nullptr)
+        {
+            if (failed)
+            {
+                throw std::runtime_error("Recording stopped after a failed write");
+            }
+            return;
+        }
+        FlushBlock();
+        FileFooter footer = { offset, static_cast<uint32_t>(index.size()), RecordingMagic };
+        bool ok = (index.empty() || std::fwrite(index.data(), sizeof(RecordingBlock), index.size(), file) == index.size())
+            && std::fwrite(&footer, sizeof(footer), 1, file) == 1;
+        ok = std::fclose(file) == 0 && ok;
+        file = nullptr;
+        if (!ok)
+        {
+            throw std::runtime_error("Failed to write recording index");
+        }
+    }
+
+    RecordingReader::RecordingReader(const std::string& path)
+    {
+        file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("Cannot open recording " + path);
+        }
+
+        try
+        {
+            FileHeader header;
+            if (std::fread(&header, sizeof(header), 1, file) != 1 || header.magic != RecordingMagic || header.version != RecordingVersion)
+            {
+                throw std::runtime_error(path + " is not a brain-data recording");
+            }
+            if (header.blockPackets == 0 || header.blockPackets > MaxBlockPackets)
+            {
+                throw std::runtime_error(path + " has a corrupt header (block size " + std::to_string(header.blockPackets) + ")");
+            }
+            syncTimestampUs = header.syncTimestampUs;
+
+            FileFooter footer = {};
+            SeekTo(file, 0, SEEK_END);
+            int64_t size = Tell(file);
+            bool indexed = size >= static_cast<int64_t>(sizeof(header) + sizeof(footer))
+                && SeekTo(file, size - static_cast<int64_t>(sizeof(footer)))
+                && std::fread(&footer, sizeof(footer), 1, file) == 1
+                && footer.magic == RecordingMagic
+                && footer.indexOffset >= static_cast<int64_t>(sizeof(header))
+                && footer.indexOffset + static_cast<int64_t>(footer.blockCount * sizeof(RecordingBlock) + sizeof(footer)) == size;
+
+            if (indexed)
+            {
+                blocks.resize(footer.blockCount);
+                SeekTo(file, footer.indexOffset);
+                if (!blocks.empty() && std::fread(blocks.data(), sizeof(RecordingBlock), blocks.size(), file) != blocks.size())
+                {
+                    throw std::runtime_error("Failed to read recording index of " + path);
+                }
+                // Blocks must lie between the header and the index, and FindBlock's search needs them in time order
+                int64_t previousUs = INT64_MIN;
+                for (const RecordingBlock& block : blocks)
+                {
+                    if (block.packetCount == 0 || block.packetCount > header.blockPackets
+                        || block.offset < static_cast<int64_t>(sizeof(header))
+                        || block.offset + static_cast<int64_t>(block.packetCount * sizeof(StoredPacket)) > footer.indexOffset
+                        || block.firstTimestampUs < previousUs || block.lastTimestampUs < block.firstTimestampUs)
+                    {
+                        throw std::runtime_error(path + " has a corrupt index (block " + std::to_string(&block - blocks.data()) + ")");
+                    }
+                    previousUs = block.lastTimestampUs;
+                }
+                return;
+            }
+
+            // Unfinished recording: every whole record after the header is data, in blocks of blockPackets
+            int64_t packetCount = (size - static_cast<int64_t>(sizeof(header))) / static_cast<int64_t>(sizeof(StoredPacket));
+            std::vector<StoredPacket> packets;
+            for (int64_t first = 0; first < packetCount; first += header.blockPackets)
+            {
+                RecordingBlock block = {};
+                block.offset = static_cast<int64_t>(sizeof(header)) + first * static_cast<int64_t>(sizeof(StoredPacket));
+                block.packetCount = static_cast<uint32_t>(std::min<int64_t>(header.blockPackets, packetCount - first));
+                blocks.push_back(block);
+                ReadBlock(blocks.size() - 1, packets);
+                blocks.back().firstTimestampUs = packets.front().timestampUs;
+                blocks.back().lastTimestampUs = packets.back().timestampUs;
+                if (blocks.back().lastTimestampUs < blocks.back().firstTimestampUs
+                    || (blocks.size() > 1 && blocks.back().firstTimestampUs < blocks[blocks.size() - 2].lastTimestampUs))
+                {
+                    throw std::runtime_error(path + " has out-of-order blocks");
+                }
+            }
+        }
+        catch (...)
+        {
+            std::fclose(file);
+            throw;
+        }
+    }
+
+    RecordingReader::~RecordingReader()
+    {
+        std::fclose(file);
+    }
+
+    size_t RecordingReader::FindBlock(int64_t timestampUs) const
+    {
+        auto it = std::lower_bound(blocks.begin(), blocks.end(), timestampUs,
+            [](const RecordingBlock& block, int64_t value) { return block.lastTimestampUs < value; });
+        return static_cast<size_t>(it - blocks.begin());
+    }
+
+    void RecordingReader::ReadBlock(size_t blockIndex, std::vector<StoredPacket>& packets)
+    {
+        const RecordingBlock& block = blocks.at(blockIndex);
+        packets.resize(block.packetCount);
+        std::lock_guard<std::mutex> guard(lock);
+        if (!SeekTo(file, block.offset) || std::fread(packets.data(), sizeof(StoredPacket), packets.size(), file) != packets.size())
+        {
+            throw std::runtime_error("Failed to read recording block " + std::to_string(blockIndex));
+        }
+        // Readers copy values into fixed arrays of MaxPacketValues and index per-type tables by type
+        for (const StoredPacket& packet : packets)
+        {
+            if (packet.valueCount > MaxPacketValues || packet.type >= PacketTypeCount)
+            {
+                throw std::runtime_error("Recording block " + std::to_string(blockIndex) + " has a corrupt packet");
+            }
+        }
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "MuseTypes.h"
+
+#include <cstdio>
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// On-disk packet layout of a session recording: fixed 48-byte records so a block can be read with one fread
+    /// </summary>
+    struct StoredPacket
+    {
+        uint8_t type;
+        uint8_t valueCount;
+        uint16_t reserved0;
+        uint32_t reserved1;
+        int64_t timestampUs;
+        float values[MaxPacketValues];
+    };
+
+    static_assert(sizeof(StoredPacket) == 48, "StoredPacket layout is part of the recording format");
+
+    /// <summary>
+    /// Time range and file location of one block of a recording
+    /// </summary>
+    struct RecordingBlock
+    {
+        int64_t firstTimestampUs;
+        int64_t lastTimestampUs;
+        int64_t offset;
+        uint32_t packetCount;
+        uint32_t reserved;
+    };
+
+    /// <summary>
+    /// Writes a session recording (.mwrec): a header, blocks of timestamp-ordered packets, then a block index
+    /// and footer so readers can seek without scanning. syncTimestampUs is the packet timestamp that
+    /// coincides with position zero of the stream's video, as for the timed-metadata muxer.
+    /// </summary>
+    class RecordingWriter
+    {
+    public:
+        static constexpr uint32_t BlockPackets = 1024;
+
+        RecordingWriter(const std::string& path, int64_t syncTimestampUs);
+        ~RecordingWriter();
+
+        RecordingWriter(const RecordingWriter&) = delete;
+        RecordingWriter& operator=(const RecordingWriter&) = delete;
+
+        /// <summary>
+        /// Buffers a packet, writing the block once full; throws once a write has failed, since the
+        /// file then ends at the last whole block and only footer-less recovery can read it
+        /// </summary>
+        void AddPacket(const MusePacket& packet);
+
+        /// <summary>
+        /// Flushes the last block, writes the index and closes the file
+        /// </summary>
+        void Finish();
+
+        uint64_t PacketsWritten() const { return packetsWritten.load(std::memory_order_relaxed); }
+
+        /// <summary>
+        /// Packets buffered in the current block and not yet written to the file
+        /// </summary>
+        uint64_t Backlog() const { return backlog.load(std::memory_order_relaxed); }
+
+    private:
+        void FlushBlock();
+
+        std::FILE* file = nullptr;
+        bool failed = false;            // a write failed and the file was closed; packets are refused from then on
+        std::vector<StoredPacket> block;
+        std::vector<RecordingBlock> index;
+        int64_t offset = 0;
+        int64_t lastTimestampUs = INT64_MIN;
+        std::atomic<uint64_t> packetsWritten{ 0 };
+        std::atomic<uint64_t> backlog{ 0 };
+    };
+
+    /// <summary>
+    /// Random access to a finished recording. A recording that was never finished (no footer) is
+    /// recovered by indexing every whole block after the header. The index is checked against the file
+    /// on opening, so a corrupt one is refused rather than trusted. Reads are serialised internally.
+    /// </summary>
+    class RecordingReader
+    {
+    public:
+        explicit RecordingReader(const std::string& path);
+        ~RecordingReader();
+
+        RecordingReader(const RecordingReader&) = delete;
+        RecordingReader& operator=(const RecordingReader&) = delete;
+
+        int64_t SyncTimestampUs() const { return syncTimestampUs; }
+        const std::vector<RecordingBlock>& Blocks() const { return blocks; }
+
+        /// <summary>
+        /// Index of the first block whose last packet is at or after timestampUs (Blocks().size() if none)
+        /// </summary>
+        size_t FindBlock(int64_t timestampUs) const;
+
+        /// <summary>
+        /// Reads one block; throws if a packet has more than MaxPacketValues values or an unknown type,
+        /// so callers can copy values into fixed arrays without checking
+        /// </summary>
+        void ReadBlock(size_t blockIndex, std::vector<StoredPacket>& packets);
+
+    private:
+        std::mutex lock;
+        std::FILE* file = nullptr;
+        int64_t syncTimestampUs = 0;
+        std::vector<RecordingBlock> blocks;
+    };
+}
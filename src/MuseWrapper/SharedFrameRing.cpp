@@ -0,0 +1,156 @@
+#include "pch.h"
+#include "SharedFrameRing.h"
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        constexpr size_t CacheLine = 64;
+        constexpr int ReadAttempts = 4;
+
+        size_t AlignUp(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+    }
+
+    SharedFrameRing::SharedFrameRing(std::unique_ptr<SharedMemory> memory, const Geometry& geometry)
+        : memory(std::move(memory)),
+          header(reinterpret_cast<FrameRingHeader*>(this->memory->Data())),
+          geometry(geometry)
+    {
+    }
+
+    std::unique_ptr<SharedFrameRing> SharedFrameRing::Create(const std::string& name, int width, int height, int slotCount)
+    {
+        if (width <= 0 || height <= 0 || slotCount < 2)
+        {
+            throw std::invalid_argument("Frame ring needs a positive size and at least two slots");
+        }
+
+        size_t stride = static_cast<size_t>(width) * FrameBuffer::BytesPerPixel;
+        Geometry geometry = {};
+        geometry.width = static_cast<uint32_t>(width);
+        geometry.height = static_cast<uint32_t>(height);
+        geometry.stride = static_cast<uint32_t>(stride);
+        geometry.slotCount = static_cast<uint32_t>(slotCount);
+        geometry.headerBytes = AlignUp(sizeof(FrameRingHeader), CacheLine);
+        geometry.slotBytes = AlignUp(sizeof(FrameSlotHeader), CacheLine) + AlignUp(stride * height, CacheLine);
+        auto memory = SharedMemory::Create(name, geometry.headerBytes + geometry.slotBytes * slotCount);
+
+        std::unique_ptr<SharedFrameRing> ring(new SharedFrameRing(std::move(memory), geometry));
+        FrameRingHeader* header = ring->header;
+        header->magic = Magic;
+        header->version = Version;
+        header->width = geometry.width;
+        header->height = geometry.height;
+        header->stride = geometry.stride;
+        header->slotCount = geometry.slotCount;
+        header->headerBytes = geometry.headerBytes;
+        header->slotBytes = geometry.slotBytes;
+        new (&header->latestSequence) std::atomic<uint64_t>(0);
+        for (int i = 0; i < slotCount; i++)
+        {
+            FrameSlotHeader* slot = ring->Slot(i);
+            new (&slot->lock) std::atomic<uint64_t>(0);
+            slot->sequence = 0;
+            slot->timestampNs = 0;
+        }
+        return ring;
+    }
+
+    std::unique_ptr<SharedFrameRing> SharedFrameRing::Open(const std::string& name)
+    {
+        auto memory = SharedMemory::Open(name);
+        if (memory->Size() < sizeof(FrameRingHeader))
+        {
+            throw std::runtime_error("Shared segment " + name + " is too small for a frame ring");
+        }
+
+        // Read once: the header is writable by every process that maps the segment
+        const FrameRingHeader* header = reinterpret_cast<const FrameRingHeader*>(memory->Data());
+        if (header->magic != Magic || header->version != Version)
+        {
+            throw std::runtime_error("Shared segment " + name + " is not a compatible frame ring");
+        }
+        Geometry geometry = { header->width, header->height, header->stride, header->slotCount, header->headerBytes, header->slotBytes };
+
+        // Slots hold atomics, so they must stay 8-byte aligned. The frame size is a product of 32-bit
+        // fields and the slot area is compared by division, so neither can overflow.
+        uint64_t size = memory->Size();
+        uint64_t frameBytes = uint64_t{ geometry.stride } * geometry.height;
+        if (geometry.slotCount == 0 || geometry.width == 0 || geometry.height == 0
+            || geometry.stride > static_cast<uint32_t>(std::numeric_limits<int>::max())
+            || geometry.height > static_cast<uint32_t>(std::numeric_limits<int>::max())
+            || geometry.stride < uint64_t{ geometry.width } * FrameBuffer::BytesPerPixel
+            || geometry.headerBytes < sizeof(FrameRingHeader) || geometry.headerBytes % alignof(FrameSlotHeader) != 0
+            || geometry.slotBytes % alignof(FrameSlotHeader) != 0 || geometry.slotBytes < frameBytes + sizeof(FrameSlotHeader))
+        {
+            throw std::runtime_error("Shared segment " + name + " has a corrupt frame ring header");
+        }
+        if (geometry.headerBytes > size || (size - geometry.headerBytes) / geometry.slotCount < geometry.slotBytes)
+        {
+            throw std::runtime_error("Shared segment " + name + " is truncated");
+        }
+        return std::unique_ptr<SharedFrameRing>(new SharedFrameRing(std::move(memory), geometry));
+    }
+
+    FrameSlotHeader* SharedFrameRing::Slot(uint64_t sequence) const
+    {
+        size_t index = static_cast<size_t>(sequence % geometry.slotCount);
+        return reinterpret_cast<FrameSlotHeader*>(memory->Data() + geometry.headerBytes + index * geometry.slotBytes);
+    }
+
+    FrameBuffer SharedFrameRing::BeginWrite()
+    {
+        writeSequence = header->latestSequence.load(std::memory_order_relaxed) + 1;
+        FrameSlotHeader* slot = Slot(writeSequence);
+        slot->lock.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return FrameBuffer(SlotPixels(slot), Width(), Height(), static_cast<int>(geometry.stride));
+    }
+
+    void SharedFrameRing::EndWrite(uint64_t timestampNs)
+    {
+        FrameSlotHeader* slot = Slot(writeSequence);
+        slot->sequence = writeSequence;
+        slot->timestampNs = timestampNs;
+        slot->lock.fetch_add(1, std::memory_order_release);
+        header->latestSequence.store(writeSequence, std::memory_order_release);
+    }
+
+    bool SharedFrameRing::ReadLatest(uint8_t* pixelsOut, size_t pixelsLen, uint64_t& sequenceOut, uint64_t& timestampOut) const
+    {
+        if (pixelsLen < FrameBytes())
+        {
+            throw std::invalid_argument("Pixel buffer is smaller than one frame");
+        }
+
+        for (int attempt = 0; attempt < ReadAttempts; attempt++)
+        {
+            uint64_t latest = header->latestSequence.load(std::memory_order_acquire);
+            if (latest == 0)
+            {
+                return false;
+            }
+
+            FrameSlotHeader* slot = Slot(latest);
+            uint64_t before = slot->lock.load(std::memory_order_acquire);
+            if ((before & 1) != 0)
+            {
+                continue;
+            }
+            uint64_t sequence = slot->sequence;
+            uint64_t timestamp = slot->timestampNs;
+            std::memcpy(pixelsOut, SlotPixels(slot), FrameBytes());
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot->lock.load(std::memory_order_relaxed) == before && sequence == latest)
+            {
+                sequenceOut = sequence;
+                timestampOut = timestamp;
+                return true;
+            }
+        }
+        return false;
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "FrameBuffer.h"
+#include "SharedMemory.h"
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Layout at the start of the shared segment. Capture plugins map the segment and read it directly:
+    /// slot i starts at headerBytes + i * slotBytes with a FrameSlotHeader followed by height * stride
+    /// bytes of premultiplied BGRA8.
+    /// </summary>
+    struct FrameRingHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t stride;
+        uint32_t slotCount;
+        uint64_t headerBytes;
+        uint64_t slotBytes;
+        std::atomic<uint64_t> latestSequence;   // 0 until the first frame is published
+    };
+
+    /// <summary>
+    /// Per-slot seqlock: 'lock' is odd while the writer is filling the slot
+    /// </summary>
+    struct FrameSlotHeader
+    {
+        std::atomic<uint64_t> lock;
+        uint64_t sequence;
+        uint64_t timestampNs;
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared frame ring requires lock-free 64-bit atomics");
+
+    /// <summary>
+    /// Single-writer, many-reader ring of video frames in shared memory. The writer renders straight
+    /// into the slot (no copy) and readers never block it; a reader that is lapped simply retries.
+    /// The segment's geometry is checked once when it is opened and kept privately, since any process
+    /// mapping the segment can rewrite the shared header afterwards.
+    /// </summary>
+    class SharedFrameRing
+    {
+    public:
+        static constexpr uint32_t Magic = 0x5246574D; // "MWFR"
+        static constexpr uint32_t Version = 1;
+
+        static std::unique_ptr<SharedFrameRing> Create(const std::string& name, int width, int height, int slotCount);
+        static std::unique_ptr<SharedFrameRing> Open(const std::string& name);
+
+        int Width() const { return static_cast<int>(geometry.width); }
+        int Height() const { return static_cast<int>(geometry.height); }
+        size_t FrameBytes() const { return static_cast<size_t>(geometry.stride) * geometry.height; }
+
+        /// <summary>
+        /// Returns a view over the next slot and marks it as being written
+        /// </summary>
+        FrameBuffer BeginWrite();
+
+        /// <summary>
+        /// Publishes the slot returned by BeginWrite as the latest frame
+        /// </summary>
+        void EndWrite(uint64_t timestampNs);
+
+        /// <summary>
+        /// Copies the most recent complete frame; returns false if nothing has been published yet
+        /// </summary>
+        bool ReadLatest(uint8_t* pixelsOut, size_t pixelsLen, uint64_t& sequenceOut, uint64_t& timestampOut) const;
+
+    private:
+        // The layout fields of FrameRingHeader
+        struct Geometry
+        {
+            uint32_t width;
+            uint32_t height;
+            uint32_t stride;
+            uint32_t slotCount;
+            uint64_t headerBytes;
+            uint64_t slotBytes;
+        };
+
+        SharedFrameRing(std::unique_ptr<SharedMemory> memory, const Geometry& geometry);
+
+        FrameSlotHeader* Slot(uint64_t sequence) const;
+        uint8_t* SlotPixels(FrameSlotHeader* slot) const { return reinterpret_cast<uint8_t*>(slot) + sizeof(FrameSlotHeader); }
+
+        std::unique_ptr<SharedMemory> memory;
+        FrameRingHeader* header;
+        Geometry geometry;
+        uint64_t writeSequence = 0;
+    };
+}
@@ -0,0 +1,124 @@
+#include "pch.h"
+#include "SharedMemory.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        std::string PlatformName(const std::string& name)
+        {
+#ifdef _WIN32
+            // Session-local namespace so no SeCreateGlobalPrivilege is needed
+            return name.find('\\') == std::string::npos ? "Local\\" + name : name;
+#else
+            return name.empty() || name[0] != '/' ? "/" + name : name;
+#endif
+        }
+    }
+
+    std::unique_ptr<SharedMemory> SharedMemory::Create(const std::string& name, size_t size)
+    {
+        std::unique_ptr<SharedMemory> memory(new SharedMemory());
+        memory->name = PlatformName(name);
+        memory->size = size;
+        memory->owner = true;
+
+#ifdef _WIN32
+        uint64_t size64 = size;
+        memory->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64 & 0xFFFFFFFF), memory->name.c_str());
+        if (memory->mapping == nullptr)
+        {
+            throw std::runtime_error("CreateFileMapping failed for " + memory->name);
+        }
+        memory->data = static_cast<uint8_t*>(MapViewOfFile(memory->mapping, FILE_MAP_ALL_ACCESS, 0, 0, size));
+#else
+        int fd = shm_open(memory->name.c_str(), O_CREAT | O_RDWR, 0600);
+        if (fd < 0)
+        {
+            throw std::runtime_error("shm_open failed for " + memory->name);
+        }
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            close(fd);
+            throw std::runtime_error("ftruncate failed for " + memory->name);
+        }
+        void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        memory->data = mapped == MAP_FAILED ? nullptr : static_cast<uint8_t*>(mapped);
+#endif
+        if (memory->data == nullptr)
+        {
+            throw std::runtime_error("Failed to map shared memory " + memory->name);
+        }
+        return memory;
+    }
+
+    std::unique_ptr<SharedMemory> SharedMemory::Open(const std::string& name)
+    {
+        std::unique_ptr<SharedMemory> memory(new SharedMemory());
+        memory->name = PlatformName(name);
+
+#ifdef _WIN32
+        memory->mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, memory->name.c_str());
+        if (memory->mapping == nullptr)
+        {
+            throw std::runtime_error("Shared memory " + memory->name + " does not exist");
+        }
+        memory->data = static_cast<uint8_t*>(MapViewOfFile(memory->mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+        if (memory->data != nullptr)
+        {
+            MEMORY_BASIC_INFORMATION info = {};
+            VirtualQuery(memory->data, &info, sizeof(info));
+            memory->size = info.RegionSize;
+        }
+#else
+        int fd = shm_open(memory->name.c_str(), O_RDWR, 0600);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Shared memory " + memory->name + " does not exist");
+        }
+        struct stat info = {};
+        fstat(fd, &info);
+        memory->size = static_cast<size_t>(info.st_size);
+        void* mapped = memory->size > 0 ? mmap(nullptr, memory->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        close(fd);
+        memory->data = mapped == MAP_FAILED ? nullptr : static_cast<uint8_t*>(mapped);
+#endif
+        if (memory->data == nullptr)
+        {
+            throw std::runtime_error("Failed to map shared memory " + memory->name);
+        }
+        return memory;
+    }
+
+    SharedMemory::~SharedMemory()
+    {
+#ifdef _WIN32
+        if (data != nullptr)
+        {
+            UnmapViewOfFile(data);
+        }
+        if (mapping != nullptr)
+        {
+            CloseHandle(mapping);
+        }
+#else
+        if (data != nullptr)
+        {
+            munmap(data, size);
+        }
+        if (owner)
+        {
+            shm_unlink(name.c_str());
+        }
+#endif
+    }
+}
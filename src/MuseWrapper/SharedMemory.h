@@ -0,0 +1,40 @@
+#pragma once
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Named shared-memory mapping readable by other processes (file mapping on Windows, shm_open elsewhere)
+    /// </summary>
+    class SharedMemory
+    {
+    public:
+        /// <summary>
+        /// Creates (or truncates) a named segment of the given size and maps it read/write
+        /// </summary>
+        static std::unique_ptr<SharedMemory> Create(const std::string& name, size_t size);
+
+        /// <summary>
+        /// Maps an existing named segment created by another component or process
+        /// </summary>
+        static std::unique_ptr<SharedMemory> Open(const std::string& name);
+
+        ~SharedMemory();
+
+        SharedMemory(const SharedMemory&) = delete;
+        SharedMemory& operator=(const SharedMemory&) = delete;
+
+        uint8_t* Data() const { return data; }
+        size_t Size() const { return size; }
+
+    private:
+        SharedMemory() = default;
+
+        uint8_t* data = nullptr;
+        size_t size = 0;
+        bool owner = false;
+        std::string name;
+#ifdef _WIN32
+        HANDLE mapping = nullptr;
+#endif
+    };
+}
@@ -0,0 +1,221 @@
+#include "pch.h"
+#include "Socket.h"
+
+#ifdef _WIN32
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace MuseWrapper
+{
+    namespace Sockets
+    {
+        namespace
+        {
+            constexpr int MaxSlices = 64;
+
+            bool LastErrorWouldBlock()
+            {
+#ifdef _WIN32
+                return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+            }
+
+            void SetNoDelay(SocketHandle socket)
+            {
+                int enable = 1;
+                setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&enable), sizeof(enable));
+            }
+        }
+
+        void Initialize()
+        {
+#ifdef _WIN32
+            static std::once_flag once;
+            std::call_once(once, []
+            {
+                WSADATA data;
+                if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+                {
+                    throw std::runtime_error("WSAStartup failed");
+                }
+            });
+#endif
+        }
+
+        SocketHandle Listen(uint16_t port, bool loopbackOnly, uint16_t& boundPort)
+        {
+            Initialize();
+            SocketHandle listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            if (listener == InvalidSocket)
+            {
+                throw std::runtime_error("Failed to create listening socket");
+            }
+
+            int reuse = 1;
+            setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+            sockaddr_in address = {};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(port);
+            address.sin_addr.s_addr = htonl(loopbackOnly ? INADDR_LOOPBACK : INADDR_ANY);
+            if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0)
+            {
+                Close(listener);
+                throw std::runtime_error("Failed to listen on port " + std::to_string(port));
+            }
+
+            socklen_t length = sizeof(address);
+            getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+            boundPort = ntohs(address.sin_port);
+            SetNonBlocking(listener);
+            return listener;
+        }
+
+        SocketHandle Accept(SocketHandle listener)
+        {
+            SocketHandle client = accept(listener, nullptr, nullptr);
+            if (client == InvalidSocket)
+            {
+                return InvalidSocket;
+            }
+            SetNonBlocking(client);
+            SetNoDelay(client);
+            return client;
+        }
+
+        SocketHandle Connect(const char* host, uint16_t port)
+        {
+            Initialize();
+            addrinfo hints = {};
+            hints.ai_family = AF_INET;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo* result = nullptr;
+            if (getaddrinfo(host, std::to_string(port).c_str(), &hints, &result) != 0 || result == nullptr)
+            {
+                throw std::runtime_error(std::string("Cannot resolve ") + host);
+            }
+
+            SocketHandle client = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+            bool connected = client != InvalidSocket
+                && connect(client, result->ai_addr, static_cast<socklen_t>(result->ai_addrlen)) == 0;
+            freeaddrinfo(result);
+            if (!connected)
+            {
+                if (client != InvalidSocket)
+                {
+                    Close(client);
+                }
+                throw std::runtime_error(std::string("Cannot connect to ") + host + ":" + std::to_string(port));
+            }
+            SetNonBlocking(client);
+            SetNoDelay(client);
+            return client;
+        }
+
+        void CreatePair(SocketHandle& first, SocketHandle& second)
+        {
+            uint16_t port = 0;
+            SocketHandle listener = Listen(0, true, port);
+            first = Connect("127.0.0.1", port);
+            second = InvalidSocket;
+            for (int attempt = 0; attempt < 1000 && second == InvalidSocket; attempt++)
+            {
+                second = Accept(listener);
+                if (second == InvalidSocket)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+            Close(listener);
+            if (second == InvalidSocket)
+            {
+                Close(first);
+                throw std::runtime_error("Failed to create loopback socket pair");
+            }
+        }
+
+        void SetNonBlocking(SocketHandle socket)
+        {
+#ifdef _WIN32
+            u_long enable = 1;
+            ioctlsocket(socket, FIONBIO, &enable);
+#else
+            fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+        }
+
+        void Close(SocketHandle socket)
+        {
+#ifdef _WIN32
+            closesocket(socket);
+#else
+            close(socket);
+#endif
+        }
+
+        intptr_t Send(SocketHandle socket, const IoSlice* slices, int count)
+        {
+            count = std::min(count, MaxSlices);
+#ifdef _WIN32
+            WSABUF buffers[MaxSlices];
+            for (int i = 0; i < count; i++)
+            {
+                buffers[i].buf = static_cast<CHAR*>(const_cast<void*>(slices[i].data));
+                buffers[i].len = static_cast<ULONG>(slices[i].length);
+            }
+            DWORD sent = 0;
+            if (WSASend(socket, buffers, static_cast<DWORD>(count), &sent, 0, nullptr, nullptr) != 0)
+            {
+                return LastErrorWouldBlock() ? 0 : -1;
+            }
+            return static_cast<intptr_t>(sent);
+#else
+            iovec vectors[MaxSlices];
+            for (int i = 0; i < count; i++)
+            {
+                vectors[i].iov_base = const_cast<void*>(slices[i].data);
+                vectors[i].iov_len = slices[i].length;
+            }
+            msghdr message = {};
+            message.msg_iov = vectors;
+            message.msg_iovlen = static_cast<size_t>(count);
+            ssize_t sent = sendmsg(socket, &message, MSG_NOSIGNAL);
+            if (sent < 0)
+            {
+                return LastErrorWouldBlock() ? 0 : -1;
+            }
+            return sent;
+#endif
+        }
+
+        intptr_t Receive(SocketHandle socket, void* buffer, size_t length)
+        {
+#ifdef _WIN32
+            int received = recv(socket, static_cast<char*>(buffer), static_cast<int>(length), 0);
+#else
+            ssize_t received = recv(socket, buffer, length, 0);
+#endif
+            if (received > 0)
+            {
+                return received;
+            }
+            if (received < 0 && LastErrorWouldBlock())
+            {
+                return 0;
+            }
+            return -1;
+        }
+    }
+}
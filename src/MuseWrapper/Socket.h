@@ -0,0 +1,70 @@
+#pragma once
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif
+
+namespace MuseWrapper
+{
+#ifdef _WIN32
+    using SocketHandle = SOCKET;
+    constexpr SocketHandle InvalidSocket = INVALID_SOCKET;
+#else
+    using SocketHandle = int;
+    constexpr SocketHandle InvalidSocket = -1;
+#endif
+
+    /// <summary>
+    /// One buffer of a gathered send (writev / WSASend)
+    /// </summary>
+    struct IoSlice
+    {
+        const void* data;
+        size_t length;
+    };
+
+    /// <summary>
+    /// Thin portable layer over BSD sockets and Winsock; all sockets it returns are non-blocking
+    /// </summary>
+    namespace Sockets
+    {
+        /// <summary>
+        /// Starts Winsock once per process; no-op elsewhere
+        /// </summary>
+        void Initialize();
+
+        /// <summary>
+        /// Listens on the given TCP port (0 picks an ephemeral port) and reports the bound port
+        /// </summary>
+        SocketHandle Listen(uint16_t port, bool loopbackOnly, uint16_t& boundPort);
+
+        /// <summary>
+        /// Accepts one pending connection, or returns InvalidSocket when none is waiting
+        /// </summary>
+        SocketHandle Accept(SocketHandle listener);
+
+        /// <summary>
+        /// Connects (blocking) to host:port and then switches the socket to non-blocking
+        /// </summary>
+        SocketHandle Connect(const char* host, uint16_t port);
+
+        /// <summary>
+        /// Creates a connected loopback pair, used to wake a poller from another thread
+        /// </summary>
+        void CreatePair(SocketHandle& first, SocketHandle& second);
+
+        void SetNonBlocking(SocketHandle socket);
+        void Close(SocketHandle socket);
+
+        /// <summary>
+        /// Gathered send; returns bytes sent, 0 if the socket would block, or -1 on a broken connection
+        /// </summary>
+        intptr_t Send(SocketHandle socket, const IoSlice* slices, int count);
+
+        /// <summary>
+        /// Returns bytes received, 0 if the socket would block, or -1 when the peer closed or failed
+        /// </summary>
+        intptr_t Receive(SocketHandle socket, void* buffer, size_t length);
+    }
+}
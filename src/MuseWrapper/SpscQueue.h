@@ -0,0 +1,90 @@
+#pragma once
+
+#include <memory_resource>
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Bounded single-producer/single-consumer queue with a power-of-two capacity. Each side keeps
+    /// its index and a cached copy of the other side's index on its own cache line, so the libmuse
+    /// callback thread and the pipeline worker only touch shared lines when the cache runs out.
+    /// Slots come from the given memory resource, e.g. the owning session's arena.
+    /// </summary>
+    template <typename T>
+    class SpscQueue
+    {
+    public:
+        explicit SpscQueue(size_t capacity, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+            : slots(memory)
+        {
+            size_t size = 1;
+            while (size < capacity)
+            {
+                size <<= 1;
+            }
+            slots.resize(size);
+            mask = size - 1;
+        }
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        size_t Capacity() const { return slots.size(); }
+
+        /// <summary>
+        /// Approximate number of queued items; exact only when called from the producer or consumer with the other side idle
+        /// </summary>
+        size_t Size() const
+        {
+            return static_cast<size_t>(tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire));
+        }
+
+        /// <summary>
+        /// Producer only: enqueues a copy of item, or returns false if the queue is full
+        /// </summary>
+        bool TryPush(const T& item)
+        {
+            uint64_t position = tail.load(std::memory_order_relaxed);
+            if (position - cachedHead >= slots.size())
+            {
+                cachedHead = head.load(std::memory_order_acquire);
+                if (position - cachedHead >= slots.size())
+                {
+                    return false;
+                }
+            }
+            slots[position & mask] = item;
+            tail.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// <summary>
+        /// Consumer only: dequeues the oldest item, or returns false if the queue is empty
+        /// </summary>
+        bool TryPop(T& item)
+        {
+            uint64_t position = head.load(std::memory_order_relaxed);
+            if (position == cachedTail)
+            {
+                cachedTail = tail.load(std::memory_order_acquire);
+                if (position == cachedTail)
+                {
+                    return false;
+                }
+            }
+            item = slots[position & mask];
+            head.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        std::pmr::vector<T> slots;
+        size_t mask = 0;
+
+        alignas(64) std::atomic<uint64_t> tail{ 0 };
+        uint64_t cachedHead = 0;
+
+        alignas(64) std::atomic<uint64_t> head{ 0 };
+        uint64_t cachedTail = 0;
+    };
+}
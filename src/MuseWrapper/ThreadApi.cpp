@@ -0,0 +1,37 @@
+// ThreadApi.cpp : Exported entry points for per-thread error state and scratch buffers.
+#include "pch.h"
+#include "ApiSupport.h"
+
+using namespace MuseWrapper;
+
+namespace
+{
+    constexpr int MaxThreadBufferLength = 16 * 1024 * 1024;
+
+    // Freed with the thread; grown by doubling so a caller sizing up in steps reallocates rarely
+    thread_local std::array<std::vector<char>, MW_THREAD_BUFFER_COUNT> threadBuffers;
+}
+
+int MwGetLastError(char* messageOut, int messageLen)
+{
+    return LastThreadError(messageOut, messageLen);
+}
+
+int MwGetThreadBuffer(int buffer, int minLength, char** bufferOut, int* lengthOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(bufferOut != nullptr && lengthOut != nullptr, "bufferOut and lengthOut are required");
+        Require(buffer >= 0 && buffer < MW_THREAD_BUFFER_COUNT, "Unknown thread buffer");
+        Require(minLength >= 1 && minLength <= MaxThreadBufferLength, "minLength is out of range");
+        std::vector<char>& scratch = threadBuffers[static_cast<size_t>(buffer)];
+        if (scratch.size() < static_cast<size_t>(minLength))
+        {
+            size_t length = std::max<size_t>(scratch.size() * 2, static_cast<size_t>(minLength));
+            scratch.assign(std::min<size_t>(length, MaxThreadBufferLength), '\0');
+        }
+        *bufferOut = scratch.data();
+        *lengthOut = static_cast<int>(scratch.size());
+        return MW_OK;
+    });
+}
@@ -0,0 +1,133 @@
+#include "pch.h"
+#include "ThreadScheduling.h"
+
+#ifdef _WIN32
+#include <avrt.h>
+#pragma comment(lib, "Avrt.lib")
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace MuseWrapper
+{
+    namespace
+    {
+#ifndef _WIN32
+        // Low in the SCHED_FIFO range, so kernel threads and audio servers still preempt it
+        constexpr int RealtimePriority = 10;
+        constexpr int HighNice = -10;
+#endif
+
+        std::string CpuList(const std::vector<int>& cpus)
+        {
+            std::string list;
+            for (int cpu : cpus)
+            {
+                list += (list.empty() ? "" : ",") + std::to_string(cpu);
+            }
+            return list;
+        }
+
+#ifdef _WIN32
+        bool SetAffinity(HANDLE thread, const std::vector<int>& cpus)
+        {
+            DWORD_PTR mask = 0;
+            for (int cpu : cpus)
+            {
+                if (cpu < 0 || cpu >= 64)
+                {
+                    return false;
+                }
+                mask |= static_cast<DWORD_PTR>(1) << cpu;
+            }
+            return SetThreadAffinityMask(thread, mask) != 0;
+        }
+#else
+        bool SetAffinity(pthread_t thread, const std::vector<int>& cpus)
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : cpus)
+            {
+                if (cpu < 0 || cpu >= CPU_SETSIZE)
+                {
+                    return false;
+                }
+                CPU_SET(cpu, &set);
+            }
+            return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+        }
+#endif
+    }
+
+    void SetThreadAffinity(std::thread& thread, const std::vector<int>& cpus)
+    {
+        if (!SetAffinity(thread.native_handle(), cpus))
+        {
+            throw std::runtime_error("Cannot restrict a thread to CPUs " + CpuList(cpus));
+        }
+    }
+
+    ScopedThreadScheduling::ScopedThreadScheduling(const ThreadScheduling& scheduling)
+    {
+#ifdef _WIN32
+        HANDLE self = GetCurrentThread();
+#else
+        pthread_t self = pthread_self();
+#endif
+        if (!scheduling.cpus.empty() && !SetAffinity(self, scheduling.cpus))
+        {
+            throw std::runtime_error("Cannot restrict a thread to CPUs " + CpuList(scheduling.cpus));
+        }
+
+#ifdef _WIN32
+        if (scheduling.priority == ThreadPriority::Realtime)
+        {
+            DWORD taskIndex = 0;
+            HANDLE task = AvSetMmThreadCharacteristicsW(L"Pro Audio", &taskIndex);
+            if (task != nullptr)
+            {
+                AvSetMmThreadPriority(task, AVRT_PRIORITY_HIGH);
+                mmcssTask = task;
+                applied = ThreadPriority::Realtime;
+                return;
+            }
+        }
+        if (scheduling.priority != ThreadPriority::Normal && SetThreadPriority(self, THREAD_PRIORITY_HIGHEST))
+        {
+            applied = ThreadPriority::High;
+        }
+#else
+        if (scheduling.priority == ThreadPriority::Realtime)
+        {
+            sched_param parameters = {};
+            parameters.sched_priority = RealtimePriority;
+            if (pthread_setschedparam(self, SCHED_FIFO, &parameters) == 0)
+            {
+                applied = ThreadPriority::Realtime;
+                return;
+            }
+        }
+        // Linux keeps a nice value per thread, addressed by its kernel thread id
+        if (scheduling.priority != ThreadPriority::Normal
+            && setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), HighNice) == 0)
+        {
+            applied = ThreadPriority::High;
+        }
+#endif
+    }
+
+    ScopedThreadScheduling::~ScopedThreadScheduling()
+    {
+#ifdef _WIN32
+        if (mmcssTask != nullptr)
+        {
+            AvRevertMmThreadCharacteristics(static_cast<HANDLE>(mmcssTask));
+        }
+#endif
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Scheduling class of a MuseWrapper thread; values match the MW_PRIORITY_* constants
+    /// </summary>
+    enum class ThreadPriority : int
+    {
+        Normal,
+        High,           // nice -10 on Linux, THREAD_PRIORITY_HIGHEST on Windows
+        Realtime,       // SCHED_FIFO on Linux, the MMCSS "Pro Audio" task on Windows
+    };
+
+    /// <summary>
+    /// Where and how urgently a latency-sensitive thread runs, so that packet handling is not starved
+    /// by a video encoder saturating every core
+    /// </summary>
+    struct ThreadScheduling
+    {
+        ThreadPriority priority = ThreadPriority::Normal;
+        std::vector<int> cpus;          // CPUs the thread may run on; empty leaves placement to the OS
+    };
+
+    /// <summary>
+    /// Restricts a thread to the given CPUs; throws if the OS refuses
+    /// </summary>
+    void SetThreadAffinity(std::thread& thread, const std::vector<int>& cpus);
+
+    /// <summary>
+    /// Applies a scheduling to the calling thread, which keeps it until the thread exits (on Windows
+    /// the MMCSS task is left when the scope ends). Affinity is applied first and throws if refused.
+    /// A priority the process is not allowed falls back a level at a time (Realtime needs
+    /// CAP_SYS_NICE or an rtprio limit on Linux, High a nice limit) instead of failing, and Applied
+    /// reports what took effect.
+    /// </summary>
+    class ScopedThreadScheduling
+    {
+    public:
+        explicit ScopedThreadScheduling(const ThreadScheduling& scheduling);
+        ~ScopedThreadScheduling();
+
+        ScopedThreadScheduling(const ScopedThreadScheduling&) = delete;
+        ScopedThreadScheduling& operator=(const ScopedThreadScheduling&) = delete;
+
+        ThreadPriority Applied() const { return applied; }
+
+    private:
+        ThreadPriority applied = ThreadPriority::Normal;
+        void* mmcssTask = nullptr;      // AvSetMmThreadCharacteristics handle, reverted on exit
+    };
+}
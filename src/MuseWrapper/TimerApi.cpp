@@ -0,0 +1,66 @@
+// TimerApi.cpp : Exported entry points for timers on the shared native timer wheel.
+#include "pch.h"
+#include "ApiHandles.h"
+#include "ApiSupport.h"
+#include "TimerWheel.h"
+
+using namespace MuseWrapper;
+
+TimerWheel& MuseWrapper::SharedTimerWheel()
+{
+    // Never destroyed: metrics pages and managed timers may still cancel while statics are torn down
+    static TimerWheel* wheel = new TimerWheel();
+    return *wheel;
+}
+
+int MwTimerStart(int delayMs, int periodMs, MwTimerCallback callback, void* context, int64_t* timerOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(callback != nullptr && timerOut != nullptr, "callback and timerOut are required");
+        Require(delayMs >= 0 && periodMs >= 0, "delayMs and periodMs cannot be negative");
+        uint64_t timer = SharedTimerWheel().Schedule(static_cast<uint64_t>(delayMs) * 1'000'000, static_cast<uint64_t>(periodMs) * 1'000'000,
+            [callback, context](uint64_t id) { callback(static_cast<int64_t>(id), context); });
+        *timerOut = static_cast<int64_t>(timer);
+        return MW_OK;
+    });
+}
+
+int MwTimerReschedule(int64_t timer, int delayMs, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(delayMs >= 0, "delayMs cannot be negative");
+        if (timer <= 0 || !SharedTimerWheel().Reschedule(static_cast<uint64_t>(timer), static_cast<uint64_t>(delayMs) * 1'000'000))
+        {
+            throw ApiError(MW_INVALID_HANDLE, "Unknown or finished timer " + std::to_string(timer));
+        }
+        return MW_OK;
+    });
+}
+
+int MwTimerCancel(int64_t timer, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        if (timer <= 0 || !SharedTimerWheel().Cancel(static_cast<uint64_t>(timer)))
+        {
+            throw ApiError(MW_INVALID_HANDLE, "Unknown or finished timer " + std::to_string(timer));
+        }
+        return MW_OK;
+    });
+}
+
+int MwTimerGetStats(MwTimerStats* statsOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(statsOut != nullptr, "statsOut is required");
+        TimerWheelStats stats = SharedTimerWheel().Stats();
+        statsOut->active = static_cast<int64_t>(stats.active);
+        statsOut->fired = static_cast<int64_t>(stats.fired);
+        statsOut->wakeups = static_cast<int64_t>(stats.wakeups);
+        statsOut->cascaded = static_cast<int64_t>(stats.cascaded);
+        return MW_OK;
+    });
+}
@@ -0,0 +1,361 @@
+#include "pch.h"
+#include "TimerWheel.h"
+#include "Clock.h"
+#include "Profiler.h"
+#include "Tracing.h"
+
+#include <bit>
+
+namespace MuseWrapper
+{
+    namespace
+    {
+        constexpr uint64_t NoEvent = UINT64_MAX;
+        constexpr uint64_t SlotMask = TimerWheel::Slots - 1;
+
+        constexpr int Shift(int level)
+        {
+            return TimerWheel::SlotBits * level;
+        }
+
+        // Bits from..to inclusive, to < 64
+        constexpr uint64_t BitRange(int from, int to)
+        {
+            return (UINT64_MAX >> (63 - to)) & (UINT64_MAX << from);
+        }
+    }
+
+    TimerWheel::TimerWheel(uint64_t tickNs)
+        : tickNs(tickNs), startNs(MonotonicNanoseconds())
+    {
+        if (tickNs == 0)
+        {
+            throw std::invalid_argument("tickNs must be positive");
+        }
+        driver = std::thread(&TimerWheel::Run, this);
+    }
+
+    TimerWheel::~TimerWheel()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        driver.join();
+    }
+
+    uint64_t TimerWheel::Schedule(uint64_t delayNs, uint64_t periodNs, Callback callback)
+    {
+        bool earlier;
+        uint64_t id;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            Timer* timer = Acquire();
+            id = timer->id;
+            timer->callback = std::move(callback);
+            timer->period = periodNs != 0 ? std::max<uint64_t>(1, (periodNs + tickNs - 1) / tickNs) : 0;
+            // Rounded up, so a timer never fires before its delay has passed
+            timer->deadline = std::max(currentTick + 1, (MonotonicNanoseconds() - startNs + delayNs + tickNs - 1) / tickNs);
+            earlier = timer->deadline < plannedWakeTick;
+            Place(timer);
+            active++;
+        }
+        if (earlier)
+        {
+            wake.notify_one();
+        }
+        return id;
+    }
+
+    bool TimerWheel::Reschedule(uint64_t id, uint64_t delayNs)
+    {
+        bool earlier;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            Timer* timer = Find(id);
+            if (timer == nullptr || timer->cancelled)
+            {
+                return false;
+            }
+            if (timer->level >= 0)
+            {
+                Unlink(timer);
+            }
+            timer->deadline = std::max(currentTick + 1, (MonotonicNanoseconds() - startNs + delayNs + tickNs - 1) / tickNs);
+            earlier = timer->deadline < plannedWakeTick;
+            Place(timer);
+        }
+        if (earlier)
+        {
+            wake.notify_one();
+        }
+        return true;
+    }
+
+    bool TimerWheel::Cancel(uint64_t id)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        Timer* timer = Find(id);
+        if (timer == nullptr || timer->cancelled)
+        {
+            return false;
+        }
+        if (timer->level >= 0)
+        {
+            Unlink(timer);
+        }
+        active--;
+        if (!timer->pending)
+        {
+            Release(timer);
+            return true;
+        }
+
+        // Due or running: the driver still holds it and frees it once it gets there
+        timer->cancelled = true;
+        if (std::this_thread::get_id() != driver.get_id())
+        {
+            settled.wait(guard, [this, id] { return runningId != id; });
+        }
+        return true;
+    }
+
+    TimerWheelStats TimerWheel::Stats() const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return TimerWheelStats{ active, fired, wakeups, cascaded };
+    }
+
+    TimerWheel::Timer* TimerWheel::Find(uint64_t id)
+    {
+        uint64_t index = id & UINT32_MAX;
+        if (id == 0 || index >= pool.size() || pool[index].id != id)
+        {
+            return nullptr;
+        }
+        return &pool[index];
+    }
+
+    TimerWheel::Timer* TimerWheel::Acquire()
+    {
+        Timer* timer = freeTimers;
+        if (timer != nullptr)
+        {
+            freeTimers = timer->next;
+            timer->next = nullptr;
+        }
+        else
+        {
+            timer = &pool.emplace_back();
+            timer->index = static_cast<uint32_t>(pool.size() - 1);
+        }
+        // Generation 0 is skipped so no id is 0
+        if (++timer->generation == 0)
+        {
+            timer->generation = 1;
+        }
+        timer->id = (uint64_t{ timer->generation } << 32) | timer->index;
+        return timer;
+    }
+
+    void TimerWheel::Release(Timer* timer)
+    {
+        timer->id = 0;
+        timer->callback = nullptr;
+        timer->cancelled = false;
+        timer->next = freeTimers;
+        freeTimers = timer;
+    }
+
+    uint64_t TimerWheel::NowTicks() const
+    {
+        return (MonotonicNanoseconds() - startNs) / tickNs;
+    }
+
+    void TimerWheel::Place(Timer* timer)
+    {
+        uint64_t delta = timer->deadline - currentTick;
+        int level = 0;
+        while (level < Levels - 1 && delta >= (uint64_t{ 1 } << Shift(level + 1)))
+        {
+            level++;
+        }
+        // Beyond the top level's reach: park it as far out as the wheel goes and place it again from there
+        uint64_t position = timer->deadline;
+        if (level == Levels - 1 && delta >= (uint64_t{ 1 } << Shift(Levels)))
+        {
+            position = currentTick + (uint64_t{ 1 } << Shift(Levels)) - 1;
+        }
+
+        int slot = static_cast<int>((position >> Shift(level)) & SlotMask);
+        Level& target = levels[static_cast<size_t>(level)];
+        timer->level = level;
+        timer->slot = slot;
+        timer->previous = nullptr;
+        timer->next = target.heads[static_cast<size_t>(slot)];
+        if (timer->next != nullptr)
+        {
+            timer->next->previous = timer;
+        }
+        target.heads[static_cast<size_t>(slot)] = timer;
+        target.occupied |= uint64_t{ 1 } << slot;
+    }
+
+    void TimerWheel::Unlink(Timer* timer)
+    {
+        Level& source = levels[static_cast<size_t>(timer->level)];
+        if (timer->previous != nullptr)
+        {
+            timer->previous->next = timer->next;
+        }
+        else
+        {
+            source.heads[static_cast<size_t>(timer->slot)] = timer->next;
+        }
+        if (timer->next != nullptr)
+        {
+            timer->next->previous = timer->previous;
+        }
+        if (source.heads[static_cast<size_t>(timer->slot)] == nullptr)
+        {
+            source.occupied &= ~(uint64_t{ 1 } << timer->slot);
+        }
+        timer->previous = nullptr;
+        timer->next = nullptr;
+        timer->level = -1;
+    }
+
+    void TimerWheel::Cascade(int level)
+    {
+        int slot = static_cast<int>((currentTick >> Shift(level)) & SlotMask);
+        // The level above empties into this one first when this level has wrapped as well
+        if (slot == 0 && level + 1 < Levels)
+        {
+            Cascade(level + 1);
+        }
+
+        Level& source = levels[static_cast<size_t>(level)];
+        Timer* timer = source.heads[static_cast<size_t>(slot)];
+        source.heads[static_cast<size_t>(slot)] = nullptr;
+        source.occupied &= ~(uint64_t{ 1 } << slot);
+        while (timer != nullptr)
+        {
+            Timer* next = timer->next;
+            Place(timer);
+            cascaded++;
+            timer = next;
+        }
+    }
+
+    void TimerWheel::Advance(uint64_t toTick, std::vector<Timer*>& due)
+    {
+        Level& first = levels[0];
+        while (currentTick < toTick)
+        {
+            // Skip straight to the next occupied level-0 slot, or to where level 0 wraps and cascades
+            uint64_t base = currentTick & ~SlotMask;
+            uint64_t limit = std::min(base + Slots, toTick);
+            int from = static_cast<int>(currentTick - base) + 1;
+            int to = static_cast<int>(std::min<uint64_t>(limit - base, Slots - 1));
+            uint64_t ahead = from <= to ? first.occupied & BitRange(from, to) : 0;
+            currentTick = ahead != 0 ? base + static_cast<uint64_t>(std::countr_zero(ahead)) : limit;
+
+            if ((currentTick & SlotMask) == 0)
+            {
+                Cascade(1);
+            }
+            size_t slot = static_cast<size_t>(currentTick & SlotMask);
+            for (Timer* timer = first.heads[slot]; timer != nullptr; timer = timer->next)
+            {
+                timer->level = -1;
+                timer->pending = true;
+                due.push_back(timer);
+            }
+            first.heads[slot] = nullptr;
+            first.occupied &= ~(uint64_t{ 1 } << slot);
+        }
+    }
+
+    uint64_t TimerWheel::NextEventTick() const
+    {
+        uint64_t next = NoEvent;
+        for (int level = 0; level < Levels; level++)
+        {
+            uint64_t occupied = levels[static_cast<size_t>(level)].occupied;
+            if (occupied == 0)
+            {
+                continue;
+            }
+            // First occupied slot after the current one, going round once; for upper levels the tick
+            // at which that slot cascades
+            uint64_t position = currentTick >> Shift(level);
+            int after = static_cast<int>((position + 1) & SlotMask);
+            uint64_t steps = static_cast<uint64_t>(std::countr_zero(std::rotr(occupied, after))) + 1;
+            next = std::min(next, (position + steps) << Shift(level));
+        }
+        return next;
+    }
+
+    void TimerWheel::Run()
+    {
+        MW_TRACE_THREAD_NAME("MuseWrapper timers");
+        Profiler::ThreadRegistration profiled("MuseWrapper timers");
+        std::vector<Timer*> due;
+        std::unique_lock<std::mutex> guard(lock);
+        while (!stopping)
+        {
+            wakeups++;
+            Advance(NowTicks(), due);
+            for (Timer* timer : due)
+            {
+                // Rescheduled or cancelled after it fell due
+                if (!timer->cancelled && timer->level < 0)
+                {
+                    runningId = timer->id;
+                    guard.unlock();
+                    {
+                        MW_TRACE_SCOPE("timers.callback");
+                        timer->callback(timer->id);
+                    }
+                    guard.lock();
+                    runningId = 0;
+                    fired++;
+                    settled.notify_all();
+                }
+
+                timer->pending = false;
+                if (timer->cancelled || (timer->level < 0 && timer->period == 0))
+                {
+                    if (timer->level >= 0)
+                    {
+                        Unlink(timer);
+                    }
+                    if (!timer->cancelled)
+                    {
+                        active--;
+                    }
+                    Release(timer);
+                }
+                else if (timer->level < 0)
+                {
+                    // From the previous deadline so the period does not drift, unless the wheel fell behind
+                    timer->deadline = std::max(timer->deadline + timer->period, currentTick + 1);
+                    Place(timer);
+                }
+            }
+            due.clear();
+
+            plannedWakeTick = NextEventTick();
+            if (plannedWakeTick == NoEvent)
+            {
+                wake.wait(guard);
+            }
+            else
+            {
+                auto at = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(startNs + plannedWakeTick * tickNs));
+                wake.wait_until(guard, at);
+            }
+        }
+    }
+}
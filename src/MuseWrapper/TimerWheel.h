@@ -0,0 +1,122 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+
+namespace MuseWrapper
+{
+    struct TimerWheelStats
+    {
+        uint64_t active;        // scheduled and not yet fired or cancelled
+        uint64_t fired;         // callbacks run
+        uint64_t wakeups;       // times the driver thread woke up
+        uint64_t cascaded;      // timers moved down a level
+    };
+
+    /// <summary>
+    /// Hierarchical hashed timer wheel driven by one thread, for the many coarse timers of a session:
+    /// device monitoring ticks, reconnect backoff, battery and RSSI polls, flush deadlines and metric
+    /// emission. Four levels of 64 slots at a 1 ms tick cover about 4.6 hours directly; longer
+    /// timers wait in the top level and are placed again as they come closer. Each slot is an
+    /// intrusive list, so Schedule and Cancel are O(1) however many timers are pending. Timers come
+    /// from a pool that only grows, and an id carries its pool index and the generation of that entry,
+    /// so scheduling does not allocate once the pool has warmed up and a stale id matches nothing.
+    ///
+    /// The driver does not tick: it sleeps until the next occupied slot or cascade, found from a
+    /// per-level occupancy mask, so an idle wheel with hundreds of long timers wakes only when one of
+    /// them is due. Timers due in the same tick fire in one wakeup.
+    ///
+    /// Callbacks run one at a time on the driver thread and must return quickly; a periodic timer is
+    /// re-armed from its previous deadline so it does not drift. A callback may schedule, reschedule
+    /// or cancel timers, including its own.
+    /// </summary>
+    class TimerWheel
+    {
+    public:
+        using Callback = std::function<void(uint64_t id)>;      // id of the timer firing
+
+        static constexpr int Levels = 4;
+        static constexpr int SlotBits = 6;
+        static constexpr int Slots = 1 << SlotBits;
+
+        explicit TimerWheel(uint64_t tickNs = 1'000'000);
+        ~TimerWheel();
+
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+
+        /// <summary>
+        /// Runs callback after delayNs, then every periodNs if that is not zero. Returns the timer's id.
+        /// </summary>
+        uint64_t Schedule(uint64_t delayNs, uint64_t periodNs, Callback callback);
+
+        /// <summary>
+        /// Moves a pending timer's next deadline to delayNs from now, keeping its period; false if it has
+        /// already fired for the last time or been cancelled
+        /// </summary>
+        bool Reschedule(uint64_t id, uint64_t delayNs);
+
+        /// <summary>
+        /// Stops a timer. Off the driver thread this also waits for its callback if it is running, so
+        /// anything the callback uses can be freed on return. False for an unknown id.
+        /// </summary>
+        bool Cancel(uint64_t id);
+
+        TimerWheelStats Stats() const;
+
+    private:
+        struct Timer
+        {
+            uint64_t id = 0;        // 0 while free
+            uint32_t index = 0;     // in the pool
+            uint32_t generation = 0;
+            uint64_t deadline;      // in ticks
+            uint64_t period;        // in ticks, 0 for one-shot
+            Callback callback;
+            Timer* previous = nullptr;
+            Timer* next = nullptr;  // also links the free list
+            int level = -1;         // -1 while not in a slot (running or due)
+            int slot = 0;
+            bool pending = false;   // fallen due and held by the driver until its callback has run
+            bool cancelled = false;
+        };
+
+        struct Level
+        {
+            std::array<Timer*, Slots> heads = {};
+            uint64_t occupied = 0;  // bit per non-empty slot
+        };
+
+        Timer* Find(uint64_t id);
+        Timer* Acquire();
+        void Release(Timer* timer);
+        uint64_t NowTicks() const;
+        void Place(Timer* timer);
+        void Unlink(Timer* timer);
+        void Advance(uint64_t toTick, std::vector<Timer*>& due);
+        void Cascade(int level);
+        uint64_t NextEventTick() const;
+        void Run();
+
+        uint64_t tickNs;
+        uint64_t startNs;
+
+        mutable std::mutex lock;
+        std::condition_variable wake;
+        std::condition_variable settled;    // a callback returned
+        std::array<Level, Levels> levels;
+        uint64_t currentTick = 0;           // every slot up to this tick has been processed
+        uint64_t plannedWakeTick = UINT64_MAX;
+        std::deque<Timer> pool;             // stable addresses; the index is the low half of an id
+        Timer* freeTimers = nullptr;
+        uint64_t active = 0;                // scheduled and neither cancelled nor fired for the last time
+        uint64_t runningId = 0;             // timer whose callback is running, 0 if none
+        bool stopping = false;
+
+        uint64_t fired = 0;
+        uint64_t wakeups = 0;
+        uint64_t cascaded = 0;
+
+        std::thread driver;
+    };
+}
@@ -0,0 +1,94 @@
+// TimingApi.cpp : Exported entry points for per-device packet timing and dropped-data statistics.
+#include "pch.h"
+#include "ApiHandles.h"
+#include "ApiSupport.h"
+#include "Clock.h"
+#include "PacketTiming.h"
+
+using namespace MuseWrapper;
+
+namespace
+{
+    HandleTable<PacketTimingMonitor> monitors;
+}
+
+HandleTable<PacketTimingMonitor>& MuseWrapper::TimingHandles()
+{
+    return monitors;
+}
+
+int MwTimingCreate(int intervalMs, int* handleOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(handleOut != nullptr, "handleOut is required");
+        Require(intervalMs > 0, "intervalMs must be positive");
+        *handleOut = monitors.Add(std::make_shared<PacketTimingMonitor>(static_cast<uint64_t>(intervalMs) * 1'000'000));
+        return MW_OK;
+    });
+}
+
+int MwTimingDestroy(int handle, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        monitors.Remove(handle);
+        return MW_OK;
+    });
+}
+
+int MwTimingSetNominalRate(int handle, int packetType, double rateHz, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(packetType >= 0 && packetType < PacketTypeCount, "Unknown packet type");
+        Require(std::isfinite(rateHz) && rateHz >= 0.0 && rateHz <= PacketTimingMonitor::MaxNominalRateHz,
+            "rateHz must be finite and between 0 and 1 MHz");
+        monitors.Get(handle)->SetNominalRate(static_cast<MuseDataPacketType>(packetType), rateHz);
+        return MW_OK;
+    });
+}
+
+int MwTimingRecordPacket(int handle, int packetType, int64_t timestampUs, const double* values, int numValues, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(packetType >= 0 && packetType < PacketTypeCount, "Unknown packet type");
+        Require(numValues >= 0 && numValues <= MaxPacketValues && (values != nullptr || numValues == 0), "Invalid packet values");
+        MusePacket packet = { static_cast<MuseDataPacketType>(packetType), numValues, timestampUs, {} };
+        std::copy_n(values, numValues, packet.values);
+        monitors.Get(handle)->Record(packet, MonotonicNanoseconds());
+        return MW_OK;
+    });
+}
+
+int MwTimingRotate(int handle, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        monitors.Get(handle)->Rotate(MonotonicNanoseconds());
+        return MW_OK;
+    });
+}
+
+int MwTimingGetStats(int handle, int packetType, MwPacketTimingStats* statsOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(packetType >= 0 && packetType < PacketTypeCount, "Unknown packet type");
+        Require(statsOut != nullptr, "statsOut is required");
+        PacketTimingSummary summary = monitors.Get(handle)->Snapshot(static_cast<MuseDataPacketType>(packetType), MonotonicNanoseconds());
+        statsOut->intervalNs = static_cast<int64_t>(summary.intervalNs);
+        statsOut->nominalRate = summary.nominalRate;
+        statsOut->packets = static_cast<int64_t>(summary.packets);
+        statsOut->missingSamples = static_cast<int64_t>(summary.missingSamples);
+        statsOut->droppedSamples = static_cast<int64_t>(summary.droppedSamples);
+        statsOut->outOfOrder = static_cast<int64_t>(summary.outOfOrder);
+        statsOut->totalPackets = static_cast<int64_t>(summary.totalPackets);
+        statsOut->totalMissingSamples = static_cast<int64_t>(summary.totalMissingSamples);
+        statsOut->totalDroppedSamples = static_cast<int64_t>(summary.totalDroppedSamples);
+        CopyLatency(summary.interArrival, &statsOut->interArrival);
+        CopyLatency(summary.timestampJitter, &statsOut->timestampJitter);
+        return MW_OK;
+    });
+}
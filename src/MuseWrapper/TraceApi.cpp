@@ -0,0 +1,37 @@
+// TraceApi.cpp : Exported entry points for recording and exporting native activity traces.
+#include "pch.h"
+#include "ApiSupport.h"
+#include "Tracing.h"
+
+using namespace MuseWrapper;
+
+int MwTraceStart(int bufferMegabytesPerThread, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(Tracing::CompiledIn, "This MuseWrapper build has no tracing; rebuild with MUSEWRAPPER_TRACING defined");
+        Require(bufferMegabytesPerThread > 0, "bufferMegabytesPerThread must be positive");
+        Tracing::Start(static_cast<size_t>(bufferMegabytesPerThread) << 20);
+        return MW_OK;
+    });
+}
+
+int MwTraceStop(char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Tracing::Stop();
+        return MW_OK;
+    });
+}
+
+int MwTraceWrite(const char* path, int format, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(path != nullptr, "path is required");
+        Require(format == MW_TRACE_CHROME_JSON || format == MW_TRACE_PERFETTO, "Unknown trace format");
+        Tracing::Write(path, format == MW_TRACE_CHROME_JSON ? Tracing::Format::ChromeJson : Tracing::Format::PerfettoProtobuf);
+        return MW_OK;
+    });
+}
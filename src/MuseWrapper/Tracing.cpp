@@ -0,0 +1,514 @@
+#include "pch.h"
+#include "Tracing.h"
+#include "Clock.h"
+
+#include <cstdio>
+#include <map>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace MuseWrapper
+{
+    namespace Tracing
+    {
+        std::atomic<bool> enabled{ false };
+
+        namespace
+        {
+            enum class Phase : uint8_t
+            {
+                Begin,
+                End,
+                Complete,
+                Counter,
+            };
+
+            struct Event
+            {
+                uint64_t timestampNs;
+                union
+                {
+                    uint64_t durationNs;
+                    double value;
+                };
+                const char* name;
+                Phase phase;
+            };
+
+            constexpr size_t ChunkEvents = 16384;
+            constexpr size_t MaxChunks = 1024;
+
+            // Written only by its own thread; Write reads the first 'count' events of the current generation
+            struct ThreadBuffer
+            {
+                uint32_t threadId = 0;
+                std::string name;                                   // guarded by registryLock
+                std::array<std::atomic<Event*>, MaxChunks> chunks = {};
+                std::atomic<size_t> count{ 0 };
+                std::atomic<uint64_t> generation{ 0 };
+                std::atomic<uint64_t> dropped{ 0 };
+            };
+
+            std::mutex controlLock;         // serialises Start, Stop and Write
+            std::mutex registryLock;
+            std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+            std::atomic<uint64_t> generation{ 0 };
+            std::atomic<size_t> capacityEvents{ 0 };
+            uint64_t sessionStartNs = 0;
+
+            thread_local ThreadBuffer* current = nullptr;
+
+            ThreadBuffer& CurrentBuffer()
+            {
+                if (!current)
+                {
+                    // Buffers outlive their threads so a trace still shows threads that have exited
+                    auto buffer = std::make_unique<ThreadBuffer>();
+                    std::lock_guard<std::mutex> guard(registryLock);
+                    buffer->threadId = static_cast<uint32_t>(buffers.size() + 1);
+                    buffer->name = "thread " + std::to_string(buffer->threadId);
+                    current = buffer.get();
+                    buffers.push_back(std::move(buffer));
+                }
+                return *current;
+            }
+
+            void Append(const Event& event)
+            {
+                ThreadBuffer& buffer = CurrentBuffer();
+                uint64_t session = generation.load(std::memory_order_acquire);
+                if (buffer.generation.load(std::memory_order_relaxed) != session)
+                {
+                    buffer.count.store(0, std::memory_order_relaxed);
+                    buffer.dropped.store(0, std::memory_order_relaxed);
+                    buffer.generation.store(session, std::memory_order_release);
+                }
+
+                size_t index = buffer.count.load(std::memory_order_relaxed);
+                if (index >= capacityEvents.load(std::memory_order_relaxed))
+                {
+                    buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                std::atomic<Event*>& slot = buffer.chunks[index / ChunkEvents];
+                Event* chunk = slot.load(std::memory_order_relaxed);
+                if (!chunk)
+                {
+                    chunk = new Event[ChunkEvents];
+                    slot.store(chunk, std::memory_order_release);
+                }
+                chunk[index % ChunkEvents] = event;
+                buffer.count.store(index + 1, std::memory_order_release);
+            }
+
+            struct ThreadEvents
+            {
+                uint32_t threadId;
+                std::string name;
+                uint64_t dropped;
+                std::vector<Event> events;
+            };
+
+            std::vector<ThreadEvents> Collect()
+            {
+                std::vector<std::pair<ThreadBuffer*, std::string>> snapshot;
+                {
+                    std::lock_guard<std::mutex> guard(registryLock);
+                    for (auto& buffer : buffers)
+                    {
+                        snapshot.emplace_back(buffer.get(), buffer->name);
+                    }
+                }
+
+                uint64_t session = generation.load(std::memory_order_acquire);
+                std::vector<ThreadEvents> threads;
+                for (auto& [buffer, name] : snapshot)
+                {
+                    if (buffer->generation.load(std::memory_order_acquire) != session)
+                    {
+                        continue;
+                    }
+                    size_t count = buffer->count.load(std::memory_order_acquire);
+                    ThreadEvents thread{ buffer->threadId, name, buffer->dropped.load(std::memory_order_relaxed), {} };
+                    thread.events.reserve(count);
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        thread.events.push_back(buffer->chunks[i / ChunkEvents].load(std::memory_order_acquire)[i % ChunkEvents]);
+                    }
+                    threads.push_back(std::move(thread));
+                }
+                return threads;
+            }
+
+            uint32_t ProcessId()
+            {
+#ifdef _WIN32
+                return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+                return static_cast<uint32_t>(getpid());
+#endif
+            }
+
+            std::string JsonString(const char* text)
+            {
+                std::string escaped = "\"";
+                for (const char* p = text; *p; p++)
+                {
+                    if (*p == '"' || *p == '\\')
+                    {
+                        escaped += '\\';
+                    }
+                    if (static_cast<unsigned char>(*p) >= 0x20)
+                    {
+                        escaped += *p;
+                    }
+                }
+                return escaped + "\"";
+            }
+
+            void WriteChromeJson(std::FILE* file, const std::vector<ThreadEvents>& threads)
+            {
+                uint32_t pid = ProcessId();
+                std::fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+                std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"name\":\"MuseWrapper\"}}", pid);
+                for (const ThreadEvents& thread : threads)
+                {
+                    std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":%s}}",
+                        pid, thread.threadId, JsonString(thread.name.c_str()).c_str());
+                    for (const Event& event : thread.events)
+                    {
+                        double ts = (static_cast<double>(event.timestampNs) - static_cast<double>(sessionStartNs)) / 1000.0;
+                        std::string name = JsonString(event.name);
+                        switch (event.phase)
+                        {
+                        case Phase::Begin:
+                        case Phase::End:
+                            std::fprintf(file, ",\n{\"name\":%s,\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%u,\"tid\":%u}",
+                                name.c_str(), event.phase == Phase::Begin ? 'B' : 'E', ts, pid, thread.threadId);
+                            break;
+                        case Phase::Complete:
+                            std::fprintf(file, ",\n{\"name\":%s,\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%u,\"tid\":%u}",
+                                name.c_str(), ts, event.durationNs / 1000.0, pid, thread.threadId);
+                            break;
+                        case Phase::Counter:
+                            std::fprintf(file, ",\n{\"name\":%s,\"ph\":\"C\",\"ts\":%.3f,\"pid\":%u,\"tid\":%u,\"args\":{\"value\":%.17g}}",
+                                name.c_str(), ts, pid, thread.threadId, event.value);
+                            break;
+                        }
+                    }
+                    if (thread.dropped != 0)
+                    {
+                        std::fprintf(file, ",\n{\"name\":\"trace buffer full\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%u,\"tid\":%u,\"args\":{\"dropped\":%llu}}",
+                            thread.events.empty() ? 0.0 : (static_cast<double>(thread.events.back().timestampNs) - static_cast<double>(sessionStartNs)) / 1000.0,
+                            pid, thread.threadId, static_cast<unsigned long long>(thread.dropped));
+                    }
+                }
+                std::fprintf(file, "\n]}\n");
+            }
+
+            // Minimal protobuf encoder for the subset of perfetto.protos.Trace written below
+            class ProtoWriter
+            {
+            public:
+                void Varint(uint32_t field, uint64_t value)
+                {
+                    Tag(field, 0);
+                    Raw(value);
+                }
+
+                void Double(uint32_t field, double value)
+                {
+                    Tag(field, 1);
+                    uint64_t bits;
+                    std::memcpy(&bits, &value, sizeof(bits));
+                    for (int i = 0; i < 8; i++)
+                    {
+                        bytes.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+                    }
+                }
+
+                void String(uint32_t field, const std::string& value)
+                {
+                    Tag(field, 2);
+                    Raw(value.size());
+                    bytes.insert(bytes.end(), value.begin(), value.end());
+                }
+
+                void Message(uint32_t field, const ProtoWriter& message)
+                {
+                    Tag(field, 2);
+                    Raw(message.bytes.size());
+                    bytes.insert(bytes.end(), message.bytes.begin(), message.bytes.end());
+                }
+
+                const std::vector<uint8_t>& Bytes() const { return bytes; }
+                void Clear() { bytes.clear(); }
+
+            private:
+                void Tag(uint32_t field, uint32_t wireType)
+                {
+                    Raw((static_cast<uint64_t>(field) << 3) | wireType);
+                }
+
+                void Raw(uint64_t value)
+                {
+                    while (value >= 0x80)
+                    {
+                        bytes.push_back(static_cast<uint8_t>(value | 0x80));
+                        value >>= 7;
+                    }
+                    bytes.push_back(static_cast<uint8_t>(value));
+                }
+
+                std::vector<uint8_t> bytes;
+            };
+
+            // Field numbers from perfetto/protos/perfetto/trace/
+            namespace Proto
+            {
+                constexpr uint32_t TracePacket = 1;
+                constexpr uint32_t PacketTimestamp = 8;
+                constexpr uint32_t PacketSequenceId = 10;
+                constexpr uint32_t PacketTrackEvent = 11;
+                constexpr uint32_t PacketSequenceFlags = 13;
+                constexpr uint32_t PacketTrackDescriptor = 60;
+                constexpr uint32_t TrackUuid = 1;
+                constexpr uint32_t TrackName = 2;
+                constexpr uint32_t TrackProcess = 3;
+                constexpr uint32_t TrackThread = 4;
+                constexpr uint32_t TrackParentUuid = 5;
+                constexpr uint32_t TrackCounter = 8;
+                constexpr uint32_t ProcessPid = 1;
+                constexpr uint32_t ProcessName = 6;
+                constexpr uint32_t ThreadPid = 1;
+                constexpr uint32_t ThreadTid = 2;
+                constexpr uint32_t ThreadName = 5;
+                constexpr uint32_t EventType = 9;
+                constexpr uint32_t EventTrackUuid = 11;
+                constexpr uint32_t EventName = 23;
+                constexpr uint32_t EventDoubleCounterValue = 44;
+                constexpr uint64_t SliceBegin = 1;
+                constexpr uint64_t SliceEnd = 2;
+                constexpr uint64_t CounterEvent = 4;
+                constexpr uint64_t IncrementalStateCleared = 1;
+            }
+
+            struct Edge
+            {
+                uint64_t timestampNs;
+                int order;              // ends before counters before begins at the same instant
+                uint64_t span;          // longer slices open first and close last
+                const Event* event;
+                Phase phase;
+            };
+
+            void WritePacket(std::FILE* file, ProtoWriter& trace, const ProtoWriter& packet)
+            {
+                trace.Message(Proto::TracePacket, packet);
+                std::fwrite(trace.Bytes().data(), 1, trace.Bytes().size(), file);
+                trace.Clear();
+            }
+
+            void WritePerfetto(std::FILE* file, const std::vector<ThreadEvents>& threads)
+            {
+                uint32_t pid = ProcessId();
+                uint64_t processUuid = pid;
+                ProtoWriter trace;
+                ProtoWriter packet;
+                ProtoWriter track;
+                ProtoWriter descriptor;
+                ProtoWriter event;
+
+                descriptor.Varint(Proto::ProcessPid, pid);
+                descriptor.String(Proto::ProcessName, "MuseWrapper");
+                track.Varint(Proto::TrackUuid, processUuid);
+                track.Message(Proto::TrackProcess, descriptor);
+                packet.Message(Proto::PacketTrackDescriptor, track);
+                WritePacket(file, trace, packet);
+
+                std::map<std::string, uint64_t> counterTracks;
+                uint64_t nextCounterUuid = (processUuid << 32) | 0x80000000u;
+                for (const ThreadEvents& thread : threads)
+                {
+                    uint64_t threadUuid = (processUuid << 32) | thread.threadId;
+                    uint32_t sequence = thread.threadId;
+                    packet.Clear();
+                    track.Clear();
+                    descriptor.Clear();
+                    descriptor.Varint(Proto::ThreadPid, pid);
+                    descriptor.Varint(Proto::ThreadTid, thread.threadId);
+                    descriptor.String(Proto::ThreadName, thread.name);
+                    track.Varint(Proto::TrackUuid, threadUuid);
+                    track.Varint(Proto::TrackParentUuid, processUuid);
+                    track.Message(Proto::TrackThread, descriptor);
+                    packet.Message(Proto::PacketTrackDescriptor, track);
+                    packet.Varint(Proto::PacketSequenceId, sequence);
+                    packet.Varint(Proto::PacketSequenceFlags, Proto::IncrementalStateCleared);
+                    WritePacket(file, trace, packet);
+
+                    // Complete slices are stored when they end, so expand and order them as begin/end pairs
+                    std::vector<Edge> edges;
+                    edges.reserve(thread.events.size() * 2);
+                    for (const Event& e : thread.events)
+                    {
+                        switch (e.phase)
+                        {
+                        case Phase::Complete:
+                            edges.push_back({ e.timestampNs, 2, ~e.durationNs, &e, Phase::Begin });
+                            edges.push_back({ e.timestampNs + e.durationNs, 0, e.durationNs, &e, Phase::End });
+                            break;
+                        case Phase::Begin:
+                            edges.push_back({ e.timestampNs, 2, 0, &e, Phase::Begin });
+                            break;
+                        case Phase::End:
+                            edges.push_back({ e.timestampNs, 0, UINT64_MAX, &e, Phase::End });
+                            break;
+                        case Phase::Counter:
+                            edges.push_back({ e.timestampNs, 1, 0, &e, Phase::Counter });
+                            break;
+                        }
+                    }
+                    std::stable_sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b)
+                    {
+                        if (a.timestampNs != b.timestampNs)
+                        {
+                            return a.timestampNs < b.timestampNs;
+                        }
+                        return a.order != b.order ? a.order < b.order : a.span < b.span;
+                    });
+
+                    for (const Edge& edge : edges)
+                    {
+                        packet.Clear();
+                        event.Clear();
+                        if (edge.phase == Phase::Counter)
+                        {
+                            auto [it, added] = counterTracks.emplace(edge.event->name, nextCounterUuid);
+                            if (added)
+                            {
+                                nextCounterUuid++;
+                                track.Clear();
+                                track.Varint(Proto::TrackUuid, it->second);
+                                track.Varint(Proto::TrackParentUuid, processUuid);
+                                track.String(Proto::TrackName, it->first);
+                                track.Message(Proto::TrackCounter, ProtoWriter());
+                                packet.Message(Proto::PacketTrackDescriptor, track);
+                                WritePacket(file, trace, packet);
+                                packet.Clear();
+                            }
+                            event.Varint(Proto::EventType, Proto::CounterEvent);
+                            event.Varint(Proto::EventTrackUuid, it->second);
+                            event.Double(Proto::EventDoubleCounterValue, edge.event->value);
+                        }
+                        else
+                        {
+                            event.Varint(Proto::EventType, edge.phase == Phase::Begin ? Proto::SliceBegin : Proto::SliceEnd);
+                            event.Varint(Proto::EventTrackUuid, threadUuid);
+                            if (edge.phase == Phase::Begin)
+                            {
+                                event.String(Proto::EventName, edge.event->name);
+                            }
+                        }
+                        packet.Varint(Proto::PacketTimestamp, edge.timestampNs);
+                        packet.Varint(Proto::PacketSequenceId, sequence);
+                        packet.Message(Proto::PacketTrackEvent, event);
+                        WritePacket(file, trace, packet);
+                    }
+                }
+            }
+        }
+
+        uint64_t Now()
+        {
+            return MonotonicNanoseconds();
+        }
+
+        void Start(size_t bufferBytes)
+        {
+            std::lock_guard<std::mutex> guard(controlLock);
+            size_t events = std::clamp(bufferBytes / sizeof(Event), ChunkEvents, ChunkEvents * MaxChunks);
+            capacityEvents.store(events, std::memory_order_relaxed);
+            sessionStartNs = Now();
+            generation.fetch_add(1, std::memory_order_release);
+            enabled.store(true, std::memory_order_relaxed);
+        }
+
+        void Stop()
+        {
+            std::lock_guard<std::mutex> guard(controlLock);
+            enabled.store(false, std::memory_order_relaxed);
+        }
+
+        void Write(const std::string& path, Format format)
+        {
+            std::lock_guard<std::mutex> guard(controlLock);
+            std::vector<ThreadEvents> threads = Collect();
+            std::FILE* file = std::fopen(path.c_str(), "wb");
+            if (file == nullptr)
+            {
+                throw std::runtime_error("Cannot create trace file " + path);
+            }
+            if (format == Format::ChromeJson)
+            {
+                WriteChromeJson(file, threads);
+            }
+            else
+            {
+                WritePerfetto(file, threads);
+            }
+            if (std::fclose(file) != 0)
+            {
+                throw std::runtime_error("Failed to write trace file " + path);
+            }
+        }
+
+        void SetThreadName(const char* name)
+        {
+            ThreadBuffer& buffer = CurrentBuffer();
+            std::lock_guard<std::mutex> guard(registryLock);
+            buffer.name = name;
+        }
+
+        void Begin(const char* name)
+        {
+            Event event;
+            event.timestampNs = Now();
+            event.durationNs = 0;
+            event.name = name;
+            event.phase = Phase::Begin;
+            Append(event);
+        }
+
+        void End(const char* name)
+        {
+            Event event;
+            event.timestampNs = Now();
+            event.durationNs = 0;
+            event.name = name;
+            event.phase = Phase::End;
+            Append(event);
+        }
+
+        void Complete(const char* name, uint64_t startNs, uint64_t endNs)
+        {
+            Event event;
+            event.timestampNs = startNs;
+            event.durationNs = endNs - startNs;
+            event.name = name;
+            event.phase = Phase::Complete;
+            Append(event);
+        }
+
+        void Counter(const char* name, double value)
+        {
+            Event event;
+            event.timestampNs = Now();
+            event.value = value;
+            event.name = name;
+            event.phase = Phase::Counter;
+            Append(event);
+        }
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Low-overhead trace recorder for native pipeline activity, exported as Chrome trace-event JSON
+    /// (chrome://tracing, ui.perfetto.dev) or Perfetto protobuf.
+    ///
+    /// Each thread appends to its own chunked buffer without locking; the writer only allocates when
+    /// a chunk fills. Event names must be string literals, as only the pointer is stored. The
+    /// MW_TRACE_* macros compile to nothing unless MUSEWRAPPER_TRACING is defined, and when compiled
+    /// in cost one relaxed load while tracing is stopped.
+    /// </summary>
+    namespace Tracing
+    {
+        enum class Format
+        {
+            ChromeJson,
+            PerfettoProtobuf,
+        };
+
+        /// <summary>
+        /// True when MUSEWRAPPER_TRACING was defined for this build
+        /// </summary>
+        constexpr bool CompiledIn =
+#ifdef MUSEWRAPPER_TRACING
+            true;
+#else
+            false;
+#endif
+
+        extern std::atomic<bool> enabled;
+
+        inline bool Enabled()
+        {
+            return enabled.load(std::memory_order_relaxed);
+        }
+
+        /// <summary>
+        /// Discards earlier events and starts recording, keeping at most bufferBytes per thread
+        /// </summary>
+        void Start(size_t bufferBytes);
+        void Stop();
+
+        /// <summary>
+        /// Writes every thread's events so far; may be called while recording
+        /// </summary>
+        void Write(const std::string& path, Format format);
+
+        /// <summary>
+        /// Names the calling thread's track in the viewer
+        /// </summary>
+        void SetThreadName(const char* name);
+
+        void Begin(const char* name);
+        void End(const char* name);
+        void Complete(const char* name, uint64_t startNs, uint64_t endNs);
+        void Counter(const char* name, double value);
+
+        uint64_t Now();
+
+        /// <summary>
+        /// Records one complete slice from construction to destruction, if tracing was on at construction
+        /// </summary>
+        class Scope
+        {
+        public:
+            explicit Scope(const char* name) : name(Enabled() ? name : nullptr), startNs(this->name ? Now() : 0) {}
+
+            ~Scope()
+            {
+                if (name)
+                {
+                    Complete(name, startNs, Now());
+                }
+            }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            const char* name;
+            uint64_t startNs;
+        };
+    }
+}
+
+#define MW_TRACE_CONCAT_INNER(a, b) a##b
+#define MW_TRACE_CONCAT(a, b) MW_TRACE_CONCAT_INNER(a, b)
+
+#ifdef MUSEWRAPPER_TRACING
+#define MW_TRACE_SCOPE(name) ::MuseWrapper::Tracing::Scope MW_TRACE_CONCAT(traceScope, __LINE__)(name)
+#define MW_TRACE_BEGIN(name) do { if (::MuseWrapper::Tracing::Enabled()) ::MuseWrapper::Tracing::Begin(name); } while (0)
+#define MW_TRACE_END(name) do { if (::MuseWrapper::Tracing::Enabled()) ::MuseWrapper::Tracing::End(name); } while (0)
+#define MW_TRACE_COUNTER(name, value) do { if (::MuseWrapper::Tracing::Enabled()) ::MuseWrapper::Tracing::Counter(name, static_cast<double>(value)); } while (0)
+#define MW_TRACE_THREAD_NAME(name) ::MuseWrapper::Tracing::SetThreadName(name)
+#else
+#define MW_TRACE_SCOPE(name) ((void)0)
+#define MW_TRACE_BEGIN(name) ((void)0)
+#define MW_TRACE_END(name) ((void)0)
+#define MW_TRACE_COUNTER(name, value) ((void)0)
+#define MW_TRACE_THREAD_NAME(name) ((void)0)
+#endif
@@ -0,0 +1,396 @@
+#include "pch.h"
+#include "TsMetadataMuxer.h"
+#include "Id3Metadata.h"
+
+namespace MuseWrapper
+{
+    using namespace MpegTs;
+
+    namespace
+    {
+        // Tags are grouped per video frame at up to 60 fps, and PSI is repeated twice a second in sidecar mode
+        constexpr uint64_t TagIntervalTicks = PtsClockHz / 60;
+        constexpr uint64_t TableIntervalTicks = PtsClockHz / 2;
+        constexpr uint64_t PcrLeadTicks = PtsClockHz / 10;
+        constexpr uint16_t SidecarPmtPid = 0x1000;
+        constexpr size_t ReadChunkPackets = 8192;
+
+        const uint8_t MetadataPointerDescriptor[] =
+        {
+            0x25, 15, 0xFF, 0xFF, 'I', 'D', '3', ' ', 0xFF, 'I', 'D', '3', ' ', 0x00, 0x1F, 0x00, 0x01,
+        };
+        const uint8_t MetadataDescriptor[] =
+        {
+            0x26, 13, 0xFF, 0xFF, 'I', 'D', '3', ' ', 0xFF, 'I', 'D', '3', ' ', 0x00, 0x0F,
+        };
+
+        bool IsVideoStream(uint8_t streamType)
+        {
+            return streamType == 0x01 || streamType == 0x02 || streamType == 0x10 || streamType == 0x1B || streamType == 0x24;
+        }
+
+        void FinishSection(std::vector<uint8_t>& section)
+        {
+            size_t sectionLength = section.size() - 3 + 4;
+            section[1] = static_cast<uint8_t>(0xB0 | ((sectionLength >> 8) & 0x0F));
+            section[2] = static_cast<uint8_t>(sectionLength);
+            uint32_t crc = Crc32(section.data(), section.size());
+            section.push_back(static_cast<uint8_t>(crc >> 24));
+            section.push_back(static_cast<uint8_t>(crc >> 16));
+            section.push_back(static_cast<uint8_t>(crc >> 8));
+            section.push_back(static_cast<uint8_t>(crc));
+        }
+
+        void AppendStreamEntry(std::vector<uint8_t>& section, uint16_t pid)
+        {
+            section.push_back(StreamTypeMetadataPes);
+            section.push_back(static_cast<uint8_t>(0xE0 | (pid >> 8)));
+            section.push_back(static_cast<uint8_t>(pid));
+            section.push_back(static_cast<uint8_t>(0xF0));
+            section.push_back(static_cast<uint8_t>(sizeof(MetadataDescriptor)));
+            section.insert(section.end(), std::begin(MetadataDescriptor), std::end(MetadataDescriptor));
+        }
+
+        // Offset of the section a payload-unit-start packet carries, past its pointer_field; 0 unless the
+        // section starts inside the packet and its declared length ends there too
+        size_t SectionOffset(const uint8_t* packet, int payload)
+        {
+            size_t start = static_cast<size_t>(payload) + 1 + packet[payload];
+            if (start + 3 > PacketSize)
+            {
+                return 0;
+            }
+            size_t sectionLength = ((packet[start + 1] & 0x0F) << 8) | packet[start + 2];
+            return sectionLength + 3 <= PacketSize - start ? start : 0;
+        }
+
+        void AppendPointerDescriptor(std::vector<uint8_t>& section, uint16_t programNumber)
+        {
+            size_t start = section.size();
+            section.insert(section.end(), std::begin(MetadataPointerDescriptor), std::end(MetadataPointerDescriptor));
+            section[start + 15] = static_cast<uint8_t>(programNumber >> 8);
+            section[start + 16] = static_cast<uint8_t>(programNumber);
+        }
+
+        void WritePts(uint8_t* out, uint64_t pts)
+        {
+            pts %= PtsWrap;
+            out[0] = static_cast<uint8_t>(0x21 | ((pts >> 29) & 0x0E));
+            out[1] = static_cast<uint8_t>(pts >> 22);
+            out[2] = static_cast<uint8_t>(0x01 | ((pts >> 14) & 0xFE));
+            out[3] = static_cast<uint8_t>(pts >> 7);
+            out[4] = static_cast<uint8_t>(0x01 | ((pts << 1) & 0xFE));
+        }
+    }
+
+    TsMetadataMuxer::TsMetadataMuxer(const std::string& outputPath, int64_t syncTimestampUs)
+        : writer(outputPath),
+          syncTimestampUs(syncTimestampUs),
+          remux(false)
+    {
+        pmtPid = SidecarPmtPid;
+        baseKnown = true;
+    }
+
+    TsMetadataMuxer::TsMetadataMuxer(const std::string& outputPath, const std::string& inputPath, int64_t syncTimestampUs)
+        : writer(outputPath),
+          inputPath(inputPath),
+          syncTimestampUs(syncTimestampUs),
+          remux(true)
+    {
+    }
+
+    bool TsMetadataMuxer::ToPts(int64_t timestampUs, uint64_t& pts) const
+    {
+        if (timestampUs < syncTimestampUs)
+        {
+            return false;
+        }
+        pts = basePts + static_cast<uint64_t>(timestampUs - syncTimestampUs) * 9 / 100;
+        return true;
+    }
+
+    void TsMetadataMuxer::AddPacket(const MusePacket& packet)
+    {
+        if (finished)
+        {
+            throw std::logic_error("Muxer has already finished");
+        }
+
+        // In remux mode the PTS base is only known once the input is read, so store the offset for now
+        uint64_t pts = 0;
+        if (!ToPts(packet.timestampUs, pts))
+        {
+            packetsSkipped++;
+            return;
+        }
+        pending.push_back(TimedPacket{ pts, packet });
+
+        if (!remux)
+        {
+            // Sidecar: a tag closes once a packet lands outside its frame interval
+            uint64_t groupStart = pending[nextPending].pts;
+            if (pts >= groupStart + TagIntervalTicks)
+            {
+                EmitUpTo(pts - 1);
+                pending.erase(pending.begin(), pending.begin() + nextPending);
+                nextPending = 0;
+            }
+        }
+    }
+
+    void TsMetadataMuxer::Finish()
+    {
+        if (finished)
+        {
+            return;
+        }
+        finished = true;
+
+        if (remux)
+        {
+            std::stable_sort(pending.begin(), pending.end(),
+                [](const TimedPacket& a, const TimedPacket& b) { return a.pts < b.pts; });
+            Remux();
+        }
+        else
+        {
+            EmitUpTo(UINT64_MAX);
+        }
+        pending.clear();
+        writer.Close();
+    }
+
+    void TsMetadataMuxer::EmitUpTo(uint64_t limitPts)
+    {
+        while (nextPending < pending.size() && pending[nextPending].pts <= limitPts)
+        {
+            uint64_t groupStart = pending[nextPending].pts;
+            size_t end = nextPending;
+            while (end < pending.size() && end - nextPending < Id3Metadata::MaxPacketsPerTag
+                && pending[end].pts <= limitPts && pending[end].pts < groupStart + TagIntervalTicks)
+            {
+                end++;
+            }
+
+            if (!remux && (!tablesWritten || groupStart >= lastTablesPts + TableIntervalTicks))
+            {
+                WriteSidecarTables();
+                lastTablesPts = groupStart;
+            }
+            WriteTag(nextPending, end - nextPending, !remux);
+            nextPending = end;
+        }
+    }
+
+    void TsMetadataMuxer::WriteTag(size_t first, size_t count, bool withPcr)
+    {
+        batch.clear();
+        for (size_t i = first; i < first + count; i++)
+        {
+            batch.push_back(pending[i].packet);
+        }
+        Id3Metadata::BuildTag(tag, batch.data(), batch.size());
+
+        uint64_t pts = pending[first].pts;
+        size_t pesLength = 3 + 5 + tag.size();
+        pes.resize(9 + 5);
+        pes[0] = 0x00;
+        pes[1] = 0x00;
+        pes[2] = 0x01;
+        pes[3] = PrivateStream1;
+        pes[4] = pesLength > 0xFFFF ? 0 : static_cast<uint8_t>(pesLength >> 8);
+        pes[5] = pesLength > 0xFFFF ? 0 : static_cast<uint8_t>(pesLength);
+        pes[6] = 0x84;  // '10' marker, data_alignment_indicator
+        pes[7] = 0x80;  // PTS only
+        pes[8] = 5;
+        WritePts(pes.data() + 9, pts);
+        pes.insert(pes.end(), tag.begin(), tag.end());
+
+        uint64_t pcr = pts > PcrLeadTicks ? pts - PcrLeadTicks : 0;
+        writer.WritePes(metadataPid, metadataContinuity, pes.data(), pes.size(), withPcr ? &pcr : nullptr);
+        packetsWritten += count;
+        tagsWritten++;
+    }
+
+    void TsMetadataMuxer::WriteSidecarTables()
+    {
+        std::vector<uint8_t> pat = { 0x00, 0x00, 0x00, 0x00, 0x01, 0xC1, 0x00, 0x00 };
+        pat.push_back(static_cast<uint8_t>(programNumber >> 8));
+        pat.push_back(static_cast<uint8_t>(programNumber));
+        pat.push_back(static_cast<uint8_t>(0xE0 | (pmtPid >> 8)));
+        pat.push_back(static_cast<uint8_t>(pmtPid));
+        FinishSection(pat);
+        writer.WriteSection(PatPid, patContinuity, pat.data(), pat.size());
+
+        std::vector<uint8_t> pmt = { 0x02, 0x00, 0x00 };
+        pmt.push_back(static_cast<uint8_t>(programNumber >> 8));
+        pmt.push_back(static_cast<uint8_t>(programNumber));
+        pmt.insert(pmt.end(), { 0xC1, 0x00, 0x00 });
+        pmt.push_back(static_cast<uint8_t>(0xE0 | (metadataPid >> 8)));   // PCR travels on the metadata PID
+        pmt.push_back(static_cast<uint8_t>(metadataPid));
+        pmt.push_back(0xF0);
+        pmt.push_back(static_cast<uint8_t>(sizeof(MetadataPointerDescriptor)));
+        AppendPointerDescriptor(pmt, programNumber);
+        AppendStreamEntry(pmt, metadataPid);
+        FinishSection(pmt);
+        writer.WriteSection(pmtPid, pmtContinuity, pmt.data(), pmt.size());
+        tablesWritten = true;
+    }
+
+    std::vector<uint8_t> TsMetadataMuxer::RewritePmt(const uint8_t* section, size_t length)
+    {
+        size_t sectionLength = ((section[1] & 0x0F) << 8) | section[2];
+        if (section[0] != 0x02 || sectionLength + 3 > length || sectionLength < 13)
+        {
+            throw std::runtime_error("Malformed or multi-packet PMT in " + inputPath);
+        }
+
+        size_t end = 3 + sectionLength - 4;
+        size_t programInfoLength = ((section[10] & 0x0F) << 8) | section[11];
+        if (12 + programInfoLength > end)
+        {
+            throw std::runtime_error("Malformed PMT in " + inputPath);
+        }
+        programNumber = static_cast<uint16_t>((section[3] << 8) | section[4]);
+
+        // Choose the video PID and a metadata PID that does not collide with existing streams
+        std::vector<uint16_t> usedPids = { pmtPid, static_cast<uint16_t>(((section[8] & 0x1F) << 8) | section[9]) };
+        uint16_t firstPid = NullPid;
+        for (size_t i = 12 + programInfoLength; i + 5 <= end;)
+        {
+            uint8_t streamType = section[i];
+            uint16_t pid = static_cast<uint16_t>(((section[i + 1] & 0x1F) << 8) | section[i + 2]);
+            size_t esInfoLength = ((section[i + 3] & 0x0F) << 8) | section[i + 4];
+            usedPids.push_back(pid);
+            if (firstPid == NullPid)
+            {
+                firstPid = pid;
+            }
+            if (videoPid == NullPid && IsVideoStream(streamType))
+            {
+                videoPid = pid;
+            }
+            i += 5 + esInfoLength;
+        }
+        if (videoPid == NullPid)
+        {
+            videoPid = firstPid;
+        }
+        while (std::find(usedPids.begin(), usedPids.end(), metadataPid) != usedPids.end())
+        {
+            metadataPid++;
+        }
+
+        std::vector<uint8_t> rewritten(section, section + 12);
+        size_t newProgramInfoLength = programInfoLength + sizeof(MetadataPointerDescriptor);
+        rewritten[10] = static_cast<uint8_t>(0xF0 | (newProgramInfoLength >> 8));
+        rewritten[11] = static_cast<uint8_t>(newProgramInfoLength);
+        rewritten.insert(rewritten.end(), section + 12, section + 12 + programInfoLength);
+        AppendPointerDescriptor(rewritten, programNumber);
+        rewritten.insert(rewritten.end(), section + 12 + programInfoLength, section + end);
+        AppendStreamEntry(rewritten, metadataPid);
+        FinishSection(rewritten);
+        return rewritten;
+    }
+
+    uint64_t TsMetadataMuxer::ExtendPts(uint64_t pts)
+    {
+        if (pts < lastPts && lastPts - pts > PtsWrap / 2)
+        {
+            ptsEpoch += PtsWrap;
+        }
+        lastPts = pts;
+        return ptsEpoch + pts;
+    }
+
+    void TsMetadataMuxer::Remux()
+    {
+        std::unique_ptr<std::FILE, int (*)(std::FILE*)> input(std::fopen(inputPath.c_str(), "rb"), &std::fclose);
+        if (!input)
+        {
+            throw std::runtime_error("Cannot open " + inputPath);
+        }
+
+        std::vector<uint8_t> chunk(ReadChunkPackets * PacketSize);
+        std::vector<uint8_t> rewrittenPmt;
+        size_t bytesRead;
+        while ((bytesRead = std::fread(chunk.data(), 1, chunk.size(), input.get())) >= PacketSize)
+        {
+            for (size_t offset = 0; offset + PacketSize <= bytesRead; offset += PacketSize)
+            {
+                uint8_t* packet = chunk.data() + offset;
+                if (packet[0] != SyncByte)
+                {
+                    throw std::runtime_error("Lost transport stream sync in " + inputPath);
+                }
+
+                uint16_t pid = Pid(packet);
+                int payload = PayloadOffset(packet);
+
+                if (pid == PatPid && pmtPid == 0 && payload > 0 && PayloadUnitStart(packet))
+                {
+                    size_t start = SectionOffset(packet, payload);
+                    const uint8_t* section = packet + start;
+                    size_t sectionLength = ((section[1] & 0x0F) << 8) | section[2];
+                    // Header fields from table_id_extension to last_section_number plus the CRC
+                    if (start == 0 || sectionLength < 9)
+                    {
+                        throw std::runtime_error("Malformed PAT in " + inputPath);
+                    }
+                    for (size_t i = 8; i + 4 <= 3 + sectionLength - 4; i += 4)
+                    {
+                        uint16_t program = static_cast<uint16_t>((section[i] << 8) | section[i + 1]);
+                        if (program != 0)
+                        {
+                            pmtPid = static_cast<uint16_t>(((section[i + 2] & 0x1F) << 8) | section[i + 3]);
+                            break;
+                        }
+                    }
+                }
+                else if (pid == pmtPid && pmtPid != 0 && payload > 0 && PayloadUnitStart(packet))
+                {
+                    size_t start = SectionOffset(packet, payload);
+                    if (start == 0)
+                    {
+                        throw std::runtime_error("Malformed or multi-packet PMT in " + inputPath);
+                    }
+                    if (rewrittenPmt.empty())
+                    {
+                        rewrittenPmt = RewritePmt(packet + start, PacketSize - start);
+                        if (rewrittenPmt.size() + 1 > static_cast<size_t>(PacketSize - 4))
+                        {
+                            throw std::runtime_error("PMT with metadata stream no longer fits in one packet");
+                        }
+                    }
+                    uint8_t continuity = ContinuityCounter(packet);
+                    writer.WriteSection(pmtPid, continuity, rewrittenPmt.data(), rewrittenPmt.size());
+                    continue;
+                }
+                else if (pid == videoPid && payload > 0 && PayloadUnitStart(packet))
+                {
+                    uint64_t pts = 0;
+                    if (ReadPesPts(packet + payload, PacketSize - payload, pts))
+                    {
+                        uint64_t extended = ExtendPts(pts);
+                        if (!baseKnown)
+                        {
+                            // Offsets were computed against a zero base; shift them onto the video timeline
+                            basePts = extended;
+                            baseKnown = true;
+                            for (TimedPacket& timed : pending)
+                            {
+                                timed.pts += basePts;
+                            }
+                        }
+                        EmitUpTo(extended);
+                    }
+                }
+
+                writer.WritePacket(packet);
+            }
+        }
+
+        EmitUpTo(UINT64_MAX);
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "MpegTs.h"
+#include "MuseTypes.h"
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Embeds brain-data packets as ID3 timed metadata (stream_type 0x15, private_stream_1 PES) in MPEG-TS.
+    ///
+    /// Sidecar mode streams a metadata-only transport stream as packets arrive; PTS 0 corresponds to
+    /// syncTimestampUs. Remux mode buffers packets and, on Finish, copies a local .ts file adding the
+    /// metadata stream to its PMT, interleaving tags ahead of the video frame they belong to;
+    /// syncTimestampUs is the packet timestamp that coincides with the first video PTS.
+    /// </summary>
+    class TsMetadataMuxer
+    {
+    public:
+        TsMetadataMuxer(const std::string& outputPath, int64_t syncTimestampUs);
+        TsMetadataMuxer(const std::string& outputPath, const std::string& inputPath, int64_t syncTimestampUs);
+
+        void AddPacket(const MusePacket& packet);
+
+        /// <summary>
+        /// Writes any pending metadata (and performs the remux in remux mode) and closes the output
+        /// </summary>
+        void Finish();
+
+        uint64_t PacketsWritten() const { return packetsWritten; }
+        uint64_t PacketsSkipped() const { return packetsSkipped; }
+        uint64_t TagsWritten() const { return tagsWritten; }
+
+    private:
+        struct TimedPacket
+        {
+            uint64_t pts;
+            MusePacket packet;
+        };
+
+        bool ToPts(int64_t timestampUs, uint64_t& pts) const;
+        void EmitUpTo(uint64_t limitPts);
+        void WriteTag(size_t first, size_t count, bool withPcr);
+        void WriteSidecarTables();
+        void Remux();
+        std::vector<uint8_t> RewritePmt(const uint8_t* section, size_t length);
+        uint64_t ExtendPts(uint64_t pts);
+
+        MpegTs::TsWriter writer;
+        std::string inputPath;
+        int64_t syncTimestampUs;
+        bool remux;
+        bool finished = false;
+
+        std::vector<TimedPacket> pending;
+        size_t nextPending = 0;
+        std::vector<MusePacket> batch;
+        std::vector<uint8_t> tag;
+        std::vector<uint8_t> pes;
+
+        uint64_t basePts = 0;
+        bool baseKnown = false;
+        uint64_t lastPts = 0;
+        uint64_t ptsEpoch = 0;
+        uint64_t lastTablesPts = 0;
+        bool tablesWritten = false;
+
+        uint16_t pmtPid = 0;
+        uint16_t videoPid = MpegTs::NullPid;
+        uint16_t metadataPid = 0x0100;
+        uint16_t programNumber = 1;
+        uint8_t patContinuity = 0;
+        uint8_t pmtContinuity = 0;
+        uint8_t metadataContinuity = 0;
+
+        uint64_t packetsWritten = 0;
+        uint64_t packetsSkipped = 0;
+        uint64_t tagsWritten = 0;
+    };
+}
@@ -0,0 +1,51 @@
+// TsMuxerApi.cpp : Exported entry points for embedding brain data as MPEG-TS timed metadata.
+#include "pch.h"
+#include "ApiSupport.h"
+#include "TsMetadataMuxer.h"
+
+using namespace MuseWrapper;
+
+namespace
+{
+    HandleTable<TsMetadataMuxer> muxers;
+}
+
+int MwTsMuxerCreate(const char* outputPath, const char* inputPath, int64_t syncTimestampUs, int* handleOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(outputPath != nullptr && handleOut != nullptr, "outputPath and handleOut are required");
+        std::shared_ptr<TsMetadataMuxer> muxer = inputPath != nullptr && *inputPath != '\0'
+            ? std::make_shared<TsMetadataMuxer>(outputPath, inputPath, syncTimestampUs)
+            : std::make_shared<TsMetadataMuxer>(outputPath, syncTimestampUs);
+        *handleOut = muxers.Add(std::move(muxer));
+        return MW_OK;
+    });
+}
+
+int MwTsMuxerAddPacket(int handle, int packetType, int64_t timestampUs, const double* values, int numValues, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        Require(packetType >= 0 && packetType < PacketTypeCount, "Unknown packet type");
+        Require(numValues >= 0 && numValues <= MaxPacketValues && (values != nullptr || numValues == 0), "Invalid packet values");
+        MusePacket packet = { static_cast<MuseDataPacketType>(packetType), numValues, timestampUs, {} };
+        std::copy_n(values, numValues, packet.values);
+        muxers.Get(handle)->AddPacket(packet);
+        return MW_OK;
+    });
+}
+
+int MwTsMuxerClose(int handle, int64_t* packetsWrittenOut, char* errorOut, int errorLen)
+{
+    return InvokeApi(errorOut, errorLen, [&]
+    {
+        std::shared_ptr<TsMetadataMuxer> muxer = muxers.Remove(handle);
+        muxer->Finish();
+        if (packetsWrittenOut != nullptr)
+        {
+            *packetsWrittenOut = static_cast<int64_t>(muxer->PacketsWritten());
+        }
+        return MW_OK;
+    });
+}
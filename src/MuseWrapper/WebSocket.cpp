@@ -0,0 +1,267 @@
+#include "pch.h"
+#include "WebSocket.h"
+
+#include <cctype>
+
+namespace MuseWrapper
+{
+    namespace WebSocket
+    {
+        namespace
+        {
+            const char AcceptGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+            inline uint32_t RotateLeft(uint32_t value, int bits)
+            {
+                return (value << bits) | (value >> (32 - bits));
+            }
+
+            std::string HeaderValue(const std::string& request, const char* name)
+            {
+                size_t nameLength = std::strlen(name);
+                size_t lineStart = request.find("\r\n");
+                while (lineStart != std::string::npos)
+                {
+                    lineStart += 2;
+                    size_t lineEnd = request.find("\r\n", lineStart);
+                    if (lineEnd == std::string::npos || lineEnd == lineStart)
+                    {
+                        break;
+                    }
+                    if (lineEnd - lineStart > nameLength && request[lineStart + nameLength] == ':')
+                    {
+                        bool match = true;
+                        for (size_t i = 0; i < nameLength && match; i++)
+                        {
+                            match = std::tolower(static_cast<unsigned char>(request[lineStart + i])) == std::tolower(static_cast<unsigned char>(name[i]));
+                        }
+                        if (match)
+                        {
+                            size_t valueStart = request.find_first_not_of(' ', lineStart + nameLength + 1);
+                            return request.substr(valueStart, lineEnd - valueStart);
+                        }
+                    }
+                    lineStart = lineEnd;
+                }
+                return std::string();
+            }
+        }
+
+        HandshakeResult ProcessHandshake(const std::string& request, std::string& response)
+        {
+            if (request.find("\r\n\r\n") == std::string::npos)
+            {
+                return request.size() > MaxHandshakeSize ? HandshakeResult::Rejected : HandshakeResult::Incomplete;
+            }
+
+            std::string key = HeaderValue(request, "Sec-WebSocket-Key");
+            if (request.compare(0, 4, "GET ") != 0 || key.empty())
+            {
+                response = "HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n";
+                return HandshakeResult::Rejected;
+            }
+
+            std::string accept = key + AcceptGuid;
+            std::array<uint8_t, 20> digest = Sha1(accept.data(), accept.size());
+            response = "HTTP/1.1 101 Switching Protocols\r\n"
+                "Upgrade: websocket\r\n"
+                "Connection: Upgrade\r\n"
+                "Sec-WebSocket-Accept: " + Base64(digest.data(), digest.size()) + "\r\n\r\n";
+            return HandshakeResult::Accepted;
+        }
+
+        size_t EncodeHeader(uint8_t* out, Opcode opcode, uint64_t payloadLength)
+        {
+            out[0] = static_cast<uint8_t>(0x80 | opcode);
+            if (payloadLength < 126)
+            {
+                out[1] = static_cast<uint8_t>(payloadLength);
+                return 2;
+            }
+            if (payloadLength <= 0xFFFF)
+            {
+                out[1] = 126;
+                out[2] = static_cast<uint8_t>(payloadLength >> 8);
+                out[3] = static_cast<uint8_t>(payloadLength);
+                return 4;
+            }
+            out[1] = 127;
+            for (int i = 0; i < 8; i++)
+            {
+                out[2 + i] = static_cast<uint8_t>(payloadLength >> (56 - 8 * i));
+            }
+            return 10;
+        }
+
+        int Decoder::Parse(size_t offset, Opcode& opcode, size_t& payloadOffset, size_t& payloadLength)
+        {
+            size_t available = buffer.size() - offset;
+            if (available < 2)
+            {
+                return 0;
+            }
+
+            const uint8_t* frame = buffer.data() + offset;
+            bool masked = (frame[1] & 0x80) != 0;
+            if (!masked || (frame[0] & 0x70) != 0)
+            {
+                return -1;  // clients must mask and we negotiate no extensions
+            }
+
+            uint64_t length = frame[1] & 0x7F;
+            size_t header = 2;
+            if (length == 126)
+            {
+                if (available < 4)
+                {
+                    return 0;
+                }
+                length = (static_cast<uint64_t>(frame[2]) << 8) | frame[3];
+                header = 4;
+            }
+            else if (length == 127)
+            {
+                if (available < 10)
+                {
+                    return 0;
+                }
+                length = 0;
+                for (int i = 0; i < 8; i++)
+                {
+                    length = (length << 8) | frame[2 + i];
+                }
+                header = 10;
+            }
+            if (length > MaxPayload)
+            {
+                return -1;
+            }
+            if (available < header + 4 + length)
+            {
+                return 0;
+            }
+
+            uint8_t* payload = buffer.data() + offset + header + 4;
+            const uint8_t* mask = frame + header;
+            for (size_t i = 0; i < length; i++)
+            {
+                payload[i] ^= mask[i & 3];
+            }
+
+            opcode = static_cast<Opcode>(frame[0] & 0x0F);
+            if (opcode == Continuation)
+            {
+                opcode = lastDataOpcode;
+            }
+            else if (opcode == Text || opcode == Binary)
+            {
+                lastDataOpcode = opcode;
+            }
+            payloadOffset = offset + header + 4;
+            payloadLength = static_cast<size_t>(length);
+            return 1;
+        }
+
+        std::string Base64(const uint8_t* data, size_t length)
+        {
+            static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            std::string encoded;
+            encoded.reserve((length + 2) / 3 * 4);
+            for (size_t i = 0; i < length; i += 3)
+            {
+                uint32_t block = static_cast<uint32_t>(data[i]) << 16;
+                if (i + 1 < length)
+                {
+                    block |= static_cast<uint32_t>(data[i + 1]) << 8;
+                }
+                if (i + 2 < length)
+                {
+                    block |= data[i + 2];
+                }
+                encoded.push_back(alphabet[(block >> 18) & 0x3F]);
+                encoded.push_back(alphabet[(block >> 12) & 0x3F]);
+                encoded.push_back(i + 1 < length ? alphabet[(block >> 6) & 0x3F] : '=');
+                encoded.push_back(i + 2 < length ? alphabet[block & 0x3F] : '=');
+            }
+            return encoded;
+        }
+
+        std::array<uint8_t, 20> Sha1(const void* data, size_t length)
+        {
+            uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+            std::vector<uint8_t> message(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + length);
+            message.push_back(0x80);
+            while (message.size() % 64 != 56)
+            {
+                message.push_back(0);
+            }
+            uint64_t bits = static_cast<uint64_t>(length) * 8;
+            for (int i = 7; i >= 0; i--)
+            {
+                message.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+            }
+
+            for (size_t chunk = 0; chunk < message.size(); chunk += 64)
+            {
+                uint32_t w[80];
+                for (int i = 0; i < 16; i++)
+                {
+                    const uint8_t* p = &message[chunk + 4 * i];
+                    w[i] = (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+                }
+                for (int i = 16; i < 80; i++)
+                {
+                    w[i] = RotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+                }
+
+                uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+                for (int i = 0; i < 80; i++)
+                {
+                    uint32_t f, k;
+                    if (i < 20)
+                    {
+                        f = (b & c) | (~b & d);
+                        k = 0x5A827999;
+                    }
+                    else if (i < 40)
+                    {
+                        f = b ^ c ^ d;
+                        k = 0x6ED9EBA1;
+                    }
+                    else if (i < 60)
+                    {
+                        f = (b & c) | (b & d) | (c & d);
+                        k = 0x8F1BBCDC;
+                    }
+                    else
+                    {
+                        f = b ^ c ^ d;
+                        k = 0xCA62C1D6;
+                    }
+                    uint32_t temp = RotateLeft(a, 5) + f + e + k + w[i];
+                    e = d;
+                    d = c;
+                    c = RotateLeft(b, 30);
+                    b = a;
+                    a = temp;
+                }
+                h[0] += a;
+                h[1] += b;
+                h[2] += c;
+                h[3] += d;
+                h[4] += e;
+            }
+
+            std::array<uint8_t, 20> digest;
+            for (int i = 0; i < 5; i++)
+            {
+                digest[4 * i] = static_cast<uint8_t>(h[i] >> 24);
+                digest[4 * i + 1] = static_cast<uint8_t>(h[i] >> 16);
+                digest[4 * i + 2] = static_cast<uint8_t>(h[i] >> 8);
+                digest[4 * i + 3] = static_cast<uint8_t>(h[i]);
+            }
+            return digest;
+        }
+    }
+}
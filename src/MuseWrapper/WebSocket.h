@@ -0,0 +1,82 @@
+#pragma once
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Minimal RFC 6455 server-side support: opening handshake, frame headers and a decoder for
+    /// masked client frames. Only what the overlay pages and spectator clients use is implemented.
+    /// </summary>
+    namespace WebSocket
+    {
+        enum Opcode : uint8_t
+        {
+            Continuation = 0x0,
+            Text = 0x1,
+            Binary = 0x2,
+            Close = 0x8,
+            Ping = 0x9,
+            Pong = 0xA,
+        };
+
+        constexpr size_t MaxHeaderSize = 10;
+        constexpr size_t MaxHandshakeSize = 8192;
+
+        enum class HandshakeResult
+        {
+            Incomplete,
+            Accepted,
+            Rejected,
+        };
+
+        /// <summary>
+        /// Parses a buffered HTTP upgrade request and builds the 101 response when it is complete
+        /// </summary>
+        HandshakeResult ProcessHandshake(const std::string& request, std::string& response);
+
+        /// <summary>
+        /// Writes an unmasked, final server frame header and returns its length
+        /// </summary>
+        size_t EncodeHeader(uint8_t* out, Opcode opcode, uint64_t payloadLength);
+
+        /// <summary>
+        /// Incremental decoder for client-to-server frames; control frames are delivered whole,
+        /// fragmented data messages are delivered per fragment with their original opcode
+        /// </summary>
+        class Decoder
+        {
+        public:
+            static constexpr size_t MaxPayload = 64 * 1024;
+
+            /// <summary>
+            /// Consumes bytes, invoking onFrame(opcode, payload, length) per frame; returns false on a protocol error
+            /// </summary>
+            template <typename OnFrame>
+            bool Feed(const uint8_t* data, size_t length, OnFrame&& onFrame)
+            {
+                buffer.insert(buffer.end(), data, data + length);
+                size_t consumed = 0;
+                Opcode opcode;
+                size_t payloadOffset;
+                size_t payloadLength;
+                int result;
+                while ((result = Parse(consumed, opcode, payloadOffset, payloadLength)) > 0)
+                {
+                    onFrame(opcode, buffer.data() + payloadOffset, payloadLength);
+                    consumed = payloadOffset + payloadLength;
+                }
+                buffer.erase(buffer.begin(), buffer.begin() + consumed);
+                return result == 0;
+            }
+
+        private:
+            // Returns 1 for a complete frame (unmasked in place), 0 when more data is needed, -1 on error
+            int Parse(size_t offset, Opcode& opcode, size_t& payloadOffset, size_t& payloadLength);
+
+            std::vector<uint8_t> buffer;
+            Opcode lastDataOpcode = Binary;
+        };
+
+        std::string Base64(const uint8_t* data, size_t length);
+        std::array<uint8_t, 20> Sha1(const void* data, size_t length);
+    }
+}
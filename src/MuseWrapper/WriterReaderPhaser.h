@@ -0,0 +1,55 @@
+#pragma once
+
+namespace MuseWrapper
+{
+    /// <summary>
+    /// Lets wait-free writers record into one of two buffers while a reader swaps them: writers call
+    /// WriterEnter, write to the buffer it names and pass its result to WriterExit. FlipPhase (one
+    /// reader at a time) directs new writers to the other buffer and waits for writers still in the
+    /// old one, after which the old buffer can be read and cleared without racing anyone.
+    /// </summary>
+    class WriterReaderPhaser
+    {
+    public:
+        /// <summary>
+        /// Returns the writer's ticket; ActiveIndex(ticket) is the buffer to write to
+        /// </summary>
+        int64_t WriterEnter()
+        {
+            return startEpoch.fetch_add(1, std::memory_order_acq_rel);
+        }
+
+        void WriterExit(int64_t ticket)
+        {
+            (ticket < 0 ? oddEndEpoch : evenEndEpoch).fetch_add(1, std::memory_order_release);
+        }
+
+        static int ActiveIndex(int64_t ticket)
+        {
+            return ticket < 0 ? 1 : 0;
+        }
+
+        /// <summary>
+        /// Swaps the buffers and returns the index of the one writers have just left
+        /// </summary>
+        int FlipPhase()
+        {
+            bool toOdd = startEpoch.load(std::memory_order_acquire) >= 0;
+            int64_t initial = toOdd ? INT64_MIN : 0;
+            (toOdd ? oddEndEpoch : evenEndEpoch).store(initial, std::memory_order_relaxed);
+            int64_t entered = startEpoch.exchange(initial, std::memory_order_acq_rel);
+
+            std::atomic<int64_t>& leaving = toOdd ? evenEndEpoch : oddEndEpoch;
+            while (leaving.load(std::memory_order_acquire) != entered)
+            {
+                std::this_thread::yield();
+            }
+            return toOdd ? 0 : 1;
+        }
+
+    private:
+        std::atomic<int64_t> startEpoch{ 0 };
+        std::atomic<int64_t> evenEndEpoch{ 0 };
+        std::atomic<int64_t> oddEndEpoch{ INT64_MIN };
+    };
+}
@@ -1,5 +1,9 @@
 #pragma once
 
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
+#define NOMINMAX                        // Keep std::min/std::max usable
+#define _CRT_SECURE_NO_WARNINGS         // Portable fopen/fread are used for recordings and transport streams
 // Windows Header Files
 #include <windows.h>
+#endif
@@ -0,0 +1,89 @@
+// AllocationCounter.cpp : Replaces the global allocation functions so benchmarks can report
+// allocations per operation. MuseWrapper is linked statically, so its allocations are counted too.
+// Builds with MUSEWRAPPER_ALLOCATION_TRACKING already replace them in AllocationTracking.cpp, so
+// there the count comes from MuseWrapper's tracker instead.
+
+#include "pch.h"
+#include "AllocationTracking.h"
+#include "Benchmark.h"
+
+#ifdef MUSEWRAPPER_ALLOCATION_TRACKING
+
+uint64_t AllocationCount()
+{
+    return MuseWrapper::AllocationTracking::GetTotals().allocations;
+}
+
+#else
+
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace
+{
+    std::atomic<uint64_t> allocations{ 0 };
+
+    void* Allocate(size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        if (void* p = std::malloc(size != 0 ? size : 1))
+        {
+            return p;
+        }
+        throw std::bad_alloc();
+    }
+
+    void* AllocateAligned(size_t size, std::align_val_t alignment)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        size_t align = static_cast<size_t>(alignment);
+#ifdef _WIN32
+        void* p = _aligned_malloc(size != 0 ? size : 1, align);
+#else
+        void* p = nullptr;
+        if (posix_memalign(&p, std::max(align, sizeof(void*)), size != 0 ? size : 1) != 0)
+        {
+            p = nullptr;
+        }
+#endif
+        if (p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    void FreeAligned(void* p)
+    {
+#ifdef _WIN32
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+}
+
+uint64_t AllocationCount()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size) { return Allocate(size); }
+void* operator new[](size_t size) { return Allocate(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { FreeAligned(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { FreeAligned(p); }
+
+#endif
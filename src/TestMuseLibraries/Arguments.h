@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Minimal "--name value" / "--flag" parser shared by the harness commands
+class Arguments
+{
+public:
+    Arguments(int argc, char** argv) : argc(argc), argv(argv) {}
+
+    bool Has(const char* name) const
+    {
+        return Find(name) >= 0;
+    }
+
+    std::string GetString(const char* name, const std::string& fallback) const
+    {
+        int index = Find(name);
+        return index >= 0 && index + 1 < argc ? argv[index + 1] : fallback;
+    }
+
+    long long GetInt(const char* name, long long fallback) const
+    {
+        int index = Find(name);
+        return index >= 0 && index + 1 < argc ? std::atoll(argv[index + 1]) : fallback;
+    }
+
+    double GetDouble(const char* name, double fallback) const
+    {
+        int index = Find(name);
+        return index >= 0 && index + 1 < argc ? std::atof(argv[index + 1]) : fallback;
+    }
+
+    // Comma-separated integers, e.g. a CPU list "2,3"; empty when absent
+    std::vector<int> GetIntList(const char* name) const
+    {
+        std::vector<int> values;
+        std::string text = GetString(name, "");
+        size_t start = 0;
+        while (start < text.size())
+        {
+            size_t comma = text.find(',', start);
+            values.push_back(std::atoi(text.substr(start, comma - start).c_str()));
+            start = comma == std::string::npos ? text.size() : comma + 1;
+        }
+        return values;
+    }
+
+private:
+    int Find(const char* name) const
+    {
+        for (int i = 0; i < argc; i++)
+        {
+            if (std::strncmp(argv[i], "--", 2) == 0 && std::strcmp(argv[i] + 2, name) == 0)
+            {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    int argc;
+    char** argv;
+};
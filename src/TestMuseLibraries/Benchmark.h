@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Clock.h"
+
+#include <span>
+
+// Microbenchmark support for the "bench" command. A benchmark function does its setup, then
+// calls state.Measure(op) once with the hot-path operation; Measure calibrates a batch size so
+// each timed sample spans at least TargetBatchNs, warms up, and samples until the time budget
+// is spent. Latency percentiles are per operation: exact when an operation is slower than
+// the batch target (batch of 1), otherwise the mean of each batch.
+
+/// <summary>
+/// Number of global operator new calls made by this process so far (see AllocationCounter.cpp)
+/// </summary>
+uint64_t AllocationCount();
+
+/// <summary>
+/// Keeps a computed value alive so the optimiser cannot drop the work that produced it
+/// </summary>
+void Consume(double value);
+
+struct BenchmarkResult
+{
+    std::string name;
+    uint64_t operations = 0;
+    uint64_t batch = 0;
+    double nsPerOp = 0.0;
+    double opsPerSecond = 0.0;
+    double bytesPerSecond = 0.0;
+    double allocationsPerOp = 0.0;
+    double p50Ns = 0.0;
+    double p99Ns = 0.0;
+    double p999Ns = 0.0;
+};
+
+class BenchmarkState
+{
+public:
+    static constexpr uint64_t TargetBatchNs = 2000;
+    static constexpr uint64_t MaxBatch = 1 << 20;
+    static constexpr size_t MaxSamples = 1 << 20;
+
+    BenchmarkState(const char* name, double seconds) : seconds(seconds)
+    {
+        result.name = name;
+    }
+
+    /// <summary>
+    /// Bytes processed by one operation, for the throughput column
+    /// </summary>
+    void SetBytesPerOp(uint64_t bytes) { bytesPerOp = bytes; }
+
+    template <typename Op>
+    void Measure(Op&& op)
+    {
+        uint64_t batch = 1;
+        while (true)
+        {
+            uint64_t start = MuseWrapper::MonotonicNanoseconds();
+            for (uint64_t i = 0; i < batch; i++)
+            {
+                op();
+            }
+            if (MuseWrapper::MonotonicNanoseconds() - start >= TargetBatchNs || batch >= MaxBatch)
+            {
+                break;
+            }
+            batch *= 2;
+        }
+
+        uint64_t budgetNs = static_cast<uint64_t>(seconds * 1e9);
+        uint64_t warmupEnd = MuseWrapper::MonotonicNanoseconds() + budgetNs / 10;
+        while (MuseWrapper::MonotonicNanoseconds() < warmupEnd)
+        {
+            for (uint64_t i = 0; i < batch; i++)
+            {
+                op();
+            }
+        }
+
+        // Reserve before counting so the sample buffer itself never shows up as an allocation
+        samples.clear();
+        samples.reserve(MaxSamples);
+        uint64_t allocationsBefore = AllocationCount();
+        uint64_t start = MuseWrapper::MonotonicNanoseconds();
+        uint64_t now = start;
+        while ((now - start < budgetNs || samples.size() < 100) && samples.size() < MaxSamples)
+        {
+            uint64_t sampleStart = now;
+            for (uint64_t i = 0; i < batch; i++)
+            {
+                op();
+            }
+            now = MuseWrapper::MonotonicNanoseconds();
+            samples.push_back(now - sampleStart);
+        }
+        uint64_t allocations = AllocationCount() - allocationsBefore;
+
+        Summarise(batch, now - start, allocations);
+    }
+
+    const BenchmarkResult& Result() const { return result; }
+
+private:
+    void Summarise(uint64_t batch, uint64_t elapsedNs, uint64_t allocations);
+
+    double seconds;
+    uint64_t bytesPerOp = 0;
+    std::vector<uint64_t> samples;
+    BenchmarkResult result;
+};
+
+struct BenchmarkDefinition
+{
+    const char* name;
+    void (*run)(BenchmarkState& state);
+};
+
+/// <summary>
+/// Every benchmark in the suite, in report order (Benchmarks.cpp)
+/// </summary>
+std::span<const BenchmarkDefinition> RegisteredBenchmarks();
@@ -0,0 +1,339 @@
+// BenchmarkRunner.cpp : The "bench" command. Runs the microbenchmarks, prints a table, optionally
+// writes the results as JSON, and compares them against a baseline written by an earlier run.
+// A benchmark regresses when ns/op or p99 grows by more than the threshold percentage, or when
+// it allocates more per operation; any regression makes the command exit with status 1.
+//
+// Baselines are machine-specific: record them with --write-baseline on the machine (or CI runner
+// class) that will run the comparison.
+
+#include "pch.h"
+#include "Arguments.h"
+#include "Benchmark.h"
+#include "Commands.h"
+#include "Statistics.h"
+
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+namespace
+{
+    volatile double sink;
+
+    using BaselineEntry = std::map<std::string, double>;
+
+    // Reads {"benchmarks": [{"name": "...", "<field>": <number>, ...}, ...]} as written by WriteJson;
+    // only flat objects with string and number values are understood
+    class BaselineParser
+    {
+    public:
+        explicit BaselineParser(const std::string& text) : text(text) {}
+
+        std::map<std::string, BaselineEntry> Parse()
+        {
+            std::map<std::string, BaselineEntry> entries;
+            size_t key = text.find("\"benchmarks\"");
+            if (key == std::string::npos)
+            {
+                throw std::runtime_error("Baseline has no \"benchmarks\" array");
+            }
+            position = text.find('[', key);
+            if (position == std::string::npos)
+            {
+                throw std::runtime_error("Baseline has no \"benchmarks\" array");
+            }
+            position++;
+            while (true)
+            {
+                SkipSpace();
+                if (Peek() == ']')
+                {
+                    return entries;
+                }
+                if (Peek() == ',')
+                {
+                    position++;
+                    continue;
+                }
+                std::string name;
+                BaselineEntry entry = ParseObject(name);
+                if (name.empty())
+                {
+                    throw std::runtime_error("Baseline entry without a name");
+                }
+                entries[name] = std::move(entry);
+            }
+        }
+
+    private:
+        BaselineEntry ParseObject(std::string& name)
+        {
+            Expect('{');
+            BaselineEntry entry;
+            while (true)
+            {
+                SkipSpace();
+                if (Peek() == '}')
+                {
+                    position++;
+                    return entry;
+                }
+                if (Peek() == ',')
+                {
+                    position++;
+                    continue;
+                }
+                std::string field = ParseString();
+                SkipSpace();
+                Expect(':');
+                SkipSpace();
+                if (Peek() == '"')
+                {
+                    std::string value = ParseString();
+                    if (field == "name")
+                    {
+                        name = value;
+                    }
+                }
+                else
+                {
+                    size_t end = text.find_first_of(",}] \t\r\n", position);
+                    if (end == std::string::npos)
+                    {
+                        throw std::runtime_error("Truncated baseline");
+                    }
+                    entry[field] = std::atof(text.substr(position, end - position).c_str());
+                    position = end;
+                }
+            }
+        }
+
+        std::string ParseString()
+        {
+            Expect('"');
+            size_t end = text.find('"', position);
+            if (end == std::string::npos)
+            {
+                throw std::runtime_error("Unterminated string in baseline");
+            }
+            std::string value = text.substr(position, end - position);
+            position = end + 1;
+            return value;
+        }
+
+        void SkipSpace()
+        {
+            while (position < text.size() && std::isspace(static_cast<unsigned char>(text[position])))
+            {
+                position++;
+            }
+        }
+
+        char Peek() const
+        {
+            if (position >= text.size())
+            {
+                throw std::runtime_error("Truncated baseline");
+            }
+            return text[position];
+        }
+
+        void Expect(char c)
+        {
+            if (Peek() != c)
+            {
+                throw std::runtime_error(std::string("Malformed baseline: expected '") + c + "' at offset " + std::to_string(position));
+            }
+            position++;
+        }
+
+        std::string text;
+        size_t position = 0;
+    };
+
+    std::map<std::string, BaselineEntry> LoadBaseline(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            throw std::runtime_error("Cannot open baseline " + path);
+        }
+        std::stringstream text;
+        text << file.rdbuf();
+        return BaselineParser(text.str()).Parse();
+    }
+
+    void WriteJson(const std::string& path, const std::vector<BenchmarkResult>& results)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("Cannot write " + path);
+        }
+        std::fprintf(file, "{\n  \"version\": 1,\n  \"hardwareThreads\": %u,\n  \"benchmarks\": [\n", std::thread::hardware_concurrency());
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const BenchmarkResult& r = results[i];
+            std::fprintf(file,
+                "    { \"name\": \"%s\", \"nsPerOp\": %.3f, \"p50Ns\": %.1f, \"p99Ns\": %.1f, \"p999Ns\": %.1f, "
+                "\"opsPerSecond\": %.0f, \"bytesPerSecond\": %.0f, \"allocationsPerOp\": %.4f }%s\n",
+                r.name.c_str(), r.nsPerOp, r.p50Ns, r.p99Ns, r.p999Ns, r.opsPerSecond, r.bytesPerSecond,
+                r.allocationsPerOp, i + 1 < results.size() ? "," : "");
+        }
+        std::fprintf(file, "  ]\n}\n");
+        std::fclose(file);
+    }
+
+    std::string FormatRate(double perSecond, const char* unit)
+    {
+        const char* prefixes[] = { "", "k", "M", "G" };
+        int prefix = 0;
+        while (perSecond >= 1000.0 && prefix < 3)
+        {
+            perSecond /= 1000.0;
+            prefix++;
+        }
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.2f %s%s/s", perSecond, prefixes[prefix], unit);
+        return text;
+    }
+
+    // Returns the verdict column for one result; sets regressed when a limit is exceeded
+    std::string Compare(const BenchmarkResult& result, const BaselineEntry& base, double threshold, double tailThreshold, bool& regressed)
+    {
+        auto field = [&](const char* name) { auto it = base.find(name); return it != base.end() ? it->second : 0.0; };
+        double nsChange = field("nsPerOp") > 0.0 ? (result.nsPerOp / field("nsPerOp") - 1.0) * 100.0 : 0.0;
+        double tailChange = field("p99Ns") > 0.0 ? (result.p99Ns / field("p99Ns") - 1.0) * 100.0 : 0.0;
+
+        std::string verdict;
+        if (nsChange > threshold)
+        {
+            verdict += " ns/op";
+        }
+        if (tailChange > tailThreshold)
+        {
+            verdict += " p99";
+        }
+        if (result.allocationsPerOp > field("allocationsPerOp") + 0.001)
+        {
+            verdict += " allocs";
+        }
+
+        char text[96];
+        std::snprintf(text, sizeof(text), "%+6.1f%% %+6.1f%%p99 ", nsChange, tailChange);
+        if (!verdict.empty())
+        {
+            regressed = true;
+            return text + std::string("REGRESSED:") + verdict;
+        }
+        return text + std::string(nsChange < -threshold ? "faster" : "ok");
+    }
+}
+
+void Consume(double value)
+{
+    sink = sink + value;
+}
+
+void BenchmarkState::Summarise(uint64_t batch, uint64_t elapsedNs, uint64_t allocations)
+{
+    uint64_t operations = batch * samples.size();
+    result.operations = operations;
+    result.batch = batch;
+    result.nsPerOp = static_cast<double>(elapsedNs) / static_cast<double>(operations);
+    result.opsPerSecond = 1e9 / result.nsPerOp;
+    result.bytesPerSecond = result.opsPerSecond * static_cast<double>(bytesPerOp);
+    result.allocationsPerOp = static_cast<double>(allocations) / static_cast<double>(operations);
+
+    double perOp = 1.0 / static_cast<double>(batch);
+    result.p50Ns = static_cast<double>(Percentile(samples, 0.50)) * perOp;
+    result.p99Ns = static_cast<double>(Percentile(samples, 0.99)) * perOp;
+    result.p999Ns = static_cast<double>(Percentile(samples, 0.999)) * perOp;
+}
+
+int RunBench(int argc, char** argv)
+{
+    Arguments args(argc, argv);
+    std::string filter = args.GetString("filter", "");
+    double seconds = args.GetDouble("seconds", 1.0);
+    double threshold = args.GetDouble("threshold", 10.0);
+    double tailThreshold = args.GetDouble("tail-threshold", 2.5 * threshold);
+    std::string baselinePath = args.GetString("baseline", "");
+    std::string jsonPath = args.GetString("json", "");
+    std::string writeBaselinePath = args.GetString("write-baseline", "");
+
+    std::map<std::string, BaselineEntry> baseline;
+    try
+    {
+        if (!baselinePath.empty())
+        {
+            baseline = LoadBaseline(baselinePath);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    std::printf("%-30s %10s %10s %10s %10s %16s %16s %8s%s\n", "benchmark", "ns/op", "p50 ns", "p99 ns", "p999 ns",
+        "ops", "bytes", "allocs", baseline.empty() ? "" : "  vs baseline");
+
+    std::vector<BenchmarkResult> results;
+    bool regressed = false;
+    for (const BenchmarkDefinition& definition : RegisteredBenchmarks())
+    {
+        if (!filter.empty() && std::string(definition.name).find(filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        BenchmarkState state(definition.name, seconds);
+        definition.run(state);
+        const BenchmarkResult& r = state.Result();
+        results.push_back(r);
+
+        std::string verdict;
+        auto base = baseline.find(r.name);
+        if (base != baseline.end())
+        {
+            verdict = Compare(r, base->second, threshold, tailThreshold, regressed);
+        }
+        else if (!baseline.empty())
+        {
+            verdict = "(no baseline)";
+        }
+        std::printf("%-30s %10.1f %10.1f %10.1f %10.1f %16s %16s %8.3f  %s\n", r.name.c_str(), r.nsPerOp, r.p50Ns, r.p99Ns, r.p999Ns,
+            FormatRate(r.opsPerSecond, "op").c_str(), r.bytesPerSecond > 0.0 ? FormatRate(r.bytesPerSecond, "B").c_str() : "-",
+            r.allocationsPerOp, verdict.c_str());
+        std::fflush(stdout);
+    }
+
+    try
+    {
+        if (!jsonPath.empty())
+        {
+            WriteJson(jsonPath, results);
+        }
+        if (!writeBaselinePath.empty())
+        {
+            WriteJson(writeBaselinePath, results);
+            std::printf("Baseline written to %s\n", writeBaselinePath.c_str());
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    if (regressed)
+    {
+        std::printf("Regressions exceed the %.1f%% (ns/op) / %.1f%% (p99) thresholds\n", threshold, tailThreshold);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,352 @@
+// Benchmarks.cpp : Hot-path microbenchmarks run by the "bench" command. Names are
+// "<area>.<case>" and are the keys of the JSON baseline, so renaming one orphans its baseline.
+
+#include "pch.h"
+#include "BandPower.h"
+#include "Benchmark.h"
+#include "Dsp.h"
+#include "Id3Metadata.h"
+#include "MuseTypes.h"
+#include "PacketTiming.h"
+#include "Rcu.h"
+#include "SessionRecording.h"
+#include "SpscQueue.h"
+#include "TimerWheel.h"
+#include "WebSocket.h"
+
+#include <filesystem>
+#include <random>
+
+using namespace MuseWrapper;
+
+namespace
+{
+    constexpr double EegRate = 256.0;
+    constexpr int EegChannels = 4;
+
+    // Deterministic EEG-like input: two tones plus noise around the Muse DC offset
+    std::vector<double> SyntheticEeg(size_t samples, int channels)
+    {
+        std::mt19937 random(42);
+        std::normal_distribution<double> noise(0.0, 5.0);
+        std::vector<double> data(samples * static_cast<size_t>(channels));
+        for (size_t i = 0; i < samples; i++)
+        {
+            double t = static_cast<double>(i) / EegRate;
+            for (int c = 0; c < channels; c++)
+            {
+                data[i * channels + c] = 841.0 + 20.0 * std::sin(2.0 * 3.14159265358979 * 10.0 * t + c)
+                    + 8.0 * std::sin(2.0 * 3.14159265358979 * 21.0 * t) + noise(random);
+            }
+        }
+        return data;
+    }
+
+    MusePacket EegPacket(int64_t timestampUs, const double* values)
+    {
+        MusePacket packet = {};
+        packet.type = MuseDataPacketType::Eeg;
+        packet.valueCount = EegChannels;
+        packet.timestampUs = timestampUs;
+        std::memcpy(packet.values, values, EegChannels * sizeof(double));
+        return packet;
+    }
+
+    std::string TempPath(const char* name)
+    {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    // libmuse callback arguments copied into a MusePacket and queued, then drained by the same thread
+    void IngestCallbackToQueue(BenchmarkState& state)
+    {
+        std::vector<double> eeg = SyntheticEeg(1024, EegChannels);
+        SpscQueue<MusePacket> queue(1024);
+        int64_t timestampUs = 0;
+        size_t index = 0;
+        MusePacket drained = {};
+        double checksum = 0.0;
+        state.SetBytesPerOp(sizeof(MusePacket));
+        state.Measure([&]
+        {
+            const double* values = eeg.data() + (index++ & 1023) * EegChannels;
+            queue.TryPush(EegPacket(timestampUs += 3906, values));
+            queue.TryPop(drained);
+            checksum += drained.values[0];
+        });
+        Consume(checksum);
+    }
+
+    // Producer on the benchmark thread, consumer spinning on another: cross-core transfer rate
+    void RingSpscTransfer(BenchmarkState& state)
+    {
+        SpscQueue<MusePacket> queue(4096);
+        std::atomic<bool> stop{ false };
+        std::atomic<uint64_t> consumed{ 0 };
+        std::thread consumer([&]
+        {
+            MusePacket packet;
+            uint64_t count = 0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                while (queue.TryPop(packet))
+                {
+                    count++;
+                }
+            }
+            while (queue.TryPop(packet))
+            {
+                count++;
+            }
+            consumed = count;
+        });
+
+        MusePacket packet = {};
+        packet.type = MuseDataPacketType::Eeg;
+        packet.valueCount = EegChannels;
+        state.SetBytesPerOp(sizeof(MusePacket));
+        state.Measure([&]
+        {
+            packet.timestampUs++;
+            while (!queue.TryPush(packet))
+            {
+                std::this_thread::yield();
+            }
+        });
+        stop = true;
+        consumer.join();
+        Consume(static_cast<double>(consumed.load()));
+    }
+
+    template <typename T>
+    std::vector<T> Samples(const std::vector<double>& values)
+    {
+        return std::vector<T>(values.begin(), values.end());
+    }
+
+    // One second of one channel through the 60 Hz notch and 1 Hz high-pass chain
+    template <typename T>
+    void DspBiquadChain256(BenchmarkState& state)
+    {
+        std::vector<T> input = Samples<T>(SyntheticEeg(256, 1));
+        std::vector<T> output(256);
+        Biquad<T> notch = Biquad<T>::Notch(EegRate, 60.0, 30.0);
+        Biquad<T> highPass = Biquad<T>::HighPass(EegRate, 1.0, 0.7071);
+        state.SetBytesPerOp(256 * sizeof(T));
+        state.Measure([&]
+        {
+            notch.Process(input.data(), output.data(), output.size());
+            highPass.Process(output.data(), output.data(), output.size());
+        });
+        Consume(output[255]);
+    }
+
+    template <typename T>
+    void DspRealFft256(BenchmarkState& state)
+    {
+        std::vector<T> input = Samples<T>(SyntheticEeg(256, 1));
+        std::vector<T> power(129);
+        RealFft<T> fft(256);
+        state.SetBytesPerOp(256 * sizeof(T));
+        state.Measure([&]
+        {
+            fft.PowerSpectrum(input.data(), power.data());
+        });
+        Consume(power[10]);
+    }
+
+    // One 4-channel EEG sample into the estimator; every 26th sample recomputes all bands, which is what p99 shows
+    template <typename T>
+    void BandPowerSample4ch(BenchmarkState& state)
+    {
+        std::vector<T> eeg = Samples<T>(SyntheticEeg(4096, EegChannels));
+        BandPowerEstimator<T> estimator(EegChannels, EegRate);
+        size_t index = 0;
+        double checksum = 0.0;
+        state.SetBytesPerOp(EegChannels * sizeof(T));
+        state.Measure([&]
+        {
+            if (estimator.AddSample(eeg.data() + (index++ & 4095) * EegChannels))
+            {
+                checksum += estimator.Powers()[0];
+            }
+        });
+        Consume(checksum);
+    }
+
+    // One 100 ms metadata tag: the five absolute band packets for a 10 Hz update
+    void SerializeId3BandTag(BenchmarkState& state)
+    {
+        std::vector<MusePacket> packets(5);
+        for (size_t i = 0; i < packets.size(); i++)
+        {
+            packets[i].type = static_cast<MuseDataPacketType>(static_cast<int>(MuseDataPacketType::AlphaAbsolute) + i);
+            packets[i].valueCount = EegChannels;
+            packets[i].timestampUs = 1000000;
+            for (int c = 0; c < EegChannels; c++)
+            {
+                packets[i].values[c] = 0.25 * static_cast<double>(c + i);
+            }
+        }
+        std::vector<uint8_t> tag;
+        Id3Metadata::BuildTag(tag, packets.data(), packets.size());
+        state.SetBytesPerOp(tag.size());
+        state.Measure([&]
+        {
+            packets[0].timestampUs += 100000;
+            Id3Metadata::BuildTag(tag, packets.data(), packets.size());
+        });
+        Consume(static_cast<double>(tag.size()));
+    }
+
+    // Framing a 256-byte overlay update for a WebSocket subscriber
+    void SerializeWebSocketFrame256(BenchmarkState& state)
+    {
+        std::vector<uint8_t> payload(256, 'x');
+        std::vector<uint8_t> frame(WebSocket::MaxHeaderSize + payload.size());
+        size_t length = 0;
+        state.SetBytesPerOp(payload.size());
+        state.Measure([&]
+        {
+            size_t header = WebSocket::EncodeHeader(frame.data(), WebSocket::Text, payload.size());
+            std::memcpy(frame.data() + header, payload.data(), payload.size());
+            length += header + payload.size();
+        });
+        Consume(static_cast<double>(length));
+    }
+
+    // Appending EEG packets to a recording, including the block flush every BlockPackets packets
+    void RecordingWritePacket(BenchmarkState& state)
+    {
+        std::string path = TempPath("mw-bench-write.mwrec");
+        std::vector<double> eeg = SyntheticEeg(1024, EegChannels);
+        {
+            RecordingWriter writer(path, 0);
+            int64_t timestampUs = 0;
+            size_t index = 0;
+            state.SetBytesPerOp(sizeof(StoredPacket));
+            state.Measure([&]
+            {
+                writer.AddPacket(EegPacket(timestampUs += 3906, eeg.data() + (index++ & 1023) * EegChannels));
+            });
+            writer.Finish();
+        }
+        std::filesystem::remove(path);
+    }
+
+    // Random block reads from a 256-block recording, as replay seeks do on a cache miss
+    void RecordingReadBlock(BenchmarkState& state)
+    {
+        std::string path = TempPath("mw-bench-read.mwrec");
+        {
+            std::vector<double> eeg = SyntheticEeg(1024, EegChannels);
+            RecordingWriter writer(path, 0);
+            for (int64_t i = 0; i < 256 * static_cast<int64_t>(RecordingWriter::BlockPackets); i++)
+            {
+                writer.AddPacket(EegPacket(i * 3906, eeg.data() + (i & 1023) * EegChannels));
+            }
+            writer.Finish();
+        }
+        {
+            RecordingReader reader(path);
+            std::vector<StoredPacket> packets;
+            std::mt19937 random(7);
+            std::uniform_int_distribution<size_t> block(0, reader.Blocks().size() - 1);
+            double checksum = 0.0;
+            state.SetBytesPerOp(RecordingWriter::BlockPackets * sizeof(StoredPacket));
+            state.Measure([&]
+            {
+                reader.ReadBlock(block(random), packets);
+                checksum += packets[0].values[0];
+            });
+            Consume(checksum);
+        }
+        std::filesystem::remove(path);
+    }
+
+    // Arrival bookkeeping for one EEG packet at 256 Hz, including the interval rotation every 10 s
+    void TimingRecordEeg(BenchmarkState& state)
+    {
+        std::vector<double> eeg = SyntheticEeg(1024, EegChannels);
+        PacketTimingMonitor monitor(10'000'000'000);
+        int64_t timestampUs = 0;
+        uint64_t arrivalNs = 1;
+        size_t index = 0;
+        state.Measure([&]
+        {
+            timestampUs += 3906;
+            arrivalNs += 3'906'250;
+            monitor.Record(EegPacket(timestampUs, eeg.data() + (index++ & 1023) * EegChannels), arrivalNs);
+        });
+        Consume(static_cast<double>(monitor.Snapshot(MuseDataPacketType::Eeg, arrivalNs).totalPackets));
+    }
+
+    // One packet dispatched to four listeners read from an epoch-protected snapshot, as the ingest worker does
+    void ListenersSnapshotDispatch(BenchmarkState& state)
+    {
+        std::vector<double> eeg = SyntheticEeg(1024, EegChannels);
+        Snapshot<std::vector<std::function<void(const MusePacket&)>>> listeners;
+        double sum = 0.0;
+        listeners.Update([&](std::vector<std::function<void(const MusePacket&)>>& next)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                next.push_back([&sum, i](const MusePacket& packet) { sum += packet.values[i]; });
+            }
+        });
+        int64_t timestampUs = 0;
+        size_t index = 0;
+        state.Measure([&]
+        {
+            MusePacket packet = EegPacket(timestampUs += 3906, eeg.data() + (index++ & 1023) * EegChannels);
+            Epochs::ReadGuard reading;
+            for (const auto& listener : listeners.Read())
+            {
+                listener(packet);
+            }
+        });
+        Consume(sum);
+    }
+
+    // Arming and cancelling a reconnect-style timer on a wheel already holding 500 monitoring timers
+    void TimersScheduleCancel(BenchmarkState& state)
+    {
+        TimerWheel wheel;
+        for (int i = 0; i < 500; i++)
+        {
+            wheel.Schedule(60'000'000'000ull + i * 1'000'000ull, 1'000'000'000, [](uint64_t) {});
+        }
+        uint64_t delayNs = 1'000'000'000;
+        state.Measure([&]
+        {
+            uint64_t id = wheel.Schedule(delayNs, 0, [](uint64_t) {});
+            wheel.Cancel(id);
+            delayNs = delayNs * 2 % 7'000'000'000 + 1'000'000'000;     // spread over levels like a backoff
+        });
+        Consume(static_cast<double>(wheel.Stats().active));
+    }
+
+    const BenchmarkDefinition definitions[] =
+    {
+        { "ingest.callback_to_queue", IngestCallbackToQueue },
+        { "ring.spsc_transfer", RingSpscTransfer },
+        { "dsp.biquad_chain_256", DspBiquadChain256<double> },
+        { "dsp.biquad_chain_256_f32", DspBiquadChain256<float> },
+        { "dsp.real_fft_256", DspRealFft256<double> },
+        { "dsp.real_fft_256_f32", DspRealFft256<float> },
+        { "bandpower.sample_4ch", BandPowerSample4ch<double> },
+        { "bandpower.sample_4ch_f32", BandPowerSample4ch<float> },
+        { "serialize.id3_band_tag", SerializeId3BandTag },
+        { "serialize.websocket_frame_256", SerializeWebSocketFrame256 },
+        { "recording.write_packet", RecordingWritePacket },
+        { "recording.read_block", RecordingReadBlock },
+        { "timing.record_eeg", TimingRecordEeg },
+        { "listeners.snapshot_dispatch", ListenersSnapshotDispatch },
+        { "timers.schedule_cancel", TimersScheduleCancel },
+    };
+}
+
+std::span<const BenchmarkDefinition> RegisteredBenchmarks()
+{
+    return definitions;
+}
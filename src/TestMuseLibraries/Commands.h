@@ -0,0 +1,14 @@
+#pragma once
+
+// Each harness command receives the arguments that follow its name on the command line
+
+int RunHubLoad(int argc, char** argv);
+int RunBench(int argc, char** argv);
+int RunLatency(int argc, char** argv);
+int RunMetrics(int argc, char** argv);
+int RunReplayLoad(int argc, char** argv);
+int RunScaling(int argc, char** argv);
+int RunPrecision(int argc, char** argv);
+int RunConnect(int argc, char** argv);
+int RunOverload(int argc, char** argv);
+int RunThreadState(int argc, char** argv);
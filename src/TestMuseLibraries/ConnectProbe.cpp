@@ -0,0 +1,133 @@
+// ConnectProbe.cpp : Connects headbands through MuseWrapper's native connection state machine and reports how
+// long each phase took and how much CPU the process used while waiting. Run against the libmuse simulator
+// (LIBMUSE_SIM_OPTIONS sets its device count, connect time and failure rate) or a real libmuse.
+
+#include "pch.h"
+#include "Arguments.h"
+#include "Commands.h"
+#include "MuseWrapper.h"
+#include "ProcessUsage.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    const char* const PhaseNames[] = { "idle", "disconnecting", "connecting", "configuring", "ready", "failed", "lost" };
+
+    struct Progress
+    {
+        std::mutex lock;
+        std::condition_variable changed;
+        int finished = 0;
+        bool verbose = false;
+    };
+
+    void OnPhase(int connection, int phase, const char* message, void* context)
+    {
+        Progress& progress = *static_cast<Progress*>(context);
+        std::lock_guard<std::mutex> guard(progress.lock);
+        if (progress.verbose)
+        {
+            std::printf("  #%d %s: %s\n", connection, PhaseNames[phase], message);
+        }
+        if (phase == MW_CONNECT_READY || phase == MW_CONNECT_FAILED)
+        {
+            progress.finished++;
+            progress.changed.notify_all();
+        }
+    }
+
+    // The simulator numbers its headbands 00:55:DA:B0:00:00, 00:55:DA:B0:00:01, ...
+    std::vector<std::string> SimulatorAddresses(int devices)
+    {
+        std::vector<std::string> addresses;
+        for (int i = 0; i < devices; i++)
+        {
+            char mac[32];
+            std::snprintf(mac, sizeof(mac), "00:55:DA:B0:%02X:%02X", (i >> 8) & 0xFF, i & 0xFF);
+            addresses.push_back(mac);
+        }
+        return addresses;
+    }
+}
+
+int RunConnect(int argc, char** argv)
+{
+    Arguments args(argc, argv);
+    std::string library = args.GetString("libmuse", "");
+    double timeoutSeconds = args.GetDouble("timeout", 120.0);
+
+    std::vector<std::string> addresses;
+    if (args.Has("macs"))
+    {
+        std::stringstream list(args.GetString("macs", ""));
+        for (std::string mac; std::getline(list, mac, ',');)
+        {
+            addresses.push_back(mac);
+        }
+    }
+    else
+    {
+        addresses = SimulatorAddresses(static_cast<int>(args.GetInt("devices", 1)));
+    }
+
+    char error[256];
+    MwConnectOptions options;
+    MwConnectGetDefaultOptions(&options, error, sizeof(error));
+    options.attempts = static_cast<int32_t>(args.GetInt("attempts", options.attempts));
+    options.attemptTimeoutMs = static_cast<int32_t>(args.GetInt("attempt-timeout-ms", options.attemptTimeoutMs));
+    options.backoffMs = static_cast<int32_t>(args.GetInt("backoff-ms", options.backoffMs));
+
+    if (MwLibmuseLoad(library.empty() ? nullptr : library.c_str(), error, sizeof(error)) != MW_OK)
+    {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    Progress progress;
+    progress.verbose = args.Has("verbose");
+    uint64_t cpuBefore = ProcessCpuNanoseconds();
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<int> handles;
+    for (const std::string& mac : addresses)
+    {
+        int handle;
+        if (MwConnectStart(mac.c_str(), &options, OnPhase, &progress, &handle, error, sizeof(error)) != MW_OK)
+        {
+            std::cerr << mac << ": " << error << "\n";
+            return 1;
+        }
+        handles.push_back(handle);
+    }
+
+    {
+        std::unique_lock<std::mutex> guard(progress.lock);
+        progress.changed.wait_for(guard, std::chrono::duration<double>(timeoutSeconds),
+            [&] { return progress.finished == static_cast<int>(handles.size()); });
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double cpuSeconds = static_cast<double>(ProcessCpuNanoseconds() - cpuBefore) / 1e9;
+
+    int ready = 0;
+    for (size_t i = 0; i < handles.size(); i++)
+    {
+        MwConnectStatus status = {};
+        MwConnectGetStatus(handles[i], &status, error, sizeof(error));
+        ready += status.phase == MW_CONNECT_READY ? 1 : 0;
+        std::printf("%s  %-13s attempts %d  configuration reads %d  connected %8.1f ms  ready %8.1f ms\n",
+            addresses[i].c_str(), PhaseNames[status.phase], status.attempts, status.configurationReads,
+            status.connectedNs / 1e6, status.readyNs / 1e6);
+        MwConnectDestroy(handles[i], error, sizeof(error));
+    }
+
+    MwTimerStats timers = {};
+    MwTimerGetStats(&timers, error, sizeof(error));
+    std::printf("%d of %zu ready in %.2f s wall, %.3f s CPU (%.2f%% of one core), %lld timer wakeups\n",
+        ready, handles.size(), wallSeconds, cpuSeconds, wallSeconds > 0.0 ? cpuSeconds / wallSeconds * 100.0 : 0.0,
+        static_cast<long long>(timers.wakeups));
+    return ready == static_cast<int>(handles.size()) ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+// HubLoadGenerator.cpp : Drives the spectator broadcast hub with many local subscribers and
+// reports delivery rate, drops, end-to-end latency and how much of one core the hub thread used.
+
+#include "pch.h"
+#include "Arguments.h"
+#include "Clock.h"
+#include "Commands.h"
+#include "MuseWrapper.h"
+#include "Poller.h"
+#include "Statistics.h"
+
+#include <cstdio>
+#include <iostream>
+
+using namespace MuseWrapper;
+
+namespace
+{
+    struct Client
+    {
+        SocketHandle socket = InvalidSocket;
+        std::vector<uint8_t> buffer;
+        bool upgraded = false;
+        uint64_t received = 0;
+    };
+
+    const char HandshakeRequest[] =
+        "GET / HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+
+    // Parses complete messages out of the client's buffer; each payload starts with the publish time
+    void ConsumeFrames(Client& client, bool webSocket, std::vector<uint64_t>& latencies)
+    {
+        size_t offset = 0;
+        if (webSocket && !client.upgraded)
+        {
+            std::string text(client.buffer.begin(), client.buffer.end());
+            size_t end = text.find("\r\n\r\n");
+            if (end == std::string::npos)
+            {
+                return;
+            }
+            client.upgraded = true;
+            offset = end + 4;
+        }
+
+        uint64_t now = MonotonicNanoseconds();
+        while (true)
+        {
+            size_t available = client.buffer.size() - offset;
+            size_t header;
+            size_t length;
+            const uint8_t* p = client.buffer.data() + offset;
+            if (webSocket)
+            {
+                if (available < 2)
+                {
+                    break;
+                }
+                length = p[1] & 0x7F;
+                header = 2;
+                if (length == 126)
+                {
+                    if (available < 4)
+                    {
+                        break;
+                    }
+                    length = (static_cast<size_t>(p[2]) << 8) | p[3];
+                    header = 4;
+                }
+            }
+            else
+            {
+                if (available < 4)
+                {
+                    break;
+                }
+                length = p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<size_t>(p[3]) << 24);
+                header = 4;
+            }
+            if (available < header + length)
+            {
+                break;
+            }
+
+            uint64_t published = 0;
+            std::memcpy(&published, p + header, sizeof(published));
+            latencies.push_back(now - published);
+            client.received++;
+            offset += header + length;
+        }
+        client.buffer.erase(client.buffer.begin(), client.buffer.begin() + offset);
+    }
+}
+
+int RunHubLoad(int argc, char** argv)
+{
+    Arguments args(argc, argv);
+    int subscriberCount = static_cast<int>(args.GetInt("subscribers", 1000));
+    double rate = args.GetDouble("rate", 30.0);
+    double seconds = args.GetDouble("seconds", 10.0);
+    size_t payloadSize = std::max<size_t>(static_cast<size_t>(args.GetInt("payload", 256)), sizeof(uint64_t));
+    bool webSocket = args.Has("websocket");
+
+    char error[256];
+    int hub;
+    if (MwHubCreate(webSocket ? -1 : 0, webSocket ? 0 : -1, 1, 8, &hub, error, sizeof(error)) != MW_OK)
+    {
+        std::cerr << "Failed to create hub: " << error << "\n";
+        return 1;
+    }
+    int tcpPort = 0;
+    int webSocketPort = 0;
+    MwHubGetPorts(hub, &tcpPort, &webSocketPort, error, sizeof(error));
+    uint16_t port = static_cast<uint16_t>(webSocket ? webSocketPort : tcpPort);
+
+    std::vector<Client> clients(static_cast<size_t>(subscriberCount));
+    Poller poller;
+    try
+    {
+        for (Client& client : clients)
+        {
+            client.socket = Sockets::Connect("127.0.0.1", port);
+            poller.Add(client.socket, &client);
+            if (webSocket)
+            {
+                IoSlice request{ HandshakeRequest, sizeof(HandshakeRequest) - 1 };
+                Sockets::Send(client.socket, &request, 1);
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << " (on Linux raise the descriptor limit with 'ulimit -n')\n";
+        return 1;
+    }
+
+    // Wait until the hub has registered every subscriber before publishing
+    MwHubStats stats = {};
+    for (int i = 0; i < 500 && stats.subscribers < subscriberCount; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        MwHubGetStats(hub, &stats, error, sizeof(error));
+    }
+
+    std::vector<uint64_t> latencies;
+    latencies.reserve(static_cast<size_t>(subscriberCount * rate * seconds));
+    std::atomic<bool> receiving{ true };
+    std::thread receiver([&]
+    {
+        PollEvent events[256];
+        uint8_t chunk[16384];
+        while (receiving.load())
+        {
+            int count = poller.Wait(events, 256, 20);
+            for (int i = 0; i < count; i++)
+            {
+                Client& client = *static_cast<Client*>(events[i].context);
+                intptr_t received;
+                while ((received = Sockets::Receive(client.socket, chunk, sizeof(chunk))) > 0)
+                {
+                    client.buffer.insert(client.buffer.end(), chunk, chunk + received);
+                }
+                ConsumeFrames(client, webSocket, latencies);
+            }
+        }
+    });
+
+    MwHubGetStats(hub, &stats, error, sizeof(error));
+    int64_t busyBefore = stats.loopBusyNs;
+    std::vector<uint8_t> payload(payloadSize, 0x5A);
+    auto interval = std::chrono::nanoseconds(static_cast<int64_t>(1e9 / rate));
+    auto start = std::chrono::steady_clock::now();
+    auto next = start;
+    int64_t published = 0;
+    while (std::chrono::steady_clock::now() - start < std::chrono::duration<double>(seconds))
+    {
+        uint64_t now = MonotonicNanoseconds();
+        std::memcpy(payload.data(), &now, sizeof(now));
+        MwHubPublish(hub, payload.data(), static_cast<int>(payload.size()), error, sizeof(error));
+        published++;
+        next += interval;
+        std::this_thread::sleep_until(next);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    receiving = false;
+    receiver.join();
+    MwHubGetStats(hub, &stats, error, sizeof(error));
+
+    uint64_t received = 0;
+    for (Client& client : clients)
+    {
+        received += client.received;
+        poller.Remove(client.socket);
+        Sockets::Close(client.socket);
+    }
+    MwHubDestroy(hub, error, sizeof(error));
+
+    uint64_t expected = static_cast<uint64_t>(published) * static_cast<uint64_t>(subscriberCount);
+    double hubCore = 100.0 * static_cast<double>(stats.loopBusyNs - busyBefore) / (elapsed * 1e9);
+    std::printf("hub-load: %d %s subscribers, %.0f Hz, %zu-byte payload, %.1f s\n",
+        subscriberCount, webSocket ? "WebSocket" : "TCP", rate, payloadSize, elapsed);
+    std::printf("  published %lld frames, delivered %llu/%llu messages (%.0f msg/s), hub dropped %lld\n",
+        static_cast<long long>(published), static_cast<unsigned long long>(received), static_cast<unsigned long long>(expected),
+        received / elapsed, static_cast<long long>(stats.framesDropped));
+    std::printf("  latency p50 %.3f ms, p99 %.3f ms, p999 %.3f ms\n",
+        Percentile(latencies, 0.50) / 1e6, Percentile(latencies, 0.99) / 1e6, Percentile(latencies, 0.999) / 1e6);
+    std::printf("  hub thread busy %.1f%% of one core\n", hubCore);
+    return received == expected ? 0 : 2;
+}
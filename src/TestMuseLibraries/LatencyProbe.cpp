@@ -0,0 +1,339 @@
+// LatencyProbe.cpp : Runs synthetic EEG through the native ingest pipeline into the overlay and the
+// broadcast hub, with a stand-in overlay page that acknowledges each update on its next animation
+// frame, and prints the per-stage latency breakdown.
+
+#include "pch.h"
+#include "Arguments.h"
+#include "Clock.h"
+#include "Commands.h"
+#include "MuseWrapper.h"
+#include "Poller.h"
+#include "Socket.h"
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+using namespace MuseWrapper;
+
+namespace
+{
+    const char HandshakeRequest[] =
+        "GET / HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+
+    const char* const StageNames[MW_STAGE_COUNT] =
+    {
+        "transport", "callback", "queue", "filter", "band power", "metrics",
+        "publish", "overlay ack", "render", "native", "end to end",
+    };
+
+    constexpr double PageFrameHz = 60.0;
+
+    // Plays the browser overlay: reads metric messages off the hub and, on the next animation frame
+    // after each one arrives, answers {"ack":N,"renderUs":R}
+    class OverlayPage
+    {
+    public:
+        explicit OverlayPage(uint16_t port, double renderUs)
+            : socket(Sockets::Connect("127.0.0.1", port)), renderUs(renderUs)
+        {
+            IoSlice request{ HandshakeRequest, sizeof(HandshakeRequest) - 1 };
+            Sockets::Send(socket, &request, 1);
+            poller.Add(socket, this);
+        }
+
+        ~OverlayPage()
+        {
+            poller.Remove(socket);
+            Sockets::Close(socket);
+        }
+
+        void Run(const std::atomic<bool>& running)
+        {
+            PollEvent events[1];
+            uint8_t chunk[4096];
+            auto frame = std::chrono::nanoseconds(static_cast<int64_t>(1e9 / PageFrameHz));
+            auto nextFrame = std::chrono::steady_clock::now() + frame;
+            while (running.load())
+            {
+                auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(nextFrame - std::chrono::steady_clock::now());
+                if (poller.Wait(events, 1, static_cast<int>(std::max<int64_t>(0, wait.count()))) > 0)
+                {
+                    intptr_t received;
+                    while ((received = Sockets::Receive(socket, chunk, sizeof(chunk))) > 0)
+                    {
+                        buffer.insert(buffer.end(), chunk, chunk + received);
+                    }
+                    ConsumeFrames();
+                }
+                if (std::chrono::steady_clock::now() >= nextFrame)
+                {
+                    AnimationFrame();
+                    nextFrame += frame;
+                }
+            }
+        }
+
+    private:
+        struct Pending
+        {
+            uint64_t trace;
+            uint64_t receivedNs;
+        };
+
+        void ConsumeFrames()
+        {
+            size_t offset = 0;
+            if (!upgraded)
+            {
+                std::string text(buffer.begin(), buffer.end());
+                size_t end = text.find("\r\n\r\n");
+                if (end == std::string::npos)
+                {
+                    return;
+                }
+                upgraded = true;
+                offset = end + 4;
+            }
+
+            uint64_t now = MonotonicNanoseconds();
+            while (buffer.size() - offset >= 2)
+            {
+                const uint8_t* p = buffer.data() + offset;
+                size_t length = p[1] & 0x7F;
+                size_t header = 2;
+                if (length == 126)
+                {
+                    if (buffer.size() - offset < 4)
+                    {
+                        break;
+                    }
+                    length = (static_cast<size_t>(p[2]) << 8) | p[3];
+                    header = 4;
+                }
+                if (buffer.size() - offset < header + length)
+                {
+                    break;
+                }
+
+                std::string message(reinterpret_cast<const char*>(p + header), length);
+                size_t key = message.find("\"trace\":");
+                if (key != std::string::npos)
+                {
+                    pending.push_back({ std::strtoull(message.c_str() + key + 8, nullptr, 10), now });
+                }
+                offset += header + length;
+            }
+            buffer.erase(buffer.begin(), buffer.begin() + offset);
+        }
+
+        // Only the newest update is drawn each frame, as a page would do; it alone is acknowledged
+        void AnimationFrame()
+        {
+            if (pending.empty())
+            {
+                return;
+            }
+            Pending latest = pending.back();
+            pending.clear();
+            if (renderUs > 0.0)
+            {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(static_cast<int64_t>(renderUs * 1000.0)));
+            }
+
+            double frameUs = (MonotonicNanoseconds() - latest.receivedNs) / 1000.0;
+            char ack[96];
+            int length = std::snprintf(ack, sizeof(ack), "{\"ack\":%llu,\"renderUs\":%.1f}",
+                static_cast<unsigned long long>(latest.trace), frameUs);
+            SendMasked(ack, static_cast<size_t>(length));
+        }
+
+        // Client-to-server frames must be masked; a fixed key is fine for a loopback probe
+        void SendMasked(const char* text, size_t length)
+        {
+            const uint8_t mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+            uint8_t frame[2 + 4 + 125];
+            frame[0] = 0x81;
+            frame[1] = static_cast<uint8_t>(0x80 | length);
+            std::memcpy(frame + 2, mask, sizeof(mask));
+            for (size_t i = 0; i < length; i++)
+            {
+                frame[6 + i] = static_cast<uint8_t>(text[i]) ^ mask[i & 3];
+            }
+            IoSlice slice{ frame, 6 + length };
+            Sockets::Send(socket, &slice, 1);
+        }
+
+        SocketHandle socket;
+        Poller poller;
+        double renderUs;
+        std::vector<uint8_t> buffer;
+        std::vector<Pending> pending;
+        bool upgraded = false;
+    };
+
+    void PrintStage(const char* name, const MwLatencyStats& stats)
+    {
+        if (stats.count == 0)
+        {
+            std::printf("  %-14s %10s\n", name, "-");
+            return;
+        }
+        std::printf("  %-14s %10lld %10.1f %10.1f %10.1f %10.1f %10.1f\n", name, static_cast<long long>(stats.count),
+            stats.p50Ns / 1000.0, stats.p90Ns / 1000.0, stats.p99Ns / 1000.0, stats.p999Ns / 1000.0, stats.maxNs / 1000.0);
+    }
+}
+
+int RunLatency(int argc, char** argv)
+{
+    Arguments args(argc, argv);
+    double seconds = args.GetDouble("seconds", 10.0);
+    int channels = static_cast<int>(args.GetInt("channels", 4));
+    double sampleRate = args.GetDouble("rate", 256.0);
+    double renderUs = args.GetDouble("render-us", 0.0);
+    std::string tracePath = args.GetString("trace", "");
+    std::string priorityName = args.GetString("priority", "");
+    std::vector<int> cpus = args.GetIntList("cpus");
+    int busyThreads = static_cast<int>(args.GetInt("busy-threads", 0));
+    int priority = priorityName == "realtime" ? MW_PRIORITY_REALTIME : priorityName == "high" ? MW_PRIORITY_HIGH : MW_PRIORITY_NORMAL;
+
+    char error[256];
+    int hub;
+    int ingest;
+    int overlay;
+    if (MwHubCreate(-1, 0, 1, 64, &hub, error, sizeof(error)) != MW_OK
+        || MwIngestCreate(channels, sampleRate, 60.0, MW_BANDS_EEG, &ingest, error, sizeof(error)) != MW_OK
+        || MwOverlayCreate("MuseWrapperLatencyProbe", 480, 120, 3, &overlay, error, sizeof(error)) != MW_OK)
+    {
+        std::cerr << "Setup failed: " << error << "\n";
+        return 1;
+    }
+    MwIngestAttachHub(ingest, hub, error, sizeof(error));
+    MwIngestAttachOverlay(ingest, overlay, error, sizeof(error));
+    if (!priorityName.empty() || !cpus.empty())
+    {
+        static const char* const priorityNames[] = { "normal", "high", "realtime" };
+        int applied;
+        if (MwIngestSetThreadScheduling(ingest, priority, cpus.data(), static_cast<int>(cpus.size()), &applied, error, sizeof(error)) != MW_OK)
+        {
+            std::cerr << "Cannot schedule the ingest worker: " << error << "\n";
+            return 1;
+        }
+        std::printf("Ingest worker priority %s (asked for %s)\n", priorityNames[applied], priorityNames[priority]);
+    }
+    int tcpPort = 0;
+    int webSocketPort = 0;
+    MwHubGetPorts(hub, &tcpPort, &webSocketPort, error, sizeof(error));
+
+    std::atomic<bool> running{ true };
+
+    // Stand-ins for an encoder saturating every core, which the ingest worker competes with
+    std::vector<std::thread> busy;
+    for (int i = 0; i < busyThreads; i++)
+    {
+        busy.emplace_back([&running]
+        {
+            volatile uint64_t spin = 0;
+            while (running.load(std::memory_order_relaxed))
+            {
+                spin = spin + 1;
+            }
+        });
+    }
+
+    OverlayPage page(static_cast<uint16_t>(webSocketPort), renderUs);
+    std::thread pageThread([&] { page.Run(running); });
+
+    // The native overlay renders at the same 60 Hz as the page
+    std::thread renderThread([&]
+    {
+        auto frame = std::chrono::nanoseconds(static_cast<int64_t>(1e9 / PageFrameHz));
+        auto next = std::chrono::steady_clock::now();
+        char renderError[256];
+        while (running.load())
+        {
+            int published;
+            MwOverlayRenderFrame(overlay, &published, renderError, sizeof(renderError));
+            next += frame;
+            std::this_thread::sleep_until(next);
+        }
+    });
+
+    // Let the page finish its handshake, then discard anything recorded while the pipeline warmed up
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    MwIngestResetLatency(ingest, error, sizeof(error));
+    if (!tracePath.empty() && MwTraceStart(64, error, sizeof(error)) != MW_OK)
+    {
+        std::cerr << error << "\n";
+        tracePath.clear();
+    }
+
+    // libmuse delivers EEG in bursts of 12 samples per Bluetooth notification
+    constexpr int SamplesPerBurst = 12;
+    std::vector<double> values(static_cast<size_t>(channels));
+    auto burst = std::chrono::nanoseconds(static_cast<int64_t>(SamplesPerBurst * 1e9 / sampleRate));
+    auto start = std::chrono::steady_clock::now();
+    auto next = start;
+    int64_t sample = 0;
+    int64_t startUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    while (std::chrono::steady_clock::now() - start < std::chrono::duration<double>(seconds))
+    {
+        for (int i = 0; i < SamplesPerBurst; i++, sample++)
+        {
+            double t = sample / sampleRate;
+            for (int c = 0; c < channels; c++)
+            {
+                values[static_cast<size_t>(c)] = 800.0 + 20.0 * std::sin(2.0 * 3.14159265358979 * (10.0 + c) * t)
+                    + 8.0 * std::sin(2.0 * 3.14159265358979 * 20.0 * t);
+            }
+            int64_t callbackNs;
+            MwClockNanoseconds(&callbackNs, error, sizeof(error));
+            MwIngestPushPacket(ingest, 2, startUs + static_cast<int64_t>(sample * 1e6 / sampleRate), values.data(), channels,
+                callbackNs, error, sizeof(error));
+        }
+        next += burst;
+        std::this_thread::sleep_until(next);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    running = false;
+    pageThread.join();
+    renderThread.join();
+    for (std::thread& thread : busy)
+    {
+        thread.join();
+    }
+    if (!tracePath.empty())
+    {
+        // A .json name selects Chrome trace-event JSON; anything else gets Perfetto protobuf
+        bool json = tracePath.size() >= 5 && tracePath.compare(tracePath.size() - 5, 5, ".json") == 0;
+        MwTraceStop(error, sizeof(error));
+        if (MwTraceWrite(tracePath.c_str(), json ? MW_TRACE_CHROME_JSON : MW_TRACE_PERFETTO, error, sizeof(error)) != MW_OK)
+        {
+            std::cerr << error << "\n";
+        }
+    }
+
+    std::printf("Per-stage latency, %d channels at %.0f Hz for %.1f s (microseconds)\n", channels, sampleRate, seconds);
+    std::printf("  %-14s %10s %10s %10s %10s %10s %10s\n", "stage", "count", "p50", "p90", "p99", "p99.9", "max");
+    for (int stage = 0; stage < MW_STAGE_COUNT; stage++)
+    {
+        MwLatencyStats stats = {};
+        MwIngestGetLatency(ingest, stage, &stats, error, sizeof(error));
+        PrintStage(StageNames[stage], stats);
+    }
+    MwLatencyStats frameStats = {};
+    MwOverlayGetLatency(overlay, &frameStats, error, sizeof(error));
+    PrintStage("overlay frame", frameStats);
+
+    MwIngestStats stats = {};
+    MwIngestGetStats(ingest, &stats, error, sizeof(error));
+    std::printf("Packets %lld ingested, %lld dropped; %lld updates published, %lld acknowledged\n",
+        static_cast<long long>(stats.packetsIngested), static_cast<long long>(stats.packetsDropped),
+        static_cast<long long>(stats.metricsPublished), static_cast<long long>(stats.acksReceived));
+
+    MwIngestDestroy(ingest, error, sizeof(error));
+    MwOverlayDestroy(overlay, error, sizeof(error));
+    MwHubDestroy(hub, error, sizeof(error));
+    return 0;
+}
@@ -0,0 +1,154 @@
+// MetricsMonitor.cpp : Reference reader for the shared-memory metrics page, as a sidecar monitor
+// would map it. With --demo it also publishes a page fed by synthetic EEG so there is something to read.
+
+#include "pch.h"
+#include "Arguments.h"
+#include "Commands.h"
+#include "MetricsPage.h"
+#include "MuseWrapper.h"
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+using namespace MuseWrapper;
+
+namespace
+{
+    constexpr int ReadAttempts = 100;
+
+    // Seqlock read: copy the page between two equal, even sequence values
+    bool ReadPage(const SharedMemory& memory, MetricsPageLayout& copy)
+    {
+        const MetricsPageLayout* page = reinterpret_cast<const MetricsPageLayout*>(memory.Data());
+        for (int attempt = 0; attempt < ReadAttempts; attempt++)
+        {
+            uint64_t before = page->sequence.load(std::memory_order_acquire);
+            if (before & 1)
+            {
+                continue;
+            }
+            std::memcpy(static_cast<void*>(&copy), static_cast<const void*>(page), sizeof(copy));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (page->sequence.load(std::memory_order_relaxed) == before)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void PrintPage(const MetricsPageLayout& page)
+    {
+        std::printf("update %llu: %llu connected, hub %llu subscribers %.1f KB/s (%.1f%% busy), recording backlog %llu, replay sessions %llu\n",
+            static_cast<unsigned long long>(page.updateCount), static_cast<unsigned long long>(page.connectedDevices),
+            static_cast<unsigned long long>(page.hubSubscribers), page.hubBytesPerSecond / 1024.0, page.hubBusyFraction * 100.0,
+            static_cast<unsigned long long>(page.recordingBacklogPackets), static_cast<unsigned long long>(page.replaySessions));
+        for (const MetricsDeviceBlock& device : page.devices)
+        {
+            if (!device.inUse)
+            {
+                continue;
+            }
+            std::printf("  %-20s state %d rssi %6.1f  eeg %6.1f/s  queue %llu/%llu  dropped %llu eeg %llu acc  missing %llu  dsp %.2f%%  e2e p99 %.1f ms\n",
+                device.name, device.connectionState, device.rssi,
+                device.packetsPerSecond[static_cast<int>(MuseDataPacketType::Eeg)],
+                static_cast<unsigned long long>(device.queueDepth), static_cast<unsigned long long>(device.queueCapacity),
+                static_cast<unsigned long long>(device.droppedEegSamples), static_cast<unsigned long long>(device.droppedAccelerometerSamples),
+                static_cast<unsigned long long>(device.missingSamples), device.dspBusyFraction * 100.0, device.endToEndP99Ns / 1e6);
+        }
+    }
+}
+
+int RunMetrics(int argc, char** argv)
+{
+    Arguments args(argc, argv);
+    std::string segment = args.GetString("segment", "MuseWrapperMetrics");
+    double seconds = args.GetDouble("seconds", 10.0);
+    bool demo = args.Has("demo");
+
+    char error[256];
+    int page = 0;
+    int ingest = 0;
+    int timing = 0;
+    if (demo)
+    {
+        int slot;
+        if (MwIngestCreate(4, 256.0, 60.0, MW_BANDS_EEG, &ingest, error, sizeof(error)) != MW_OK
+            || MwTimingCreate(1000, &timing, error, sizeof(error)) != MW_OK
+            || MwIngestAttachTiming(ingest, timing, error, sizeof(error)) != MW_OK
+            || MwMetricsCreate(segment.c_str(), 250, &page, error, sizeof(error)) != MW_OK
+            || MwMetricsAddDevice(page, "Muse-DEMO", ingest, timing, &slot, error, sizeof(error)) != MW_OK
+            || MwMetricsSetDeviceStatus(page, slot, 1, -58.0, error, sizeof(error)) != MW_OK)
+        {
+            std::cerr << "Demo setup failed: " << error << "\n";
+            return 1;
+        }
+    }
+
+    std::unique_ptr<SharedMemory> memory;
+    try
+    {
+        memory = SharedMemory::Open(segment);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    const MetricsPageLayout* header = reinterpret_cast<const MetricsPageLayout*>(memory->Data());
+    if (memory->Size() < sizeof(MetricsPageLayout) || header->magic != MetricsPage::Magic || header->version != MetricsPage::Version)
+    {
+        std::cerr << "Segment " << segment << " is not a version " << MetricsPage::Version << " metrics page\n";
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto nextPrint = start + std::chrono::seconds(1);
+    int64_t sample = 0;
+    while (std::chrono::steady_clock::now() - start < std::chrono::duration<double>(seconds))
+    {
+        if (demo)
+        {
+            // 12-sample bursts at 256 Hz, as libmuse delivers them
+            for (int i = 0; i < 12; i++, sample++)
+            {
+                double t = sample / 256.0;
+                double values[4];
+                for (int c = 0; c < 4; c++)
+                {
+                    values[c] = 800.0 + 20.0 * std::sin(2.0 * 3.14159265358979 * 10.0 * t + c);
+                }
+                MwIngestPushPacket(ingest, 2, 1'000'000 + sample * 3906, values, 4, 0, error, sizeof(error));
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(46875));
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+
+        if (std::chrono::steady_clock::now() >= nextPrint)
+        {
+            MetricsPageLayout copy;
+            if (ReadPage(*memory, copy))
+            {
+                PrintPage(copy);
+            }
+            else
+            {
+                std::cout << "page busy, retrying\n";
+            }
+            nextPrint += std::chrono::seconds(1);
+        }
+    }
+
+    memory.reset();
+    if (demo)
+    {
+        MwMetricsDestroy(page, error, sizeof(error));
+        MwIngestDestroy(ingest, error, sizeof(error));
+        MwTimingDestroy(timing, error, sizeof(error));
+    }
+    return 0;
+}
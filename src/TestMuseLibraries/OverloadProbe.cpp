@@ -0,0 +1,217 @@
+// OverloadProbe.cpp : Overloads MuseWrapper's bounded queues under each overflow policy and reports what was
+// dropped where, how stale the delivered data got and whether memory stayed flat. The ingest queue is fed
+// faster than a deliberately slow packet listener drains it; the hub's subscriber queues are fed faster
+// than a subscriber that never reads.
+
+#include "pch.h"
+#include "Arguments.h"
+#include "Commands.h"
+#include "MuseWrapper.h"
+#include "Poller.h"
+#include "ProcessUsage.h"
+
+#include <cstdio>
+#include <iostream>
+
+using namespace MuseWrapper;
+
+namespace
+{
+    constexpr int EegPacketType = 2;
+
+    struct Policy
+    {
+        const char* name;
+        int value;
+    };
+
+    const Policy Policies[] = {
+        { "block", MW_OVERFLOW_BLOCK },
+        { "drop-oldest", MW_OVERFLOW_DROP_OLDEST },
+        { "drop-newest", MW_OVERFLOW_DROP_NEWEST },
+        { "latest-only", MW_OVERFLOW_LATEST_ONLY },
+    };
+
+    struct Settings
+    {
+        double seconds;
+        double rate;
+        int consumerUs;
+        int payload;
+    };
+
+    struct Sample
+    {
+        int64_t peakDepth = 0;
+        uint64_t peakResident = 0;
+        int64_t peakArena = 0;
+    };
+
+    void PrintQueue(const char* stage, const char* policy, const MwQueueStats& stats, const Sample& sample, uint64_t residentBefore)
+    {
+        std::printf("%-6s %-12s accepted %8lld  dropped newest %7lld oldest %7lld coalesced %7lld  blocked %7.1f ms"
+            "  depth max %5lld of %5d  RSS %+7.1f MB\n",
+            stage, policy, static_cast<long long>(stats.accepted), static_cast<long long>(stats.droppedNewest),
+            static_cast<long long>(stats.droppedOldest), static_cast<long long>(stats.coalesced), stats.blockedNs / 1e6,
+            static_cast<long long>(sample.peakDepth), stats.capacity,
+            (static_cast<double>(sample.peakResident) - static_cast<double>(residentBefore)) / (1024.0 * 1024.0));
+    }
+
+    // Pushes EEG faster than a listener that sleeps on every packet can take it
+    bool RunIngest(const Policy& policy, const Settings& settings)
+    {
+        char error[256];
+        int pipeline;
+        if (MwIngestCreate(4, 256.0, 60.0, MW_BANDS_EEG, &pipeline, error, sizeof(error)) != MW_OK
+            || MwIngestSetOverflowPolicy(pipeline, policy.value, error, sizeof(error)) != MW_OK)
+        {
+            std::cerr << "Failed to create pipeline: " << error << "\n";
+            return false;
+        }
+        std::atomic<int> consumerUs{ settings.consumerUs };
+        int listener;
+        MwIngestAddListener(pipeline, EegPacketType,
+            [](int, int64_t, const double*, int, void* context)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(static_cast<std::atomic<int>*>(context)->load()));
+            },
+            &consumerUs, &listener, error, sizeof(error));
+
+        uint64_t residentBefore = ProcessResidentBytes();
+        Sample sample;
+        double values[4] = { 1.0, 2.0, 3.0, 4.0 };
+        int perMillisecond = std::max(1, static_cast<int>(settings.rate / 1000.0));
+        auto start = std::chrono::steady_clock::now();
+        auto next = start;
+        int64_t pushed = 0;
+        for (int tick = 0; std::chrono::steady_clock::now() - start < std::chrono::duration<double>(settings.seconds); tick++)
+        {
+            for (int i = 0; i < perMillisecond; i++, pushed++)
+            {
+                int64_t now = 0;
+                MwClockNanoseconds(&now, error, sizeof(error));
+                MwIngestPushPacket(pipeline, EegPacketType, 0, values, 4, now, error, sizeof(error));
+            }
+            if (tick % 50 == 0)
+            {
+                MwQueueStats stats = {};
+                MwIngestStats ingest = {};
+                MwIngestGetQueueStats(pipeline, &stats, error, sizeof(error));
+                MwIngestGetStats(pipeline, &ingest, error, sizeof(error));
+                sample.peakDepth = std::max<int64_t>(sample.peakDepth, stats.depth);
+                sample.peakArena = std::max(sample.peakArena, ingest.arenaBytesInUse);
+                sample.peakResident = std::max(sample.peakResident, ProcessResidentBytes());
+            }
+            next += std::chrono::milliseconds(1);
+            std::this_thread::sleep_until(next);
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        MwQueueStats stats = {};
+        MwLatencyStats queueLatency = {};
+        MwIngestGetQueueStats(pipeline, &stats, error, sizeof(error));
+        MwIngestGetLatency(pipeline, MW_STAGE_QUEUE, &queueLatency, error, sizeof(error));
+        PrintQueue("ingest", policy.name, stats, sample, residentBefore);
+        std::printf("       %-12s pushed %.0f/s of %.0f/s asked  queue wait p50 %8.1f ms  p99 %8.1f ms  arena peak %.1f MB\n",
+            "", static_cast<double>(pushed) / elapsed, settings.rate, queueLatency.p50Ns / 1e6, queueLatency.p99Ns / 1e6,
+            static_cast<double>(sample.peakArena) / (1024.0 * 1024.0));
+
+        // Destroying the pipeline waits for the backlog, so a stalled listener is released first
+        consumerUs = 0;
+        MwIngestDestroy(pipeline, error, sizeof(error));
+        return true;
+    }
+
+    // Publishes to a subscriber whose socket buffer has filled because it never reads
+    bool RunHub(const Policy& policy, const Settings& settings)
+    {
+        char error[256];
+        int hub;
+        if (MwHubCreate(0, -1, 1, 8, &hub, error, sizeof(error)) != MW_OK
+            || MwHubSetOverflowPolicy(hub, MW_HUB_QUEUE_SUBSCRIBER, policy.value, error, sizeof(error)) != MW_OK)
+        {
+            std::cerr << "Failed to create hub: " << error << "\n";
+            return false;
+        }
+        int tcpPort = 0;
+        MwHubGetPorts(hub, &tcpPort, nullptr, error, sizeof(error));
+        SocketHandle stalled = Sockets::Connect("127.0.0.1", static_cast<uint16_t>(tcpPort));
+        MwHubStats hubStats = {};
+        for (int i = 0; i < 500 && hubStats.subscribers < 1; i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            MwHubGetStats(hub, &hubStats, error, sizeof(error));
+        }
+
+        uint64_t residentBefore = ProcessResidentBytes();
+        Sample sample;
+        std::vector<uint8_t> payload(static_cast<size_t>(settings.payload), 0x5A);
+        int perMillisecond = std::max(1, static_cast<int>(settings.rate / 1000.0));
+        auto start = std::chrono::steady_clock::now();
+        auto next = start;
+        for (int tick = 0; std::chrono::steady_clock::now() - start < std::chrono::duration<double>(settings.seconds); tick++)
+        {
+            for (int i = 0; i < perMillisecond; i++)
+            {
+                MwHubPublish(hub, payload.data(), static_cast<int>(payload.size()), error, sizeof(error));
+            }
+            if (tick % 50 == 0)
+            {
+                MwQueueStats stats = {};
+                MwHubGetQueueStats(hub, MW_HUB_QUEUE_SUBSCRIBER, &stats, error, sizeof(error));
+                sample.peakDepth = std::max<int64_t>(sample.peakDepth, stats.depth);
+                sample.peakResident = std::max(sample.peakResident, ProcessResidentBytes());
+            }
+            next += std::chrono::milliseconds(1);
+            std::this_thread::sleep_until(next);
+        }
+
+        MwQueueStats subscriber = {};
+        MwQueueStats publish = {};
+        MwHubGetQueueStats(hub, MW_HUB_QUEUE_SUBSCRIBER, &subscriber, error, sizeof(error));
+        MwHubGetQueueStats(hub, MW_HUB_QUEUE_PUBLISH, &publish, error, sizeof(error));
+        PrintQueue("hub", policy.name, subscriber, sample, residentBefore);
+        std::printf("       %-12s publish queue accepted %lld, dropped %lld\n", "", static_cast<long long>(publish.accepted),
+            static_cast<long long>(publish.droppedNewest + publish.droppedOldest + publish.coalesced));
+
+        Sockets::Close(stalled);
+        MwHubDestroy(hub, error, sizeof(error));
+        return true;
+    }
+}
+
+int RunOverload(int argc, char** argv)
+{
+    Arguments args(argc, argv);
+    std::string only = args.GetString("policy", "all");
+    Settings settings;
+    settings.seconds = args.GetDouble("seconds", 4.0);
+    settings.rate = args.GetDouble("rate", 8000.0);
+    settings.consumerUs = static_cast<int>(args.GetInt("consumer-us", 500));
+    settings.payload = static_cast<int>(args.GetInt("payload", 16384));
+
+    bool ran = false;
+    for (const Policy& policy : Policies)
+    {
+        if (only != "all" && only != policy.name)
+        {
+            continue;
+        }
+        ran = true;
+        if (!RunIngest(policy, settings))
+        {
+            return 1;
+        }
+        // Subscriber queues cannot block the hub thread
+        if (policy.value != MW_OVERFLOW_BLOCK && !RunHub(policy, settings))
+        {
+            return 1;
+        }
+    }
+    if (!ran)
+    {
+        std::cerr << "Unknown policy: " << only << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,183 @@
+// PrecisionCheck.cpp : Bounds the error of the float32 EEG path against the double one. The same
+// EEG is fed through the ingest pipeline's EEG chain in both precisions, comparing every filtered
+// sample and every band power update, and the command fails if either error exceeds its limit.
+
+#include "pch.h"
+#include "Arguments.h"
+#include "Clock.h"
+#include "Commands.h"
+#include "EegChain.h"
+#include "SessionRecording.h"
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+using namespace MuseWrapper;
+
+namespace
+{
+    constexpr double Pi = 3.14159265358979323846;
+
+    // Muse-like EEG: the ~800 uV electrode offset, alpha and beta rhythms, mains hum, slow drift and noise
+    std::vector<MusePacket> SyntheticEeg(double seconds, int channels, double sampleRate)
+    {
+        std::mt19937 random(7);
+        std::normal_distribution<double> noise(0.0, 5.0);
+        size_t samples = static_cast<size_t>(seconds * sampleRate);
+        std::vector<MusePacket> packets(samples);
+        for (size_t i = 0; i < samples; i++)
+        {
+            double t = static_cast<double>(i) / sampleRate;
+            MusePacket& packet = packets[i];
+            packet.type = MuseDataPacketType::Eeg;
+            packet.valueCount = channels;
+            packet.timestampUs = static_cast<int64_t>(t * 1e6);
+            for (int c = 0; c < channels; c++)
+            {
+                packet.values[c] = 841.0 + 40.0 * std::sin(2.0 * Pi * 0.05 * t + c)
+                    + 20.0 * std::sin(2.0 * Pi * 10.0 * t + c) + 8.0 * std::sin(2.0 * Pi * 21.0 * t)
+                    + 30.0 * std::sin(2.0 * Pi * 60.0 * t) + noise(random);
+            }
+        }
+        return packets;
+    }
+
+    std::vector<MusePacket> RecordedEeg(const std::string& path, int& channels)
+    {
+        RecordingReader reader(path);
+        std::vector<MusePacket> packets;
+        std::vector<StoredPacket> block;
+        for (size_t i = 0; i < reader.Blocks().size(); i++)
+        {
+            reader.ReadBlock(i, block);
+            for (const StoredPacket& stored : block)
+            {
+                if (stored.type != static_cast<uint8_t>(MuseDataPacketType::Eeg))
+                {
+                    continue;
+                }
+                MusePacket packet = {};
+                packet.type = MuseDataPacketType::Eeg;
+                packet.valueCount = std::min<int>(stored.valueCount, MaxPacketValues);
+                packet.timestampUs = stored.timestampUs;
+                std::copy_n(stored.values, packet.valueCount, packet.values);
+                packets.push_back(packet);
+            }
+        }
+        if (packets.empty())
+        {
+            throw std::runtime_error("Recording has no EEG: " + path);
+        }
+        channels = packets.front().valueCount;
+        return packets;
+    }
+
+    struct ChainRun
+    {
+        std::vector<double> filtered;       // every filtered sample, sample-major
+        std::vector<double> powers;         // every band power update, channel-major within an update
+        double nsPerSample = 0.0;
+    };
+
+    ChainRun Run(const std::vector<MusePacket>& packets, IngestPipeline::Options options)
+    {
+        std::unique_ptr<EegChain> chain = EegChain::Create(options);
+        ChainRun run;
+        size_t channels = static_cast<size_t>(options.eegChannels);
+        size_t powerCount = channels * BandCount;
+        run.filtered.resize(packets.size() * channels);
+        uint64_t busyNs = 0;
+        for (size_t i = 0; i < packets.size(); i++)
+        {
+            uint64_t startNs = MonotonicNanoseconds();
+            chain->Filter(packets[i]);
+            bool updated = chain->UpdateBandPower();
+            busyNs += MonotonicNanoseconds() - startNs;
+
+            chain->LastFiltered(run.filtered.data() + i * channels);
+            if (updated)
+            {
+                run.powers.insert(run.powers.end(), chain->Powers(), chain->Powers() + powerCount);
+            }
+        }
+        run.nsPerSample = static_cast<double>(busyNs) / static_cast<double>(packets.size());
+        return run;
+    }
+}
+
+int RunPrecision(int argc, char** argv)
+{
+    Arguments args(argc, argv);
+    double seconds = args.GetDouble("seconds", 600.0);
+    int channels = static_cast<int>(args.GetInt("channels", 4));
+    double sampleRate = args.GetDouble("rate", 256.0);
+    double notch = args.GetDouble("notch", 60.0);
+    std::string recordingPath = args.GetString("recording", "");
+    // Float rounding of the ~800 uV electrode offset leaks through the high-pass as ~0.02 uV of low
+    // frequency error: negligible next to the signal, but a visible fraction of a nearly empty band
+    // (delta, once the synthetic drift is filtered out), which is what sets the band limit
+    double maxEegError = args.GetDouble("max-eeg-error", 1e-3);
+    double maxBandError = args.GetDouble("max-band-error", 0.05);
+    if (seconds <= 0.0 || channels < 1 || channels > MaxPacketValues || sampleRate <= 0.0)
+    {
+        std::cerr << "precision needs a positive --seconds and --rate and --channels 1-" << MaxPacketValues << "\n";
+        return 1;
+    }
+
+    std::vector<MusePacket> packets;
+    try
+    {
+        packets = recordingPath.empty() ? SyntheticEeg(seconds, channels, sampleRate) : RecordedEeg(recordingPath, channels);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    IngestPipeline::Options options;
+    options.eegChannels = channels;
+    options.eegSampleRate = sampleRate;
+    options.notchFrequency = notch;
+    ChainRun reference = Run(packets, options);
+    options.precision = IngestPipeline::SamplePrecision::Float;
+    ChainRun single = Run(packets, options);
+
+    // Filtered EEG error relative to the filtered signal's RMS, so the bound does not depend on scale
+    double signalSquares = 0.0;
+    double errorSquares = 0.0;
+    double maxError = 0.0;
+    for (size_t i = 0; i < reference.filtered.size(); i++)
+    {
+        double error = std::abs(single.filtered[i] - reference.filtered[i]);
+        signalSquares += reference.filtered[i] * reference.filtered[i];
+        errorSquares += error * error;
+        maxError = std::max(maxError, error);
+    }
+    double signalRms = std::sqrt(signalSquares / static_cast<double>(reference.filtered.size()));
+    double relativeRmsError = signalRms > 0.0 ? std::sqrt(errorSquares / static_cast<double>(reference.filtered.size())) / signalRms : 0.0;
+
+    // Band powers are log10 (Bels), so an absolute difference is a ratio error
+    std::array<double, BandCount> bandDifference = {};
+    for (size_t i = 0; i < reference.powers.size(); i++)
+    {
+        double& worst = bandDifference[i % BandCount];
+        worst = std::max(worst, std::abs(single.powers[i] - reference.powers[i]));
+    }
+    double maxBandDifference = *std::max_element(bandDifference.begin(), bandDifference.end());
+
+    std::printf("Float32 against double over %zu samples of %d-channel EEG (%s)\n", packets.size(), channels,
+        recordingPath.empty() ? "synthetic" : recordingPath.c_str());
+    std::printf("  filtered EEG: %.3g relative RMS error (limit %.3g), %.4f uV worst sample, signal RMS %.2f uV\n",
+        relativeRmsError, maxEegError, maxError, signalRms);
+    std::printf("  band powers:  %.3g B worst difference over %zu updates (limit %.3g); by band alpha %.2g, beta %.2g, delta %.2g, theta %.2g, gamma %.2g\n",
+        maxBandDifference, reference.powers.size() / (static_cast<size_t>(channels) * BandCount), maxBandError,
+        bandDifference[0], bandDifference[1], bandDifference[2], bandDifference[3], bandDifference[4]);
+    std::printf("  chain cost:   %.0f ns per sample in double, %.0f ns in float\n", reference.nsPerSample, single.nsPerSample);
+
+    bool passed = relativeRmsError <= maxEegError && maxBandDifference <= maxBandError;
+    std::printf("%s\n", passed ? "PASS" : "FAIL");
+    return passed ? 0 : 1;
+}
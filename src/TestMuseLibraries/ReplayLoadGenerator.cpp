@@ -0,0 +1,330 @@
+// ReplayLoadGenerator.cpp : Soak-tests the native ingest path with recorded sessions instead of
+// synthetic sine waves. A .mwrec recording is loaded once and replayed into one ingest pipeline per
+// simulated headband at N times real time (or as fast as the pipelines accept it), looping for as
+// long as the run lasts.
+
+#include "pch.h"
+#include "Arguments.h"
+#include "Clock.h"
+#include "Commands.h"
+#include "MuseWrapper.h"
+#include "SessionRecording.h"
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+using namespace MuseWrapper;
+
+namespace
+{
+    // Gap left between the end of the recording and its next loop, so timestamps stay increasing
+    constexpr int64_t LoopGapUs = 4'000;
+
+    struct Recording
+    {
+        std::vector<StoredPacket> packets;
+        int64_t firstUs = 0;
+        int64_t durationUs = 0;         // first packet to the start of the next loop
+        int eegChannels = 4;
+    };
+
+    Recording LoadRecording(const std::string& path)
+    {
+        RecordingReader reader(path);
+        Recording recording;
+        std::vector<StoredPacket> block;
+        for (size_t i = 0; i < reader.Blocks().size(); i++)
+        {
+            reader.ReadBlock(i, block);
+            recording.packets.insert(recording.packets.end(), block.begin(), block.end());
+        }
+        if (recording.packets.empty())
+        {
+            throw std::runtime_error("Recording has no packets: " + path);
+        }
+        recording.firstUs = recording.packets.front().timestampUs;
+        recording.durationUs = recording.packets.back().timestampUs - recording.firstUs + LoopGapUs;
+        for (const StoredPacket& packet : recording.packets)
+        {
+            if (packet.type == static_cast<uint8_t>(MuseDataPacketType::Eeg))
+            {
+                recording.eegChannels = std::min<int>(packet.valueCount, MaxPacketValues);
+                break;
+            }
+        }
+        return recording;
+    }
+
+    struct Device
+    {
+        int ingest = 0;
+        int timing = 0;
+        std::thread thread;
+        std::atomic<uint64_t> packetsPushed{ 0 };
+        std::atomic<uint64_t> packetsRejected{ 0 };
+        std::atomic<int64_t> replayedUs{ 0 };      // recording time pushed so far, across loops
+        std::atomic<int64_t> lagUs{ 0 };           // how far behind schedule the last push was, in recording time
+    };
+
+    // Replays the recording into one device's pipeline. Each device starts at a different offset so
+    // the pipelines are not fed in lockstep, and loops add the recording length to the timestamps.
+    void ReplayDevice(const Recording& recording, Device& device, size_t startIndex, double speed,
+        const std::atomic<bool>& running)
+    {
+        char error[256];
+        double values[MaxPacketValues];
+        const std::vector<StoredPacket>& packets = recording.packets;
+        int64_t startOffsetUs = packets[startIndex].timestampUs - recording.firstUs;
+        uint64_t startNs = MonotonicNanoseconds();
+        size_t index = startIndex;
+        int64_t loopUs = 0;
+        while (running.load(std::memory_order_relaxed))
+        {
+            const StoredPacket& packet = packets[index];
+            int64_t replayedUs = packet.timestampUs - recording.firstUs + loopUs - startOffsetUs;
+            if (speed > 0.0)
+            {
+                uint64_t dueNs = startNs + static_cast<uint64_t>(replayedUs * 1000.0 / speed);
+                uint64_t nowNs = MonotonicNanoseconds();
+                if (nowNs < dueNs)
+                {
+                    // Recorded packets come in notification bursts, so this sleeps once per burst
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(dueNs - nowNs));
+                    continue;
+                }
+                device.lagUs.store(static_cast<int64_t>((nowNs - dueNs) * speed / 1000.0), std::memory_order_relaxed);
+            }
+
+            // The reader refuses longer packets; values is a fixed array all the same
+            int valueCount = std::min<int>(packet.valueCount, MaxPacketValues);
+            for (int v = 0; v < valueCount; v++)
+            {
+                values[v] = packet.values[v];
+            }
+            int64_t callbackNs;
+            MwClockNanoseconds(&callbackNs, error, sizeof(error));
+            int status = MwIngestPushPacket(device.ingest, packet.type, packet.timestampUs + loopUs, values, valueCount,
+                callbackNs, error, sizeof(error));
+            if (status == MW_QUEUE_FULL)
+            {
+                if (speed <= 0.0)
+                {
+                    // Flat out, a full queue is back-pressure rather than loss
+                    std::this_thread::yield();
+                    continue;
+                }
+                device.packetsRejected.fetch_add(1, std::memory_order_relaxed);
+            }
+            else if (status == MW_OK)
+            {
+                device.packetsPushed.fetch_add(1, std::memory_order_relaxed);
+            }
+            device.replayedUs.store(replayedUs, std::memory_order_relaxed);
+
+            if (++index == packets.size())
+            {
+                index = 0;
+                loopUs += recording.durationUs;
+            }
+        }
+    }
+
+    // Steady-state heap allocations per packet, overall and by pipeline stage
+    void PrintAllocations(uint64_t packets, const std::string& reportPath)
+    {
+        char error[256];
+        MwAllocationStats stats = {};
+        MwAllocationGetStats(&stats, error, sizeof(error));
+        double perPacket = packets != 0 ? 1.0 / static_cast<double>(packets) : 0.0;
+        std::printf("Heap after warm-up: %.4f allocations per packet, %lld live bytes, %lld peak\n",
+            stats.allocations * perPacket, static_cast<long long>(stats.liveBytes), static_cast<long long>(stats.peakBytes));
+        char name[64];
+        MwAllocationStageStats stage = {};
+        for (int i = 0; MwAllocationGetStage(i, name, sizeof(name), &stage, error, sizeof(error)) == MW_OK; i++)
+        {
+            if (stage.allocations != 0)
+            {
+                std::printf("  %-24s %.4f per packet, %lld bytes\n", name, stage.allocations * perPacket,
+                    static_cast<long long>(stage.bytes));
+            }
+        }
+        if (!reportPath.empty() && MwAllocationWriteReport(reportPath.c_str(), 20, error, sizeof(error)) != MW_OK)
+        {
+            std::cerr << error << "\n";
+        }
+    }
+}
+
+int RunReplayLoad(int argc, char** argv)
+{
+    Arguments args(argc, argv);
+    std::string path = args.GetString("recording", "");
+    int deviceCount = static_cast<int>(args.GetInt("devices", 8));
+    double speed = args.GetDouble("speed", 1.0);
+    double seconds = args.GetDouble("seconds", 10.0);
+    double notch = args.GetDouble("notch", 60.0);
+    bool timing = args.Has("timing");
+    int precision = args.Has("float") ? MW_PRECISION_FLOAT : MW_PRECISION_DOUBLE;
+    std::string allocationReport = args.GetString("allocation-report", "");
+    std::string profilePath = args.GetString("profile", "");
+    int profileHz = static_cast<int>(args.GetInt("profile-hz", 997));
+    if (path.empty() || deviceCount < 1 || speed < 0.0)
+    {
+        std::cerr << "replay-load needs --recording file.mwrec, --devices >= 1 and --speed >= 0 (0 = as fast as possible)\n";
+        return 1;
+    }
+
+    Recording recording;
+    try
+    {
+        recording = LoadRecording(path);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    char pace[32];
+    std::snprintf(pace, sizeof(pace), speed > 0.0 ? "%gx real time" : "full speed", speed);
+    std::printf("Replaying %zu packets (%.1f s, %d EEG channels) into %d devices at %s\n",
+        recording.packets.size(), recording.durationUs / 1e6, recording.eegChannels, deviceCount, pace);
+
+    char error[256];
+    if (!profilePath.empty() && MwProfilerStart(profileHz, error, sizeof(error)) != MW_OK)
+    {
+        std::cerr << error << "\n";
+        profilePath.clear();
+    }
+    std::vector<std::unique_ptr<Device>> devices;
+    for (int i = 0; i < deviceCount; i++)
+    {
+        auto device = std::make_unique<Device>();
+        if (MwIngestCreateWithPrecision(recording.eegChannels, 256.0, notch, MW_BANDS_EEG, precision, &device->ingest, error, sizeof(error)) != MW_OK
+            || (timing && (MwTimingCreate(1000, &device->timing, error, sizeof(error)) != MW_OK
+                || MwIngestAttachTiming(device->ingest, device->timing, error, sizeof(error)) != MW_OK)))
+        {
+            std::cerr << "Setup failed: " << error << "\n";
+            return 1;
+        }
+        devices.push_back(std::move(device));
+    }
+
+    std::atomic<bool> running{ true };
+    for (int i = 0; i < deviceCount; i++)
+    {
+        size_t startIndex = recording.packets.size() * static_cast<size_t>(i) / static_cast<size_t>(deviceCount);
+        Device& device = *devices[static_cast<size_t>(i)];
+        device.thread = std::thread([&recording, &device, startIndex, speed, &running]
+        {
+            ReplayDevice(recording, device, startIndex, speed, running);
+        });
+    }
+
+    // Allocation counts are only available in MUSEWRAPPER_ALLOCATION_TRACKING builds
+    MwAllocationStats allocations = {};
+    bool trackAllocations = MwAllocationGetStats(&allocations, error, sizeof(error)) == MW_OK;
+    uint64_t pushedAtReset = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t lastPushed = 0;
+    int64_t lastReplayedUs = 0;
+    for (int second = 1; second <= static_cast<int>(std::ceil(seconds)); second++)
+    {
+        std::this_thread::sleep_until(start + std::chrono::seconds(second));
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        uint64_t pushed = 0;
+        uint64_t rejected = 0;
+        int64_t replayedUs = 0;
+        int64_t maxLagUs = 0;
+        for (const auto& device : devices)
+        {
+            pushed += device->packetsPushed.load(std::memory_order_relaxed);
+            rejected += device->packetsRejected.load(std::memory_order_relaxed);
+            replayedUs += device->replayedUs.load(std::memory_order_relaxed);
+            maxLagUs = std::max(maxLagUs, device->lagUs.load(std::memory_order_relaxed));
+        }
+        std::printf("%6.1f s: %9.0f packets/s  %7.1fx real time per device  %llu rejected  lag %.1f ms\n",
+            elapsed, static_cast<double>(pushed - lastPushed), (replayedUs - lastReplayedUs) / 1e6 / deviceCount,
+            static_cast<unsigned long long>(rejected), maxLagUs / 1000.0);
+        lastPushed = pushed;
+        lastReplayedUs = replayedUs;
+
+        // The first second covers pipeline start-up; steady state is what should not allocate
+        if (second == 1 && trackAllocations)
+        {
+            MwAllocationReset(!allocationReport.empty(), error, sizeof(error));
+            pushedAtReset = pushed;
+        }
+    }
+    running = false;
+    for (const auto& device : devices)
+    {
+        device->thread.join();
+    }
+    // Let the pipelines drain what is still queued before reading their figures
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    if (trackAllocations)
+    {
+        PrintAllocations(lastPushed - pushedAtReset, allocationReport);
+    }
+    if (!profilePath.empty())
+    {
+        int64_t samples = 0;
+        MwProfilerStop(error, sizeof(error));
+        if (MwProfilerWrite(profilePath.c_str(), 1, &samples, error, sizeof(error)) == MW_OK)
+        {
+            std::printf("Wrote %lld profiler samples to %s\n", static_cast<long long>(samples), profilePath.c_str());
+        }
+        else
+        {
+            std::cerr << error << "\n";
+        }
+    }
+
+    MwLatencyStats worstFilter = {};
+    MwLatencyStats worstBandPower = {};
+    MwLatencyStats worstEndToEnd = {};
+    int64_t ingested = 0;
+    int64_t dropped = 0;
+    int64_t published = 0;
+    int64_t missingSamples = 0;
+    int64_t replayedUs = 0;
+    for (const auto& device : devices)
+    {
+        MwIngestStats stats = {};
+        MwIngestGetStats(device->ingest, &stats, error, sizeof(error));
+        ingested += stats.packetsIngested;
+        dropped += stats.packetsDropped;
+        published += stats.metricsPublished;
+        replayedUs += device->replayedUs.load();
+
+        MwLatencyStats stage = {};
+        MwIngestGetLatency(device->ingest, MW_STAGE_FILTER, &stage, error, sizeof(error));
+        worstFilter = stage.p99Ns > worstFilter.p99Ns ? stage : worstFilter;
+        MwIngestGetLatency(device->ingest, MW_STAGE_BAND_POWER, &stage, error, sizeof(error));
+        worstBandPower = stage.p99Ns > worstBandPower.p99Ns ? stage : worstBandPower;
+        MwIngestGetLatency(device->ingest, MW_STAGE_NATIVE, &stage, error, sizeof(error));
+        worstEndToEnd = stage.p99Ns > worstEndToEnd.p99Ns ? stage : worstEndToEnd;
+
+        if (device->timing != 0)
+        {
+            MwPacketTimingStats timingStats = {};
+            MwTimingGetStats(device->timing, static_cast<int>(MuseDataPacketType::Eeg), &timingStats, error, sizeof(error));
+            missingSamples += timingStats.totalMissingSamples;
+            MwTimingDestroy(device->timing, error, sizeof(error));
+        }
+        MwIngestDestroy(device->ingest, error, sizeof(error));
+    }
+
+    std::printf("Replayed %.1f device-hours: %lld packets ingested, %lld refused with a full queue, %lld metric updates\n",
+        replayedUs / 3.6e9, static_cast<long long>(ingested), static_cast<long long>(dropped), static_cast<long long>(published));
+    std::printf("Worst device p99: filter %.1f us, band power %.1f us, native %.1f us\n",
+        worstFilter.p99Ns / 1000.0, worstBandPower.p99Ns / 1000.0, worstEndToEnd.p99Ns / 1000.0);
+    if (timing)
+    {
+        std::printf("EEG samples missing by timestamp: %lld\n", static_cast<long long>(missingSamples));
+    }
+    return 0;
+}
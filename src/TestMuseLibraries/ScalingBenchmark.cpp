@@ -0,0 +1,351 @@
+// ScalingBenchmark.cpp : Ramps simulated headbands through the whole native pipeline (ingest,
+// filtering, band power, session recording and the broadcast hub) and reports what each extra
+// headband costs in CPU and memory, the worst pipeline p99 at each step, and the step at which the
+// cost stops growing linearly.
+
+#include "pch.h"
+#include "Arguments.h"
+#include "Commands.h"
+#include "MuseTypes.h"
+#include "MuseWrapper.h"
+#include "Poller.h"
+#include "ProcessUsage.h"
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+using namespace MuseWrapper;
+
+namespace
+{
+    // libmuse delivers EEG in bursts of 12 samples per Bluetooth notification
+    constexpr int SamplesPerBurst = 12;
+    constexpr double WarmUpSeconds = 1.0;
+
+    struct Headband
+    {
+        int ingest = 0;
+        int recording = 0;
+        std::string path;
+    };
+
+    struct StepResult
+    {
+        int devices = 0;
+        double cpuPercent = 0.0;            // of one core, whole process
+        double cpuPercentPerDevice = 0.0;
+        double residentKbPerDevice = 0.0;
+        double queueP99Us = 0.0;            // worst device
+        double nativeP99Us = 0.0;           // worst device, ingest to publish
+        int64_t packetsDropped = 0;
+        int64_t hubFramesDropped = 0;
+        const char* knee = nullptr;         // why this step stopped scaling linearly, if it did
+    };
+
+    // A spectator that reads and discards everything the hub sends, so frames are really delivered
+    class Subscriber
+    {
+    public:
+        explicit Subscriber(uint16_t port) : socket(Sockets::Connect("127.0.0.1", port))
+        {
+            poller.Add(socket, this);
+            thread = std::thread([this]
+            {
+                PollEvent events[1];
+                uint8_t chunk[16384];
+                while (running.load())
+                {
+                    if (poller.Wait(events, 1, 20) > 0)
+                    {
+                        while (Sockets::Receive(socket, chunk, sizeof(chunk)) > 0)
+                        {
+                        }
+                    }
+                }
+            });
+        }
+
+        ~Subscriber()
+        {
+            running = false;
+            thread.join();
+            poller.Remove(socket);
+            Sockets::Close(socket);
+        }
+
+    private:
+        SocketHandle socket;
+        Poller poller;
+        std::atomic<bool> running{ true };
+        std::thread thread;
+    };
+
+    StepResult RunStep(int deviceCount, int hub, int pool, int channels, double sampleRate, double seconds, const std::string& directory)
+    {
+        char error[256];
+        StepResult result;
+        result.devices = deviceCount;
+        uint64_t residentBefore = ProcessResidentBytes();
+
+        std::vector<Headband> headbands(static_cast<size_t>(deviceCount));
+        for (int i = 0; i < deviceCount; i++)
+        {
+            Headband& headband = headbands[static_cast<size_t>(i)];
+            headband.path = directory + "/scaling-" + std::to_string(deviceCount) + "-" + std::to_string(i) + ".mwrec";
+            if (MwIngestCreate(channels, sampleRate, 60.0, MW_BANDS_EEG, &headband.ingest, error, sizeof(error)) != MW_OK
+                || MwIngestAttachHub(headband.ingest, hub, error, sizeof(error)) != MW_OK
+                || (pool != 0 && MwIngestAttachPool(headband.ingest, pool, error, sizeof(error)) != MW_OK)
+                || MwRecordingCreate(headband.path.c_str(), 0, &headband.recording, error, sizeof(error)) != MW_OK)
+            {
+                throw std::runtime_error(std::string("Setup failed: ") + error);
+            }
+        }
+
+        MwHubStats hubBefore = {};
+        uint64_t cpuBefore = 0;
+        std::vector<double> values(static_cast<size_t>(channels));
+        auto burst = std::chrono::nanoseconds(static_cast<int64_t>(SamplesPerBurst * 1e9 / sampleRate));
+        auto start = std::chrono::steady_clock::now();
+        auto measureFrom = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(WarmUpSeconds));
+        auto end = measureFrom + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+        bool measuring = false;
+        auto next = start;
+        int64_t sample = 0;
+        int64_t startUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        while (next < end)
+        {
+            if (!measuring && next >= measureFrom)
+            {
+                // Start-up costs (thread creation, first blocks) are not part of the steady state
+                for (const Headband& headband : headbands)
+                {
+                    MwIngestResetLatency(headband.ingest, error, sizeof(error));
+                }
+                MwHubGetStats(hub, &hubBefore, error, sizeof(error));
+                cpuBefore = ProcessCpuNanoseconds();
+                measureFrom = std::chrono::steady_clock::now();
+                measuring = true;
+            }
+
+            for (int i = 0; i < SamplesPerBurst; i++, sample++)
+            {
+                int64_t timestampUs = startUs + static_cast<int64_t>(sample * 1e6 / sampleRate);
+                for (int d = 0; d < deviceCount; d++)
+                {
+                    // Each headband gets its own alpha frequency and phase so the DSP sees distinct signals
+                    double t = sample / sampleRate;
+                    for (int c = 0; c < channels; c++)
+                    {
+                        values[static_cast<size_t>(c)] = 800.0 + 20.0 * std::sin(2.0 * 3.14159265358979 * (9.0 + 0.05 * d) * t + c)
+                            + 6.0 * std::sin(2.0 * 3.14159265358979 * 21.0 * t + d);
+                    }
+                    const Headband& headband = headbands[static_cast<size_t>(d)];
+                    int64_t callbackNs;
+                    MwClockNanoseconds(&callbackNs, error, sizeof(error));
+                    MwIngestPushPacket(headband.ingest, 2, timestampUs, values.data(), channels, callbackNs, error, sizeof(error));
+                    MwRecordingAddPacket(headband.recording, 2, timestampUs, values.data(), channels, error, sizeof(error));
+                }
+            }
+            next += burst;
+            std::this_thread::sleep_until(next);
+        }
+        double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - measureFrom).count();
+        uint64_t cpuNs = ProcessCpuNanoseconds() - cpuBefore;
+        uint64_t residentAfter = ProcessResidentBytes();
+        MwHubStats hubAfter = {};
+        MwHubGetStats(hub, &hubAfter, error, sizeof(error));
+
+        result.cpuPercent = 100.0 * cpuNs / elapsedNs;
+        result.cpuPercentPerDevice = result.cpuPercent / deviceCount;
+        result.residentKbPerDevice = (static_cast<double>(residentAfter) - static_cast<double>(residentBefore)) / 1024.0 / deviceCount;
+        result.hubFramesDropped = hubAfter.framesDropped - hubBefore.framesDropped;
+        for (Headband& headband : headbands)
+        {
+            MwLatencyStats queue = {};
+            MwLatencyStats native = {};
+            MwIngestStats stats = {};
+            MwIngestGetLatency(headband.ingest, MW_STAGE_QUEUE, &queue, error, sizeof(error));
+            MwIngestGetLatency(headband.ingest, MW_STAGE_NATIVE, &native, error, sizeof(error));
+            MwIngestGetStats(headband.ingest, &stats, error, sizeof(error));
+            result.queueP99Us = std::max(result.queueP99Us, queue.p99Ns / 1000.0);
+            result.nativeP99Us = std::max(result.nativeP99Us, native.p99Ns / 1000.0);
+            result.packetsDropped += stats.packetsDropped;
+
+            int64_t written;
+            MwIngestDestroy(headband.ingest, error, sizeof(error));
+            MwRecordingClose(headband.recording, &written, error, sizeof(error));
+            std::remove(headband.path.c_str());
+        }
+        return result;
+    }
+
+    // Linear scaling means a constant cost per headband. The reference is the cheapest step so far,
+    // since fixed costs (hub thread, feeder) make the smallest steps look dearer per headband. Latency
+    // only counts against scaling once p99 exceeds the notification interval, i.e. once the pipeline
+    // is still busy with one burst when the next arrives.
+    void FindKnee(std::vector<StepResult>& results, double tolerancePercent, double burstUs)
+    {
+        double cheapest = results.front().cpuPercentPerDevice;
+        for (StepResult& result : results)
+        {
+            if (result.packetsDropped > 0 || result.hubFramesDropped > 0)
+            {
+                result.knee = "packets or frames dropped";
+            }
+            else if (result.cpuPercentPerDevice > cheapest * (1.0 + tolerancePercent / 100.0))
+            {
+                result.knee = "CPU per headband rising";
+            }
+            else if (result.nativeP99Us > burstUs)
+            {
+                result.knee = "p99 beyond one notification interval";
+            }
+            if (result.knee != nullptr)
+            {
+                return;
+            }
+            cheapest = std::min(cheapest, result.cpuPercentPerDevice);
+        }
+    }
+
+    // "2,3,6" -> { 2, 3, 6 }
+    void WriteJson(const std::string& path, const std::vector<StepResult>& results, int channels, double sampleRate)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("Cannot write " + path);
+        }
+        std::fprintf(file, "{\n  \"version\": 1,\n  \"hardwareThreads\": %u,\n  \"channels\": %d,\n  \"sampleRate\": %.1f,\n  \"steps\": [\n",
+            std::thread::hardware_concurrency(), channels, sampleRate);
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const StepResult& r = results[i];
+            std::fprintf(file,
+                "    { \"devices\": %d, \"cpuPercent\": %.2f, \"cpuPercentPerDevice\": %.3f, \"residentKbPerDevice\": %.1f, "
+                "\"queueP99Us\": %.1f, \"nativeP99Us\": %.1f, \"packetsDropped\": %lld, \"hubFramesDropped\": %lld, \"knee\": %s%s%s }%s\n",
+                r.devices, r.cpuPercent, r.cpuPercentPerDevice, r.residentKbPerDevice, r.queueP99Us, r.nativeP99Us,
+                static_cast<long long>(r.packetsDropped), static_cast<long long>(r.hubFramesDropped),
+                r.knee ? "\"" : "", r.knee ? r.knee : "null", r.knee ? "\"" : "", i + 1 < results.size() ? "," : "");
+        }
+        std::fprintf(file, "  ]\n}\n");
+        std::fclose(file);
+    }
+}
+
+int RunScaling(int argc, char** argv)
+{
+    Arguments args(argc, argv);
+    int maxDevices = static_cast<int>(args.GetInt("max-devices", 64));
+    double seconds = args.GetDouble("step-seconds", 5.0);
+    int channels = static_cast<int>(args.GetInt("channels", 4));
+    double sampleRate = args.GetDouble("rate", 256.0);
+    double tolerance = args.GetDouble("tolerance", 25.0);
+    std::string directory = args.GetString("dir", ".");
+    std::string jsonPath = args.GetString("json", "");
+    int poolWorkers = static_cast<int>(args.GetInt("pool", -1));
+    std::vector<int> poolCpus = args.GetIntList("pool-cpus");
+    if (maxDevices < 1 || channels < 1 || channels > MaxPacketValues || sampleRate <= 0.0)
+    {
+        std::cerr << "scaling needs --max-devices >= 1, --channels 1-" << MaxPacketValues << " and a positive --rate\n";
+        return 1;
+    }
+
+    char error[256];
+    int hub;
+    if (MwHubCreate(0, -1, 1, 64, &hub, error, sizeof(error)) != MW_OK)
+    {
+        std::cerr << "Failed to create hub: " << error << "\n";
+        return 1;
+    }
+    int tcpPort = 0;
+    int webSocketPort = 0;
+    MwHubGetPorts(hub, &tcpPort, &webSocketPort, error, sizeof(error));
+
+    // Without --pool every headband's pipeline keeps a worker thread of its own
+    int pool = 0;
+    if (args.Has("pool") && MwPoolCreate(std::max(poolWorkers, 0), poolCpus.data(), static_cast<int>(poolCpus.size()), &pool, error, sizeof(error)) != MW_OK)
+    {
+        std::cerr << "Failed to create DSP pool: " << error << "\n";
+        MwHubDestroy(hub, error, sizeof(error));
+        return 1;
+    }
+    MwPoolStats poolStats = {};
+    if (pool != 0)
+    {
+        MwPoolGetStats(pool, &poolStats, error, sizeof(error));
+    }
+
+    std::vector<StepResult> results;
+    std::printf("Scaling %d-channel EEG at %.0f Hz through ingest, recording and the hub; %u hardware threads, %.0f s per step\n",
+        channels, sampleRate, std::thread::hardware_concurrency(), seconds);
+    if (pool != 0)
+    {
+        std::printf("Pipelines share a DSP pool of %d workers\n", poolStats.workers);
+    }
+    std::printf("  %7s %9s %12s %12s %11s %12s %9s\n", "devices", "CPU %", "CPU %/device", "KB/device", "queue p99", "native p99", "dropped");
+    try
+    {
+        Subscriber subscriber(static_cast<uint16_t>(tcpPort));
+        for (int devices = 1; ; devices = std::min(devices * 2, maxDevices))
+        {
+            StepResult result = RunStep(devices, hub, pool, channels, sampleRate, seconds, directory);
+            std::printf("  %7d %8.1f%% %11.2f%% %12.1f %9.0f us %9.0f us %9lld\n", result.devices, result.cpuPercent,
+                result.cpuPercentPerDevice, result.residentKbPerDevice, result.queueP99Us, result.nativeP99Us,
+                static_cast<long long>(result.packetsDropped + result.hubFramesDropped));
+            results.push_back(result);
+            if (devices == maxDevices)
+            {
+                break;
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        if (pool != 0)
+        {
+            MwPoolDestroy(pool, error, sizeof(error));
+        }
+        MwHubDestroy(hub, error, sizeof(error));
+        return 1;
+    }
+    if (pool != 0)
+    {
+        MwPoolGetStats(pool, &poolStats, error, sizeof(error));
+        std::printf("DSP pool ran %lld batches, %lld of them stolen from another worker\n",
+            static_cast<long long>(poolStats.batches), static_cast<long long>(poolStats.steals));
+        MwPoolDestroy(pool, error, sizeof(error));
+    }
+    MwHubDestroy(hub, error, sizeof(error));
+
+    FindKnee(results, tolerance, SamplesPerBurst * 1e6 / sampleRate);
+    auto knee = std::find_if(results.begin(), results.end(), [](const StepResult& r) { return r.knee != nullptr; });
+    if (knee == results.end())
+    {
+        std::printf("Scaled linearly up to %d headbands (within %.0f%% CPU per headband)\n", results.back().devices, tolerance);
+    }
+    else if (knee == results.begin())
+    {
+        std::printf("Did not scale even at %d headband: %s\n", knee->devices, knee->knee);
+    }
+    else
+    {
+        std::printf("Scaled linearly up to %d headbands; knee at %d (%s)\n", (knee - 1)->devices, knee->devices, knee->knee);
+    }
+
+    if (!jsonPath.empty())
+    {
+        try
+        {
+            WriteJson(jsonPath, results, channels, sampleRate);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Sorts the samples in place and returns the value at quantile q (0-1), or 0 for no samples
+inline uint64_t Percentile(std::vector<uint64_t>& samples, double q)
+{
+    if (samples.empty())
+    {
+        return 0;
+    }
+    size_t index = std::min(samples.size() - 1, static_cast<size_t>(q * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
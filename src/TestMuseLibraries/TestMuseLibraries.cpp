@@ -1,20 +1,61 @@
-// TestMuseLibraries.cpp : This file contains the 'main' function. Program execution begins and ends there.
+// TestMuseLibraries.cpp : Command-line harness for exercising MuseWrapper without a headband.
 //
 
+#include <cstring>
 #include <iostream>
 
-int main()
+#include "Commands.h"
+
+namespace
 {
-    std::cout << "Hello World!\n";
+    struct Command
+    {
+        const char* name;
+        int (*run)(int argc, char** argv);
+        const char* usage;
+    };
+
+    const Command commands[] =
+    {
+        { "hub-load", RunHubLoad, "[--subscribers 1000] [--rate 30] [--seconds 10] [--payload 256] [--websocket]" },
+        { "bench", RunBench, "[--filter name] [--seconds 1] [--baseline file] [--threshold 10] [--tail-threshold 25] [--json file] [--write-baseline file]" },
+        { "latency", RunLatency, "[--seconds 10] [--channels 4] [--rate 256] [--render-us 0] [--trace file.json|file.pftrace] [--priority normal|high|realtime] [--cpus 2,3] [--busy-threads 0]" },
+        { "metrics", RunMetrics, "[--segment MuseWrapperMetrics] [--seconds 10] [--demo]" },
+        { "replay-load", RunReplayLoad, "--recording file.mwrec [--devices 8] [--speed 1|10|100|0] [--seconds 10] [--notch 60] [--float] [--timing] [--allocation-report file] [--profile file.folded] [--profile-hz 997]" },
+        { "scaling", RunScaling, "[--max-devices 64] [--step-seconds 5] [--channels 4] [--rate 256] [--tolerance 25] [--pool workers] [--pool-cpus 2,3] [--dir .] [--json file]" },
+        { "precision", RunPrecision, "[--seconds 600] [--channels 4] [--rate 256] [--notch 60] [--recording file.mwrec] [--max-eeg-error 1e-3] [--max-band-error 0.05]" },
+        { "connect", RunConnect, "[--libmuse path] [--devices 1 | --macs a,b] [--attempts 3] [--attempt-timeout-ms 30000] [--backoff-ms 1000] [--timeout 120] [--verbose]" },
+        { "overload", RunOverload, "[--policy all|block|drop-oldest|drop-newest|latest-only] [--seconds 4] [--rate 8000] [--consumer-us 500] [--payload 16384]" },
+        { "thread-state", RunThreadState, "[--threads 8] [--rounds 10000]" },
+    };
+
+    void PrintUsage()
+    {
+        std::cout << "Usage: TestMuseLibraries <command> [options]\n\nCommands:\n";
+        for (const Command& command : commands)
+        {
+            std::cout << "  " << command.name << " " << command.usage << "\n";
+        }
+    }
 }
 
-// Run program: Ctrl + F5 or Debug > Start Without Debugging menu
-// Debug program: F5 or Debug > Start Debugging menu
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    for (const Command& command : commands)
+    {
+        if (std::strcmp(argv[1], command.name) == 0)
+        {
+            return command.run(argc - 2, argv + 2);
+        }
+    }
 
-// Tips for Getting Started: 
-//   1. Use the Solution Explorer window to add/manage files
-//   2. Use the Team Explorer window to connect to source control
-//   3. Use the Output window to see build output and other messages
-//   4. Use the Error List window to view errors
-//   5. Go to Project > Add New Item to create new code files, or Project > Add Existing Item to add existing code files to the project
-//   6. In the future, to open this project again, go to File > Open > Project and select the .sln file
+    std::cerr << "Unknown command: " << argv[1] << "\n\n";
+    PrintUsage();
+    return 1;
+}
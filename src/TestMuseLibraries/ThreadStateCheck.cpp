@@ -0,0 +1,178 @@
+// ThreadStateCheck.cpp : Checks MuseWrapper's per-thread state: that MwGetLastError reports only the
+// calling thread's latest failure while other threads fail concurrently, that it truncates to the
+// caller's buffer, and that MwGetThreadBuffer grows each thread's buffers by doubling up to the 16 MB
+// cap and refuses anything larger. The command fails if any check does.
+
+#include "pch.h"
+#include "Arguments.h"
+#include "Commands.h"
+#include "MuseWrapper.h"
+
+#include <barrier>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    constexpr int MaxThreadBufferLength = 16 * 1024 * 1024;
+
+    // Failures whose messages tell the threads apart
+    const char* const UnknownBuffer = "Unknown thread buffer";
+    const char* const LengthOutOfRange = "minLength is out of range";
+
+    class Checks
+    {
+    public:
+        void Expect(bool condition, const char* what)
+        {
+            checked++;
+            if (!condition)
+            {
+                failures++;
+                std::printf("  FAILED: %s\n", what);
+            }
+        }
+
+        bool Passed() const { return failures == 0; }
+        int Checked() const { return checked; }
+
+    private:
+        int checked = 0;
+        int failures = 0;
+    };
+
+    int FailWith(const char* message)
+    {
+        char* buffer = nullptr;
+        int length = 0;
+        return std::strcmp(message, UnknownBuffer) == 0
+            ? MwGetThreadBuffer(MW_THREAD_BUFFER_COUNT, 1, &buffer, &length, nullptr, 0)
+            : MwGetThreadBuffer(MW_THREAD_BUFFER_STRING, 0, &buffer, &length, nullptr, 0);
+    }
+
+    // Threads fail with alternating messages in lockstep, then each reads back its own
+    void CheckIsolation(Checks& checks, int threads, int rounds)
+    {
+        std::barrier failed(threads);
+        std::barrier read(threads);
+        std::atomic<int> mismatches{ 0 };
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++)
+        {
+            workers.emplace_back([&, t]
+            {
+                for (int round = 0; round < rounds; round++)
+                {
+                    const char* expected = (t + round) % 2 == 0 ? UnknownBuffer : LengthOutOfRange;
+                    FailWith(expected);
+                    failed.arrive_and_wait();
+                    char message[256];
+                    if (MwGetLastError(message, sizeof(message)) != MW_INVALID_ARGUMENT || std::strcmp(message, expected) != 0)
+                    {
+                        mismatches++;
+                    }
+                    read.arrive_and_wait();
+                }
+            });
+        }
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+        checks.Expect(mismatches == 0, "each thread reads back its own latest failure");
+
+        int code = MW_FAILURE;
+        char message[256] = "unchanged";
+        std::thread([&] { code = MwGetLastError(message, sizeof(message)); }).join();
+        checks.Expect(code == MW_OK && message[0] == '\0', "a thread that never failed reports MW_OK and no message");
+    }
+
+    void CheckTruncation(Checks& checks)
+    {
+        FailWith(LengthOutOfRange);
+        char message[8];
+        std::memset(message, 'x', sizeof(message));
+        int code = MwGetLastError(message, sizeof(message));
+        checks.Expect(code == MW_INVALID_ARGUMENT, "the status survives truncation");
+        checks.Expect(std::strlen(message) == sizeof(message) - 1 && std::strncmp(message, LengthOutOfRange, sizeof(message) - 1) == 0,
+            "the message is cut to the buffer and terminated");
+
+        char single = 'x';
+        MwGetLastError(&single, 1);
+        checks.Expect(single == '\0', "a one-byte buffer gets only the terminator");
+        checks.Expect(MwGetLastError(nullptr, 0) == MW_INVALID_ARGUMENT, "the status is returned without a buffer");
+
+        char full[256];
+        MwGetLastError(full, sizeof(full));
+        checks.Expect(std::strcmp(full, LengthOutOfRange) == 0, "reading does not clear or shorten the stored message");
+    }
+
+    void CheckGrowth(Checks& checks)
+    {
+        char* first = nullptr;
+        int length = 0;
+        checks.Expect(MwGetThreadBuffer(MW_THREAD_BUFFER_STRING, 100, &first, &length, nullptr, 0) == MW_OK && length == 100,
+            "a first request gets exactly what it asked for");
+        std::memset(first, 'a', static_cast<size_t>(length));
+
+        char* same = nullptr;
+        checks.Expect(MwGetThreadBuffer(MW_THREAD_BUFFER_STRING, 60, &same, &length, nullptr, 0) == MW_OK && same == first && length == 100
+            && same[99] == 'a', "a smaller request returns the same buffer untouched");
+
+        char* grown = nullptr;
+        MwGetThreadBuffer(MW_THREAD_BUFFER_STRING, 101, &grown, &length, nullptr, 0);
+        checks.Expect(length == 200, "a slightly larger request doubles the buffer");
+        MwGetThreadBuffer(MW_THREAD_BUFFER_STRING, 1000, &grown, &length, nullptr, 0);
+        checks.Expect(length == 1000, "a request past double gets what it asked for");
+
+        char* other = nullptr;
+        MwGetThreadBuffer(MW_THREAD_BUFFER_ERROR, 1000, &other, &length, nullptr, 0);
+        checks.Expect(other != grown, "each kind of buffer is separate");
+
+        char* elsewhere = nullptr;
+        std::thread([&] { MwGetThreadBuffer(MW_THREAD_BUFFER_STRING, 1000, &elsewhere, &length, nullptr, 0); }).join();
+        checks.Expect(elsewhere != nullptr && elsewhere != grown, "each thread has its own buffers");
+    }
+
+    // Run on a fresh thread so the buffers it grows to 16 MB are freed when it exits
+    void CheckCap(Checks& checks)
+    {
+        std::thread([&]
+        {
+            char* buffer = nullptr;
+            int length = 0;
+            MwGetThreadBuffer(MW_THREAD_BUFFER_STRING, 12 * 1024 * 1024, &buffer, &length, nullptr, 0);
+            MwGetThreadBuffer(MW_THREAD_BUFFER_STRING, 12 * 1024 * 1024 + 1, &buffer, &length, nullptr, 0);
+            checks.Expect(length == MaxThreadBufferLength, "doubling stops at 16 MB");
+
+            checks.Expect(MwGetThreadBuffer(MW_THREAD_BUFFER_STRING, MaxThreadBufferLength, &buffer, &length, nullptr, 0) == MW_OK
+                && length == MaxThreadBufferLength, "exactly 16 MB is allowed");
+
+            char* before = buffer;
+            char error[256] = "";
+            checks.Expect(MwGetThreadBuffer(MW_THREAD_BUFFER_STRING, MaxThreadBufferLength + 1, &buffer, &length, error, sizeof(error))
+                == MW_INVALID_ARGUMENT && std::strcmp(error, LengthOutOfRange) == 0, "more than 16 MB is refused");
+            checks.Expect(MwGetThreadBuffer(MW_THREAD_BUFFER_STRING, 1, &buffer, &length, nullptr, 0) == MW_OK && buffer == before
+                && length == MaxThreadBufferLength, "a refused request leaves the buffer as it was");
+            checks.Expect(MwGetThreadBuffer(MW_THREAD_BUFFER_STRING, 0, &buffer, &length, nullptr, 0) == MW_INVALID_ARGUMENT,
+                "a zero length is refused");
+        }).join();
+    }
+}
+
+int RunThreadState(int argc, char** argv)
+{
+    Arguments args(argc, argv);
+    int threads = static_cast<int>(args.GetInt("threads", 8));
+    int rounds = static_cast<int>(args.GetInt("rounds", 10000));
+
+    Checks checks;
+    CheckIsolation(checks, threads, rounds);
+    CheckTruncation(checks);
+    CheckGrowth(checks);
+    CheckCap(checks);
+
+    std::printf("Thread state: %d checks, errors isolated across %d threads over %d rounds\n", checks.Checked(), threads, rounds);
+    std::printf("%s\n", checks.Passed() ? "PASS" : "FAIL");
+    return checks.Passed() ? 0 : 1;
+}